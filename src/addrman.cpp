@@ -88,6 +88,49 @@ CAddrInfo* CAddrMan::Find(const CNetAddr& addr, int* pnId)
     return NULL;
 }
 
+const CAddrInfo* CAddrMan::Lookup(const CNetAddr& addr) const
+{
+    std::map<CNetAddr, int>::const_iterator it = mapAddr.find(addr);
+    if (it == mapAddr.end())
+        return NULL;
+    std::map<int, CAddrInfo>::const_iterator it2 = mapInfo.find((*it).second);
+    if (it2 != mapInfo.end())
+        return &(*it2).second;
+    return NULL;
+}
+
+/**
+ * Store nId at a table position and maintain the dense list of occupied positions
+ * used by Select_, so that picking a random entry does not have to probe empty slots.
+ */
+static void SetTableSlot(int (*vvTable)[ADDRMAN_BUCKET_SIZE], int (*vvSlot)[ADDRMAN_BUCKET_SIZE], std::vector<int>& vSlots, int nBucket, int nBucketPos, int nId)
+{
+    bool fOccupied = vvTable[nBucket][nBucketPos] != -1;
+    vvTable[nBucket][nBucketPos] = nId;
+    if (nId != -1 && !fOccupied) {
+        vvSlot[nBucket][nBucketPos] = vSlots.size();
+        vSlots.push_back(nBucket * ADDRMAN_BUCKET_SIZE + nBucketPos);
+    } else if (nId == -1 && fOccupied) {
+        // move the last occupied position into the hole
+        int nSlot = vvSlot[nBucket][nBucketPos];
+        int nLast = vSlots.back();
+        vSlots[nSlot] = nLast;
+        vvSlot[nLast / ADDRMAN_BUCKET_SIZE][nLast % ADDRMAN_BUCKET_SIZE] = nSlot;
+        vSlots.pop_back();
+        vvSlot[nBucket][nBucketPos] = -1;
+    }
+}
+
+void CAddrMan::SetNew(int nUBucket, int nUBucketPos, int nId)
+{
+    SetTableSlot(vvNew, vvNewSlot, vNewSlots, nUBucket, nUBucketPos, nId);
+}
+
+void CAddrMan::SetTried(int nKBucket, int nKBucketPos, int nId)
+{
+    SetTableSlot(vvTried, vvTriedSlot, vTriedSlots, nKBucket, nKBucketPos, nId);
+}
+
 CAddrInfo* CAddrMan::Create(const CAddress& addr, const CNetAddr& addrSource, int* pnId)
 {
     int nId = nIdCount++;
@@ -142,7 +185,7 @@ void CAddrMan::ClearNew(int nUBucket, int nUBucketPos)
         CAddrInfo& infoDelete = mapInfo[nIdDelete];
         assert(infoDelete.nRefCount > 0);
         infoDelete.nRefCount--;
-        vvNew[nUBucket][nUBucketPos] = -1;
+        SetNew(nUBucket, nUBucketPos, -1);
         if (infoDelete.nRefCount == 0) {
             Delete(nIdDelete);
         }
@@ -155,7 +198,7 @@ void CAddrMan::MakeTried(CAddrInfo& info, int nId)
     for (int bucket = 0; bucket < ADDRMAN_NEW_BUCKET_COUNT; bucket++) {
         int pos = info.GetBucketPosition(nKey, true, bucket);
         if (vvNew[bucket][pos] == nId) {
-            vvNew[bucket][pos] = -1;
+            SetNew(bucket, pos, -1);
             info.nRefCount--;
         }
     }
@@ -176,7 +219,7 @@ void CAddrMan::MakeTried(CAddrInfo& info, int nId)
 
         // Remove the to-be-evicted item from the tried set.
         infoOld.fInTried = false;
-        vvTried[nKBucket][nKBucketPos] = -1;
+        SetTried(nKBucket, nKBucketPos, -1);
         nTried--;
 
         // find which new bucket it belongs to
@@ -187,30 +230,30 @@ void CAddrMan::MakeTried(CAddrInfo& info, int nId)
 
         // Enter it into the new set again.
         infoOld.nRefCount = 1;
-        vvNew[nUBucket][nUBucketPos] = nIdEvict;
+        SetNew(nUBucket, nUBucketPos, nIdEvict);
         nNew++;
     }
     assert(vvTried[nKBucket][nKBucketPos] == -1);
 
-    vvTried[nKBucket][nKBucketPos] = nId;
+    SetTried(nKBucket, nKBucketPos, nId);
     nTried++;
     info.fInTried = true;
 }
 
-void CAddrMan::Good_(const CService& addr, int64_t nTime)
+bool CAddrMan::Good_(const CService& addr, int64_t nTime)
 {
     int nId;
     CAddrInfo* pinfo = Find(addr, &nId);
 
     // if not found, bail out
     if (!pinfo)
-        return;
+        return false;
 
     CAddrInfo& info = *pinfo;
 
     // check whether we are talking about the exact same CService (including same port)
     if (info != addr)
-        return;
+        return false;
 
     // update info
     info.nLastSuccess = nTime;
@@ -221,7 +264,7 @@ void CAddrMan::Good_(const CService& addr, int64_t nTime)
 
     // if it is already in the tried set, don't do anything else
     if (info.fInTried)
-        return;
+        return true;
 
     // find a bucket it is in now
     int nRnd = GetRandInt(ADDRMAN_NEW_BUCKET_COUNT);
@@ -238,12 +281,13 @@ void CAddrMan::Good_(const CService& addr, int64_t nTime)
     // if no bucket is found, something bad happened;
     // TODO: maybe re-add the node, but for now, just bail out
     if (nUBucket == -1)
-        return;
+        return true;
 
     LogPrint("addrman", "Moving %s to tried\n", addr.ToString());
 
     // move nId to the tried tables
     MakeTried(info, nId);
+    return true;
 }
 
 bool CAddrMan::Add_(const CAddress& addr, const CNetAddr& source, int64_t nTimePenalty)
@@ -304,7 +348,7 @@ bool CAddrMan::Add_(const CAddress& addr, const CNetAddr& source, int64_t nTimeP
         if (fInsert) {
             ClearNew(nUBucket, nUBucketPos);
             pinfo->nRefCount++;
-            vvNew[nUBucket][nUBucketPos] = nId;
+            SetNew(nUBucket, nUBucketPos, nId);
         } else {
             if (pinfo->nRefCount == 0) {
                 Delete(nId);
@@ -314,75 +358,80 @@ bool CAddrMan::Add_(const CAddress& addr, const CNetAddr& source, int64_t nTimeP
     return fNew;
 }
 
-void CAddrMan::Attempt_(const CService& addr, int64_t nTime)
+bool CAddrMan::IsRedundant_(const CAddress& addr, int64_t nTimePenalty) const
+{
+    if (!addr.IsRoutable())
+        return true;
+
+    const CAddrInfo* pinfo = Lookup(addr);
+    if (!pinfo)
+        return false;
+
+    // the checks below mirror the early returns taken by Add_ for a known entry
+    if ((pinfo->nServices | addr.nServices) != pinfo->nServices)
+        return false;
+    bool fCurrentlyOnline = (GetAdjustedTime() - addr.nTime < 24 * 60 * 60);
+    int64_t nUpdateInterval = (fCurrentlyOnline ? 60 * 60 : 24 * 60 * 60);
+    if (addr.nTime && (!pinfo->nTime || pinfo->nTime < addr.nTime - nUpdateInterval - nTimePenalty))
+        return false;
+    return !addr.nTime || (pinfo->nTime && addr.nTime <= pinfo->nTime) ||
+           pinfo->fInTried || pinfo->nRefCount == ADDRMAN_NEW_BUCKETS_PER_ADDRESS;
+}
+
+bool CAddrMan::Attempt_(const CService& addr, int64_t nTime)
 {
     CAddrInfo* pinfo = Find(addr);
 
     // if not found, bail out
     if (!pinfo)
-        return;
+        return false;
 
     CAddrInfo& info = *pinfo;
 
     // check whether we are talking about the exact same CService (including same port)
     if (info != addr)
-        return;
+        return false;
 
     // update info
     info.nLastTry = nTime;
     info.nAttempts++;
+    return true;
 }
 
-CAddrInfo CAddrMan::Select_()
+CAddrInfo CAddrMan::Select_() const
 {
-    if (size() == 0)
+    if (vRandom.empty())
         return CAddrInfo();
 
     // Use a 50% chance for choosing between tried and new table entries.
-    if (nTried > 0 && (nNew == 0 || GetRandInt(2) == 0)) {
-        // use a tried node
-        double fChanceFactor = 1.0;
-        while (1) {
-            int nKBucket = GetRandInt(ADDRMAN_TRIED_BUCKET_COUNT);
-            int nKBucketPos = GetRandInt(ADDRMAN_BUCKET_SIZE);
-            while (vvTried[nKBucket][nKBucketPos] == -1) {
-                nKBucket = (nKBucket + insecure_rand.randbits(ADDRMAN_TRIED_BUCKET_COUNT_LOG2)) % ADDRMAN_TRIED_BUCKET_COUNT;
-                nKBucketPos = (nKBucketPos + insecure_rand.randbits(ADDRMAN_BUCKET_SIZE_LOG2)) % ADDRMAN_BUCKET_SIZE;
-            }
-            int nId = vvTried[nKBucket][nKBucketPos];
-            assert(mapInfo.count(nId) == 1);
-            CAddrInfo& info = mapInfo[nId];
-            if (GetRandInt(1 << 30) < fChanceFactor * info.GetChance() * (1 << 30))
-                return info;
-            fChanceFactor *= 1.2;
-        }
-    } else {
-        // use a new node
-        double fChanceFactor = 1.0;
-        while (1) {
-            int nUBucket = GetRandInt(ADDRMAN_NEW_BUCKET_COUNT);
-            int nUBucketPos = GetRandInt(ADDRMAN_BUCKET_SIZE);
-            while (vvNew[nUBucket][nUBucketPos] == -1) {
-                nUBucket = (nUBucket + insecure_rand.randbits(ADDRMAN_NEW_BUCKET_COUNT_LOG2)) % ADDRMAN_NEW_BUCKET_COUNT;
-                nUBucketPos = (nUBucketPos + insecure_rand.randbits(ADDRMAN_BUCKET_SIZE_LOG2)) % ADDRMAN_BUCKET_SIZE;
-            }
-            int nId = vvNew[nUBucket][nUBucketPos];
-            assert(mapInfo.count(nId) == 1);
-            CAddrInfo& info = mapInfo[nId];
-            if (GetRandInt(1 << 30) < fChanceFactor * info.GetChance() * (1 << 30))
-                return info;
-            fChanceFactor *= 1.2;
-        }
+    bool fTried = nTried > 0 && (nNew == 0 || GetRandInt(2) == 0);
+    const std::vector<int>& vSlots = fTried ? vTriedSlots : vNewSlots;
+    if (vSlots.empty())
+        return CAddrInfo();
+
+    // Draw uniformly among the occupied positions of the chosen table, which is what the
+    // old random walk over the buckets converged to, without probing empty slots.
+    double fChanceFactor = 1.0;
+    while (1) {
+        int nSlot = vSlots[GetRandInt(vSlots.size())];
+        int nBucket = nSlot / ADDRMAN_BUCKET_SIZE;
+        int nBucketPos = nSlot % ADDRMAN_BUCKET_SIZE;
+        int nId = fTried ? vvTried[nBucket][nBucketPos] : vvNew[nBucket][nBucketPos];
+        std::map<int, CAddrInfo>::const_iterator it = mapInfo.find(nId);
+        assert(it != mapInfo.end());
+        const CAddrInfo& info = it->second;
+        if (GetRandInt(1 << 30) < fChanceFactor * info.GetChance() * (1 << 30))
+            return info;
+        fChanceFactor *= 1.2;
     }
 }
 
-#ifdef DEBUG_ADDRMAN
 int CAddrMan::Check_()
 {
     std::set<int> setTried;
     std::map<int, int> mapNew;
 
-    if (vRandom.size() != nTried + nNew)
+    if (vRandom.size() != (size_t)(nTried + nNew))
         return -7;
 
     for (std::map<int, CAddrInfo>::iterator it = mapInfo.begin(); it != mapInfo.end(); it++) {
@@ -403,7 +452,7 @@ int CAddrMan::Check_()
         }
         if (mapAddr[info] != n)
             return -5;
-        if (info.nRandomPos < 0 || info.nRandomPos >= vRandom.size() || vRandom[info.nRandomPos] != n)
+        if (info.nRandomPos < 0 || info.nRandomPos >= (int)vRandom.size() || vRandom[info.nRandomPos] != n)
             return -14;
         if (info.nLastTry < 0)
             return -6;
@@ -411,9 +460,9 @@ int CAddrMan::Check_()
             return -8;
     }
 
-    if (setTried.size() != nTried)
+    if (setTried.size() != (size_t)nTried)
         return -9;
-    if (mapNew.size() != nNew)
+    if (mapNew.size() != (size_t)nNew)
         return -10;
 
     for (int n = 0; n < ADDRMAN_TRIED_BUCKET_COUNT; n++) {
@@ -443,6 +492,17 @@ int CAddrMan::Check_()
         }
     }
 
+    for (unsigned int i = 0; i < vTriedSlots.size(); i++) {
+        int nBucket = vTriedSlots[i] / ADDRMAN_BUCKET_SIZE, nBucketPos = vTriedSlots[i] % ADDRMAN_BUCKET_SIZE;
+        if (vvTried[nBucket][nBucketPos] == -1 || vvTriedSlot[nBucket][nBucketPos] != (int)i)
+            return -20;
+    }
+    for (unsigned int i = 0; i < vNewSlots.size(); i++) {
+        int nBucket = vNewSlots[i] / ADDRMAN_BUCKET_SIZE, nBucketPos = vNewSlots[i] % ADDRMAN_BUCKET_SIZE;
+        if (vvNew[nBucket][nBucketPos] == -1 || vvNewSlot[nBucket][nBucketPos] != (int)i)
+            return -21;
+    }
+
     if (setTried.size())
         return -13;
     if (mapNew.size())
@@ -452,45 +512,62 @@ int CAddrMan::Check_()
 
     return 0;
 }
-#endif
 
-void CAddrMan::GetAddr_(std::vector<CAddress>& vAddr)
+void CAddrMan::GetAddr_(std::vector<CAddress>& vAddr) const
 {
     unsigned int nNodes = ADDRMAN_GETADDR_MAX_PCT * vRandom.size() / 100;
     if (nNodes > ADDRMAN_GETADDR_MAX)
         nNodes = ADDRMAN_GETADDR_MAX;
 
-    // gather a list of random nodes, skipping those of low quality
-    for (unsigned int n = 0; n < vRandom.size(); n++) {
+    // gather a list of random nodes, skipping those of low quality; the partial
+    // shuffle runs on a copy so only a shared lock is needed
+    std::vector<int> vIds(vRandom);
+    for (unsigned int n = 0; n < vIds.size(); n++) {
         if (vAddr.size() >= nNodes)
             break;
 
-        int nRndPos = GetRandInt(vRandom.size() - n) + n;
-        SwapRandom(n, nRndPos);
-        assert(mapInfo.count(vRandom[n]) == 1);
+        int nRndPos = GetRandInt(vIds.size() - n) + n;
+        std::swap(vIds[n], vIds[nRndPos]);
+        std::map<int, CAddrInfo>::const_iterator it = mapInfo.find(vIds[n]);
+        assert(it != mapInfo.end());
 
-        const CAddrInfo& ai = mapInfo[vRandom[n]];
+        const CAddrInfo& ai = it->second;
         if (!ai.IsTerrible())
             vAddr.push_back(ai);
     }
 }
 
-void CAddrMan::Connected_(const CService& addr, int64_t nTime)
+bool CAddrMan::NeedsConnected_(const CService& addr, int64_t nTime) const
+{
+    const CAddrInfo* pinfo = Lookup(addr);
+
+    // check whether we are talking about the exact same CService (including same port)
+    if (!pinfo || *pinfo != addr)
+        return false;
+
+    int64_t nUpdateInterval = 20 * 60;
+    return nTime - pinfo->nTime > nUpdateInterval;
+}
+
+bool CAddrMan::Connected_(const CService& addr, int64_t nTime)
 {
     CAddrInfo* pinfo = Find(addr);
 
     // if not found, bail out
     if (!pinfo)
-        return;
+        return false;
 
     CAddrInfo& info = *pinfo;
 
     // check whether we are talking about the exact same CService (including same port)
     if (info != addr)
-        return;
+        return false;
 
     // update info
     int64_t nUpdateInterval = 20 * 60;
-    if (nTime - info.nTime > nUpdateInterval)
+    if (nTime - info.nTime > nUpdateInterval) {
         info.nTime = nTime;
+        return true;
+    }
+    return false;
 }
@@ -176,12 +176,14 @@ public:
 class CAddrMan
 {
 private:
-    //! critical section to protect the inner data structures
-    mutable RecursiveMutex cs;
+    //! protects the inner data structures; selection and serialization only take it shared
+    mutable SharedMutex cs;
 
+protected:
     //! secret key to randomize bucket select with
     uint256 nKey;
 
+private:
     //! last used nId
     int nIdCount;
 
@@ -206,16 +208,34 @@ private:
     //! list of "new" buckets
     int vvNew[ADDRMAN_NEW_BUCKET_COUNT][ADDRMAN_BUCKET_SIZE];
 
-protected:
-    //! secret key to randomize bucket select with
-    //uint256 nKey;
+    //! occupied "tried" positions (bucket * ADDRMAN_BUCKET_SIZE + position), in no particular order
+    std::vector<int> vTriedSlots;
+
+    //! index of each "tried" position in vTriedSlots, or -1 if the position is empty
+    int vvTriedSlot[ADDRMAN_TRIED_BUCKET_COUNT][ADDRMAN_BUCKET_SIZE];
 
-    //! Source of random numbers for randomization in inner loops
-    FastRandomContext insecure_rand;
+    //! occupied "new" positions (bucket * ADDRMAN_BUCKET_SIZE + position), in no particular order
+    std::vector<int> vNewSlots;
 
+    //! index of each "new" position in vNewSlots, or -1 if the position is empty
+    int vvNewSlot[ADDRMAN_NEW_BUCKET_COUNT][ADDRMAN_BUCKET_SIZE];
+
+    //! number of modifications that affect the serialized tables
+    uint64_t nChanges;
+
+protected:
     //! Find an entry.
     CAddrInfo* Find(const CNetAddr& addr, int* pnId = NULL);
 
+    //! Find an entry without modifying anything, so it can be used under a shared lock.
+    const CAddrInfo* Lookup(const CNetAddr& addr) const;
+
+    //! Store nId (or -1 to empty it) at a position of the "new" table, keeping vNewSlots in sync.
+    void SetNew(int nUBucket, int nUBucketPos, int nId);
+
+    //! Store nId (or -1 to empty it) at a position of the "tried" table, keeping vTriedSlots in sync.
+    void SetTried(int nKBucket, int nKBucketPos, int nId);
+
     //! find an entry, creating it if necessary.
     //! nTime and nServices of the found node are updated, if necessary.
     CAddrInfo* Create(const CAddress& addr, const CNetAddr& addrSource, int* pnId = NULL);
@@ -232,29 +252,33 @@ protected:
     //! Clear a position in a "new" table. This is the only place where entries are actually deleted.
     void ClearNew(int nUBucket, int nUBucketPos);
 
-    //! Mark an entry "good", possibly moving it from "new" to "tried".
-    void Good_(const CService& addr, int64_t nTime);
+    //! Mark an entry "good", possibly moving it from "new" to "tried". Returns whether an entry was updated.
+    bool Good_(const CService& addr, int64_t nTime);
 
     //! Add an entry to the "new" table.
     bool Add_(const CAddress& addr, const CNetAddr& source, int64_t nTimePenalty);
 
-    //! Mark an entry as attempted to connect.
-    void Attempt_(const CService& addr, int64_t nTime);
+    //! Return whether Add_ would certainly leave the tables unchanged for this address.
+    bool IsRedundant_(const CAddress& addr, int64_t nTimePenalty) const;
+
+    //! Mark an entry as attempted to connect. Returns whether an entry was updated.
+    bool Attempt_(const CService& addr, int64_t nTime);
 
     //! Select an address to connect to.
     //! nUnkBias determines how much to favor new addresses over tried ones (min=0, max=100)
-    CAddrInfo Select_();
+    CAddrInfo Select_() const;
 
-#ifdef DEBUG_ADDRMAN
-    //! Perform consistency check. Returns an error code or zero.
+    //! Perform consistency check. Returns an error code or zero. Only run by Check() under DEBUG_ADDRMAN.
     int Check_();
-#endif
 
     //! Select several addresses at once.
-    void GetAddr_(std::vector<CAddress>& vAddr);
+    void GetAddr_(std::vector<CAddress>& vAddr) const;
 
-    //! Mark an entry as currently-connected-to.
-    void Connected_(const CService& addr, int64_t nTime);
+    //! Mark an entry as currently-connected-to. Returns whether the entry was updated.
+    bool Connected_(const CService& addr, int64_t nTime);
+
+    //! Return whether Connected_ would update the entry.
+    bool NeedsConnected_(const CService& addr, int64_t nTime) const;
 
 public:
     /**
@@ -289,7 +313,7 @@ public:
     template <typename Stream>
     void Serialize(Stream& s, int nType, int nVersionDummy) const
     {
-        LOCK(cs);
+        LOCK_SHARED(cs);
 
         unsigned char nVersion = 1;
         s << nVersion;
@@ -370,7 +394,7 @@ public:
                 int nUBucket = info.GetNewBucket(nKey);
                 int nUBucketPos = info.GetBucketPosition(nKey, true, nUBucket);
                 if (vvNew[nUBucket][nUBucketPos] == -1) {
-                    vvNew[nUBucket][nUBucketPos] = n;
+                    SetNew(nUBucket, nUBucketPos, n);
                     info.nRefCount++;
                 }
             }
@@ -390,7 +414,7 @@ public:
                 vRandom.push_back(nIdCount);
                 mapInfo[nIdCount] = info;
                 mapAddr[info] = nIdCount;
-                vvTried[nKBucket][nKBucketPos] = nIdCount;
+                SetTried(nKBucket, nKBucketPos, nIdCount);
                 nIdCount++;
             } else {
                 nLost++;
@@ -410,7 +434,7 @@ public:
                     int nUBucketPos = info.GetBucketPosition(nKey, true, bucket);
                     if (nVersion == 1 && nUBuckets == ADDRMAN_NEW_BUCKET_COUNT && vvNew[bucket][nUBucketPos] == -1 && info.nRefCount < ADDRMAN_NEW_BUCKETS_PER_ADDRESS) {
                         info.nRefCount++;
-                        vvNew[bucket][nUBucketPos] = nIndex;
+                        SetNew(bucket, nUBucketPos, nIndex);
                     }
                 }
             }
@@ -446,13 +470,17 @@ public:
         for (size_t bucket = 0; bucket < ADDRMAN_NEW_BUCKET_COUNT; bucket++) {
             for (size_t entry = 0; entry < ADDRMAN_BUCKET_SIZE; entry++) {
                 vvNew[bucket][entry] = -1;
+                vvNewSlot[bucket][entry] = -1;
             }
         }
         for (size_t bucket = 0; bucket < ADDRMAN_TRIED_BUCKET_COUNT; bucket++) {
             for (size_t entry = 0; entry < ADDRMAN_BUCKET_SIZE; entry++) {
                 vvTried[bucket][entry] = -1;
+                vvTriedSlot[bucket][entry] = -1;
             }
         }
+        std::vector<int>().swap(vNewSlots);
+        std::vector<int>().swap(vTriedSlots);
 
         nIdCount = 0;
         nTried = 0;
@@ -461,6 +489,7 @@ public:
 
     CAddrMan()
     {
+        nChanges = 0;
         Clear();
     }
 
@@ -470,32 +499,43 @@ public:
     }
 
     //! Return the number of (unique) addresses in all tables.
-    int size()
+    int size() const
     {
+        LOCK_SHARED(cs);
         return vRandom.size();
     }
 
-    //! Consistency check
+    //! Return a counter that increases whenever the serialized tables may have changed.
+    uint64_t GetChangeCount() const
+    {
+        LOCK_SHARED(cs);
+        return nChanges;
+    }
+
+    //! Consistency check. The caller must hold cs exclusively.
     void Check()
     {
 #ifdef DEBUG_ADDRMAN
-        {
-            LOCK(cs);
-            int err;
-            if ((err = Check_()))
-                LogPrintf("ADDRMAN CONSISTENCY CHECK FAILED!!! err=%i\n", err);
-        }
+        int err;
+        if ((err = Check_()))
+            LogPrintf("ADDRMAN CONSISTENCY CHECK FAILED!!! err=%i\n", err);
 #endif
     }
 
     //! Add a single address.
     bool Add(const CAddress& addr, const CNetAddr& source, int64_t nTimePenalty = 0)
     {
+        {
+            LOCK_SHARED(cs);
+            if (IsRedundant_(addr, nTimePenalty))
+                return false;
+        }
         bool fRet = false;
         {
             LOCK(cs);
             Check();
             fRet |= Add_(addr, source, nTimePenalty);
+            nChanges++;
             Check();
         }
         if (fRet)
@@ -506,12 +546,24 @@ public:
     //! Add multiple addresses.
     bool Add(const std::vector<CAddress>& vAddr, const CNetAddr& source, int64_t nTimePenalty = 0)
     {
+        // Most addresses relayed to us are already known; filter those out under the
+        // shared lock so that addr floods do not serialize on the exclusive one.
+        std::vector<CAddress> vAddrUseful;
+        {
+            LOCK_SHARED(cs);
+            for (std::vector<CAddress>::const_iterator it = vAddr.begin(); it != vAddr.end(); it++)
+                if (!IsRedundant_(*it, nTimePenalty))
+                    vAddrUseful.push_back(*it);
+        }
+        if (vAddrUseful.empty())
+            return false;
         int nAdd = 0;
         {
             LOCK(cs);
             Check();
-            for (std::vector<CAddress>::const_iterator it = vAddr.begin(); it != vAddr.end(); it++)
+            for (std::vector<CAddress>::const_iterator it = vAddrUseful.begin(); it != vAddrUseful.end(); it++)
                 nAdd += Add_(*it, source, nTimePenalty) ? 1 : 0;
+            nChanges++;
             Check();
         }
         if (nAdd)
@@ -525,7 +577,8 @@ public:
         {
             LOCK(cs);
             Check();
-            Good_(addr, nTime);
+            if (Good_(addr, nTime))
+                nChanges++;
             Check();
         }
     }
@@ -536,7 +589,8 @@ public:
         {
             LOCK(cs);
             Check();
-            Attempt_(addr, nTime);
+            if (Attempt_(addr, nTime))
+                nChanges++;
             Check();
         }
     }
@@ -545,38 +599,37 @@ public:
      * Choose an address to connect to.
      * nUnkBias determines how much "new" entries are favored over "tried" ones (0-100).
      */
-    CAddrInfo Select()
+    CAddrInfo Select() const
     {
-        CAddrInfo addrRet;
-        {
-            LOCK(cs);
-            Check();
-            addrRet = Select_();
-            Check();
-        }
-        return addrRet;
+        LOCK_SHARED(cs);
+        return Select_();
     }
 
     //! Return a bunch of addresses, selected at random.
-    std::vector<CAddress> GetAddr()
+    std::vector<CAddress> GetAddr() const
     {
-        Check();
         std::vector<CAddress> vAddr;
         {
-            LOCK(cs);
+            LOCK_SHARED(cs);
             GetAddr_(vAddr);
         }
-        Check();
         return vAddr;
     }
 
     //! Mark an entry as currently-connected-to.
     void Connected(const CService& addr, int64_t nTime = GetAdjustedTime())
     {
+        // nTime is only refreshed every 20 minutes, so most calls need no exclusive lock
+        {
+            LOCK_SHARED(cs);
+            if (!NeedsConnected_(addr, nTime))
+                return;
+        }
         {
             LOCK(cs);
             Check();
-            Connected_(addr, nTime);
+            if (Connected_(addr, nTime))
+                nChanges++;
             Check();
         }
     }
@@ -261,7 +261,9 @@ struct zero_after_free_allocator : public std::allocator<T> {
 // This is exactly like std::string, but with a custom allocator.
 typedef std::basic_string<char, std::char_traits<char>, secure_allocator<char> > SecureString;
 typedef std::vector<unsigned char, secure_allocator<unsigned char> > SecureVector;
+// Byte-vector for public data (network messages, blocks, chainstate records).
+typedef std::vector<char> CSerializeData;
 // Byte-vector that clears its contents before deletion.
-typedef std::vector<char, zero_after_free_allocator<char> > CSerializeData;
+typedef std::vector<char, zero_after_free_allocator<char> > CSecureSerializeData;
 
 #endif // BITCOIN_ALLOCATORS_H
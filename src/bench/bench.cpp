@@ -0,0 +1,114 @@
+// Copyright (c) 2015-2016 The Bitcoin Core developers
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include <chrono>
+#include <iostream>
+#include <regex>
+
+#include <univalue.h>
+
+using namespace benchmark;
+
+BenchRunner::BenchmarkMap& BenchRunner::benchmarks()
+{
+    // Constructed on first use so registration from other translation units
+    // does not depend on static initialization order
+    static BenchmarkMap benchmarks_map;
+    return benchmarks_map;
+}
+
+static double gettimedouble()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+BenchRunner::BenchRunner(std::string name, BenchFunction func)
+{
+    benchmarks().insert(std::make_pair(name, func));
+}
+
+std::vector<std::string> BenchRunner::List()
+{
+    std::vector<std::string> vNames;
+    for (BenchmarkMap::iterator it = benchmarks().begin(); it != benchmarks().end(); ++it)
+        vNames.push_back(it->first);
+    return vNames;
+}
+
+void BenchRunner::RunAll(const std::string& filter, double elapsedTimeForOne, bool fJson)
+{
+    std::regex reFilter(filter);
+    UniValue results(UniValue::VARR);
+
+    if (!fJson)
+        std::cout << "#Benchmark" << "," << "count" << "," << "min" << "," << "max" << "," << "average" << std::endl;
+
+    for (BenchmarkMap::iterator it = benchmarks().begin(); it != benchmarks().end(); ++it) {
+        if (!std::regex_match(it->first, reFilter))
+            continue;
+
+        State state(it->first, elapsedTimeForOne);
+        BenchFunction& func = it->second;
+        func(state);
+
+        Result result = state.GetResult();
+        if (fJson) {
+            UniValue entry(UniValue::VOBJ);
+            entry.push_back(Pair("name", result.name));
+            entry.push_back(Pair("count", result.count));
+            entry.push_back(Pair("min", result.minTime));
+            entry.push_back(Pair("max", result.maxTime));
+            entry.push_back(Pair("average", result.average));
+            results.push_back(entry);
+        } else {
+            std::cout << result.name << "," << result.count << "," << result.minTime << "," << result.maxTime << "," << result.average << std::endl;
+        }
+    }
+
+    if (fJson)
+        std::cout << results.write(4) << std::endl;
+}
+
+bool State::KeepRunning()
+{
+    double now;
+    if (count == 0) {
+        lastTime = beginTime = now = gettimedouble();
+    } else {
+        // timeCheckCount avoids reading the clock on every iteration, so
+        // benchmarks that run very quickly still get consistent results
+        if ((count + 1) % timeCheckCount != 0) {
+            ++count;
+            return true; // keep going
+        }
+        now = gettimedouble();
+        double elapsedOne = (now - lastTime) / timeCheckCount;
+        if (elapsedOne < minTime) minTime = elapsedOne;
+        if (elapsedOne > maxTime) maxTime = elapsedOne;
+        if (elapsedOne * timeCheckCount < maxElapsed / 16) timeCheckCount *= 2;
+    }
+    lastTime = now;
+    ++count;
+
+    if (now - beginTime < maxElapsed) return true; // Keep going
+
+    --count;
+    totalTime = now - beginTime;
+
+    return false;
+}
+
+Result State::GetResult() const
+{
+    Result result;
+    result.name = name;
+    result.count = count;
+    result.average = count > 0 ? totalTime / count : 0;
+    result.minTime = count > 0 ? minTime : 0;
+    result.maxTime = count > 0 ? maxTime : 0;
+    return result;
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2015 The Bitcoin Core developers
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "checkpoints.h"
+#include "crypto/sha256.h"
+#include "guiinterface.h"
+#include "key.h"
+#include "main.h"
+#include "random.h"
+#include "util.h"
+
+#include <iostream>
+
+CClientUIInterface uiInterface;
+CWallet* pwalletMain;
+
+[[noreturn]] void Shutdown(void* parg)
+{
+    exit(0);
+}
+
+void StartShutdown()
+{
+    exit(0);
+}
+
+bool ShutdownRequested()
+{
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    ParseParameters(argc, argv);
+
+    if (mapArgs.count("-?") || mapArgs.count("-help")) {
+        std::string strUsage = "Usage: bench_dogecash [options]\n";
+        strUsage += HelpMessageOpt("-?", "This help message");
+        strUsage += HelpMessageOpt("-filter=<regex>", "Only run benchmarks whose name matches the regular expression (default: .*)");
+        strUsage += HelpMessageOpt("-time=<n>", "Seconds to spend on each benchmark (default: 1.0)");
+        strUsage += HelpMessageOpt("-json", "Print the results as a JSON array instead of CSV, for regression tracking");
+        strUsage += HelpMessageOpt("-list", "List the available benchmarks and exit");
+        std::cout << strUsage;
+        return 0;
+    }
+
+    if (GetBoolArg("-list", false)) {
+        for (const std::string& strName : benchmark::BenchRunner::List())
+            std::cout << strName << std::endl;
+        return 0;
+    }
+
+    RandomInit();
+    SHA256AutoDetect();
+    ECC_Start();
+    ECCVerifyHandle globalVerifyHandle;
+    SetupEnvironment();
+    fPrintToDebugLog = false; // don't want to write to debug.log file
+
+    // Validate the synthetic blocks the way a fresh node would: against the
+    // unit test chain, with scripts checked and without proof of work
+    SelectParams(CBaseChainParams::UNITTEST);
+    ModifiableParams()->setSkipProofOfWorkCheck(true);
+    Checkpoints::fEnabled = false;
+
+    benchmark::BenchRunner::RunAll(GetArg("-filter", ".*"), atof(GetArg("-time", "1.0").c_str()), GetBoolArg("-json", false));
+
+    ECC_Stop();
+}
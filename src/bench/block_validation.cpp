@@ -0,0 +1,118 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "coins.h"
+#include "consensus/merkle.h"
+#include "key.h"
+#include "keystore.h"
+#include "main.h"
+#include "primitives/block.h"
+#include "script/sign.h"
+#include "script/standard.h"
+
+#include <assert.h>
+
+/* Number of signed pay-to-pubkey-hash spends in the synthetic block */
+static const int BLOCK_SPEND_COUNT = 1000;
+
+/**
+ * Build a block on top of the genesis block that spends BLOCK_SPEND_COUNT
+ * outputs of a single funding transaction, and add that transaction to coins.
+ */
+static void BuildSyntheticBlock(CBlock& block, CCoinsViewCache& coins)
+{
+    CBasicKeyStore keystore;
+    CKey key;
+    key.MakeNewKey(true);
+    keystore.AddKey(key);
+    const CScript scriptPubKey = GetScriptForDestination(key.GetPubKey().GetID());
+
+    CMutableTransaction txFunding;
+    txFunding.vin.resize(1);
+    txFunding.vin[0].prevout = COutPoint(GetRandHash(), 0);
+    for (int i = 0; i < BLOCK_SPEND_COUNT; i++)
+        txFunding.vout.push_back(CTxOut(COIN, scriptPubKey));
+    const CTransaction txFrom(txFunding);
+    coins.ModifyCoins(txFrom.GetHash())->FromTx(txFrom, 0);
+    coins.SetBestBlock(Params().HashGenesisBlock());
+
+    const CAmount nFee = 1000;
+    CMutableTransaction txCoinBase;
+    txCoinBase.vin.resize(1);
+    txCoinBase.vin[0].prevout.SetNull();
+    txCoinBase.vin[0].scriptSig = CScript() << 1 << OP_0;
+    txCoinBase.vout.push_back(CTxOut(nFee * BLOCK_SPEND_COUNT, scriptPubKey));
+
+    block.SetNull();
+    block.nVersion = 3;
+    block.hashPrevBlock = Params().HashGenesisBlock();
+    block.nTime = Params().GenesisBlock().nTime + 60;
+    block.nBits = Params().GenesisBlock().nBits;
+    block.vtx.push_back(CTransaction(txCoinBase));
+
+    for (int i = 0; i < BLOCK_SPEND_COUNT; i++) {
+        CMutableTransaction tx;
+        tx.vin.push_back(CTxIn(COutPoint(txFrom.GetHash(), i)));
+        tx.vout.push_back(CTxOut(COIN - nFee, scriptPubKey));
+        bool fSigned = SignSignature(keystore, txFrom, tx, 0);
+        assert(fSigned);
+        block.vtx.push_back(CTransaction(tx));
+    }
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+}
+
+// Context free checks, including the merkle root and every transaction
+static void CheckBlock_1000tx(benchmark::State& state)
+{
+    CCoinsView viewDummy;
+    CCoinsViewCache coins(&viewDummy);
+    CBlock block;
+    BuildSyntheticBlock(block, coins);
+
+    while (state.KeepRunning()) {
+        CValidationState validationState;
+        // fCheckPOW is left on so the header hash is part of the measurement;
+        // the unit test chain skips the target comparison itself
+        bool fValid = CheckBlock(block, validationState, true, true, false);
+        assert(fValid);
+    }
+}
+
+// Input lookups, script verification and coin updates for one block, the way
+// TestBlockValidity runs it (fJustCheck, so nothing is written to disk)
+static void ConnectBlock_1000tx(benchmark::State& state)
+{
+    CCoinsView viewDummy;
+    CCoinsViewCache coins(&viewDummy);
+    CBlock block;
+    BuildSyntheticBlock(block, coins);
+
+    LOCK(cs_main);
+    // Connect on top of a genesis-only active chain; CheckInputs also looks the
+    // spend height up in mapBlockIndex through the view's best block
+    CBlockIndex indexGenesis(Params().GenesisBlock());
+    BlockMap::iterator mi = mapBlockIndex.insert(std::make_pair(Params().HashGenesisBlock(), &indexGenesis)).first;
+    indexGenesis.phashBlock = &mi->first;
+    chainActive.SetTip(&indexGenesis);
+    const uint256 hashBlock = block.GetHash();
+    CBlockIndex index(block);
+    index.phashBlock = &hashBlock;
+    index.pprev = &indexGenesis;
+    index.nHeight = 1;
+
+    while (state.KeepRunning()) {
+        CCoinsViewCache view(&coins);
+        CValidationState validationState;
+        bool fValid = ConnectBlock(block, validationState, &index, view, true, true);
+        assert(fValid);
+    }
+    chainActive.SetTip(NULL);
+    mapBlockIndex.erase(mi);
+}
+
+BENCHMARK(CheckBlock_1000tx);
+BENCHMARK(ConnectBlock_1000tx);
@@ -0,0 +1,72 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "coins.h"
+#include "random.h"
+#include "script/standard.h"
+
+#include <assert.h>
+#include <vector>
+
+/* Number of transactions with unspent outputs in the parent cache */
+static const int COINS_CACHE_ENTRIES = 100000;
+/* Number of lookups per iteration, roughly the inputs of a full block */
+static const int COINS_LOOKUPS = 2000;
+
+static void FillCoinsCache(CCoinsViewCache& coins, std::vector<uint256>& vTxids)
+{
+    FastRandomContext rng(true);
+    for (int i = 0; i < COINS_CACHE_ENTRIES; i++) {
+        const uint256 txid = rng.rand256();
+        CCoinsModifier modifier = coins.ModifyCoins(txid);
+        modifier->nHeight = i;
+        modifier->nVersion = 1;
+        modifier->vout.resize(2);
+        modifier->vout[0] = CTxOut(COIN, GetScriptForDestination(CKeyID(uint160(rng.randbytes(20)))));
+        modifier->vout[1] = CTxOut(COIN, GetScriptForDestination(CKeyID(uint160(rng.randbytes(20)))));
+        vTxids.push_back(txid);
+    }
+}
+
+// A block's worth of input lookups through a fresh child cache, as in ConnectBlock
+static void CoinsViewCacheAccessCoins(benchmark::State& state)
+{
+    CCoinsView viewDummy;
+    CCoinsViewCache coins(&viewDummy);
+    std::vector<uint256> vTxids;
+    FillCoinsCache(coins, vTxids);
+
+    FastRandomContext rng(true);
+    while (state.KeepRunning()) {
+        CCoinsViewCache view(&coins);
+        for (int i = 0; i < COINS_LOOKUPS; i++) {
+            const CCoins* pcoins = view.AccessCoins(vTxids[rng.randrange(vTxids.size())]);
+            assert(pcoins);
+        }
+    }
+}
+
+// Half hits, half misses straight against the populated cache, as in mempool acceptance
+static void CoinsViewCacheHaveCoins(benchmark::State& state)
+{
+    CCoinsView viewDummy;
+    CCoinsViewCache coins(&viewDummy);
+    std::vector<uint256> vTxids;
+    FillCoinsCache(coins, vTxids);
+
+    FastRandomContext rng(true);
+    while (state.KeepRunning()) {
+        for (int i = 0; i < COINS_LOOKUPS; i++) {
+            if (i % 2)
+                coins.HaveCoins(vTxids[rng.randrange(vTxids.size())]);
+            else
+                coins.HaveCoins(rng.rand256());
+        }
+    }
+}
+
+BENCHMARK(CoinsViewCacheAccessCoins);
+BENCHMARK(CoinsViewCacheHaveCoins);
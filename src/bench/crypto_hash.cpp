@@ -0,0 +1,91 @@
+// Copyright (c) 2016 The Bitcoin Core developers
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "crypto/sha256.h"
+#include "hash.h"
+#include "uint256.h"
+
+#include <vector>
+
+/* Number of bytes to hash per iteration */
+static const uint64_t BUFFER_SIZE = 1000 * 1000;
+
+/* Number of 64-byte inputs hashed per SHA256D64 iteration (one Merkle level of a large block) */
+static const size_t D64_BLOCKS = 1024;
+
+static void SHA256(benchmark::State& state, sha256_implementation::UseImplementation impl)
+{
+    SHA256AutoDetect(impl);
+    uint8_t hash[CSHA256::OUTPUT_SIZE];
+    std::vector<uint8_t> in(BUFFER_SIZE, 0);
+    while (state.KeepRunning())
+        CSHA256().Write(in.data(), in.size()).Finalize(hash);
+    SHA256AutoDetect();
+}
+
+static void SHA256_32b(benchmark::State& state, sha256_implementation::UseImplementation impl)
+{
+    SHA256AutoDetect(impl);
+    std::vector<uint8_t> in(32, 0);
+    while (state.KeepRunning()) {
+        for (int i = 0; i < 100000; i++) {
+            CSHA256().Write(in.data(), in.size()).Finalize(in.data());
+        }
+    }
+    SHA256AutoDetect();
+}
+
+static void SHA256D64_1024(benchmark::State& state, sha256_implementation::UseImplementation impl)
+{
+    SHA256AutoDetect(impl);
+    std::vector<uint8_t> in(64 * D64_BLOCKS, 0);
+    while (state.KeepRunning())
+        SHA256D64(in.data(), in.data(), D64_BLOCKS);
+    SHA256AutoDetect();
+}
+
+static void DoubleSHA256_64b_loop(benchmark::State& state)
+{
+    // What ComputeMerkleRoot did before SHA256D64: one CHash256 per pair
+    std::vector<uint8_t> in(64 * D64_BLOCKS, 0);
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < D64_BLOCKS; i++) {
+            CHash256().Write(in.data() + 64 * i, 64).Finalize(in.data() + 32 * i);
+        }
+    }
+}
+
+static void HashQuark_80b(benchmark::State& state)
+{
+    // Block header sized input, as hashed by CBlockHeader::GetHash() before zerocoin
+    std::vector<uint8_t> in(80, 0);
+    uint256 hash;
+    while (state.KeepRunning()) {
+        hash = HashQuark(in.begin(), in.end());
+        in[0] = hash.begin()[0];
+    }
+}
+
+static void SHA256_STANDARD(benchmark::State& state) { SHA256(state, sha256_implementation::STANDARD); }
+static void SHA256_SHANI(benchmark::State& state) { SHA256(state, sha256_implementation::USE_SHANI); }
+static void SHA256_32b_STANDARD(benchmark::State& state) { SHA256_32b(state, sha256_implementation::STANDARD); }
+static void SHA256_32b_SHANI(benchmark::State& state) { SHA256_32b(state, sha256_implementation::USE_SHANI); }
+static void SHA256D64_1024_STANDARD(benchmark::State& state) { SHA256D64_1024(state, sha256_implementation::STANDARD); }
+static void SHA256D64_1024_SSE4(benchmark::State& state) { SHA256D64_1024(state, sha256_implementation::USE_SSE4); }
+static void SHA256D64_1024_AVX2(benchmark::State& state) { SHA256D64_1024(state, sha256_implementation::USE_AVX2); }
+static void SHA256D64_1024_SHANI(benchmark::State& state) { SHA256D64_1024(state, sha256_implementation::USE_SHANI); }
+
+BENCHMARK(HashQuark_80b);
+BENCHMARK(SHA256_STANDARD);
+BENCHMARK(SHA256_SHANI);
+BENCHMARK(SHA256_32b_STANDARD);
+BENCHMARK(SHA256_32b_SHANI);
+BENCHMARK(SHA256D64_1024_STANDARD);
+BENCHMARK(SHA256D64_1024_SSE4);
+BENCHMARK(SHA256D64_1024_AVX2);
+BENCHMARK(SHA256D64_1024_SHANI);
+BENCHMARK(DoubleSHA256_64b_loop);
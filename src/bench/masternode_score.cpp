@@ -0,0 +1,45 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chain.h"
+#include "main.h"
+#include "masternode.h"
+#include "random.h"
+
+#include <vector>
+
+/* Length of the fake active chain the scores are computed against */
+static const int SCORE_CHAIN_LENGTH = 1000;
+/* Masternodes ranked per iteration, as in CMasternodeMan::GetMasternodeRank */
+static const int SCORE_MASTERNODE_COUNT = 1000;
+
+static void MasternodeCalculateScore(benchmark::State& state)
+{
+    std::vector<uint256> vHashes(SCORE_CHAIN_LENGTH);
+    std::vector<CBlockIndex> vIndex(SCORE_CHAIN_LENGTH);
+    for (int i = 0; i < SCORE_CHAIN_LENGTH; i++) {
+        vHashes[i] = GetRandHash();
+        vIndex[i].phashBlock = &vHashes[i];
+        vIndex[i].nHeight = i;
+        vIndex[i].pprev = i > 0 ? &vIndex[i - 1] : NULL;
+    }
+
+    std::vector<CMasternode> vMasternodes(SCORE_MASTERNODE_COUNT);
+    for (CMasternode& mn : vMasternodes)
+        mn.vin = CTxIn(COutPoint(GetRandHash(), 0));
+
+    LOCK(cs_main);
+    chainActive.SetTip(&vIndex.back());
+    int64_t nBlockHeight = 2;
+    while (state.KeepRunning()) {
+        for (CMasternode& mn : vMasternodes)
+            mn.CalculateScore(1, nBlockHeight);
+        nBlockHeight = nBlockHeight % (SCORE_CHAIN_LENGTH - 1) + 2;
+    }
+    chainActive.SetTip(NULL);
+}
+
+BENCHMARK(MasternodeCalculateScore);
@@ -0,0 +1,69 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "main.h"
+#include "random.h"
+#include "txmempool.h"
+
+#include <list>
+#include <vector>
+
+/* Number of transactions added to the pool per iteration, roughly one full block */
+static const int MEMPOOL_TX_COUNT = 1000;
+
+static void BuildTransactions(std::vector<CTransaction>& vtx)
+{
+    FastRandomContext rng(true);
+    for (int i = 0; i < MEMPOOL_TX_COUNT; i++) {
+        CMutableTransaction tx;
+        // Every other transaction spends the previous one, so mapNextTx sees in-pool parents
+        tx.vin.resize(2);
+        tx.vin[0].prevout = COutPoint(rng.rand256(), 0);
+        tx.vin[0].scriptSig = CScript() << std::vector<unsigned char>(72, 0) << std::vector<unsigned char>(33, 0);
+        tx.vin[1].prevout = (i % 2 && !vtx.empty()) ? COutPoint(vtx.back().GetHash(), 1) : COutPoint(rng.rand256(), 1);
+        tx.vin[1].scriptSig = tx.vin[0].scriptSig;
+        tx.vout.resize(2);
+        tx.vout[0] = CTxOut(COIN, CScript() << OP_TRUE);
+        tx.vout[1] = CTxOut(COIN, CScript() << OP_TRUE);
+        vtx.push_back(CTransaction(tx));
+    }
+}
+
+static void AddAll(CTxMemPool& pool, const std::vector<CTransaction>& vtx)
+{
+    for (const CTransaction& tx : vtx)
+        pool.addUnchecked(tx.GetHash(), CTxMemPoolEntry(tx, 10000, GetTime(), 1.0, 1));
+}
+
+static void MempoolAddUnchecked(benchmark::State& state)
+{
+    std::vector<CTransaction> vtx;
+    BuildTransactions(vtx);
+
+    CTxMemPool pool(::minRelayTxFee);
+    while (state.KeepRunning()) {
+        AddAll(pool, vtx);
+        pool.clear();
+    }
+}
+
+// The pool is refilled each iteration, so this measures addUnchecked plus removeForBlock
+static void MempoolRemoveForBlock(benchmark::State& state)
+{
+    std::vector<CTransaction> vtx;
+    BuildTransactions(vtx);
+
+    CTxMemPool pool(::minRelayTxFee);
+    unsigned int nHeight = 1;
+    while (state.KeepRunning()) {
+        AddAll(pool, vtx);
+        std::list<CTransaction> conflicts;
+        pool.removeForBlock(vtx, nHeight++, conflicts);
+    }
+}
+
+BENCHMARK(MempoolAddUnchecked);
+BENCHMARK(MempoolRemoveForBlock);
@@ -0,0 +1,64 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "primitives/block.h"
+#include "random.h"
+#include "streams.h"
+#include "version.h"
+
+#include <assert.h>
+
+/* Transactions in the block that is round-tripped */
+static const int SERIALIZE_TX_COUNT = 1000;
+
+static CMutableTransaction BuildTransaction(FastRandomContext& rng)
+{
+    // Shaped like a two input, two output pay-to-pubkey-hash spend
+    CMutableTransaction tx;
+    tx.vin.resize(2);
+    tx.vout.resize(2);
+    for (CTxIn& txin : tx.vin) {
+        txin.prevout = COutPoint(rng.rand256(), 0);
+        txin.scriptSig = CScript() << rng.randbytes(72) << rng.randbytes(33);
+    }
+    for (CTxOut& txout : tx.vout)
+        txout = CTxOut(COIN, CScript() << OP_DUP << OP_HASH160 << rng.randbytes(20) << OP_EQUALVERIFY << OP_CHECKSIG);
+    return tx;
+}
+
+static void SerializeRoundTripTransaction(benchmark::State& state)
+{
+    FastRandomContext rng(true);
+    const CTransaction tx(BuildTransaction(rng));
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    while (state.KeepRunning()) {
+        ss << tx;
+        CTransaction txRead;
+        ss >> txRead;
+        assert(ss.empty());
+    }
+}
+
+static void SerializeRoundTripBlock(benchmark::State& state)
+{
+    FastRandomContext rng(true);
+    CBlock block;
+    block.nVersion = 3;
+    for (int i = 0; i < SERIALIZE_TX_COUNT; i++)
+        block.vtx.push_back(CTransaction(BuildTransaction(rng)));
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    while (state.KeepRunning()) {
+        ss << block;
+        CBlock blockRead;
+        ss >> blockRead;
+        assert(ss.empty());
+    }
+}
+
+BENCHMARK(SerializeRoundTripTransaction);
+BENCHMARK(SerializeRoundTripBlock);
@@ -0,0 +1,74 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "key.h"
+#include "primitives/transaction.h"
+#include "random.h"
+#include "script/sigcache.h"
+
+#include <assert.h>
+#include <vector>
+
+/* Distinct signatures checked per iteration */
+static const int SIGCACHE_SIGNATURES = 100;
+
+struct SignedHash {
+    uint256 hash;
+    std::vector<unsigned char> vchSig;
+};
+
+static void SignHashes(const CKey& key, std::vector<SignedHash>& vSigned)
+{
+    for (int i = 0; i < SIGCACHE_SIGNATURES; i++) {
+        SignedHash entry;
+        entry.hash = GetRandHash();
+        bool fSigned = key.Sign(entry.hash, entry.vchSig);
+        assert(fSigned);
+        vSigned.push_back(entry);
+    }
+}
+
+// Signatures already seen in the mempool, checked again when the block arrives
+static void SigCacheHit(benchmark::State& state)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    std::vector<SignedHash> vSigned;
+    SignHashes(key, vSigned);
+
+    const CTransaction txTo;
+    CachingTransactionSignatureChecker checker(&txTo, 0, true);
+    for (const SignedHash& entry : vSigned) {
+        bool fValid = checker.VerifySignature(entry.vchSig, pubkey, entry.hash);
+        assert(fValid);
+    }
+
+    while (state.KeepRunning()) {
+        for (const SignedHash& entry : vSigned)
+            checker.VerifySignature(entry.vchSig, pubkey, entry.hash);
+    }
+}
+
+// Cache lookup plus the full ECDSA verification, without storing the result
+static void SigCacheMiss(benchmark::State& state)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    std::vector<SignedHash> vSigned;
+    SignHashes(key, vSigned);
+
+    const CTransaction txTo;
+    CachingTransactionSignatureChecker checker(&txTo, 0, false);
+    while (state.KeepRunning()) {
+        for (const SignedHash& entry : vSigned)
+            checker.VerifySignature(entry.vchSig, pubkey, entry.hash);
+    }
+}
+
+BENCHMARK(SigCacheHit);
+BENCHMARK(SigCacheMiss);
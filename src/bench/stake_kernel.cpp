@@ -0,0 +1,69 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "kernel.h"
+#include "random.h"
+#include "stakeinput.h"
+
+#include <limits>
+
+/** Stake input with fixed values, so the kernel hash is measured without a wallet or disk lookups */
+class CBenchStakeInput : public CStakeInput
+{
+private:
+    COutPoint prevout;
+    CAmount nValue;
+
+public:
+    CBenchStakeInput(CBlockIndex* pindex, const COutPoint& prevoutIn, CAmount nValueIn) : prevout(prevoutIn), nValue(nValueIn)
+    {
+        pindexFrom = pindex;
+    }
+
+    CBlockIndex* GetIndexFrom() override { return pindexFrom; }
+    bool CreateTxIn(CWallet* pwallet, CTxIn& txIn, uint256 hashTxOut = 0) override { return false; }
+    bool GetTxFrom(CTransaction& tx) override { return false; }
+    CAmount GetValue() override { return nValue; }
+    bool CreateTxOuts(CWallet* pwallet, std::vector<CTxOut>& vout, CAmount nTotal) override { return false; }
+    bool GetModifier(uint64_t& nStakeModifier) override
+    {
+        nStakeModifier = pindexFrom->nStakeModifier;
+        return true;
+    }
+    bool Iszdogec() override { return false; }
+    CDataStream GetUniqueness() override
+    {
+        // Same layout as CDOGECStake: the output index, then the funding tx hash
+        CDataStream ss(SER_NETWORK, 0);
+        ss << prevout.n << prevout.hash;
+        return ss;
+    }
+    uint256 GetSerialHash() const override { return 0; }
+};
+
+// One kernel hash per try, the way the staker scans timestamps in StakeV1
+static void StakeKernelHash(benchmark::State& state)
+{
+    CBlockIndex indexFrom;
+    indexFrom.nHeight = 1000;
+    indexFrom.nTime = Params().GenesisBlock().nTime;
+    indexFrom.nStakeModifier = GetRand(std::numeric_limits<uint64_t>::max());
+
+    CBlockIndex indexPrev;
+    indexPrev.nHeight = 2000;
+    indexPrev.nTime = indexFrom.nTime + 60 * 60 * 24;
+    indexPrev.nStakeModifierV2 = GetRandHash();
+
+    CBenchStakeInput stake(&indexFrom, COutPoint(GetRandHash(), 1), 10000 * COIN);
+    const unsigned int nBits = Params().GenesisBlock().nBits;
+    unsigned int nTimeTx = indexPrev.nTime + 180;
+    uint256 hashProofOfStake;
+    while (state.KeepRunning())
+        CheckStakeKernelHash(&indexPrev, nBits, &stake, nTimeTx--, hashProofOfStake);
+}
+
+BENCHMARK(StakeKernelHash);
@@ -0,0 +1,59 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "libzerocoin/Accumulator.h"
+#include "libzerocoin/Coin.h"
+#include "libzerocoin/CoinSpend.h"
+
+#include <assert.h>
+#include <vector>
+
+using namespace libzerocoin;
+
+/* Number of coins accumulated alongside the one being spent */
+static const int ACCUMULATED_COIN_COUNT = 10;
+
+// The modular exponentiation ComputeAccumulatedCoins does once per mint
+static void AccumulatorIncrement(benchmark::State& state)
+{
+    ZerocoinParams* params = Params().Zerocoin_Params(false);
+    PrivateCoin coin(params, CoinDenomination::ZQ_ONE);
+    const CBigNum bnValue = coin.getPublicCoin().getValue();
+
+    Accumulator accumulator(params, CoinDenomination::ZQ_ONE);
+    while (state.KeepRunning())
+        accumulator.increment(bnValue);
+}
+
+// Full proof verification of a single spend, as done for every zerocoin spend input
+static void CoinSpendVerify(benchmark::State& state)
+{
+    ZerocoinParams* params = Params().Zerocoin_Params(false);
+    const CoinDenomination denom = CoinDenomination::ZQ_ONE;
+
+    std::vector<PrivateCoin> vCoins;
+    for (int i = 0; i < ACCUMULATED_COIN_COUNT; i++)
+        vCoins.emplace_back(params, denom);
+
+    Accumulator accumulator(params, denom);
+    AccumulatorWitness witness(params, accumulator, vCoins[0].getPublicCoin());
+    for (int i = 0; i < ACCUMULATED_COIN_COUNT; i++) {
+        accumulator += vCoins[i].getPublicCoin();
+        if (i != 0)
+            witness += vCoins[i].getPublicCoin();
+    }
+
+    CoinSpend spend(params, params, vCoins[0], accumulator, 0, witness, 0, SpendType::SPEND);
+    bool fValid = spend.Verify(accumulator);
+    assert(fValid);
+
+    while (state.KeepRunning())
+        spend.Verify(accumulator);
+}
+
+BENCHMARK(AccumulatorIncrement);
+BENCHMARK(CoinSpendVerify);
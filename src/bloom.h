@@ -8,12 +8,12 @@
 
 #include "libzerocoin/bignum.h"
 #include "serialize.h"
+#include "uint256.h"
 
 #include <vector>
 
 class COutPoint;
 class CTransaction;
-class uint256;
 
 //! 20,000 items with fp rate < 0.1% or 10,000 items and <0.0001%
 static const unsigned int MAX_BLOOM_FILTER_SIZE = 36000; // bytes
@@ -31,6 +31,36 @@ enum bloomflags {
     BLOOM_UPDATE_MASK = 3,
 };
 
+/**
+ * The elements of a transaction that a bloom filter is matched against: its
+ * hash, the data pushed by its scripts and the outpoints it spends.
+ *
+ * Extracting them takes parsing every script, so when serving a block to many
+ * filtering peers it is done once per transaction and shared by all filters.
+ */
+class CBloomTxData
+{
+public:
+    struct Output {
+        //! Non-empty data elements of the scriptPubKey
+        std::vector<std::vector<unsigned char> > vElements;
+        //! Whether the output is pay-to-pubkey or multisig, for BLOOM_UPDATE_P2PUBKEY_ONLY
+        bool fPubKeyOrMultisig;
+    };
+    struct Input {
+        //! Serialized outpoint the input spends
+        std::vector<unsigned char> vPrevout;
+        //! Non-empty data elements of the scriptSig
+        std::vector<std::vector<unsigned char> > vElements;
+    };
+
+    uint256 hash;
+    std::vector<Output> vOutputs;
+    std::vector<Input> vInputs;
+
+    explicit CBloomTxData(const CTransaction& tx);
+};
+
 /**
  * BloomFilter is a probabilistic filter which SPV clients provide
  * so that we can filter the transactions we sends them.
@@ -52,7 +82,9 @@ private:
     unsigned int nTweak;
     unsigned char nFlags;
 
-    unsigned int Hash(unsigned int nHashNum, const std::vector<unsigned char>& vDataToHash) const;
+    unsigned int Hash(unsigned int nHashNum, const unsigned char* pData, size_t nSize) const;
+    void insert(const unsigned char* pData, size_t nSize);
+    bool contains(const unsigned char* pData, size_t nSize) const;
 
 public:
     /**
@@ -99,6 +131,7 @@ public:
 
     //! Also adds any outputs which match the filter to the filter (to match their spending txes)
     bool IsRelevantAndUpdate(const CTransaction& tx);
+    bool IsRelevantAndUpdate(const CBloomTxData& txData);
 
     //! Checks for empty and full filters to avoid wasting cpu
     void UpdateEmptyFull();
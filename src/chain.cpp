@@ -8,6 +8,26 @@
 
 using namespace std;
 
+/**
+ * CBlockIndexArena implementation
+ */
+CBlockIndex* CBlockIndexArena::Allocate()
+{
+    if (nUsed == nChunkSize) {
+        vChunks.push_back(new CBlockIndex[nChunkSize]);
+        nUsed = 0;
+    }
+    return &vChunks.back()[nUsed++];
+}
+
+void CBlockIndexArena::Clear()
+{
+    for (CBlockIndex* pchunk : vChunks)
+        delete[] pchunk;
+    vChunks.clear();
+    nUsed = nChunkSize;
+}
+
 /**
  * CChain implementation
  */
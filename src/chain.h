@@ -17,6 +17,9 @@
 #include "util.h"
 #include "libzerocoin/Denominations.h"
 
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
 #include <boost/foreach.hpp>
@@ -103,6 +106,169 @@ enum BlockStatus {
     BLOCK_FAILED_MASK = BLOCK_FAILED_VALID | BLOCK_FAILED_CHILD,
 };
 
+//! Number of zerocoin denominations tracked per block index entry
+static const unsigned int ZEROCOIN_DENOM_COUNT = 8;
+
+/** Position of a denomination in libzerocoin::zerocoinDenomList, or -1 for anything else */
+inline int ZerocoinDenominationIndex(libzerocoin::CoinDenomination denom)
+{
+    switch (denom) {
+    case libzerocoin::ZQ_ONE: return 0;
+    case libzerocoin::ZQ_FIVE: return 1;
+    case libzerocoin::ZQ_TEN: return 2;
+    case libzerocoin::ZQ_FIFTY: return 3;
+    case libzerocoin::ZQ_ONE_HUNDRED: return 4;
+    case libzerocoin::ZQ_FIVE_HUNDRED: return 5;
+    case libzerocoin::ZQ_ONE_THOUSAND: return 6;
+    case libzerocoin::ZQ_FIVE_THOUSAND: return 7;
+    default: return -1;
+    }
+}
+
+/**
+ * Zerocoin supply per denomination, stored inline rather than in a std::map so
+ * that block index entries don't each carry eight heap nodes. Serialized exactly
+ * like the std::map<CoinDenomination, int64_t> it replaces.
+ */
+class CZerocoinSupply
+{
+private:
+    int64_t nSupply[ZEROCOIN_DENOM_COUNT];
+
+public:
+    CZerocoinSupply()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        std::fill(nSupply, nSupply + ZEROCOIN_DENOM_COUNT, 0);
+    }
+
+    int64_t& at(libzerocoin::CoinDenomination denom)
+    {
+        int i = ZerocoinDenominationIndex(denom);
+        if (i < 0)
+            throw std::out_of_range("CZerocoinSupply::at : invalid denomination");
+        return nSupply[i];
+    }
+
+    const int64_t& at(libzerocoin::CoinDenomination denom) const
+    {
+        return const_cast<CZerocoinSupply*>(this)->at(denom);
+    }
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const
+    {
+        return GetSizeOfCompactSize(ZEROCOIN_DENOM_COUNT) +
+               ZEROCOIN_DENOM_COUNT * (sizeof(libzerocoin::CoinDenomination) + sizeof(int64_t));
+    }
+
+    template <typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        WriteCompactSize(s, ZEROCOIN_DENOM_COUNT);
+        for (unsigned int i = 0; i < ZEROCOIN_DENOM_COUNT; i++) {
+            ::Serialize(s, libzerocoin::zerocoinDenomList[i], nType, nVersion);
+            ::Serialize(s, nSupply[i], nType, nVersion);
+        }
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s, int nType, int nVersion)
+    {
+        SetNull();
+        unsigned int nSize = ReadCompactSize(s);
+        for (unsigned int n = 0; n < nSize; n++) {
+            libzerocoin::CoinDenomination denom;
+            int64_t nValue;
+            ::Unserialize(s, denom, nType, nVersion);
+            ::Unserialize(s, nValue, nType, nVersion);
+            int i = ZerocoinDenominationIndex(denom);
+            if (i >= 0)
+                nSupply[i] = nValue;
+        }
+    }
+};
+
+/**
+ * Number of zerocoin mints of each denomination in a block. Serialized like the
+ * std::vector<CoinDenomination> it replaces, with the mints sorted by denomination.
+ * A mint output is several hundred bytes, so a block can't hold enough of them to
+ * overflow a 16 bit count.
+ */
+class CZerocoinMintCounts
+{
+private:
+    uint16_t nMints[ZEROCOIN_DENOM_COUNT];
+
+public:
+    CZerocoinMintCounts()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        std::fill(nMints, nMints + ZEROCOIN_DENOM_COUNT, 0);
+    }
+
+    unsigned int Count(libzerocoin::CoinDenomination denom) const
+    {
+        int i = ZerocoinDenominationIndex(denom);
+        return i < 0 ? 0 : nMints[i];
+    }
+
+    unsigned int Total() const
+    {
+        unsigned int nTotal = 0;
+        for (unsigned int i = 0; i < ZEROCOIN_DENOM_COUNT; i++)
+            nTotal += nMints[i];
+        return nTotal;
+    }
+
+    void Add(libzerocoin::CoinDenomination denom)
+    {
+        int i = ZerocoinDenominationIndex(denom);
+        if (i >= 0)
+            nMints[i]++;
+    }
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const
+    {
+        unsigned int nTotal = Total();
+        return GetSizeOfCompactSize(nTotal) + nTotal * sizeof(libzerocoin::CoinDenomination);
+    }
+
+    template <typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        WriteCompactSize(s, Total());
+        for (unsigned int i = 0; i < ZEROCOIN_DENOM_COUNT; i++) {
+            for (unsigned int n = 0; n < nMints[i]; n++)
+                ::Serialize(s, libzerocoin::zerocoinDenomList[i], nType, nVersion);
+        }
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s, int nType, int nVersion)
+    {
+        SetNull();
+        unsigned int nSize = ReadCompactSize(s);
+        for (unsigned int n = 0; n < nSize; n++) {
+            libzerocoin::CoinDenomination denom;
+            ::Unserialize(s, denom, nType, nVersion);
+            int i = ZerocoinDenominationIndex(denom);
+            if (i < 0)
+                continue;
+            if (nMints[i] == std::numeric_limits<uint16_t>::max())
+                throw std::ios_base::failure("CZerocoinMintCounts::Unserialize : too many mints");
+            nMints[i]++;
+        }
+    }
+};
+
 /** The block chain is a tree shaped structure starting with the
  * genesis block at the root, with each block potentially having multiple
  * candidates to be the next block. A blockindex may have multiple pprev pointing
@@ -123,9 +289,6 @@ public:
     //! pointer to the index of some further predecessor of this block
     CBlockIndex* pskip;
 
-    //ppcoin: trust score of block chain
-    uint256 bnChainTrust;
-
     //! height of the entry in the chain. The genesis block has height 0
     int nHeight;
 
@@ -186,8 +349,8 @@ public:
     uint32_t nSequenceId;
 
     //! zerocoin specific fields
-    std::map<libzerocoin::CoinDenomination, int64_t> mapZerocoinSupply;
-    std::vector<libzerocoin::CoinDenomination> vMintDenominationsInBlock;
+    CZerocoinSupply zerocoinSupply;
+    CZerocoinMintCounts mintsInBlock;
 
     void SetNull()
     {
@@ -219,11 +382,8 @@ public:
         nBits = 0;
         nNonce = 0;
         nAccumulatorCheckpoint = 0;
-        // Start supply of each denomination with 0s
-        for (auto& denom : libzerocoin::zerocoinDenomList) {
-            mapZerocoinSupply.insert(make_pair(denom, 0));
-        }
-        vMintDenominationsInBlock.clear();
+        zerocoinSupply.SetNull();
+        mintsInBlock.SetNull();
     }
 
     CBlockIndex()
@@ -301,7 +461,7 @@ public:
      */
     int64_t GetZcMints(libzerocoin::CoinDenomination denom) const
     {
-        return mapZerocoinSupply.at(denom);
+        return zerocoinSupply.at(denom);
     }
 
     /**
@@ -316,7 +476,7 @@ public:
 
     bool MintedDenomination(libzerocoin::CoinDenomination denom) const
     {
-        return std::find(vMintDenominationsInBlock.begin(), vMintDenominationsInBlock.end(), denom) != vMintDenominationsInBlock.end();
+        return mintsInBlock.Count(denom) > 0;
     }
 
     uint256 GetBlockHash() const
@@ -518,8 +678,8 @@ public:
         READWRITE(nNonce);
         if(this->nVersion > 3) {
             READWRITE(nAccumulatorCheckpoint);
-            READWRITE(mapZerocoinSupply);
-            READWRITE(vMintDenominationsInBlock);
+            READWRITE(zerocoinSupply);
+            READWRITE(mintsInBlock);
         }
 
     }
@@ -549,6 +709,37 @@ public:
     }
 };
 
+/**
+ * Hands out block index entries from large chunks instead of allocating each one
+ * separately, which saves the per-allocation overhead and heap calls at startup.
+ * The index is loaded in block hash order, so entries next to each other in memory
+ * are unrelated blocks. Entries are never freed individually: they stay valid
+ * until Clear().
+ */
+class CBlockIndexArena
+{
+private:
+    //! Entries per chunk
+    static const size_t nChunkSize = 4096;
+
+    std::vector<CBlockIndex*> vChunks;
+    //! Entries used in the last chunk
+    size_t nUsed;
+
+    CBlockIndexArena(const CBlockIndexArena&);
+    void operator=(const CBlockIndexArena&);
+
+public:
+    CBlockIndexArena() : nUsed(nChunkSize) {}
+    ~CBlockIndexArena() { Clear(); }
+
+    //! Return a fresh, null entry
+    CBlockIndex* Allocate();
+    //! Free every entry handed out so far
+    void Clear();
+    size_t Size() const { return vChunks.empty() ? 0 : (vChunks.size() - 1) * nChunkSize + nUsed; }
+};
+
 /** An in-memory indexed chain of blocks. */
 class CChain
 {
@@ -7,6 +7,7 @@
 
 #include "random.h"
 
+#include <algorithm>
 #include <assert.h>
 
 /**
@@ -206,6 +207,50 @@ bool CCoinsViewCache::Flush()
     return fOk;
 }
 
+bool CCoinsViewCache::Flush(size_t nRetain)
+{
+    CCoinsMap mapDirty;
+    DetachDirty(mapDirty, nRetain);
+    return base->BatchWrite(mapDirty, hashBlock);
+}
+
+void CCoinsViewCache::DetachDirty(CCoinsMap& mapDirty, size_t nRetain, size_t nMaxTotal)
+{
+    assert(!hasModifier);
+    size_t nDirty = 0;
+    for (CCoinsMap::const_iterator it = cacheCoins.begin(); it != cacheCoins.end(); it++) {
+        if (it->second.flags & CCoinsCacheEntry::DIRTY)
+            nDirty++;
+    }
+    // mapDirty holds every modified entry, whether it stays cached or not.
+    nRetain = std::min(nRetain, nMaxTotal > nDirty ? nMaxTotal - nDirty : 0);
+    // Decide how many entries to drop: unmodified ones first, then modified ones.
+    size_t nEvict = cacheCoins.size() > nRetain ? cacheCoins.size() - nRetain : 0;
+    size_t nEvictClean = std::min(nEvict, cacheCoins.size() - nDirty);
+    size_t nEvictDirty = nEvict - nEvictClean;
+    for (CCoinsMap::iterator it = cacheCoins.begin(); it != cacheCoins.end();) {
+        CCoinsMap::iterator itCur = it++;
+        if (itCur->second.flags & CCoinsCacheEntry::DIRTY) {
+            CCoinsCacheEntry& entry = mapDirty[itCur->first];
+            entry.flags = itCur->second.flags;
+            if (nEvictDirty > 0 || itCur->second.coins.IsPruned()) {
+                // Spent entries are never worth keeping.
+                entry.coins.swap(itCur->second.coins);
+                cacheCoins.erase(itCur);
+                if (nEvictDirty > 0)
+                    nEvictDirty--;
+            } else {
+                // The base view will have this version once mapDirty is written.
+                entry.coins = itCur->second.coins;
+                itCur->second.flags = 0;
+            }
+        } else if (nEvictClean > 0) {
+            cacheCoins.erase(itCur);
+            nEvictClean--;
+        }
+    }
+}
+
 unsigned int CCoinsViewCache::GetCacheSize() const
 {
     return cacheCoins.size();
@@ -14,6 +14,7 @@
 #include "undo.h"
 
 #include <assert.h>
+#include <limits>
 #include <stdint.h>
 
 #include <boost/foreach.hpp>
@@ -454,6 +455,23 @@ public:
      */
     bool Flush();
 
+    /**
+     * Like Flush, but keep up to nRetain entries cached instead of starting over
+     * from an empty cache. Modified entries are kept in preference to ones that
+     * were only read, as recently created outputs are the likeliest to be spent next.
+     */
+    bool Flush(size_t nRetain);
+
+    /**
+     * Move the modifications applied to this cache into mapDirty instead of pushing
+     * them to the base view, so the caller can write them out elsewhere (see
+     * CCoinsViewWriteBehind), and shrink the cache to at most nRetain entries as
+     * Flush(nRetain) does. Entries that stay cached are marked unmodified.
+     * Modified entries that stay cached are also copied into mapDirty, so the cache
+     * is shrunk further if needed to keep it and mapDirty within nMaxTotal entries.
+     */
+    void DetachDirty(CCoinsMap& mapDirty, size_t nRetain, size_t nMaxTotal = std::numeric_limits<size_t>::max());
+
     //! Calculate the size of the cache (in number of transactions)
     unsigned int GetCacheSize() const;
 
@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string>
 
 /** A hasher class for SHA-256. */
 class CSHA256
@@ -25,4 +26,31 @@ public:
     CSHA256& Reset();
 };
 
+namespace sha256_implementation
+{
+/** Implementations SHA256AutoDetect may pick from, if the CPU supports them. */
+enum UseImplementation : uint8_t {
+    STANDARD = 0,
+    USE_SSE4 = 1 << 0,
+    USE_AVX2 = 1 << 1,
+    USE_SHANI = 1 << 2,
+    USE_ALL = USE_SSE4 | USE_AVX2 | USE_SHANI,
+};
+} // namespace sha256_implementation
+
+/**
+ * Select the fastest SHA-256 implementations this CPU supports, out of those
+ * allowed by use_implementation, and return a description of the choice.
+ * Until this is called the portable implementation is used.
+ */
+std::string SHA256AutoDetect(sha256_implementation::UseImplementation use_implementation = sha256_implementation::USE_ALL);
+
+/**
+ * Compute the double SHA-256 of blocks consecutive 64-byte inputs, writing
+ * blocks consecutive 32-byte hashes to out. This is the hashing of inner nodes
+ * of a merkle tree, so it uses multi-buffer code where available. out may be
+ * the same as in.
+ */
+void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
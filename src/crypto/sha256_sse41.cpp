@@ -0,0 +1,280 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// Double SHA-256 of four 64-byte inputs at once, using SSE4.1 intrinsics.
+
+#ifdef ENABLE_SSE41
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include "crypto/common.h"
+
+namespace sha256d64_sse41
+{
+namespace
+{
+__m128i inline K(uint32_t x) { return _mm_set1_epi32(x); }
+
+__m128i inline Add(__m128i x, __m128i y) { return _mm_add_epi32(x, y); }
+__m128i inline Add(__m128i x, __m128i y, __m128i z) { return Add(Add(x, y), z); }
+__m128i inline Add(__m128i x, __m128i y, __m128i z, __m128i w) { return Add(Add(x, y), Add(z, w)); }
+__m128i inline Inc(__m128i& x, __m128i y, __m128i z, __m128i w) { x = Add(x, y, z, w); return x; }
+__m128i inline Xor(__m128i x, __m128i y) { return _mm_xor_si128(x, y); }
+__m128i inline Xor(__m128i x, __m128i y, __m128i z) { return Xor(Xor(x, y), z); }
+__m128i inline Or(__m128i x, __m128i y) { return _mm_or_si128(x, y); }
+__m128i inline And(__m128i x, __m128i y) { return _mm_and_si128(x, y); }
+__m128i inline ShR(__m128i x, int n) { return _mm_srli_epi32(x, n); }
+__m128i inline ShL(__m128i x, int n) { return _mm_slli_epi32(x, n); }
+
+__m128i inline Ch(__m128i x, __m128i y, __m128i z) { return Xor(z, And(x, Xor(y, z))); }
+__m128i inline Maj(__m128i x, __m128i y, __m128i z) { return Or(And(x, y), And(z, Or(x, y))); }
+__m128i inline Sigma0(__m128i x) { return Xor(Or(ShR(x, 2), ShL(x, 30)), Or(ShR(x, 13), ShL(x, 19)), Or(ShR(x, 22), ShL(x, 10))); }
+__m128i inline Sigma1(__m128i x) { return Xor(Or(ShR(x, 6), ShL(x, 26)), Or(ShR(x, 11), ShL(x, 21)), Or(ShR(x, 25), ShL(x, 7))); }
+__m128i inline sigma0(__m128i x) { return Xor(Or(ShR(x, 7), ShL(x, 25)), Or(ShR(x, 18), ShL(x, 14)), ShR(x, 3)); }
+__m128i inline sigma1(__m128i x) { return Xor(Or(ShR(x, 17), ShL(x, 15)), Or(ShR(x, 19), ShL(x, 13)), ShR(x, 10)); }
+
+/** One round of SHA-256 on 4 lanes, kw being the round constant plus the message word. */
+void inline __attribute__((always_inline)) Round(__m128i a, __m128i b, __m128i c, __m128i& d, __m128i e, __m128i f, __m128i g, __m128i& h, __m128i kw)
+{
+    __m128i t1 = Add(h, Sigma1(e), Ch(e, f, g), kw);
+    __m128i t2 = Add(Sigma0(a), Maj(a, b, c));
+    d = Add(d, t1);
+    h = Add(t1, t2);
+}
+
+/** Load the big endian word at offset of 4 consecutive 64-byte inputs. */
+__m128i inline Read4(const unsigned char* chunk, int offset)
+{
+    __m128i ret = _mm_set_epi32(
+        ReadLE32(chunk + 192 + offset),
+        ReadLE32(chunk + 128 + offset),
+        ReadLE32(chunk + 64 + offset),
+        ReadLE32(chunk + 0 + offset));
+    return _mm_shuffle_epi8(ret, _mm_set_epi32(0x0C0D0E0FUL, 0x08090A0BUL, 0x04050607UL, 0x00010203UL));
+}
+
+/** Store a big endian word at offset of 4 consecutive 32-byte outputs. */
+void inline Write4(unsigned char* out, int offset, __m128i v)
+{
+    v = _mm_shuffle_epi8(v, _mm_set_epi32(0x0C0D0E0FUL, 0x08090A0BUL, 0x04050607UL, 0x00010203UL));
+    WriteLE32(out + 0 + offset, _mm_extract_epi32(v, 0));
+    WriteLE32(out + 32 + offset, _mm_extract_epi32(v, 1));
+    WriteLE32(out + 64 + offset, _mm_extract_epi32(v, 2));
+    WriteLE32(out + 96 + offset, _mm_extract_epi32(v, 3));
+}
+
+void inline Initialize(__m128i* s)
+{
+    s[0] = K(0x6a09e667ul);
+    s[1] = K(0xbb67ae85ul);
+    s[2] = K(0x3c6ef372ul);
+    s[3] = K(0xa54ff53aul);
+    s[4] = K(0x510e527ful);
+    s[5] = K(0x9b05688cul);
+    s[6] = K(0x1f83d9abul);
+    s[7] = K(0x5be0cd19ul);
+}
+
+/** Perform one SHA-256 transformation of state s with the message words in w, which are overwritten. */
+void inline __attribute__((always_inline)) Transform(__m128i* s, __m128i* w)
+{
+    __m128i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+    Round(a, b, c, d, e, f, g, h, Add(K(0x428a2f98ul), w[0]));
+    Round(h, a, b, c, d, e, f, g, Add(K(0x71374491ul), w[1]));
+    Round(g, h, a, b, c, d, e, f, Add(K(0xb5c0fbcful), w[2]));
+    Round(f, g, h, a, b, c, d, e, Add(K(0xe9b5dba5ul), w[3]));
+    Round(e, f, g, h, a, b, c, d, Add(K(0x3956c25bul), w[4]));
+    Round(d, e, f, g, h, a, b, c, Add(K(0x59f111f1ul), w[5]));
+    Round(c, d, e, f, g, h, a, b, Add(K(0x923f82a4ul), w[6]));
+    Round(b, c, d, e, f, g, h, a, Add(K(0xab1c5ed5ul), w[7]));
+    Round(a, b, c, d, e, f, g, h, Add(K(0xd807aa98ul), w[8]));
+    Round(h, a, b, c, d, e, f, g, Add(K(0x12835b01ul), w[9]));
+    Round(g, h, a, b, c, d, e, f, Add(K(0x243185beul), w[10]));
+    Round(f, g, h, a, b, c, d, e, Add(K(0x550c7dc3ul), w[11]));
+    Round(e, f, g, h, a, b, c, d, Add(K(0x72be5d74ul), w[12]));
+    Round(d, e, f, g, h, a, b, c, Add(K(0x80deb1feul), w[13]));
+    Round(c, d, e, f, g, h, a, b, Add(K(0x9bdc06a7ul), w[14]));
+    Round(b, c, d, e, f, g, h, a, Add(K(0xc19bf174ul), w[15]));
+
+    Round(a, b, c, d, e, f, g, h, Add(K(0xe49b69c1ul), Inc(w[0], sigma1(w[14]), w[9], sigma0(w[1]))));
+    Round(h, a, b, c, d, e, f, g, Add(K(0xefbe4786ul), Inc(w[1], sigma1(w[15]), w[10], sigma0(w[2]))));
+    Round(g, h, a, b, c, d, e, f, Add(K(0x0fc19dc6ul), Inc(w[2], sigma1(w[0]), w[11], sigma0(w[3]))));
+    Round(f, g, h, a, b, c, d, e, Add(K(0x240ca1ccul), Inc(w[3], sigma1(w[1]), w[12], sigma0(w[4]))));
+    Round(e, f, g, h, a, b, c, d, Add(K(0x2de92c6ful), Inc(w[4], sigma1(w[2]), w[13], sigma0(w[5]))));
+    Round(d, e, f, g, h, a, b, c, Add(K(0x4a7484aaul), Inc(w[5], sigma1(w[3]), w[14], sigma0(w[6]))));
+    Round(c, d, e, f, g, h, a, b, Add(K(0x5cb0a9dcul), Inc(w[6], sigma1(w[4]), w[15], sigma0(w[7]))));
+    Round(b, c, d, e, f, g, h, a, Add(K(0x76f988daul), Inc(w[7], sigma1(w[5]), w[0], sigma0(w[8]))));
+    Round(a, b, c, d, e, f, g, h, Add(K(0x983e5152ul), Inc(w[8], sigma1(w[6]), w[1], sigma0(w[9]))));
+    Round(h, a, b, c, d, e, f, g, Add(K(0xa831c66dul), Inc(w[9], sigma1(w[7]), w[2], sigma0(w[10]))));
+    Round(g, h, a, b, c, d, e, f, Add(K(0xb00327c8ul), Inc(w[10], sigma1(w[8]), w[3], sigma0(w[11]))));
+    Round(f, g, h, a, b, c, d, e, Add(K(0xbf597fc7ul), Inc(w[11], sigma1(w[9]), w[4], sigma0(w[12]))));
+    Round(e, f, g, h, a, b, c, d, Add(K(0xc6e00bf3ul), Inc(w[12], sigma1(w[10]), w[5], sigma0(w[13]))));
+    Round(d, e, f, g, h, a, b, c, Add(K(0xd5a79147ul), Inc(w[13], sigma1(w[11]), w[6], sigma0(w[14]))));
+    Round(c, d, e, f, g, h, a, b, Add(K(0x06ca6351ul), Inc(w[14], sigma1(w[12]), w[7], sigma0(w[15]))));
+    Round(b, c, d, e, f, g, h, a, Add(K(0x14292967ul), Inc(w[15], sigma1(w[13]), w[8], sigma0(w[0]))));
+
+    Round(a, b, c, d, e, f, g, h, Add(K(0x27b70a85ul), Inc(w[0], sigma1(w[14]), w[9], sigma0(w[1]))));
+    Round(h, a, b, c, d, e, f, g, Add(K(0x2e1b2138ul), Inc(w[1], sigma1(w[15]), w[10], sigma0(w[2]))));
+    Round(g, h, a, b, c, d, e, f, Add(K(0x4d2c6dfcul), Inc(w[2], sigma1(w[0]), w[11], sigma0(w[3]))));
+    Round(f, g, h, a, b, c, d, e, Add(K(0x53380d13ul), Inc(w[3], sigma1(w[1]), w[12], sigma0(w[4]))));
+    Round(e, f, g, h, a, b, c, d, Add(K(0x650a7354ul), Inc(w[4], sigma1(w[2]), w[13], sigma0(w[5]))));
+    Round(d, e, f, g, h, a, b, c, Add(K(0x766a0abbul), Inc(w[5], sigma1(w[3]), w[14], sigma0(w[6]))));
+    Round(c, d, e, f, g, h, a, b, Add(K(0x81c2c92eul), Inc(w[6], sigma1(w[4]), w[15], sigma0(w[7]))));
+    Round(b, c, d, e, f, g, h, a, Add(K(0x92722c85ul), Inc(w[7], sigma1(w[5]), w[0], sigma0(w[8]))));
+    Round(a, b, c, d, e, f, g, h, Add(K(0xa2bfe8a1ul), Inc(w[8], sigma1(w[6]), w[1], sigma0(w[9]))));
+    Round(h, a, b, c, d, e, f, g, Add(K(0xa81a664bul), Inc(w[9], sigma1(w[7]), w[2], sigma0(w[10]))));
+    Round(g, h, a, b, c, d, e, f, Add(K(0xc24b8b70ul), Inc(w[10], sigma1(w[8]), w[3], sigma0(w[11]))));
+    Round(f, g, h, a, b, c, d, e, Add(K(0xc76c51a3ul), Inc(w[11], sigma1(w[9]), w[4], sigma0(w[12]))));
+    Round(e, f, g, h, a, b, c, d, Add(K(0xd192e819ul), Inc(w[12], sigma1(w[10]), w[5], sigma0(w[13]))));
+    Round(d, e, f, g, h, a, b, c, Add(K(0xd6990624ul), Inc(w[13], sigma1(w[11]), w[6], sigma0(w[14]))));
+    Round(c, d, e, f, g, h, a, b, Add(K(0xf40e3585ul), Inc(w[14], sigma1(w[12]), w[7], sigma0(w[15]))));
+    Round(b, c, d, e, f, g, h, a, Add(K(0x106aa070ul), Inc(w[15], sigma1(w[13]), w[8], sigma0(w[0]))));
+
+    Round(a, b, c, d, e, f, g, h, Add(K(0x19a4c116ul), Inc(w[0], sigma1(w[14]), w[9], sigma0(w[1]))));
+    Round(h, a, b, c, d, e, f, g, Add(K(0x1e376c08ul), Inc(w[1], sigma1(w[15]), w[10], sigma0(w[2]))));
+    Round(g, h, a, b, c, d, e, f, Add(K(0x2748774cul), Inc(w[2], sigma1(w[0]), w[11], sigma0(w[3]))));
+    Round(f, g, h, a, b, c, d, e, Add(K(0x34b0bcb5ul), Inc(w[3], sigma1(w[1]), w[12], sigma0(w[4]))));
+    Round(e, f, g, h, a, b, c, d, Add(K(0x391c0cb3ul), Inc(w[4], sigma1(w[2]), w[13], sigma0(w[5]))));
+    Round(d, e, f, g, h, a, b, c, Add(K(0x4ed8aa4aul), Inc(w[5], sigma1(w[3]), w[14], sigma0(w[6]))));
+    Round(c, d, e, f, g, h, a, b, Add(K(0x5b9cca4ful), Inc(w[6], sigma1(w[4]), w[15], sigma0(w[7]))));
+    Round(b, c, d, e, f, g, h, a, Add(K(0x682e6ff3ul), Inc(w[7], sigma1(w[5]), w[0], sigma0(w[8]))));
+    Round(a, b, c, d, e, f, g, h, Add(K(0x748f82eeul), Inc(w[8], sigma1(w[6]), w[1], sigma0(w[9]))));
+    Round(h, a, b, c, d, e, f, g, Add(K(0x78a5636ful), Inc(w[9], sigma1(w[7]), w[2], sigma0(w[10]))));
+    Round(g, h, a, b, c, d, e, f, Add(K(0x84c87814ul), Inc(w[10], sigma1(w[8]), w[3], sigma0(w[11]))));
+    Round(f, g, h, a, b, c, d, e, Add(K(0x8cc70208ul), Inc(w[11], sigma1(w[9]), w[4], sigma0(w[12]))));
+    Round(e, f, g, h, a, b, c, d, Add(K(0x90befffaul), Inc(w[12], sigma1(w[10]), w[5], sigma0(w[13]))));
+    Round(d, e, f, g, h, a, b, c, Add(K(0xa4506cebul), Inc(w[13], sigma1(w[11]), w[6], sigma0(w[14]))));
+    Round(c, d, e, f, g, h, a, b, Add(K(0xbef9a3f7ul), Inc(w[14], sigma1(w[12]), w[7], sigma0(w[15]))));
+    Round(b, c, d, e, f, g, h, a, Add(K(0xc67178f2ul), Inc(w[15], sigma1(w[13]), w[8], sigma0(w[0]))));
+
+    s[0] = Add(s[0], a);
+    s[1] = Add(s[1], b);
+    s[2] = Add(s[2], c);
+    s[3] = Add(s[3], d);
+    s[4] = Add(s[4], e);
+    s[5] = Add(s[5], f);
+    s[6] = Add(s[6], g);
+    s[7] = Add(s[7], h);
+}
+
+/**
+ * Transform state s with the padding block of a 64-byte message. Its message
+ * schedule is the same for every input, so the round constants below already
+ * have it added in.
+ */
+void inline __attribute__((always_inline)) TransformPadding64(__m128i* s)
+{
+    __m128i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+    Round(a, b, c, d, e, f, g, h, K(0xc28a2f98ul));
+    Round(h, a, b, c, d, e, f, g, K(0x71374491ul));
+    Round(g, h, a, b, c, d, e, f, K(0xb5c0fbcful));
+    Round(f, g, h, a, b, c, d, e, K(0xe9b5dba5ul));
+    Round(e, f, g, h, a, b, c, d, K(0x3956c25bul));
+    Round(d, e, f, g, h, a, b, c, K(0x59f111f1ul));
+    Round(c, d, e, f, g, h, a, b, K(0x923f82a4ul));
+    Round(b, c, d, e, f, g, h, a, K(0xab1c5ed5ul));
+    Round(a, b, c, d, e, f, g, h, K(0xd807aa98ul));
+    Round(h, a, b, c, d, e, f, g, K(0x12835b01ul));
+    Round(g, h, a, b, c, d, e, f, K(0x243185beul));
+    Round(f, g, h, a, b, c, d, e, K(0x550c7dc3ul));
+    Round(e, f, g, h, a, b, c, d, K(0x72be5d74ul));
+    Round(d, e, f, g, h, a, b, c, K(0x80deb1feul));
+    Round(c, d, e, f, g, h, a, b, K(0x9bdc06a7ul));
+    Round(b, c, d, e, f, g, h, a, K(0xc19bf374ul));
+
+    Round(a, b, c, d, e, f, g, h, K(0x649b69c1ul));
+    Round(h, a, b, c, d, e, f, g, K(0xf0fe4786ul));
+    Round(g, h, a, b, c, d, e, f, K(0x0fe1edc6ul));
+    Round(f, g, h, a, b, c, d, e, K(0x240cf254ul));
+    Round(e, f, g, h, a, b, c, d, K(0x4fe9346ful));
+    Round(d, e, f, g, h, a, b, c, K(0x6cc984beul));
+    Round(c, d, e, f, g, h, a, b, K(0x61b9411eul));
+    Round(b, c, d, e, f, g, h, a, K(0x16f988faul));
+    Round(a, b, c, d, e, f, g, h, K(0xf2c65152ul));
+    Round(h, a, b, c, d, e, f, g, K(0xa88e5a6dul));
+    Round(g, h, a, b, c, d, e, f, K(0xb019fc65ul));
+    Round(f, g, h, a, b, c, d, e, K(0xb9d99ec7ul));
+    Round(e, f, g, h, a, b, c, d, K(0x9a1231c3ul));
+    Round(d, e, f, g, h, a, b, c, K(0xe70eeaa0ul));
+    Round(c, d, e, f, g, h, a, b, K(0xfdb1232bul));
+    Round(b, c, d, e, f, g, h, a, K(0xc7353eb0ul));
+
+    Round(a, b, c, d, e, f, g, h, K(0x3069bad5ul));
+    Round(h, a, b, c, d, e, f, g, K(0xcb976d5ful));
+    Round(g, h, a, b, c, d, e, f, K(0x5a0f118ful));
+    Round(f, g, h, a, b, c, d, e, K(0xdc1eeefdul));
+    Round(e, f, g, h, a, b, c, d, K(0x0a35b689ul));
+    Round(d, e, f, g, h, a, b, c, K(0xde0b7a04ul));
+    Round(c, d, e, f, g, h, a, b, K(0x58f4ca9dul));
+    Round(b, c, d, e, f, g, h, a, K(0xe15d5b16ul));
+    Round(a, b, c, d, e, f, g, h, K(0x007f3e86ul));
+    Round(h, a, b, c, d, e, f, g, K(0x37088980ul));
+    Round(g, h, a, b, c, d, e, f, K(0xa507ea32ul));
+    Round(f, g, h, a, b, c, d, e, K(0x6fab9537ul));
+    Round(e, f, g, h, a, b, c, d, K(0x17406110ul));
+    Round(d, e, f, g, h, a, b, c, K(0x0d8cd6f1ul));
+    Round(c, d, e, f, g, h, a, b, K(0xcdaa3b6dul));
+    Round(b, c, d, e, f, g, h, a, K(0xc0bbbe37ul));
+
+    Round(a, b, c, d, e, f, g, h, K(0x83613bdaul));
+    Round(h, a, b, c, d, e, f, g, K(0xdb48a363ul));
+    Round(g, h, a, b, c, d, e, f, K(0x0b02e931ul));
+    Round(f, g, h, a, b, c, d, e, K(0x6fd15ca7ul));
+    Round(e, f, g, h, a, b, c, d, K(0x521afacaul));
+    Round(d, e, f, g, h, a, b, c, K(0x31338431ul));
+    Round(c, d, e, f, g, h, a, b, K(0x6ed41a95ul));
+    Round(b, c, d, e, f, g, h, a, K(0x6d437890ul));
+    Round(a, b, c, d, e, f, g, h, K(0xc39c91f2ul));
+    Round(h, a, b, c, d, e, f, g, K(0x9eccabbdul));
+    Round(g, h, a, b, c, d, e, f, K(0xb5c9a0e6ul));
+    Round(f, g, h, a, b, c, d, e, K(0x532fb63cul));
+    Round(e, f, g, h, a, b, c, d, K(0xd2c741c6ul));
+    Round(d, e, f, g, h, a, b, c, K(0x07237ea3ul));
+    Round(c, d, e, f, g, h, a, b, K(0xa4954b68ul));
+    Round(b, c, d, e, f, g, h, a, K(0x4c191d76ul));
+
+    s[0] = Add(s[0], a);
+    s[1] = Add(s[1], b);
+    s[2] = Add(s[2], c);
+    s[3] = Add(s[3], d);
+    s[4] = Add(s[4], e);
+    s[5] = Add(s[5], f);
+    s[6] = Add(s[6], g);
+    s[7] = Add(s[7], h);
+}
+
+} // namespace
+
+void Transform_4way(unsigned char* out, const unsigned char* in)
+{
+    __m128i s[8], w[16];
+
+    // First SHA-256 of the 4 inputs: the message block, then its padding.
+    Initialize(s);
+    for (int i = 0; i < 16; i++)
+        w[i] = Read4(in, 4 * i);
+    Transform(s, w);
+    TransformPadding64(s);
+
+    // Second SHA-256, of the 32-byte first hashes.
+    for (int i = 0; i < 8; i++)
+        w[i] = s[i];
+    w[8] = K(0x80000000ul);
+    for (int i = 9; i < 15; i++)
+        w[i] = K(0);
+    w[15] = K(0x100ul);
+    Initialize(s);
+    Transform(s, w);
+
+    for (int i = 0; i < 8; i++)
+        Write4(out, 4 * i, s[i]);
+}
+
+} // namespace sha256d64_sse41
+
+#endif // ENABLE_SSE41
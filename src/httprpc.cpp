@@ -8,6 +8,7 @@
 #include "base58.h"
 #include "chainparams.h"
 #include "httpserver.h"
+#include "rpc/jsonstream.h"
 #include "rpc/protocol.h"
 #include "rpc/server.h"
 #include "random.h"
@@ -129,8 +130,17 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
 
             UniValue result = tableRPC.execute(jreq.strMethod, jreq.params);
 
-            // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            // Send reply, streaming large results instead of writing them to one string
+            req->WriteHeader("Content-Type", "application/json");
+            CJSONStreamWriter writer(std::bind(&HTTPRequest::WriteReplyStream, req, HTTP_OK, std::placeholders::_1, std::placeholders::_2));
+            writer.BeginObject();
+            writer.Pair("result", result);
+            writer.Pair("error", NullUniValue);
+            writer.Pair("id", jreq.id);
+            writer.EndObject();
+            writer.Raw("\n");
+            writer.Finish();
+            return true;
 
         // array of requests
         } else if (valRequest.isArray())
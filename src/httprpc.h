@@ -22,6 +22,9 @@ void InterruptHTTPRPC();
  */
 void StopHTTPRPC();
 
+/** Default size of the REST response cache in megabytes */
+static const unsigned int DEFAULT_REST_CACHE_SIZE = 32;
+
 /** Start HTTP REST subsystem.
  * Precondition; HTTP and RPC has been started.
  */
@@ -26,6 +26,7 @@
 #include <event2/http.h>
 #include <event2/thread.h>
 #include <event2/buffer.h>
+#include <event2/bufferevent.h>
 #include <event2/util.h>
 #include <event2/keyvalq_struct.h>
 
@@ -38,6 +39,8 @@
 
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
+/** Maximum number of bytes of a streamed reply waiting to be written to the client */
+static const size_t MAX_STREAM_BYTES_IN_FLIGHT = 1024 * 1024;
 
 /** HTTP request work item */
 class HTTPWorkItem : public HTTPClosure
@@ -59,6 +62,22 @@ private:
     HTTPRequestHandler func;
 };
 
+/** Work item running a plain function */
+class HTTPFunctionItem : public HTTPClosure
+{
+public:
+    HTTPFunctionItem(const std::function<void()>& func): func(func)
+    {
+    }
+    void operator()()
+    {
+        func();
+    }
+
+private:
+    std::function<void()> func;
+};
+
 /** Simple work queue for distributing work over multiple threads.
  * Work items are simply callable objects.
  */
@@ -109,11 +128,11 @@ public:
             queue.pop_front();
         }
     }
-    /** Enqueue a work item */
-    bool Enqueue(WorkItem* item)
+    /** Enqueue a work item, leaving nReserve slots free for other work */
+    bool Enqueue(WorkItem* item, size_t nReserve = 0)
     {
         std::unique_lock<std::mutex> lock(cs);
-        if (queue.size() >= maxDepth) {
+        if (queue.size() + nReserve >= maxDepth) {
             return false;
         }
         queue.push_back(item);
@@ -296,6 +315,18 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
     }
 }
 
+bool HTTPEnqueueWork(const std::function<void()>& func)
+{
+    if (!workQueue)
+        return false;
+    // Keep half of the queue for incoming requests
+    std::unique_ptr<HTTPFunctionItem> item(new HTTPFunctionItem(func));
+    if (!workQueue->Enqueue(item.get(), std::max((long)GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L) / 2))
+        return false;
+    item.release();
+    return true;
+}
+
 /** Callback to reject HTTP requests after shutdown. */
 static void http_reject_request_cb(struct evhttp_request* req, void*)
 {
@@ -465,6 +496,7 @@ void InterruptHTTPServer()
         for (evhttp_bound_socket *socket : boundSockets) {
             evhttp_del_accept_socket(eventHTTP, socket);
         }
+        boundSockets.clear();
         evhttp_set_gencb(eventHTTP, http_reject_request_cb, NULL);
     }
     if (workQueue)
@@ -478,6 +510,7 @@ void StopHTTPServer()
         LogPrint("http", "Waiting for HTTP worker threads to exit\n");
         workQueue->WaitExit();
         delete workQueue;
+        workQueue = 0;
     }
     MilliSleep(500); // Avoid race condition while the last HTTP-thread is exiting
     if (eventBase) {
@@ -537,13 +570,61 @@ void HTTPEvent::trigger(struct timeval* tv)
     else
         evtimer_add(ev, tv); // trigger after timeval passed
 }
+/** Flow control state of a streamed reply.
+ * The libevent callbacks and the events sending the reply run on the http
+ * thread; the worker producing the reply waits on cond.
+ */
+struct HTTPStreamState
+{
+    HTTPStreamState() : nInFlight(0), nQueued(0), fClosed(false) {}
+
+    std::mutex cs;
+    std::condition_variable cond;
+    //! Bytes handed to the http thread which have not been written to the client yet
+    size_t nInFlight;
+    //! Bytes passed to the connection since its output buffer was last drained
+    size_t nQueued;
+    //! The client has gone away
+    bool fClosed;
+
+    void Drained()
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        nInFlight -= nQueued;
+        nQueued = 0;
+        cond.notify_all();
+    }
+
+    void Closed()
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fClosed = true;
+        cond.notify_all();
+    }
+};
+
+static void http_stream_drained_cb(struct evhttp_connection*, void* arg)
+{
+    ((HTTPStreamState*)arg)->Drained();
+}
+
+static void http_stream_closed_cb(struct evhttp_connection*, void* arg)
+{
+    ((HTTPStreamState*)arg)->Closed();
+}
+
 HTTPRequest::HTTPRequest(struct evhttp_request* req) : req(req),
-                                                       replySent(false)
+                                                       replySent(false),
+                                                       replyStarted(false)
 {
 }
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (replyStarted && !replySent) {
+        // Streaming was interrupted; a terminated chunked reply would look complete
+        LogPrintf("%s: Unfinished streamed reply\n", __func__);
+        AbortReplyStream();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL, "Unhandled request");
@@ -596,6 +677,12 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  */
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
 {
+    if (replyStarted) {
+        // A status can no longer be sent once a streamed reply has started
+        LogPrintf("%s: Reply %d after the start of a streamed reply\n", __func__, nStatus);
+        AbortReplyStream();
+        return;
+    }
     assert(!replySent && req);
     // Send event to main http thread to send reply message
     struct evbuffer* evb = evhttp_request_get_output_buffer(req);
@@ -608,6 +695,102 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = 0; // transferred back to main thread
 }
 
+bool HTTPRequest::WriteReplyStream(int nStatus, const std::string& strData, bool fFinal)
+{
+    if (!replyStarted && fFinal) {
+        WriteReply(nStatus, strData);
+        return true;
+    }
+    assert(!replySent && req);
+    // Events are triggered in order on the main http thread, which owns the connection
+    struct evhttp_request* reqStream = req;
+    if (!replyStarted) {
+        stream = std::make_shared<HTTPStreamState>();
+        std::shared_ptr<HTTPStreamState> state = stream;
+        HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqStream, state, nStatus]() {
+            struct evhttp_connection* evcon = evhttp_request_get_connection(reqStream);
+            if (!evcon) {
+                state->Closed();
+                return;
+            }
+            evhttp_connection_set_closecb(evcon, http_stream_closed_cb, state.get());
+            evhttp_send_reply_start(reqStream, nStatus, (const char*)NULL);
+        });
+        ev->trigger(0);
+        replyStarted = true;
+    }
+
+    // Wait for the client to catch up, so that only a bounded part of the
+    // reply is held in memory
+    {
+        std::unique_lock<std::mutex> lock(stream->cs);
+        while (stream->nInFlight >= MAX_STREAM_BYTES_IN_FLIGHT && !stream->fClosed)
+            stream->cond.wait(lock);
+        if (stream->fClosed) {
+            lock.unlock();
+            AbortReplyStream();
+            return false;
+        }
+        stream->nInFlight += strData.size();
+    }
+
+    if (!strData.empty()) {
+        std::shared_ptr<HTTPStreamState> state = stream;
+        struct evbuffer* evb = evbuffer_new();
+        assert(evb);
+        evbuffer_add(evb, strData.data(), strData.size());
+        HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqStream, state, evb]() {
+            struct evhttp_connection* evcon = evhttp_request_get_connection(reqStream);
+            if (evcon) {
+                {
+                    std::lock_guard<std::mutex> lock(state->cs);
+                    state->nQueued += evbuffer_get_length(evb);
+                }
+                evhttp_send_reply_chunk_with_cb(reqStream, evb, http_stream_drained_cb, state.get());
+                // Nothing was queued for writing (e.g. a HEAD request), so no drain callback follows
+                if (evbuffer_get_length(bufferevent_get_output(evhttp_connection_get_bufferevent(evcon))) == 0)
+                    state->Drained();
+            }
+            evbuffer_free(evb);
+        });
+        ev->trigger(0);
+    }
+    if (fFinal) {
+        std::shared_ptr<HTTPStreamState> state = stream;
+        HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqStream, state]() {
+            struct evhttp_connection* evcon = evhttp_request_get_connection(reqStream);
+            if (evcon)
+                evhttp_connection_set_closecb(evcon, NULL, NULL);
+            evhttp_send_reply_end(reqStream);
+        });
+        ev->trigger(0);
+        replySent = true;
+        req = 0; // transferred back to main thread
+    }
+    return true;
+}
+
+void HTTPRequest::AbortReplyStream()
+{
+    assert(replyStarted && !replySent && req);
+    struct evhttp_request* reqStream = req;
+    std::shared_ptr<HTTPStreamState> state = stream;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqStream, state]() {
+        struct evhttp_connection* evcon = evhttp_request_get_connection(reqStream);
+        if (evcon) {
+            // Freeing the connection frees the request with it
+            evhttp_connection_set_closecb(evcon, NULL, NULL);
+            evhttp_connection_free(evcon);
+        } else {
+            // The client is gone and libevent left the request to us
+            evhttp_request_free(reqStream);
+        }
+    });
+    ev->trigger(0);
+    replySent = true;
+    req = 0; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer()
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -8,6 +8,7 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <memory>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
@@ -17,6 +18,7 @@ struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+struct HTTPStreamState;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -42,6 +44,12 @@ void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPR
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Run func on one of the HTTP worker threads.
+ * Returns false, and does not run func, if the work queue is not running or
+ * is more than half full.
+ */
+bool HTTPEnqueueWork(const std::function<void()>& func);
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
@@ -55,6 +63,9 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    bool replyStarted;
+    //! Flow control of a streamed reply, shared with the http thread
+    std::shared_ptr<HTTPStreamState> stream;
 
 public:
     HTTPRequest(struct evhttp_request* req);
@@ -110,6 +121,28 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Write part of an HTTP reply.
+     * A reply consisting of a single final piece is sent with WriteReply;
+     * otherwise the first piece starts a chunked reply with status nStatus,
+     * and the piece with fFinal set completes it.
+     *
+     * Blocks while too much of the reply is still waiting to be written to
+     * the client. Returns false if the client has gone away, in which case
+     * the rest of the reply can be skipped.
+     *
+     * @note As with WriteReply, do not call any other HTTPRequest methods after
+     * the final piece.
+     */
+    bool WriteReplyStream(int nStatus, const std::string& strData, bool fFinal);
+
+    /**
+     * Give up on a streamed reply that cannot be completed, closing the
+     * connection so the client does not mistake the partial reply for a
+     * complete one.
+     */
+    void AbortReplyStream();
 };
 
 /** Event handler closure.
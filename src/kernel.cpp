@@ -43,39 +43,36 @@ static int64_t GetStakeModifierSelectionIntervalSection(int nSection)
     return a;
 }
 
-// select a block from the candidate blocks in vSortedByTimestamp, excluding
-// already selected blocks in vSelectedBlocks, and with timestamp up to
-// nSelectionIntervalStop.
-static bool SelectBlockFromCandidates(
-    std::vector<std::pair<int64_t, uint256> >& vSortedByTimestamp,
-    std::map<uint256, const CBlockIndex*>& mapSelectedBlocks,
-    int64_t nSelectionIntervalStop,
-    uint64_t nStakeModifierPrev,
-    const CBlockIndex** pindexSelected)
-{
-    bool fModifierV2 = false;
-    bool fFirstRun = true;
-    bool fSelected = false;
-    uint256 hashBest = 0;
-    *pindexSelected = (const CBlockIndex*)0;
-    for (const PAIRTYPE(int64_t, uint256) & item : vSortedByTimestamp) {
-        if (!mapBlockIndex.count(item.second))
-            return error("%s : failed to find block index for candidate block %s", __func__, item.second.ToString().c_str());
-
-        const CBlockIndex* pindex = mapBlockIndex[item.second];
-        if (fSelected && pindex->GetBlockTime() > nSelectionIntervalStop)
-            break;
-
-        //if the lowest block height (vSortedByTimestamp[0]) is >= switch height, use new modifier calc
-        if (fFirstRun){
-            fModifierV2 = pindex->nHeight >= Params().ModifierUpgradeBlock();
-            fFirstRun = false;
-        }
+// A block considered for a v1 stake modifier, with its selection hash computed
+// once per modifier rather than once per selection round
+struct CModifierCandidate {
+    int64_t nTime;
+    const CBlockIndex* pindex;
+    uint256 hashSelection;
+    bool fSelected;
+
+    CModifierCandidate(const CBlockIndex* pindexIn) : nTime(pindexIn->GetBlockTime()), pindex(pindexIn), hashSelection(0), fSelected(false) {}
+
+    // candidates are ordered by timestamp, then block hash
+    bool operator<(const CModifierCandidate& other) const
+    {
+        if (nTime != other.nTime)
+            return nTime < other.nTime;
+        return pindex->GetBlockHash() < other.pindex->GetBlockHash();
+    }
+};
 
-        if (mapSelectedBlocks.count(pindex->GetBlockHash()) > 0)
-            continue;
+// compute the selection hash of every candidate in vSortedByTimestamp by hashing
+// an input that is unique to that block with the previous stake modifier
+static void ComputeSelectionHashes(std::vector<CModifierCandidate>& vSortedByTimestamp, uint64_t nStakeModifierPrev)
+{
+    if (vSortedByTimestamp.empty())
+        return;
 
-        // compute the selection hash by hashing an input that is unique to that block
+    //if the lowest block height (vSortedByTimestamp[0]) is >= switch height, use new modifier calc
+    const bool fModifierV2 = vSortedByTimestamp[0].pindex->nHeight >= Params().ModifierUpgradeBlock();
+    for (CModifierCandidate& candidate : vSortedByTimestamp) {
+        const CBlockIndex* pindex = candidate.pindex;
         uint256 hashProof;
         if(fModifierV2)
             hashProof = pindex->GetBlockHash();
@@ -84,26 +81,42 @@ static bool SelectBlockFromCandidates(
 
         CDataStream ss(SER_GETHASH, 0);
         ss << hashProof << nStakeModifierPrev;
-        uint256 hashSelection = Hash(ss.begin(), ss.end());
+        candidate.hashSelection = Hash(ss.begin(), ss.end());
 
         // the selection hash is divided by 2**32 so that proof-of-stake block
         // is always favored over proof-of-work block. this is to preserve
         // the energy efficiency property
         if (pindex->IsProofOfStake())
-            hashSelection >>= 32;
-
-        if (fSelected && hashSelection < hashBest) {
-            hashBest = hashSelection;
-            *pindexSelected = (const CBlockIndex*)pindex;
-        } else if (!fSelected) {
-            fSelected = true;
-            hashBest = hashSelection;
-            *pindexSelected = (const CBlockIndex*)pindex;
-        }
+            candidate.hashSelection >>= 32;
     }
-    if (GetBoolArg("-printstakemodifier", false))
-        LogPrintf("%s : selection hash=%s\n", __func__, hashBest.ToString().c_str());
-    return fSelected;
+}
+
+// select a block from the candidate blocks in vSortedByTimestamp, excluding
+// already selected blocks, and with timestamp up to nSelectionIntervalStop.
+static bool SelectBlockFromCandidates(
+    std::vector<CModifierCandidate>& vSortedByTimestamp,
+    int64_t nSelectionIntervalStop,
+    bool fPrintStakeModifier,
+    const CBlockIndex** pindexSelected)
+{
+    CModifierCandidate* pcandidateBest = NULL;
+    for (CModifierCandidate& candidate : vSortedByTimestamp) {
+        if (pcandidateBest && candidate.nTime > nSelectionIntervalStop)
+            break;
+        if (candidate.fSelected)
+            continue;
+        if (!pcandidateBest || candidate.hashSelection < pcandidateBest->hashSelection)
+            pcandidateBest = &candidate;
+    }
+    if (!pcandidateBest) {
+        *pindexSelected = (const CBlockIndex*)0;
+        return false;
+    }
+    if (fPrintStakeModifier)
+        LogPrintf("%s : selection hash=%s\n", __func__, pcandidateBest->hashSelection.ToString().c_str());
+    pcandidateBest->fSelected = true;
+    *pindexSelected = pcandidateBest->pindex;
+    return true;
 }
 
 /* NEW MODIFIER */
@@ -171,51 +184,50 @@ bool ComputeNextStakeModifier(const CBlockIndex* pindexPrev, uint64_t& nStakeMod
     if (!GetLastStakeModifier(pindexPrev, nStakeModifier, nModifierTime))
         return error("%s : unable to get last modifier", __func__);
 
-    if (GetBoolArg("-printstakemodifier", false))
+    const bool fPrintStakeModifier = GetBoolArg("-printstakemodifier", false);
+    if (fPrintStakeModifier)
         LogPrintf("%s : prev modifier= %s time=%s\n", __func__, std::to_string(nStakeModifier).c_str(), DateTimeStrFormat("%Y-%m-%d %H:%M:%S", nModifierTime).c_str());
 
     if (nModifierTime / MODIFIER_INTERVAL >= pindexPrev->GetBlockTime() / MODIFIER_INTERVAL)
         return true;
 
     // Sort candidate blocks by timestamp
-    std::vector<std::pair<int64_t, uint256> > vSortedByTimestamp;
+    std::vector<CModifierCandidate> vSortedByTimestamp;
     vSortedByTimestamp.reserve(64 * MODIFIER_INTERVAL  / Params().TargetSpacing());
     int64_t nSelectionIntervalStart = (pindexPrev->GetBlockTime() / MODIFIER_INTERVAL ) * MODIFIER_INTERVAL  - OLD_MODIFIER_INTERVAL;
     const CBlockIndex* pindex = pindexPrev;
 
     while (pindex && pindex->GetBlockTime() >= nSelectionIntervalStart) {
-        vSortedByTimestamp.push_back(std::make_pair(pindex->GetBlockTime(), pindex->GetBlockHash()));
+        vSortedByTimestamp.push_back(CModifierCandidate(pindex));
         pindex = pindex->pprev;
     }
 
     int nHeightFirstCandidate = pindex ? (pindex->nHeight + 1) : 0;
     std::reverse(vSortedByTimestamp.begin(), vSortedByTimestamp.end());
     std::sort(vSortedByTimestamp.begin(), vSortedByTimestamp.end());
+    ComputeSelectionHashes(vSortedByTimestamp, nStakeModifier);
 
     // Select 64 blocks from candidate blocks to generate stake modifier
     uint64_t nStakeModifierNew = 0;
     int64_t nSelectionIntervalStop = nSelectionIntervalStart;
-    std::map<uint256, const CBlockIndex*> mapSelectedBlocks;
     for (int nRound = 0; nRound < std::min(64, (int)vSortedByTimestamp.size()); nRound++) {
         // add an interval section to the current selection round
         nSelectionIntervalStop += GetStakeModifierSelectionIntervalSection(nRound);
 
         // select a block from the candidates of current round
-        if (!SelectBlockFromCandidates(vSortedByTimestamp, mapSelectedBlocks, nSelectionIntervalStop, nStakeModifier, &pindex))
+        if (!SelectBlockFromCandidates(vSortedByTimestamp, nSelectionIntervalStop, fPrintStakeModifier, &pindex))
             return error("%s : unable to select block at round %d", __func__, nRound);
 
         // write the entropy bit of the selected block
         nStakeModifierNew |= (((uint64_t)pindex->GetStakeEntropyBit()) << nRound);
 
-        // add the selected block from candidates to selected list
-        mapSelectedBlocks.insert(std::make_pair(pindex->GetBlockHash(), pindex));
-        if (GetBoolArg("-printstakemodifier", false))
+        if (fPrintStakeModifier)
             LogPrintf("%s : selected round %d stop=%s height=%d bit=%d\n", __func__,
                 nRound, DateTimeStrFormat("%Y-%m-%d %H:%M:%S", nSelectionIntervalStop).c_str(), pindex->nHeight, pindex->GetStakeEntropyBit());
     }
 
     // Print selection map for visualization of the selected blocks
-    if (GetBoolArg("-printstakemodifier", false)) {
+    if (fPrintStakeModifier) {
         std::string strSelectionMap = "";
         // '-' indicates proof-of-work blocks not selected
         strSelectionMap.insert(0, pindexPrev->nHeight - nHeightFirstCandidate + 1, '-');
@@ -226,14 +238,16 @@ bool ComputeNextStakeModifier(const CBlockIndex* pindexPrev, uint64_t& nStakeMod
                 strSelectionMap.replace(pindex->nHeight - nHeightFirstCandidate, 1, "=");
             pindex = pindex->pprev;
         }
-        for (const std::pair<const uint256, const CBlockIndex*> &item : mapSelectedBlocks) {
+        for (const CModifierCandidate& candidate : vSortedByTimestamp) {
+            if (!candidate.fSelected)
+                continue;
             // 'S' indicates selected proof-of-stake blocks
             // 'W' indicates selected proof-of-work blocks
-            strSelectionMap.replace(item.second->nHeight - nHeightFirstCandidate, 1, item.second->IsProofOfStake() ? "S" : "W");
+            strSelectionMap.replace(candidate.pindex->nHeight - nHeightFirstCandidate, 1, candidate.pindex->IsProofOfStake() ? "S" : "W");
         }
         LogPrintf("%s : selection height [%d, %d] map %s\n", __func__, nHeightFirstCandidate, pindexPrev->nHeight, strSelectionMap.c_str());
     }
-    if (GetBoolArg("-printstakemodifier", false)) {
+    if (fPrintStakeModifier) {
         LogPrintf("%s : new modifier=%s time=%s\n", __func__, std::to_string(nStakeModifierNew).c_str(), DateTimeStrFormat("%Y-%m-%d %H:%M:%S", pindexPrev->GetBlockTime()).c_str());
     }
 
@@ -242,6 +256,44 @@ bool ComputeNextStakeModifier(const CBlockIndex* pindexPrev, uint64_t& nStakeMod
     return true;
 }
 
+// Kernel stake modifiers already looked up, by block-from hash. The modifier only
+// depends on the active chain up to the block it was taken from, so an entry is
+// valid for as long as that block is still on the active chain; entries left
+// behind by a reorg are recomputed on their next lookup.
+struct CKernelModifierEntry {
+    const CBlockIndex* pindexModifier;
+    uint64_t nStakeModifier;
+    int nStakeModifierHeight;
+    int64_t nStakeModifierTime;
+};
+
+static Mutex cs_kernelModifierCache;
+static boost::unordered_map<uint256, CKernelModifierEntry, BlockHasher> mapKernelModifierCache;
+
+static bool LookupKernelModifierCache(const uint256& hashBlockFrom, uint64_t& nStakeModifier, int& nStakeModifierHeight, int64_t& nStakeModifierTime)
+{
+    LOCK(cs_kernelModifierCache);
+    boost::unordered_map<uint256, CKernelModifierEntry, BlockHasher>::const_iterator it = mapKernelModifierCache.find(hashBlockFrom);
+    if (it == mapKernelModifierCache.end())
+        return false;
+    if (!chainActive.Contains(it->second.pindexModifier)) {
+        mapKernelModifierCache.erase(it);
+        return false;
+    }
+    nStakeModifier = it->second.nStakeModifier;
+    nStakeModifierHeight = it->second.nStakeModifierHeight;
+    nStakeModifierTime = it->second.nStakeModifierTime;
+    return true;
+}
+
+static void AddKernelModifierCache(const uint256& hashBlockFrom, const CKernelModifierEntry& entry)
+{
+    LOCK(cs_kernelModifierCache);
+    if (mapKernelModifierCache.size() >= MAX_KERNEL_MODIFIER_CACHE_SIZE)
+        mapKernelModifierCache.clear();
+    mapKernelModifierCache[hashBlockFrom] = entry;
+}
+
 // The stake modifier used to hash for a stake kernel is chosen as the stake
 // modifier about a selection interval later than the coin generating the kernel
 bool GetKernelStakeModifier(const uint256& hashBlockFrom, uint64_t& nStakeModifier, int& nStakeModifierHeight, int64_t& nStakeModifierTime, bool fPrintProofOfStake)
@@ -261,6 +313,8 @@ bool GetKernelStakeModifier(const uint256& hashBlockFrom, uint64_t& nStakeModifi
         nStakeModifier = pindexFrom->nStakeModifier;
         return true;
     }
+    if (LookupKernelModifierCache(hashBlockFrom, nStakeModifier, nStakeModifierHeight, nStakeModifierTime))
+        return true;
     const CBlockIndex* pindex = pindexFrom;
     CBlockIndex* pindexNext = chainActive[pindex->nHeight + 1];
 
@@ -279,6 +333,7 @@ bool GetKernelStakeModifier(const uint256& hashBlockFrom, uint64_t& nStakeModifi
     } while (nStakeModifierTime < pindexFrom->GetBlockTime() + OLD_MODIFIER_INTERVAL);
 
     nStakeModifier = pindex->nStakeModifier;
+    AddKernelModifierCache(hashBlockFrom, {pindex, nStakeModifier, nStakeModifierHeight, nStakeModifierTime});
     return true;
 }
 
@@ -16,6 +16,10 @@ static const unsigned int MODIFIER_INTERVAL = 60;
 // ratio of group interval length between the last group and the first group
 static const int MODIFIER_INTERVAL_RATIO = 3;
 
+// MAX_KERNEL_MODIFIER_CACHE_SIZE: kernel stake modifier lookups remembered
+// before the cache is reset
+static const unsigned int MAX_KERNEL_MODIFIER_CACHE_SIZE = 100000;
+
 // Compute the hash modifier for proof-of-stake
 bool GetKernelStakeModifier(const uint256& hashBlockFrom, uint64_t& nStakeModifier, int& nStakeModifierHeight, int64_t& nStakeModifierTime, bool fPrintProofOfStake);
 bool ComputeNextStakeModifier(const CBlockIndex* pindexPrev, uint64_t& nStakeModifier, bool& fGeneratedStakeModifier);
@@ -26,6 +26,7 @@
 #include "messagesigner.h"
 #include "net.h"
 #include "obfuscation.h"
+#include "perfstats.h"
 #include "pow.h"
 #include "spork.h"
 #include "sporkdb.h"
@@ -75,6 +76,8 @@ using namespace libzerocoin;
 RecursiveMutex cs_main;
 
 BlockMap mapBlockIndex;
+/** Storage for the entries of mapBlockIndex. */
+static CBlockIndexArena blockIndexArena;
 std::map<uint256, uint256> mapProofOfStake;
 CChain chainActive;
 CBlockIndex* pindexBestHeader = nullptr;
@@ -93,6 +96,7 @@ bool fIsBareMultisigStd = true;
 bool fCheckBlockIndex = false;
 bool fVerifyingBlocks = false;
 unsigned int nCoinCacheSize = 5000;
+unsigned int nCoinCacheRetainSize = 2500;
 bool fAlerts = DEFAULT_ALERTS;
 bool fClearSpendCache = false;
 
@@ -628,6 +632,7 @@ CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& loc
 }
 
 CCoinsViewCache* pcoinsTip = nullptr;
+CCoinsViewWriteBehind* pcoinsWriteBehind = nullptr;
 CBlockTreeDB* pblocktree = nullptr;
 CZerocoinDB* zerocoinDB = nullptr;
 CSporkDB* pSporkDB = nullptr;
@@ -935,10 +940,7 @@ int GetInputAgeIX(uint256 nTXHash, CTxIn& vin)
     if (nResult < 0) nResult = 0;
 
     if (nResult < 6) {
-        std::map<uint256, CTransactionLock>::iterator i = mapTxLocks.find(nTXHash);
-        if (i != mapTxLocks.end()) {
-            sigs = (*i).second.CountSignatures();
-        }
+        sigs = swifttxManager.CountSignatures(nTXHash);
         if (sigs >= SWIFTTX_SIGNATURES_REQUIRED) {
             return nSwiftTXDepth + nResult;
         }
@@ -949,12 +951,7 @@ int GetInputAgeIX(uint256 nTXHash, CTxIn& vin)
 
 int GetIXConfirmations(uint256 nTXHash)
 {
-    int sigs = 0;
-
-    std::map<uint256, CTransactionLock>::iterator i = mapTxLocks.find(nTXHash);
-    if (i != mapTxLocks.end()) {
-        sigs = (*i).second.CountSignatures();
-    }
+    int sigs = swifttxManager.CountSignatures(nTXHash);
     if (sigs >= SWIFTTX_SIGNATURES_REQUIRED) {
         return nSwiftTXDepth;
     }
@@ -1292,6 +1289,32 @@ CAmount GetMinRelayFee(const CTransaction& tx, unsigned int nBytes, bool fAllowF
 }
 
 
+static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+
+/**
+ * CheckInputs for a loose transaction. The scripts of large transactions are verified
+ * on the script-checking threads; the queue is shared with ConnectBlock, which is
+ * serialized against us by cs_main. On failure the inputs are checked again serially
+ * so that state carries the exact reject reason.
+ */
+static bool CheckInputsForMempool(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& view, unsigned int flags)
+{
+    AssertLockHeld(cs_main);
+    if (!nScriptCheckThreads || tx.vin.size() < MEMPOOL_PARALLEL_SCRIPTCHECK_MIN_INPUTS)
+        return CheckInputs(tx, state, view, true, flags, true);
+
+    std::vector<CScriptCheck> vChecks;
+    if (!CheckInputs(tx, state, view, true, flags, true, &vChecks))
+        return false;
+
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+    control.Add(vChecks);
+    if (control.Wait())
+        return true;
+
+    return CheckInputs(tx, state, view, true, flags, true);
+}
+
 bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState& state, const CTransaction& tx, bool fLimitFree, bool* pfMissingInputs, bool fRejectInsaneFee, bool ignoreFees)
 {
     AssertLockHeld(cs_main);
@@ -1339,14 +1362,11 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState& state, const CTransa
 
     // ----------- swiftTX transaction scanning -----------
 
-    BOOST_FOREACH (const CTxIn& in, tx.vin) {
-        if (mapLockedInputs.count(in.prevout)) {
-            if (mapLockedInputs[in.prevout] != tx.GetHash()) {
-                return state.DoS(0,
-                    error("%s : conflicts with existing transaction lock: %s",
-                            __func__, reason), REJECT_INVALID, "tx-lock-conflict");
-            }
-        }
+    uint256 hashLocked;
+    if (swifttxManager.GetConflictingLock(tx, hashLocked)) {
+        return state.DoS(0,
+            error("%s : conflicts with existing transaction lock: %s",
+                    __func__, reason), REJECT_INVALID, "tx-lock-conflict");
     }
 
     // Check for conflicts with in-memory transactions
@@ -1532,7 +1552,7 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState& state, const CTransa
         int flags = STANDARD_SCRIPT_VERIFY_FLAGS;
         if (fCLTVIsActive)
             flags |= SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY;
-        if (!CheckInputs(tx, state, view, true, flags, true)) {
+        if (!CheckInputsForMempool(tx, state, view, flags)) {
             return error("%s : ConnectInputs failed %s", __func__, hash.ToString());
         }
 
@@ -1548,7 +1568,7 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState& state, const CTransa
         flags = MANDATORY_SCRIPT_VERIFY_FLAGS;
         if (fCLTVIsActive)
             flags |= SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY;
-        if (!CheckInputs(tx, state, view, true, flags, true)) {
+        if (!CheckInputsForMempool(tx, state, view, flags)) {
             return error("%s : BUG! PLEASE REPORT THIS! ConnectInputs failed against MANDATORY but not STANDARD flags %s",
                     __func__, hash.ToString());
         }
@@ -1597,14 +1617,11 @@ bool AcceptableInputs(CTxMemPool& pool, CValidationState& state, const CTransact
 
     // ----------- swiftTX transaction scanning -----------
 
-    BOOST_FOREACH (const CTxIn& in, tx.vin) {
-        if (mapLockedInputs.count(in.prevout)) {
-            if (mapLockedInputs[in.prevout] != tx.GetHash()) {
-                return state.DoS(0,
-                    error("AcceptableInputs : conflicts with existing transaction lock: %s", reason),
-                    REJECT_INVALID, "tx-lock-conflict");
-            }
-        }
+    uint256 hashLocked;
+    if (swifttxManager.GetConflictingLock(tx, hashLocked)) {
+        return state.DoS(0,
+            error("AcceptableInputs : conflicts with existing transaction lock: %s", reason),
+            REJECT_INVALID, "tx-lock-conflict");
     }
 
     // Check for conflicts with in-memory transactions
@@ -1777,8 +1794,8 @@ bool GetTransaction(const uint256& hash, CTransaction& txOut, uint256& hashBlock
 {
     CBlockIndex* pindexSlow = blockIndex;
 
-    LOCK(cs_main);
-
+    // cs_main is only taken where the chain state is consulted, so that the
+    // txindex and block file reads of concurrent RPC callers do not serialize.
     if (!blockIndex) {
         if (mempool.lookup(hash, txOut)) {
             return true;
@@ -1809,6 +1826,7 @@ bool GetTransaction(const uint256& hash, CTransaction& txOut, uint256& hashBlock
         }
 
         if (fAllowSlow) { // use coin database to locate block that contains transaction, and scan it
+            LOCK(cs_main);
             int nHeight = -1;
             {
                 CCoinsViewCache& view = *pcoinsTip;
@@ -1822,8 +1840,13 @@ bool GetTransaction(const uint256& hash, CTransaction& txOut, uint256& hashBlock
     }
 
     if (pindexSlow) {
+        CDiskBlockPos blockPos;
+        {
+            LOCK(cs_main);
+            blockPos = pindexSlow->GetBlockPos();
+        }
         CBlock block;
-        if (ReadBlockFromDisk(block, pindexSlow)) {
+        if (ReadBlockFromDisk(block, blockPos) && block.GetHash() == pindexSlow->GetBlockHash()) {
             BOOST_FOREACH (const CTransaction& tx, block.vtx) {
                 if (tx.GetHash() == hash) {
                     txOut = tx;
@@ -1900,6 +1923,54 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex)
     return true;
 }
 
+bool ReadRawBlockFromDisk(std::vector<char>& vchBlock, const CDiskBlockPos& pos)
+{
+    // Blocks are stored as message start, size and block: step back over the index header
+    if (pos.nPos < MESSAGE_START_SIZE + sizeof(unsigned int))
+        return error("%s : invalid block position %d:%u", __func__, pos.nFile, pos.nPos);
+    CDiskBlockPos hpos(pos.nFile, pos.nPos - (MESSAGE_START_SIZE + sizeof(unsigned int)));
+
+    CAutoFile filein(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return error("%s : OpenBlockFile failed for %d:%u", __func__, pos.nFile, pos.nPos);
+
+    try {
+        MessageStartChars blkStart;
+        unsigned int nSize;
+        filein >> FLATDATA(blkStart) >> nSize;
+        if (memcmp(blkStart, Params().MessageStart(), MESSAGE_START_SIZE))
+            return error("%s : block magic mismatch at %d:%u", __func__, pos.nFile, pos.nPos);
+        if (nSize > MAX_BLOCK_SIZE_CURRENT)
+            return error("%s : block size %u too large at %d:%u", __func__, nSize, pos.nFile, pos.nPos);
+
+        vchBlock.resize(nSize);
+        if (nSize > 0)
+            filein.read(&vchBlock[0], nSize);
+    } catch (const std::exception& e) {
+        return error("%s : I/O error - %s", __func__, e.what());
+    }
+
+    return true;
+}
+
+bool ReadRawBlockFromDisk(std::vector<char>& vchBlock, const CBlockIndex* pindex)
+{
+    if (!ReadRawBlockFromDisk(vchBlock, pindex->GetBlockPos()))
+        return false;
+
+    // Only the header is decoded to make sure the bytes belong to this index entry
+    try {
+        CBlockHeader header;
+        CDataStream ssHeader(vchBlock.data(), vchBlock.data() + std::min(vchBlock.size(), sizeof(CBlockHeader)), SER_DISK, CLIENT_VERSION);
+        ssHeader >> header;
+        if (header.GetHash() != pindex->GetBlockHash())
+            return error("%s : GetHash() doesn't match index for %s", __func__, pindex->GetBlockHash().GetHex());
+    } catch (const std::exception& e) {
+        return error("%s : Deserialize error - %s", __func__, e.what());
+    }
+    return true;
+}
+
 
 double ConvertBitsToDouble(unsigned int nBits)
 {
@@ -2752,8 +2823,6 @@ void static FlushBlockFile(bool fFinalize = false)
 
 bool FindUndoPos(CValidationState& state, int nFile, CDiskBlockPos& pos, unsigned int nAddSize);
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
-
 void ThreadScriptCheck()
 {
     util::ThreadRename("dogecash-scriptch");
@@ -2777,7 +2846,7 @@ void AddWrappedSerialsInflation()
 
         // Add inflated denominations to block index mapSupply
         for (auto denom : libzerocoin::zerocoinDenomList) {
-            pindex->mapZerocoinSupply.at(denom) += GetWrapppedSerialInflation(denom);
+            pindex->zerocoinSupply.at(denom) += GetWrapppedSerialInflation(denom);
         }
         // Update current block index to disk
         assert(pblocktree->WriteBlockIndex(CDiskBlockIndex(pindex)));
@@ -2810,10 +2879,9 @@ void RecalculatezdogecMinted()
         std::list<CZerocoinMint> listMints;
         BlockToZerocoinMintList(block, listMints, true);
 
-        vector<libzerocoin::CoinDenomination> vDenomsBefore = pindex->vMintDenominationsInBlock;
-        pindex->vMintDenominationsInBlock.clear();
+        pindex->mintsInBlock.SetNull();
         for (auto mint : listMints)
-            pindex->vMintDenominationsInBlock.emplace_back(mint.GetDenomination());
+            pindex->mintsInBlock.Add(mint.GetDenomination());
 
         if (pindex->nHeight < chainHeight)
             pindex = chainActive.Next(pindex);
@@ -2842,22 +2910,21 @@ void RecalculatezdogecSpent()
         list<libzerocoin::CoinDenomination> listDenomsSpent = ZerocoinSpendListFromBlock(block, true);
 
         //Reset the supply to previous block
-        pindex->mapZerocoinSupply = pindex->pprev->mapZerocoinSupply;
+        pindex->zerocoinSupply = pindex->pprev->zerocoinSupply;
 
         //Add mints to zdogec supply
         for (auto denom : libzerocoin::zerocoinDenomList) {
-            long nDenomAdded = count(pindex->vMintDenominationsInBlock.begin(), pindex->vMintDenominationsInBlock.end(), denom);
-            pindex->mapZerocoinSupply.at(denom) += nDenomAdded;
+            pindex->zerocoinSupply.at(denom) += pindex->mintsInBlock.Count(denom);
         }
 
         //Remove spends from zdogec supply
         for (auto denom : listDenomsSpent)
-            pindex->mapZerocoinSupply.at(denom)--;
+            pindex->zerocoinSupply.at(denom)--;
 
         // Add inflation from Wrapped Serials if block is Zerocoin_Block_EndFakeSerial()
         if (pindex->nHeight == Params().Zerocoin_Block_EndFakeSerial() + 1)
             for (auto denom : libzerocoin::zerocoinDenomList) {
-                pindex->mapZerocoinSupply.at(denom) += GetWrapppedSerialInflation(denom);
+                pindex->zerocoinSupply.at(denom) += GetWrapppedSerialInflation(denom);
             }
 
         //Rewrite money supply
@@ -3012,7 +3079,7 @@ bool UpdatezdogecSupply(const CBlock& block, CBlockIndex* pindex, bool fJustChec
     
 
     //Reset the supply to previous block
-    pindex->mapZerocoinSupply = pindex->pprev->mapZerocoinSupply;
+    pindex->zerocoinSupply = pindex->pprev->zerocoinSupply;
 
     //Add mints to zdogec supply (mints are forever disabled after last checkpoint)
     if (pindex->nHeight < Params().Zerocoin_Block_LastGoodCheckpoint()) {
@@ -3020,7 +3087,7 @@ bool UpdatezdogecSupply(const CBlock& block, CBlockIndex* pindex, bool fJustChec
         std::set<uint256> setAddedToWallet;
         BlockToZerocoinMintList(block, listMints, true);
         for (const auto& m : listMints) {
-            pindex->mapZerocoinSupply.at(m.GetDenomination())++;
+            pindex->zerocoinSupply.at(m.GetDenomination())++;
 
             //Remove any of our own mints from the mintpool
             if (!fJustCheck && pwalletMain) {
@@ -3047,9 +3114,9 @@ bool UpdatezdogecSupply(const CBlock& block, CBlockIndex* pindex, bool fJustChec
     //Remove spends from zDOGEC supply        
     std::list<libzerocoin::CoinDenomination> listDenomsSpent = ZerocoinSpendListFromBlock(block, true);
     for (const auto& denom : listDenomsSpent) {
-        pindex->mapZerocoinSupply.at(denom)--;
+        pindex->zerocoinSupply.at(denom)--;
         // zerocoin failsafe
-        if (pindex->mapZerocoinSupply.at(denom) < 0)
+        if (pindex->zerocoinSupply.at(denom) < 0)
             return error("Block contains zerocoins that spend more than are in the available supply to spend");
     }
 
@@ -3058,21 +3125,20 @@ bool UpdatezdogecSupply(const CBlock& block, CBlockIndex* pindex, bool fJustChec
     if (Params().NetworkID() == CBaseChainParams::MAIN && pindex->nHeight == Params().Zerocoin_Block_EndFakeSerial() + 1
             && pindex->GetZerocoinSupply() < Params().GetSupplyBeforeFakeSerial() + GetWrapppedSerialInflationAmount()) {
         for (const auto& denom : libzerocoin::zerocoinDenomList)
-            pindex->mapZerocoinSupply.at(denom) += GetWrapppedSerialInflation(denom);
+            pindex->zerocoinSupply.at(denom) += GetWrapppedSerialInflation(denom);
         }
     }
 
     for (const auto& denom : libzerocoin::zerocoinDenomList)
-        LogPrint("zero", "%s coins for denomination %d pubcoin %s\n", __func__, denom, pindex->mapZerocoinSupply.at(denom));
+        LogPrint("zero", "%s coins for denomination %d pubcoin %s\n", __func__, denom, pindex->zerocoinSupply.at(denom));
 
     return true;
 }
 
-static int64_t nTimeVerify = 0;
-static int64_t nTimeConnect = 0;
-static int64_t nTimeIndex = 0;
-static int64_t nTimeCallbacks = 0;
-static int64_t nTimeTotal = 0;
+static CPerfStage stageConnectBlockConnect("connectblock.connect");
+static CPerfStage stageConnectBlockVerify("connectblock.verify");
+static CPerfStage stageConnectBlockIndex("connectblock.index");
+static CPerfStage stageConnectBlockCallbacks("connectblock.callbacks");
 
 bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex, CCoinsViewCache& view, bool fJustCheck, bool fAlreadyChecked)
 {
@@ -3298,8 +3364,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
 //              FormatMoney(nFees), FormatMoney(nMint), FormatMoney(nAmountZerocoinSpent));
 
     int64_t nTime1 = GetTimeMicros();
-    nTimeConnect += nTime1 - nTimeStart;
-    LogPrint("bench", "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs]\n", (unsigned)block.vtx.size(), 0.001 * (nTime1 - nTimeStart), 0.001 * (nTime1 - nTimeStart) / block.vtx.size(), nInputs <= 1 ? 0 : 0.001 * (nTime1 - nTimeStart) / (nInputs - 1), nTimeConnect * 0.000001);
+    stageConnectBlockConnect.Add(nTime1 - nTimeStart);
+    LogPrint("bench", "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs]\n", (unsigned)block.vtx.size(), 0.001 * (nTime1 - nTimeStart), 0.001 * (nTime1 - nTimeStart) / block.vtx.size(), nInputs <= 1 ? 0 : 0.001 * (nTime1 - nTimeStart) / (nInputs - 1), stageConnectBlockConnect.Total() * 0.000001);
 
     //PoW phase redistributed fees to miner. PoS stage destroys fees.
     CAmount nExpectedMint = GetBlockValue(pindex->nHeight);
@@ -3328,8 +3394,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     if (!control.Wait())
         return state.DoS(100, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
     int64_t nTime2 = GetTimeMicros();
-    nTimeVerify += nTime2 - nTimeStart;
-    LogPrint("bench", "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs]\n", nInputs - 1, 0.001 * (nTime2 - nTimeStart), nInputs <= 1 ? 0 : 0.001 * (nTime2 - nTimeStart) / (nInputs - 1), nTimeVerify * 0.000001);
+    stageConnectBlockVerify.Add(nTime2 - nTimeStart);
+    LogPrint("bench", "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs]\n", nInputs - 1, 0.001 * (nTime2 - nTimeStart), nInputs <= 1 ? 0 : 0.001 * (nTime2 - nTimeStart) / (nInputs - 1), stageConnectBlockVerify.Total() * 0.000001);
 
     //IMPORTANT NOTE: Nothing before this point should actually store to disk (or even memory)
     if (fJustCheck)
@@ -3398,8 +3464,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         view.SetBestBlock(pindex->GetBlockHash());
 
     int64_t nTime3 = GetTimeMicros();
-    nTimeIndex += nTime3 - nTime2;
-    LogPrint("bench", "    - Index writing: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2), nTimeIndex * 0.000001);
+    stageConnectBlockIndex.Add(nTime3 - nTime2);
+    LogPrint("bench", "    - Index writing: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2), stageConnectBlockIndex.Total() * 0.000001);
 
     // Watch for changes to the previous coinbase transaction.
     static uint256 hashPrevBestCoinBase;
@@ -3407,8 +3473,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     hashPrevBestCoinBase = block.vtx[0].GetHash();
 
     int64_t nTime4 = GetTimeMicros();
-    nTimeCallbacks += nTime4 - nTime3;
-    LogPrint("bench", "    - Callbacks: %.2fms [%.2fs]\n", 0.001 * (nTime4 - nTime3), nTimeCallbacks * 0.000001);
+    stageConnectBlockCallbacks.Add(nTime4 - nTime3);
+    LogPrint("bench", "    - Callbacks: %.2fms [%.2fs]\n", 0.001 * (nTime4 - nTime3), stageConnectBlockCallbacks.Total() * 0.000001);
 
     //Continue tracking possible movement of fraudulent funds until they are completely frozen
     if (pindex->nHeight >= Params().Zerocoin_Block_FirstFraudulent() && pindex->nHeight <= Params().Zerocoin_Block_RecalculateAccumulators() + 1)
@@ -3430,6 +3496,11 @@ enum FlushStateMode {
     FLUSH_STATE_ALWAYS
 };
 
+bool CoinsCacheFlushNeeded(size_t nCacheSize, size_t nWriting, size_t nLimit)
+{
+    return nCacheSize + std::min(nWriting, nLimit / 2) > nLimit;
+}
+
 /**
  * Update the on-disk chain state.
  * The caches and indexes are flushed if either they're too large, forceWrite is set, or
@@ -3439,9 +3510,18 @@ bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode)
 {
     LOCK(cs_main);
     static int64_t nLastWrite = 0;
+    // Best chain of the last background coins write, reported to the wallet once it is on disk
+    static CBlockLocator locatorWriting;
+    static bool fLocatorWriting = false;
     try {
+        if (fLocatorWriting && !pcoinsWriteBehind->IsWriting()) {
+            GetMainSignals().SetBestChain(locatorWriting);
+            fLocatorWriting = false;
+        }
+        // A batch still being written holds its coins in memory too, so it counts against the cache size.
+        const size_t nCoinsWriting = pcoinsWriteBehind ? pcoinsWriteBehind->GetWritingSize() : 0;
         if ((mode == FLUSH_STATE_ALWAYS) ||
-            ((mode == FLUSH_STATE_PERIODIC || mode == FLUSH_STATE_IF_NEEDED) && pcoinsTip->GetCacheSize() > nCoinCacheSize) ||
+            ((mode == FLUSH_STATE_PERIODIC || mode == FLUSH_STATE_IF_NEEDED) && CoinsCacheFlushNeeded(pcoinsTip->GetCacheSize(), nCoinsWriting, nCoinCacheSize)) ||
             (mode == FLUSH_STATE_PERIODIC && GetTimeMicros() > nLastWrite + DATABASE_WRITE_INTERVAL * 1000000)) {
             // Typical CCoins structures on disk are around 100 bytes in size.
             // Pushing a new one to the database can cause it to be written
@@ -3471,11 +3551,32 @@ bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode)
                 }
             }
             // Finally flush the chainstate (which may refer to block index entries).
-            if (!pcoinsTip->Flush())
-                return state.Abort("Failed to write to coin database");
-            // Update best block in wallet (so we can detect restored wallets).
-            if (mode != FLUSH_STATE_IF_NEEDED) {
-                GetMainSignals().SetBestChain(chainActive.GetLocator());
+            if (pcoinsWriteBehind && mode != FLUSH_STATE_ALWAYS) {
+                // Hand the modified coins to the background writer and keep part of the
+                // cache (modified entries first, otherwise in no particular order), so block
+                // connection neither waits on LevelDB nor restarts from an empty cache. The
+                // batch and the retained entries together stay within half of nCoinCacheSize,
+                // leaving the other half to the blocks connected while the batch is written.
+                // This only blocks if the previous batch is still being written.
+                CCoinsMap mapDirty;
+                if (!pcoinsWriteBehind->WaitForWrite())
+                    return state.Abort("Failed to write to coin database");
+                pcoinsTip->DetachDirty(mapDirty, nCoinCacheRetainSize, nCoinCacheSize / 2);
+                if (!pcoinsWriteBehind->WriteAsync(mapDirty, pcoinsTip->GetBestBlock()))
+                    return state.Abort("Failed to write to coin database");
+                if (mode != FLUSH_STATE_IF_NEEDED) {
+                    locatorWriting = chainActive.GetLocator();
+                    fLocatorWriting = true;
+                }
+            } else {
+                bool fFlushed = mode == FLUSH_STATE_ALWAYS ? pcoinsTip->Flush() : pcoinsTip->Flush(nCoinCacheRetainSize);
+                if (!fFlushed)
+                    return state.Abort("Failed to write to coin database");
+                // Update best block in wallet (so we can detect restored wallets).
+                if (mode != FLUSH_STATE_IF_NEEDED) {
+                    GetMainSignals().SetBestChain(chainActive.GetLocator());
+                    fLocatorWriting = false;
+                }
             }
             nLastWrite = GetTimeMicros();
         }
@@ -3533,6 +3634,8 @@ void static UpdateTip(CBlockIndex* pindexNew)
     }
 }
 
+static CPerfStage stageDisconnectTipDisconnect("disconnecttip.disconnect");
+
 /** Disconnect chainActive's tip. */
 bool static DisconnectTip(CValidationState& state)
 {
@@ -3551,22 +3654,27 @@ bool static DisconnectTip(CValidationState& state)
             return error("DisconnectTip() : DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         assert(view.Flush());
     }
-    LogPrint("bench", "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
+    stageDisconnectTipDisconnect.Add(GetTimeMicros() - nStart);
+    LogPrint("bench", "- Disconnect block: %.2fms\n", stageDisconnectTipDisconnect.Last() * 0.001);
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(state, FLUSH_STATE_ALWAYS))
         return false;
     // Resurrect mempool transactions from the disconnected block.
+    list<CTransaction> removed;
     BOOST_FOREACH (const CTransaction& tx, block.vtx) {
         // ignore validation errors in resurrected transactions
-        list<CTransaction> removed;
         CValidationState stateDummy;
         if (tx.IsCoinBase() || tx.IsCoinStake() || !AcceptToMemoryPool(mempool, stateDummy, tx, false, NULL))
             mempool.remove(tx, removed, true);
     }
-    mempool.removeCoinbaseSpends(pcoinsTip, pindexDelete->nHeight);
+    mempool.removeCoinbaseSpends(pcoinsTip, pindexDelete->nHeight, removed);
     mempool.check(pcoinsTip);
     // Update chainActive and related variables.
     UpdateTip(pindexDelete->pprev);
+    GetMainSignals().BlockDisconnected(block);
+    BOOST_FOREACH (const CTransaction& tx, removed) {
+        GetMainSignals().TransactionRemovedFromMempool(tx);
+    }
     // Let wallets know transactions went from 1-confirmed to
     // 0-confirmed or conflicted:
     BOOST_FOREACH (const CTransaction& tx, block.vtx) {
@@ -3575,11 +3683,26 @@ bool static DisconnectTip(CValidationState& state)
     return true;
 }
 
-static int64_t nTimeReadFromDisk = 0;
-static int64_t nTimeConnectTotal = 0;
-static int64_t nTimeFlush = 0;
-static int64_t nTimeChainState = 0;
-static int64_t nTimePostConnect = 0;
+static CPerfStage stageConnectTipLoad("connecttip.load");
+static CPerfStage stageConnectTipConnect("connecttip.connect");
+static CPerfStage stageConnectTipFlush("connecttip.flush");
+static CPerfStage stageConnectTipChainState("connecttip.chainstate");
+static CPerfStage stageConnectTipPostProcess("connecttip.postprocess");
+static CPerfStage stageConnectTipTotal("connecttip.total");
+
+/** Tell the wallets about the transactions that went from the mempool to conflicted,
+ * and about those the connected block confirmed.
+ */
+static void SyncConnectedTransactions(const CBlock& block, const std::list<CTransaction>& txConflicted)
+{
+    BOOST_FOREACH (const CTransaction& tx, txConflicted) {
+        GetMainSignals().TransactionRemovedFromMempool(tx);
+        SyncWithWallets(tx, NULL);
+    }
+    BOOST_FOREACH (const CTransaction& tx, block.vtx) {
+        SyncWithWallets(tx, &block);
+    }
+}
 
 /**
  * Connect a new block to chainActive. pblock is either NULL or a pointer to a CBlock
@@ -3604,9 +3727,9 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, CBlock*
     }
     // Apply the block atomically to the chain state.
     int64_t nTime2 = GetTimeMicros();
-    nTimeReadFromDisk += nTime2 - nTime1;
+    stageConnectTipLoad.Add(nTime2 - nTime1);
     int64_t nTime3;
-    LogPrint("bench", "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * 0.001, nTimeReadFromDisk * 0.000001);
+    LogPrint("bench", "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * 0.001, stageConnectTipLoad.Total() * 0.000001);
     {
         CInv inv(MSG_BLOCK, pindexNew->GetBlockHash());
         bool rv = ConnectBlock(*pblock, state, pindexNew, view, false, fAlreadyChecked);
@@ -3618,13 +3741,13 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, CBlock*
         }
         mapBlockSource.erase(inv.hash);
         nTime3 = GetTimeMicros();
-        nTimeConnectTotal += nTime3 - nTime2;
-        LogPrint("bench", "  - Connect total: %.2fms [%.2fs]\n", (nTime3 - nTime2) * 0.001, nTimeConnectTotal * 0.000001);
+        stageConnectTipConnect.Add(nTime3 - nTime2);
+        LogPrint("bench", "  - Connect total: %.2fms [%.2fs]\n", (nTime3 - nTime2) * 0.001, stageConnectTipConnect.Total() * 0.000001);
         assert(view.Flush());
     }
     int64_t nTime4 = GetTimeMicros();
-    nTimeFlush += nTime4 - nTime3;
-    LogPrint("bench", "  - Flush: %.2fms [%.2fs]\n", (nTime4 - nTime3) * 0.001, nTimeFlush * 0.000001);
+    stageConnectTipFlush.Add(nTime4 - nTime3);
+    LogPrint("bench", "  - Flush: %.2fms [%.2fs]\n", (nTime4 - nTime3) * 0.001, stageConnectTipFlush.Total() * 0.000001);
 
     // Write the chain state to disk, if necessary. Always write to disk if this is the first of a new file.
     FlushStateMode flushMode = FLUSH_STATE_IF_NEEDED;
@@ -3633,8 +3756,8 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, CBlock*
     if (!FlushStateToDisk(state, flushMode))
         return false;
     int64_t nTime5 = GetTimeMicros();
-    nTimeChainState += nTime5 - nTime4;
-    LogPrint("bench", "  - Writing chainstate: %.2fms [%.2fs]\n", (nTime5 - nTime4) * 0.001, nTimeChainState * 0.000001);
+    stageConnectTipChainState.Add(nTime5 - nTime4);
+    LogPrint("bench", "  - Writing chainstate: %.2fms [%.2fs]\n", (nTime5 - nTime4) * 0.001, stageConnectTipChainState.Total() * 0.000001);
 
     // Remove conflicting transactions from the mempool.
     list<CTransaction> txConflicted;
@@ -3642,21 +3765,22 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, CBlock*
     mempool.check(pcoinsTip);
     // Update chainActive & related variables.
     UpdateTip(pindexNew);
-    // Tell wallet about transactions that went from mempool
-    // to conflicted:
-    BOOST_FOREACH (const CTransaction& tx, txConflicted) {
-        SyncWithWallets(tx, NULL);
-    }
-    // ... and about transactions that got confirmed:
-    BOOST_FOREACH (const CTransaction& tx, pblock->vtx) {
-        SyncWithWallets(tx, pblock);
+    if (pwalletMain) {
+        // the wallet commits what the block changes in it once, not once per transaction
+        LOCK(pwalletMain->cs_wallet);
+        CDBBatch batch(pwalletMain->strWalletFile, pwalletMain->cs_wallet, false);
+        SyncConnectedTransactions(*pblock, txConflicted);
+        if (!batch.Commit())
+            return state.Abort("Failed to write to wallet database");
+    } else {
+        SyncConnectedTransactions(*pblock, txConflicted);
     }
 
     int64_t nTime6 = GetTimeMicros();
-    nTimePostConnect += nTime6 - nTime5;
-    nTimeTotal += nTime6 - nTime1;
-    LogPrint("bench", "  - Connect postprocess: %.2fms [%.2fs]\n", (nTime6 - nTime5) * 0.001, nTimePostConnect * 0.000001);
-    LogPrint("bench", "- Connect block: %.2fms [%.2fs]\n", (nTime6 - nTime1) * 0.001, nTimeTotal * 0.000001);
+    stageConnectTipPostProcess.Add(nTime6 - nTime5);
+    stageConnectTipTotal.Add(nTime6 - nTime1);
+    LogPrint("bench", "  - Connect postprocess: %.2fms [%.2fs]\n", (nTime6 - nTime5) * 0.001, stageConnectTipPostProcess.Total() * 0.000001);
+    LogPrint("bench", "- Connect block: %.2fms [%.2fs]\n", (nTime6 - nTime1) * 0.001, stageConnectTipTotal.Total() * 0.000001);
     return true;
 }
 
@@ -3725,6 +3849,9 @@ bool DisconnectBlockAndInputs(CValidationState& state, CTransaction txLock)
     //remove anything conflicting in the memory pool
     list<CTransaction> txConflicted;
     mempool.removeConflicts(txLock, txConflicted);
+    BOOST_FOREACH (const CTransaction& tx, txConflicted) {
+        GetMainSignals().TransactionRemovedFromMempool(tx);
+    }
 
 
     // List of what to disconnect (typically nothing)
@@ -4083,8 +4210,8 @@ CBlockIndex* AddToBlockIndex(const CBlock& block)
         return it->second;
 
     // Construct new block index object
-    CBlockIndex* pindexNew = new CBlockIndex(block);
-    assert(pindexNew);
+    CBlockIndex* pindexNew = blockIndexArena.Allocate();
+    *pindexNew = CBlockIndex(block);
     // We assign the sequence id to blocks only when the full data is available,
     // to avoid miners withholding blocks but broadcasting headers, to get a
     // competitive advantage.
@@ -4100,9 +4227,6 @@ CBlockIndex* AddToBlockIndex(const CBlock& block)
         //update previous block pointer
         pindexNew->pprev->pnext = pindexNew;
 
-        // ppcoin: compute chain trust score
-        pindexNew->bnChainTrust = (pindexNew->pprev ? pindexNew->pprev->bnChainTrust : 0) + pindexNew->GetBlockTrust();
-
         // ppcoin: compute stake entropy bit for stake modifier
         if (!pindexNew->SetStakeEntropyBit(pindexNew->GetStakeEntropyBit()))
             LogPrintf("AddToBlockIndex() : SetStakeEntropyBit() failed \n");
@@ -4380,16 +4504,13 @@ bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW, bo
         for (const CTransaction& tx : block.vtx) {
             if (!tx.IsCoinBase()) {
                 //only reject blocks when it's based on complete consensus
-                BOOST_FOREACH (const CTxIn& in, tx.vin) {
-                    if (mapLockedInputs.count(in.prevout)) {
-                        if (mapLockedInputs[in.prevout] != tx.GetHash()) {
-                            mapRejectedBlocks.insert(make_pair(block.GetHash(), GetTime()));
-                            LogPrintf("%s : found conflicting transaction with transaction lock %s %s\n", __func__,
-                                    mapLockedInputs[in.prevout].ToString(), tx.GetHash().GetHex());
-                            return state.DoS(0, error("%s : found conflicting transaction with transaction lock", __func__),
-                                REJECT_INVALID, "conflicting-tx-ix");
-                        }
-                    }
+                uint256 hashLocked;
+                if (swifttxManager.GetConflictingLock(tx, hashLocked)) {
+                    mapRejectedBlocks.insert(make_pair(block.GetHash(), GetTime()));
+                    LogPrintf("%s : found conflicting transaction with transaction lock %s %s\n", __func__,
+                            hashLocked.ToString(), tx.GetHash().GetHex());
+                    return state.DoS(0, error("%s : found conflicting transaction with transaction lock", __func__),
+                        REJECT_INVALID, "conflicting-tx-ix");
                 }
             }
         }
@@ -5233,9 +5354,7 @@ CBlockIndex* InsertBlockIndex(uint256 hash)
         return (*mi).second;
 
     // Create new
-    CBlockIndex* pindexNew = new CBlockIndex();
-    if (!pindexNew)
-        throw runtime_error("LoadBlockIndex() : new CBlockIndex failed");
+    CBlockIndex* pindexNew = blockIndexArena.Allocate();
     mi = mapBlockIndex.insert(make_pair(hash, pindexNew)).first;
 
     pindexNew->phashBlock = &((*mi).first);
@@ -5811,10 +5930,10 @@ bool static AlreadyHave(const CInv& inv)
     case MSG_BLOCK:
         return mapBlockIndex.count(inv.hash);
     case MSG_TXLOCK_REQUEST:
-        return mapTxLockReq.count(inv.hash) ||
-               mapTxLockReqRejected.count(inv.hash);
+        return swifttxManager.HaveLockRequest(inv.hash) ||
+               swifttxManager.IsLockRequestRejected(inv.hash);
     case MSG_TXLOCK_VOTE:
-        return mapTxLockVote.count(inv.hash);
+        return swifttxManager.HaveVote(inv.hash);
     case MSG_SPORK:
         return mapSporks.count(inv.hash);
     case MSG_MASTERNODE_WINNER:
@@ -5860,6 +5979,33 @@ bool static AlreadyHave(const CInv& inv)
     return true;
 }
 
+/** Blocks recently requested by filtering peers, oldest first in dequeFilteredBlocks */
+static std::map<uint256, std::shared_ptr<const CBloomBlockData> > mapFilteredBlocks;
+static std::deque<uint256> dequeFilteredBlocks;
+
+/** Read a block to serve as merkleblock, reusing the data extracted for other filtering peers */
+static std::shared_ptr<const CBloomBlockData> GetFilteredBlockData(CBlockIndex* pindex)
+{
+    AssertLockHeld(cs_main);
+    const uint256 hash = pindex->GetBlockHash();
+    std::map<uint256, std::shared_ptr<const CBloomBlockData> >::iterator it = mapFilteredBlocks.find(hash);
+    if (it != mapFilteredBlocks.end())
+        return it->second;
+
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex))
+        assert(!"cannot load block from disk");
+    std::shared_ptr<const CBloomBlockData> pblockData = std::make_shared<const CBloomBlockData>(block);
+
+    if (dequeFilteredBlocks.size() >= MAX_FILTERED_BLOCK_CACHE) {
+        mapFilteredBlocks.erase(dequeFilteredBlocks.front());
+        dequeFilteredBlocks.pop_front();
+    }
+    mapFilteredBlocks.emplace(hash, pblockData);
+    dequeFilteredBlocks.push_back(hash);
+    return pblockData;
+}
+
 void static ProcessGetData(CNode* pfrom)
 {
     AssertLockNotHeld(cs_main);
@@ -5898,17 +6044,19 @@ void static ProcessGetData(CNode* pfrom)
                 }
                 // Don't send not-validated blocks
                 if (send && (mi->second->nStatus & BLOCK_HAVE_DATA)) {
-                    // Send block from disk
-                    CBlock block;
-                    if (!ReadBlockFromDisk(block, (*mi).second))
-                        assert(!"cannot load block from disk");
-                    if (inv.type == MSG_BLOCK)
+                    if (inv.type == MSG_BLOCK) {
+                        // Send block from disk
+                        CBlock block;
+                        if (!ReadBlockFromDisk(block, (*mi).second))
+                            assert(!"cannot load block from disk");
                         pfrom->PushMessage("block", block);
-                    else // MSG_FILTERED_BLOCK)
+                    } else // MSG_FILTERED_BLOCK)
                     {
                         LOCK(pfrom->cs_filter);
                         if (pfrom->pfilter) {
-                            CMerkleBlock merkleBlock(block, *pfrom->pfilter);
+                            std::shared_ptr<const CBloomBlockData> pblockData = GetFilteredBlockData((*mi).second);
+                            const CBlock& block = pblockData->block;
+                            CMerkleBlock merkleBlock(*pblockData, *pfrom->pfilter);
                             pfrom->PushMessage("merkleblock", merkleBlock);
                             // CMerkleBlock just contains hashes, so also push any transactions in the block the client did not see
                             // This avoids hurting performance by pointlessly requiring a round-trip
@@ -5960,19 +6108,21 @@ void static ProcessGetData(CNode* pfrom)
                 }
 
                 if (!pushed && inv.type == MSG_TXLOCK_VOTE) {
-                    if (mapTxLockVote.count(inv.hash)) {
+                    CConsensusVote vote;
+                    if (swifttxManager.GetVote(inv.hash, vote)) {
                         CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
                         ss.reserve(1000);
-                        ss << mapTxLockVote[inv.hash];
+                        ss << vote;
                         pfrom->PushMessage("txlvote", ss);
                         pushed = true;
                     }
                 }
                 if (!pushed && inv.type == MSG_TXLOCK_REQUEST) {
-                    if (mapTxLockReq.count(inv.hash)) {
+                    CTransaction txLockReq;
+                    if (swifttxManager.GetLockRequest(inv.hash, txLockReq)) {
                         CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
                         ss.reserve(1000);
-                        ss << mapTxLockReq[inv.hash];
+                        ss << txLockReq;
                         pfrom->PushMessage("ix", ss);
                         pushed = true;
                     }
@@ -6952,6 +7102,79 @@ int ActiveProtocol()
     return MIN_PEER_PROTO_VERSION_BEFORE_ENFORCEMENT;
 }
 
+/**
+ * Masternode, payment, budget and SwiftX vote messages arrive in bursts of thousands during
+ * sync. When the next queued message of a peer has not been looked at yet,
+ * collect the signatures of it and the signed messages queued behind it and
+ * recover their keys in parallel; the checks made while processing the
+ * messages one by one then hit the recovered key cache. Messages the handlers
+ * drop before checking a signature (already seen, unknown masternode, sigTime
+ * out of range) are skipped, so spam costs no more than it would without the
+ * prefetch. Called with cs_vRecvMsg held.
+ */
+static void PrefetchMessageSignatures(CNode* pfrom)
+{
+    if (!nScriptCheckThreads || pfrom->vRecvMsg.empty() || pfrom->vRecvMsg.front().fSigsPrefetched)
+        return;
+
+    const int64_t nNow = GetAdjustedTime();
+    std::vector<std::pair<uint256, std::vector<unsigned char> > > vSignatures;
+    for (std::deque<CNetMessage>::iterator it = pfrom->vRecvMsg.begin(); it != pfrom->vRecvMsg.end(); ++it) {
+        CNetMessage& msg = *it;
+        if (!msg.complete() || msg.fSigsPrefetched || vSignatures.size() >= MAX_SIGNATURE_BATCH_SIZE)
+            break;
+        msg.fSigsPrefetched = true;
+
+        const std::string strCommand = msg.hdr.GetCommand();
+        try {
+            CDataStream vRecv(msg.vRecv.begin(), msg.vRecv.end(), msg.vRecv.GetType(), msg.vRecv.GetVersion());
+            if (strCommand == "mnb") {
+                CMasternodeBroadcast mnb;
+                vRecv >> mnb;
+                if (mnodeman.mapSeenMasternodeBroadcast.count(mnb.GetHash()) || mnb.sigTime > nNow + 60 * 60)
+                    continue;
+                vSignatures.push_back(std::make_pair(mnb.GetSignedHash(), mnb.GetVchSig()));
+                vSignatures.push_back(std::make_pair(mnb.lastPing.GetSignedHash(), mnb.lastPing.GetVchSig()));
+            } else if (strCommand == "mnp") {
+                CMasternodePing mnp;
+                vRecv >> mnp;
+                if (mnodeman.mapSeenMasternodePing.count(mnp.GetHash()) || mnp.sigTime > nNow + 60 * 60 ||
+                    mnp.sigTime <= nNow - 60 * 60 || !mnodeman.Find(mnp.vin))
+                    continue;
+                vSignatures.push_back(std::make_pair(mnp.GetSignedHash(), mnp.GetVchSig()));
+            } else if (strCommand == "mnw") {
+                CMasternodePaymentWinner winner;
+                vRecv >> winner;
+                if (masternodePayments.mapMasternodePayeeVotes.count(winner.GetHash()) || !mnodeman.Find(winner.vinMasternode))
+                    continue;
+                vSignatures.push_back(std::make_pair(winner.GetSignedHash(), winner.GetVchSig()));
+            } else if (strCommand == "mvote") {
+                CBudgetVote vote;
+                vRecv >> vote;
+                if (budget.mapSeenMasternodeBudgetVotes.count(vote.GetHash()) || !mnodeman.Find(vote.vin))
+                    continue;
+                vSignatures.push_back(std::make_pair(vote.GetSignedHash(), vote.GetVchSig()));
+            } else if (strCommand == "fbvote") {
+                CFinalizedBudgetVote vote;
+                vRecv >> vote;
+                if (budget.mapSeenFinalizedBudgetVotes.count(vote.GetHash()) || !mnodeman.Find(vote.vin))
+                    continue;
+                vSignatures.push_back(std::make_pair(vote.GetSignedHash(), vote.GetVchSig()));
+            } else if (strCommand == "txlvote") {
+                CConsensusVote vote;
+                vRecv >> vote;
+                if (swifttxManager.HaveVote(vote.GetHash()) || !mnodeman.Find(vote.vinMasternode))
+                    continue;
+                vSignatures.push_back(std::make_pair(vote.GetSignedHash(), vote.GetVchSig()));
+            }
+        } catch (const std::exception&) {
+            // malformed messages are reported when they get processed
+        }
+    }
+
+    CHashSigner::RecoverBatch(vSignatures);
+}
+
 // requires LOCK(cs_vRecvMsg)
 bool ProcessMessages(CNode* pfrom)
 {
@@ -6968,12 +7191,17 @@ bool ProcessMessages(CNode* pfrom)
     //
     bool fOk = true;
 
-    if (!pfrom->vRecvGetData.empty())
+    if (!pfrom->vRecvGetData.empty()) {
+        int64_t nStart = GetTimeMicros();
         ProcessGetData(pfrom);
+        pfrom->RecordMsgProcessTime("getdata", GetTimeMicros() - nStart);
+    }
 
     // this maintains the order of responses
     if (!pfrom->vRecvGetData.empty()) return fOk;
 
+    PrefetchMessageSignatures(pfrom);
+
     std::deque<CNetMessage>::iterator it = pfrom->vRecvMsg.begin();
     while (!pfrom->fDisconnect && it != pfrom->vRecvMsg.end()) {
         // Don't bother if send buffer is too full to respond anyway
@@ -7026,6 +7254,7 @@ bool ProcessMessages(CNode* pfrom)
 
         // Process message
         bool fRet = false;
+        int64_t nProcessStart = GetTimeMicros();
         try {
             fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime);
             boost::this_thread::interruption_point();
@@ -7047,6 +7276,7 @@ bool ProcessMessages(CNode* pfrom)
         } catch (...) {
             PrintExceptionContinue(NULL, "ProcessMessages()");
         }
+        pfrom->RecordMsgProcessTime(strCommand, GetTimeMicros() - nProcessStart);
 
         if (!fRet)
             LogPrintf("ProcessMessage(%s, %u bytes) FAILED peer=%d\n", SanitizeString(strCommand), nMessageSize, pfrom->id);
@@ -7355,10 +7585,8 @@ public:
     ~CMainCleanup()
     {
         // block headers
-        BlockMap::iterator it1 = mapBlockIndex.begin();
-        for (; it1 != mapBlockIndex.end(); it1++)
-            delete (*it1).second;
         mapBlockIndex.clear();
+        blockIndexArena.Clear();
 
         // orphan transactions
         mapOrphanTransactions.clear();
@@ -47,6 +47,7 @@
 
 class CBlockIndex;
 class CBlockTreeDB;
+class CCoinsViewWriteBehind;
 class CZerocoinDB;
 class CSporkDB;
 class CBloomFilter;
@@ -89,6 +90,8 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Loose transactions with at least this many inputs have their scripts checked on the script-checking threads */
+static const unsigned int MEMPOOL_PARALLEL_SCRIPTCHECK_MIN_INPUTS = 16;
 /** Number of blocks that can be requested at any given time from a single peer. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 512;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
@@ -103,6 +106,8 @@ static const unsigned int MAX_HEADERS_RESULTS = 2000;
 static const unsigned int BLOCK_DOWNLOAD_WINDOW = 1024;
 /** Time to wait (in seconds) between writing blockchain state to disk. */
 static const unsigned int DATABASE_WRITE_INTERVAL = 3600;
+/** Number of blocks kept ready for serving to filtering peers, so SPV clients syncing the same history share the work. */
+static const unsigned int MAX_FILTERED_BLOCK_CACHE = 16;
 /** Maximum length of reject messages. */
 static const unsigned int MAX_REJECT_MESSAGE_LENGTH = 111;
 
@@ -161,6 +166,7 @@ extern bool fTxIndex;
 extern bool fIsBareMultisigStd;
 extern bool fCheckBlockIndex;
 extern unsigned int nCoinCacheSize;
+extern unsigned int nCoinCacheRetainSize;
 extern CFeeRate minRelayTxFee;
 extern bool fAlerts;
 extern int64_t nMaxTipAge;
@@ -254,6 +260,14 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats);
 void Misbehaving(NodeId nodeid, int howmuch);
 /** Flush all state, indexes and buffers to disk. */
 void FlushStateToDisk();
+/**
+ * Whether the coins cache must be flushed because, with the batch still being written
+ * in the background, it holds more than nLimit entries. The batch counts for at most
+ * half of nLimit, and a flush leaves cache and batch within that half, so blocks
+ * connected while it is written do not flush again, and wait for it, before they
+ * have filled the other half.
+ */
+bool CoinsCacheFlushNeeded(size_t nCacheSize, size_t nWriting, size_t nLimit);
 
 
 /** (try to) add transaction to memory pool **/
@@ -445,6 +459,9 @@ public:
 bool WriteBlockToDisk(CBlock& block, CDiskBlockPos& pos);
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex);
+/** Read the serialized bytes of a block as stored on disk, without deserializing its transactions */
+bool ReadRawBlockFromDisk(std::vector<char>& vchBlock, const CDiskBlockPos& pos);
+bool ReadRawBlockFromDisk(std::vector<char>& vchBlock, const CBlockIndex* pindex);
 
 
 /** Functions for validating blocks and updating the block tree */
@@ -634,6 +651,9 @@ extern CChain chainActive;
 /** Global variable that points to the active CCoinsView (protected by cs_main) */
 extern CCoinsViewCache* pcoinsTip;
 
+/** Background writer below pcoinsTip, or NULL if coins are flushed synchronously (protected by cs_main) */
+extern CCoinsViewWriteBehind* pcoinsWriteBehind;
+
 /** Global variable that points to the active block tree (protected by cs_main) */
 extern CBlockTreeDB* pblocktree;
 
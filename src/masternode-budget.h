@@ -11,6 +11,7 @@
 #include "key.h"
 #include "main.h"
 #include "masternode.h"
+#include "masternode-cachedb.h"
 #include "net.h"
 #include "sync.h"
 #include "util.h"
@@ -149,23 +150,9 @@ public:
 
 /** Save Budget Manager (budget.dat)
  */
-class CBudgetDB
+class CBudgetDB : public CMasternodeCacheDB
 {
-private:
-    boost::filesystem::path pathDB;
-    std::string strMagicMessage;
-
 public:
-    enum ReadResult {
-        Ok,
-        FileError,
-        HashReadError,
-        IncorrectHash,
-        IncorrectMagicMessage,
-        IncorrectMagicNumber,
-        IncorrectFormat
-    };
-
     CBudgetDB();
     bool Write(const CBudgetManager& objToSave);
     ReadResult Read(CBudgetManager& objToLoad, bool fDryRun = false);
@@ -182,6 +169,14 @@ private:
     // XX42    map<uint256, CTransaction> mapCollateral;
     map<uint256, uint256> mapCollateralTxids;
 
+    // proposals by net yes votes, best first; rebuilt only after a tally or mapProposals changed
+    std::vector<std::pair<CBudgetProposal*, int> > vProposalRanking;
+    bool fProposalRankingDirty;
+
+    /// Revalidate the votes of all proposals against the masternode list
+    void CleanProposalVotes();
+    const std::vector<std::pair<CBudgetProposal*, int> >& GetProposalRanking();
+
 public:
     // critical section to protect the inner data structures
     mutable RecursiveMutex cs;
@@ -201,6 +196,7 @@ public:
     {
         mapProposals.clear();
         mapFinalizedBudgets.clear();
+        fProposalRankingDirty = true;
     }
 
     void ClearSeen()
@@ -256,6 +252,7 @@ public:
         mapSeenFinalizedBudgetVotes.clear();
         mapOrphanMasternodeBudgetVotes.clear();
         mapOrphanFinalizedBudgetVotes.clear();
+        fProposalRankingDirty = true;
     }
     void CheckAndRemove();
     std::string ToString() const;
@@ -275,6 +272,8 @@ public:
 
         READWRITE(mapProposals);
         READWRITE(mapFinalizedBudgets);
+        if (ser_action.ForRead())
+            fProposalRankingDirty = true;
     }
 };
 
@@ -315,6 +314,7 @@ private:
     // critical section to protect the inner data structures
     mutable RecursiveMutex cs;
     bool fAutoChecked; //If it matches what we see, we'll auto vote for it (masternode only)
+    int64_t nVotesCheckedListVersion; //masternode list version the votes were last validated against
 
 public:
     bool fValid;
@@ -328,7 +328,7 @@ public:
     CFinalizedBudget();
     CFinalizedBudget(const CFinalizedBudget& other);
 
-    void CleanAndRemove();
+    bool CleanAndRemove();
     bool AddOrUpdateVote(CFinalizedBudgetVote& vote, std::string& strError);
     double GetScore();
     bool HasMinimumRequiredSupport();
@@ -459,6 +459,14 @@ private:
     mutable RecursiveMutex cs;
     CAmount nAlloted;
 
+    // running tallies of the valid votes in mapVotes
+    int nYeas;
+    int nNays;
+    int nAbstains;
+    int64_t nVotesCheckedListVersion; //masternode list version the votes were last validated against
+
+    void TallyVote(const CBudgetVote& vote, int nDelta);
+
 public:
     bool fValid;
     std::string strProposalName;
@@ -503,14 +511,17 @@ public:
     int GetBlockCurrentCycle();
     int GetBlockEndCycle();
     double GetRatio();
-    int GetYeas() const;
-    int GetNays() const;
-    int GetAbstains() const;
+    int GetYeas() const { return nYeas; }
+    int GetNays() const { return nNays; }
+    int GetAbstains() const { return nAbstains; }
     CAmount GetAmount() { return nAmount; }
     void SetAllotted(CAmount nAllotedIn) { nAlloted = nAllotedIn; }
     CAmount GetAllotted() { return nAlloted; }
 
-    void CleanAndRemove();
+    /// Revalidate votes if the masternode list changed; returns true if the tallies changed
+    bool CleanAndRemove();
+    /// Rebuild the tallies from mapVotes, after it was replaced wholesale
+    void RecountVotes();
 
     uint256 GetHash() const
     {
@@ -544,6 +555,8 @@ public:
 
         //for saving to the serialized db
         READWRITE(mapVotes);
+        if (ser_action.ForRead())
+            RecountVotes();
     }
 };
 
@@ -572,6 +585,8 @@ public:
         swap(first.nTime, second.nTime);
         swap(first.nFeeTXHash, second.nFeeTXHash);
         first.mapVotes.swap(second.mapVotes);
+        first.RecountVotes();
+        second.RecountVotes();
     }
 
     CBudgetProposalBroadcast& operator=(CBudgetProposalBroadcast from)
@@ -0,0 +1,153 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "masternode-cachedb.h"
+
+#include "chainparams.h"
+#include "sync.h"
+
+#include <boost/filesystem.hpp>
+
+/** Checksums of the cache files as last read or written, by file name */
+static std::map<std::string, uint256> mapOnDiskHashes;
+static Mutex cs_onDiskHashes;
+
+CMasternodeCacheDB::CMasternodeCacheDB(const std::string& strFilenameIn, const std::string& strMagicMessageIn) : strFilename(strFilenameIn),
+                                                                                                                  strMagicMessage(strMagicMessageIn)
+{
+    pathDB = GetDataDir() / strFilename;
+}
+
+void CMasternodeCacheDB::WriteHeader(CDataStream& ss) const
+{
+    ss << strMagicMessage;                   // cache file specific magic message
+    ss << FLATDATA(Params().MessageStart()); // network specific magic number
+}
+
+CMasternodeCacheDB::ReadResult CMasternodeCacheDB::ReadHeader(CDataStream& ss) const
+{
+    unsigned char pchMsgTmp[4];
+    std::string strMagicMessageTmp;
+    try {
+        // de-serialize file header (cache file specific magic message) and ..
+        ss >> strMagicMessageTmp;
+
+        // ... verify the message matches predefined one
+        if (strMagicMessage != strMagicMessageTmp) {
+            error("%s : Invalid %s magic message", __func__, strFilename);
+            return IncorrectMagicMessage;
+        }
+
+        // de-serialize file header (network specific magic number) and ..
+        ss >> FLATDATA(pchMsgTmp);
+
+        // ... verify the network matches ours
+        if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp))) {
+            error("%s : Invalid network magic number", __func__);
+            return IncorrectMagicNumber;
+        }
+    } catch (const std::exception& e) {
+        error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        return IncorrectFormat;
+    }
+
+    return Ok;
+}
+
+CMasternodeCacheDB::ReadResult CMasternodeCacheDB::VerifyHeader() const
+{
+    FILE* file = fopen(pathDB.string().c_str(), "rb");
+    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return FileError;
+
+    // the header is tiny, read just enough of the file to cover it
+    CDataStream ssHeader(SER_DISK, CLIENT_VERSION);
+    ssHeader.resize(256);
+    size_t nRead = fread(&ssHeader[0], 1, ssHeader.size(), filein.Get());
+    ssHeader.resize(nRead);
+
+    return ReadHeader(ssHeader);
+}
+
+bool CMasternodeCacheDB::WriteStream(CDataStream& ss) const
+{
+    int64_t nStart = GetTimeMillis();
+
+    // write to a temporary file first, so a crash never leaves a truncated cache behind
+    boost::filesystem::path pathTmp = pathDB;
+    pathTmp += ".new";
+    FILE* file = fopen(pathTmp.string().c_str(), "wb");
+    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+    if (fileout.IsNull())
+        return error("%s : Failed to open file %s", __func__, pathTmp.string());
+
+    // Write and commit header, data
+    try {
+        fileout << ss;
+    } catch (const std::exception& e) {
+        return error("%s : Serialize or I/O error - %s", __func__, e.what());
+    }
+    FileCommit(fileout.Get());
+    fileout.fclose();
+
+    if (!RenameOver(pathTmp, pathDB))
+        return error("%s : Rename-into-place failed for %s", __func__, pathDB.string());
+
+    LogPrint("masternode", "Written %u bytes to %s  %dms\n", ss.size(), strFilename, GetTimeMillis() - nStart);
+    return true;
+}
+
+CMasternodeCacheDB::ReadResult CMasternodeCacheDB::ReadStream(CDataStream& ss, uint256& hashRet) const
+{
+    // open input file, and associate with CAutoFile
+    FILE* file = fopen(pathDB.string().c_str(), "rb");
+    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        error("%s : Failed to open file %s", __func__, pathDB.string());
+        return FileError;
+    }
+
+    // use file size to size memory buffer, and read straight into the stream
+    int64_t fileSize = boost::filesystem::file_size(pathDB);
+    int64_t dataSize = fileSize - sizeof(uint256);
+    // Don't try to resize to a negative number if file is small
+    if (dataSize < 0)
+        dataSize = 0;
+    ss.resize(dataSize);
+    uint256 hashIn;
+
+    // read data and checksum from file
+    try {
+        if (dataSize > 0)
+            filein.read(&ss[0], dataSize);
+        filein >> hashIn;
+    } catch (const std::exception& e) {
+        error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        return HashReadError;
+    }
+    filein.fclose();
+
+    // verify stored checksum matches input data
+    hashRet = Hash(ss.begin(), ss.end());
+    if (hashIn != hashRet) {
+        error("%s : Checksum mismatch, data corrupted", __func__);
+        return IncorrectHash;
+    }
+
+    return ReadHeader(ss);
+}
+
+bool CMasternodeCacheDB::IsOnDisk(const uint256& hash) const
+{
+    LOCK(cs_onDiskHashes);
+    std::map<std::string, uint256>::const_iterator it = mapOnDiskHashes.find(strFilename);
+    return it != mapOnDiskHashes.end() && it->second == hash && boost::filesystem::exists(pathDB);
+}
+
+void CMasternodeCacheDB::SetOnDisk(const uint256& hash) const
+{
+    LOCK(cs_onDiskHashes);
+    mapOnDiskHashes[strFilename] = hash;
+}
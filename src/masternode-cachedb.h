@@ -0,0 +1,101 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MASTERNODE_CACHEDB_H
+#define MASTERNODE_CACHEDB_H
+
+#include "clientversion.h"
+#include "hash.h"
+#include "streams.h"
+#include "util.h"
+#include "version.h"
+
+#include <boost/filesystem/path.hpp>
+
+/**
+ * Snapshot file shared by mncache.dat, mnpayments.dat and budget.dat.
+ *
+ * Layout, unchanged from the files written before: magic message, network
+ * magic, payload and a checksum of everything before it. A snapshot replaces
+ * the previous file atomically, and is not written at all if its checksum
+ * matches the file already on disk. Loading is not lazy: the whole file is
+ * read, its checksum verified and the payload deserialized at once.
+ */
+class CMasternodeCacheDB
+{
+public:
+    enum ReadResult {
+        Ok,
+        FileError,
+        HashReadError,
+        IncorrectHash,
+        IncorrectMagicMessage,
+        IncorrectMagicNumber,
+        IncorrectFormat
+    };
+
+    /// Check the header of the file on disk, without loading it
+    ReadResult VerifyHeader() const;
+
+protected:
+    boost::filesystem::path pathDB;
+    std::string strFilename;
+    std::string strMagicMessage;
+
+    CMasternodeCacheDB(const std::string& strFilenameIn, const std::string& strMagicMessageIn);
+
+    template <typename T>
+    bool WriteObject(const T& objToSave)
+    {
+        // serialize, checksum data up to that point, then append checksum
+        CDataStream ssObj(SER_DISK, CLIENT_VERSION);
+        WriteHeader(ssObj);
+        ssObj << objToSave;
+        uint256 hash = Hash(ssObj.begin(), ssObj.end());
+        if (IsOnDisk(hash)) {
+            LogPrint("masternode", "%s is unchanged, not rewriting it\n", strFilename);
+            return true;
+        }
+        ssObj << hash;
+
+        if (!WriteStream(ssObj))
+            return false;
+        SetOnDisk(hash);
+        return true;
+    }
+
+    template <typename T>
+    ReadResult ReadObject(T& objToLoad)
+    {
+        CDataStream ssObj(SER_DISK, CLIENT_VERSION);
+        uint256 hash;
+        ReadResult result = ReadStream(ssObj, hash);
+        if (result != Ok)
+            return result;
+
+        try {
+            ssObj >> objToLoad;
+        } catch (const std::exception& e) {
+            objToLoad.Clear();
+            error("%s : Deserialize or I/O error - %s", __func__, e.what());
+            return IncorrectFormat;
+        }
+        SetOnDisk(hash);
+        return Ok;
+    }
+
+private:
+    void WriteHeader(CDataStream& ss) const;
+    /// Check the header fields at the current position of a stream
+    ReadResult ReadHeader(CDataStream& ss) const;
+    /// Replace the file with the contents of a stream
+    bool WriteStream(CDataStream& ss) const;
+    /// Read the file, verify its checksum and header and leave the stream at the payload
+    ReadResult ReadStream(CDataStream& ss, uint256& hashRet) const;
+
+    bool IsOnDisk(const uint256& hash) const;
+    void SetOnDisk(const uint256& hash) const;
+};
+
+#endif // MASTERNODE_CACHEDB_H
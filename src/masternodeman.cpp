@@ -27,19 +27,12 @@ struct CompareLastPaid {
     }
 };
 
-struct CompareScoreTxIn {
-    bool operator()(const pair<int64_t, CTxIn>& t1,
-        const pair<int64_t, CTxIn>& t2) const
+struct CompareScoreIndex {
+    bool operator()(const pair<int64_t, size_t>& t1,
+        const pair<int64_t, size_t>& t2) const
     {
-        return t1.first < t2.first;
-    }
-};
-
-struct CompareScoreMN {
-    bool operator()(const pair<int64_t, CMasternode>& t1,
-        const pair<int64_t, CMasternode>& t2) const
-    {
-        return t1.first < t2.first;
+        // best score first, ties broken by list position
+        return t1.first > t2.first || (t1.first == t2.first && t1.second < t2.second);
     }
 };
 
@@ -47,113 +40,25 @@ struct CompareScoreMN {
 // CMasternodeDB
 //
 
-CMasternodeDB::CMasternodeDB()
+CMasternodeDB::CMasternodeDB() : CMasternodeCacheDB("mncache.dat", "MasternodeCache")
 {
-    pathMN = GetDataDir() / "mncache.dat";
-    strMagicMessage = "MasternodeCache";
 }
 
 bool CMasternodeDB::Write(const CMasternodeMan& mnodemanToSave)
 {
-    int64_t nStart = GetTimeMillis();
-
-    // serialize, checksum data up to that point, then append checksum
-    CDataStream ssMasternodes(SER_DISK, CLIENT_VERSION);
-    ssMasternodes << strMagicMessage;                   // masternode cache file specific magic message
-    ssMasternodes << FLATDATA(Params().MessageStart()); // network specific magic number
-    ssMasternodes << mnodemanToSave;
-    uint256 hash = Hash(ssMasternodes.begin(), ssMasternodes.end());
-    ssMasternodes << hash;
-
-    // open output file, and associate with CAutoFile
-    FILE* file = fopen(pathMN.string().c_str(), "wb");
-    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("%s : Failed to open file %s", __func__, pathMN.string());
-
-    // Write and commit header, data
-    try {
-        fileout << ssMasternodes;
-    } catch (const std::exception& e) {
-        return error("%s : Serialize or I/O error - %s", __func__, e.what());
-    }
-    //    FileCommit(fileout);
-    fileout.fclose();
+    if (!WriteObject(mnodemanToSave))
+        return false;
 
-    LogPrint("masternode","Written info to mncache.dat  %dms\n", GetTimeMillis() - nStart);
     LogPrint("masternode","  %s\n", mnodemanToSave.ToString());
-
     return true;
 }
 
 CMasternodeDB::ReadResult CMasternodeDB::Read(CMasternodeMan& mnodemanToLoad, bool fDryRun)
 {
     int64_t nStart = GetTimeMillis();
-    // open input file, and associate with CAutoFile
-    FILE* file = fopen(pathMN.string().c_str(), "rb");
-    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        error("%s : Failed to open file %s", __func__, pathMN.string());
-        return FileError;
-    }
-
-    // use file size to size memory buffer
-    int fileSize = boost::filesystem::file_size(pathMN);
-    int dataSize = fileSize - sizeof(uint256);
-    // Don't try to resize to a negative number if file is small
-    if (dataSize < 0)
-        dataSize = 0;
-    vector<unsigned char> vchData;
-    vchData.resize(dataSize);
-    uint256 hashIn;
-
-    // read data and checksum from file
-    try {
-        filein.read((char*)&vchData[0], dataSize);
-        filein >> hashIn;
-    } catch (const std::exception& e) {
-        error("%s : Deserialize or I/O error - %s", __func__, e.what());
-        return HashReadError;
-    }
-    filein.fclose();
-
-    CDataStream ssMasternodes(vchData, SER_DISK, CLIENT_VERSION);
-
-    // verify stored checksum matches input data
-    uint256 hashTmp = Hash(ssMasternodes.begin(), ssMasternodes.end());
-    if (hashIn != hashTmp) {
-        error("%s : Checksum mismatch, data corrupted", __func__);
-        return IncorrectHash;
-    }
-
-    unsigned char pchMsgTmp[4];
-    std::string strMagicMessageTmp;
-    try {
-        // de-serialize file header (masternode cache file specific magic message) and ..
-
-        ssMasternodes >> strMagicMessageTmp;
-
-        // ... verify the message matches predefined one
-        if (strMagicMessage != strMagicMessageTmp) {
-            error("%s : Invalid masternode cache magic message", __func__);
-            return IncorrectMagicMessage;
-        }
-
-        // de-serialize file header (network specific magic number) and ..
-        ssMasternodes >> FLATDATA(pchMsgTmp);
-
-        // ... verify the network matches ours
-        if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp))) {
-            error("%s : Invalid network magic number", __func__);
-            return IncorrectMagicNumber;
-        }
-        // de-serialize data into CMasternodeMan object
-        ssMasternodes >> mnodemanToLoad;
-    } catch (const std::exception& e) {
-        mnodemanToLoad.Clear();
-        error("%s : Deserialize or I/O error - %s", __func__, e.what());
-        return IncorrectFormat;
-    }
+    ReadResult result = ReadObject(mnodemanToLoad);
+    if (result != Ok)
+        return result;
 
     LogPrint("masternode","Loaded info from mncache.dat  %dms\n", GetTimeMillis() - nStart);
     LogPrint("masternode","  %s\n", mnodemanToLoad.ToString());
@@ -172,10 +77,9 @@ void DumpMasternodes()
     int64_t nStart = GetTimeMillis();
 
     CMasternodeDB mndb;
-    CMasternodeMan tempMnodeman;
 
     LogPrint("masternode","Verifying mncache.dat format...\n");
-    CMasternodeDB::ReadResult readResult = mndb.Read(tempMnodeman, true);
+    CMasternodeDB::ReadResult readResult = mndb.VerifyHeader();
     // there was an error and it was not an error on file opening => do not proceed
     if (readResult == CMasternodeDB::FileError)
         LogPrint("masternode","Missing masternode cache file - mncache.dat, will try to recreate\n");
@@ -194,9 +98,122 @@ void DumpMasternodes()
     LogPrint("masternode","Masternode dump finished  %dms\n", GetTimeMillis() - nStart);
 }
 
+CMasternodeCollateralWatcher::CollateralState CMasternodeCollateralWatcher::GetState(const CTxIn& vin) const
+{
+    LOCK(cs);
+    std::map<COutPoint, WatchedCollateral>::const_iterator it = mapWatched.find(vin.prevout);
+    if (it == mapWatched.end())
+        return COLLATERAL_UNKNOWN;
+    if (!it->second.hashSpender.IsNull())
+        return COLLATERAL_SPENT;
+    return it->second.fChecked ? COLLATERAL_UNSPENT : COLLATERAL_UNKNOWN;
+}
+
+bool CMasternodeCollateralWatcher::CheckUnspent(const CTxIn& vin, CValidationState& state)
+{
+    AssertLockHeld(cs_main);
+
+    // the collateral must be spendable to the obfuscation collateral address by a mempool transaction
+    CMutableTransaction tx = CMutableTransaction();
+    CTxOut vout = CTxOut(((Params().MasternodeCollateralLimit() - 0.01)) * COIN, obfuScationPool.collateralPubKey);
+    tx.vin.push_back(vin);
+    tx.vout.push_back(vout);
+
+    if (!AcceptableInputs(mempool, state, CTransaction(tx), false, NULL))
+        return false;
+
+    LOCK(cs);
+    std::map<COutPoint, WatchedCollateral>::iterator it = mapWatched.find(vin.prevout);
+    if (it != mapWatched.end()) {
+        it->second.fChecked = true;
+        it->second.hashSpender.SetNull();
+        it->second.fSpentInBlock = false;
+    }
+    return true;
+}
+
+void CMasternodeCollateralWatcher::Watch(const CTxIn& vin)
+{
+    LOCK(cs);
+    mapWatched.insert(std::make_pair(vin.prevout, WatchedCollateral()));
+}
+
+void CMasternodeCollateralWatcher::Forget(const CTxIn& vin)
+{
+    LOCK(cs);
+    mapWatched.erase(vin.prevout);
+}
+
+void CMasternodeCollateralWatcher::Clear()
+{
+    LOCK(cs);
+    mapWatched.clear();
+}
+
+size_t CMasternodeCollateralWatcher::size() const
+{
+    LOCK(cs);
+    return mapWatched.size();
+}
+
+void CMasternodeCollateralWatcher::SyncTransaction(const CTransaction& tx, const CBlock* pblock)
+{
+    {
+        LOCK(cs);
+        if (mapWatched.empty())
+            return;
+    }
+
+    // without a block this is either a new mempool transaction or one leaving a block or the
+    // mempool; the latter are handled by BlockDisconnected and TransactionRemovedFromMempool
+    const uint256 hash = tx.GetHash();
+    if (!pblock && !mempool.exists(hash))
+        return;
+
+    LOCK(cs);
+    BOOST_FOREACH (const CTxIn& txin, tx.vin) {
+        std::map<COutPoint, WatchedCollateral>::iterator it = mapWatched.find(txin.prevout);
+        if (it == mapWatched.end())
+            continue;
+        if (it->second.hashSpender != hash)
+            LogPrint("masternode", "CMasternodeCollateralWatcher: collateral %s spent by %s\n", txin.prevout.ToString(), hash.ToString());
+        it->second.hashSpender = hash;
+        it->second.fSpentInBlock = pblock != NULL;
+    }
+}
+
+void CMasternodeCollateralWatcher::TransactionRemovedFromMempool(const CTransaction& tx)
+{
+    RevertSpends(tx, false);
+}
+
+void CMasternodeCollateralWatcher::BlockDisconnected(const CBlock& block)
+{
+    BOOST_FOREACH (const CTransaction& tx, block.vtx)
+        RevertSpends(tx, true);
+}
+
+void CMasternodeCollateralWatcher::RevertSpends(const CTransaction& tx, bool fInBlock)
+{
+    LOCK(cs);
+    if (mapWatched.empty())
+        return;
+
+    const uint256 hash = tx.GetHash();
+    BOOST_FOREACH (const CTxIn& txin, tx.vin) {
+        std::map<COutPoint, WatchedCollateral>::iterator it = mapWatched.find(txin.prevout);
+        if (it == mapWatched.end() || it->second.hashSpender != hash || it->second.fSpentInBlock != fInBlock)
+            continue;
+        LogPrint("masternode", "CMasternodeCollateralWatcher: collateral %s no longer spent by %s\n", txin.prevout.ToString(), hash.ToString());
+        it->second.hashSpender.SetNull();
+        it->second.fSpentInBlock = false;
+    }
+}
+
 CMasternodeMan::CMasternodeMan()
 {
     nDsqCount = 0;
+    nListVersion = 0;
 }
 
 bool CMasternodeMan::Add(CMasternode& mn)
@@ -210,6 +227,8 @@ bool CMasternodeMan::Add(CMasternode& mn)
     if (pmn == NULL) {
         LogPrint("masternode", "CMasternodeMan: Adding new Masternode %s - %i now\n", mn.vin.prevout.hash.ToString(), size() + 1);
         vMasternodes.push_back(mn);
+        collateralWatcher.Watch(mn.vin);
+        ClearRankCache();
         return true;
     }
 
@@ -279,7 +298,9 @@ void CMasternodeMan::CheckAndRemove(bool forceExpiredRemoval)
                 }
             }
 
+            collateralWatcher.Forget((*it).vin);
             it = vMasternodes.erase(it);
+            ClearRankCache();
         } else {
             ++it;
         }
@@ -341,6 +362,8 @@ void CMasternodeMan::Clear()
 {
     LOCK(cs);
     vMasternodes.clear();
+    collateralWatcher.Clear();
+    ClearRankCache();
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
     mWeAskedForMasternodeListEntry.clear();
@@ -568,109 +591,150 @@ CMasternode* CMasternodeMan::FindRandomNotInVec(std::vector<CTxIn>& vecToExclude
     return NULL;
 }
 
-CMasternode* CMasternodeMan::GetCurrentMasterNode(int mod, int64_t nBlockHeight, int minProtocol)
+const CMasternodeMan::ScoreTable* CMasternodeMan::GetScores(int64_t nBlockHeight, uint256& hashBlock)
 {
-    int64_t score = 0;
-    CMasternode* winner = nullptr;
+    AssertLockHeld(cs);
 
-    // scan for winner
-    BOOST_FOREACH (CMasternode& mn, vMasternodes) {
-        mn.Check();
-        if (mn.protocolVersion < minProtocol || !mn.IsEnabled()) continue;
+    //make sure we know about this block
+    if (!GetBlockHash(hashBlock, nBlockHeight)) return NULL;
 
-        // calculate the score for each Masternode
-        uint256 n = mn.CalculateScore(mod, nBlockHeight);
-        int64_t n2 = n.GetCompact(false);
+    // scores only depend on the block hash, so they survive until the list changes
+    std::map<uint256, ScoreTable>::iterator it = mapScoreCache.find(hashBlock);
+    if (it != mapScoreCache.end())
+        return &it->second;
 
-        // determine the winner
-        if (n2 > score) {
-            score = n2;
-            winner = &mn;
-        }
+    if (mapScoreCache.size() >= MASTERNODES_RANK_CACHE_SIZE)
+        mapScoreCache.clear();
+
+    ScoreTable& vScores = mapScoreCache[hashBlock];
+    vScores.reserve(vMasternodes.size());
+    for (size_t i = 0; i < vMasternodes.size(); i++) {
+        uint256 n = vMasternodes[i].CalculateScore(1, nBlockHeight);
+        vScores.push_back(make_pair(n.GetCompact(false), i));
     }
+    sort(vScores.begin(), vScores.end(), CompareScoreIndex());
 
-    return winner;
+    return &vScores;
 }
 
-int CMasternodeMan::GetMasternodeRank(const CTxIn& vin, int64_t nBlockHeight, int minProtocol, bool fOnlyActive)
+const CMasternodeMan::RankTable* CMasternodeMan::GetRankTable(int64_t nBlockHeight, int minProtocol, int nFlags)
 {
-    std::vector<pair<int64_t, CTxIn> > vecMasternodeScores;
-    int64_t nMasternode_Min_Age = MN_WINNER_MINIMUM_AGE;
-    int64_t nMasternode_Age = 0;
-
-    //make sure we know about this block
-    uint256 hash = 0;
-    if (!GetBlockHash(hash, nBlockHeight)) return -1;
-
-    // scan for winner
-    BOOST_FOREACH (CMasternode& mn, vMasternodes) {
+    AssertLockHeld(cs);
+
+    uint256 hashBlock;
+    const ScoreTable* pScores = GetScores(nBlockHeight, hashBlock);
+    if (pScores == NULL) return NULL;
+
+    // enabled states and ages change over time, so rank tables are rebuilt as
+    // often as Masternodes get checked
+    RankKey key = make_pair(hashBlock, make_pair(minProtocol, nFlags));
+    std::map<RankKey, RankTable>::iterator it = mapRankCache.find(key);
+    if (it != mapRankCache.end() && GetTime() - it->second.nTime < MASTERNODE_CHECK_SECONDS)
+        return &it->second;
+
+    if (it == mapRankCache.end() && mapRankCache.size() >= MASTERNODES_RANK_CACHE_SIZE)
+        mapRankCache.clear();
+
+    RankTable& table = mapRankCache[key];
+    table.nTime = GetTime();
+    table.vRanked.clear();
+    table.mapRanks.clear();
+
+    bool fCheckAge = (nFlags & RANK_MINIMUM_AGE) && sporkManager.IsSporkActive(SPORK_8_MASTERNODE_PAYMENT_ENFORCEMENT);
+    BOOST_FOREACH (const PAIRTYPE(int64_t, size_t) & s, *pScores) {
+        CMasternode& mn = vMasternodes[s.second];
         if (mn.protocolVersion < minProtocol) {
             LogPrint("masternode","Skipping Masternode with obsolete version %d\n", mn.protocolVersion);
             continue;                                                       // Skip obsolete versions
         }
 
-        if (sporkManager.IsSporkActive(SPORK_8_MASTERNODE_PAYMENT_ENFORCEMENT)) {
-            nMasternode_Age = GetAdjustedTime() - mn.sigTime;
-            if ((nMasternode_Age) < nMasternode_Min_Age) {
+        if (fCheckAge) {
+            int64_t nMasternode_Age = GetAdjustedTime() - mn.sigTime;
+            if (nMasternode_Age < MN_WINNER_MINIMUM_AGE) {
                 if (fDebug) LogPrint("masternode","Skipping just activated Masternode. Age: %ld\n", nMasternode_Age);
                 continue;                                                   // Skip masternodes younger than (default) 1 hour
             }
         }
-        if (fOnlyActive) {
+        if (nFlags & RANK_ONLY_ACTIVE) {
             mn.Check();
             if (!mn.IsEnabled()) continue;
         }
-        uint256 n = mn.CalculateScore(1, nBlockHeight);
-        int64_t n2 = n.GetCompact(false);
 
-        vecMasternodeScores.push_back(make_pair(n2, mn.vin));
+        table.vRanked.push_back(s.second);
+        table.mapRanks[mn.vin.prevout] = table.vRanked.size();
     }
 
-    sort(vecMasternodeScores.rbegin(), vecMasternodeScores.rend(), CompareScoreTxIn());
+    return &table;
+}
 
-    int rank = 0;
-    BOOST_FOREACH (PAIRTYPE(int64_t, CTxIn) & s, vecMasternodeScores) {
-        rank++;
-        if (s.second.prevout == vin.prevout) {
-            return rank;
-        }
+void CMasternodeMan::ClearRankCache()
+{
+    mapScoreCache.clear();
+    mapRankCache.clear();
+    nListVersion++;
+}
+
+CMasternode* CMasternodeMan::GetCurrentMasterNode(int mod, int64_t nBlockHeight, int minProtocol)
+{
+    LOCK(cs);
+
+    uint256 hashBlock;
+    const ScoreTable* pScores = GetScores(nBlockHeight, hashBlock);
+    if (pScores == NULL) return NULL;
+
+    // the winner is the enabled Masternode with the best score
+    BOOST_FOREACH (const PAIRTYPE(int64_t, size_t) & s, *pScores) {
+        if (s.first <= 0) break;
+        CMasternode& mn = vMasternodes[s.second];
+        mn.Check();
+        if (mn.protocolVersion < minProtocol || !mn.IsEnabled()) continue;
+        return &mn;
     }
 
-    return -1;
+    return NULL;
+}
+
+int CMasternodeMan::GetMasternodeRank(const CTxIn& vin, int64_t nBlockHeight, int minProtocol, bool fOnlyActive)
+{
+    LOCK(cs);
+
+    const RankTable* pTable = GetRankTable(nBlockHeight, minProtocol, RANK_MINIMUM_AGE | (fOnlyActive ? RANK_ONLY_ACTIVE : 0));
+    if (pTable == NULL) return -1;
+
+    std::map<COutPoint, int>::const_iterator it = pTable->mapRanks.find(vin.prevout);
+    if (it == pTable->mapRanks.end()) return -1;
+
+    return it->second;
 }
 
 std::vector<pair<int, CMasternode> > CMasternodeMan::GetMasternodeRanks(int64_t nBlockHeight, int minProtocol)
 {
-    std::vector<pair<int64_t, CMasternode> > vecMasternodeScores;
+    LOCK(cs);
+
     std::vector<pair<int, CMasternode> > vecMasternodeRanks;
 
-    //make sure we know about this block
-    uint256 hash = 0;
-    if (!GetBlockHash(hash, nBlockHeight)) return vecMasternodeRanks;
+    uint256 hashBlock;
+    const ScoreTable* pScores = GetScores(nBlockHeight, hashBlock);
+    if (pScores == NULL) return vecMasternodeRanks;
 
-    // scan for winner
-    BOOST_FOREACH (CMasternode& mn, vMasternodes) {
+    // enabled Masternodes by score, followed by the ones that are not enabled
+    std::vector<size_t> vDisabled;
+    BOOST_FOREACH (const PAIRTYPE(int64_t, size_t) & s, *pScores) {
+        CMasternode& mn = vMasternodes[s.second];
         mn.Check();
 
         if (mn.protocolVersion < minProtocol) continue;
 
         if (!mn.IsEnabled()) {
-            vecMasternodeScores.push_back(make_pair(9999, mn));
+            vDisabled.push_back(s.second);
             continue;
         }
 
-        uint256 n = mn.CalculateScore(1, nBlockHeight);
-        int64_t n2 = n.GetCompact(false);
-
-        vecMasternodeScores.push_back(make_pair(n2, mn));
+        vecMasternodeRanks.push_back(make_pair(vecMasternodeRanks.size() + 1, mn));
     }
 
-    sort(vecMasternodeScores.rbegin(), vecMasternodeScores.rend(), CompareScoreMN());
-
-    int rank = 0;
-    BOOST_FOREACH (PAIRTYPE(int64_t, CMasternode) & s, vecMasternodeScores) {
-        rank++;
-        vecMasternodeRanks.push_back(make_pair(rank, s.second));
+    BOOST_FOREACH (size_t i, vDisabled) {
+        vecMasternodeRanks.push_back(make_pair(vecMasternodeRanks.size() + 1, vMasternodes[i]));
     }
 
     return vecMasternodeRanks;
@@ -678,33 +742,12 @@ std::vector<pair<int, CMasternode> > CMasternodeMan::GetMasternodeRanks(int64_t
 
 CMasternode* CMasternodeMan::GetMasternodeByRank(int nRank, int64_t nBlockHeight, int minProtocol, bool fOnlyActive)
 {
-    std::vector<pair<int64_t, CTxIn> > vecMasternodeScores;
-
-    // scan for winner
-    BOOST_FOREACH (CMasternode& mn, vMasternodes) {
-        if (mn.protocolVersion < minProtocol) continue;
-        if (fOnlyActive) {
-            mn.Check();
-            if (!mn.IsEnabled()) continue;
-        }
-
-        uint256 n = mn.CalculateScore(1, nBlockHeight);
-        int64_t n2 = n.GetCompact(false);
-
-        vecMasternodeScores.push_back(make_pair(n2, mn.vin));
-    }
-
-    sort(vecMasternodeScores.rbegin(), vecMasternodeScores.rend(), CompareScoreTxIn());
+    LOCK(cs);
 
-    int rank = 0;
-    BOOST_FOREACH (PAIRTYPE(int64_t, CTxIn) & s, vecMasternodeScores) {
-        rank++;
-        if (rank == nRank) {
-            return Find(s.second);
-        }
-    }
+    const RankTable* pTable = GetRankTable(nBlockHeight, minProtocol, fOnlyActive ? RANK_ONLY_ACTIVE : 0);
+    if (pTable == NULL || nRank < 1 || nRank > (int)pTable->vRanked.size()) return NULL;
 
-    return NULL;
+    return &vMasternodes[pTable->vRanked[nRank - 1]];
 }
 
 void CMasternodeMan::ProcessMasternodeConnections()
@@ -986,16 +1029,11 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand, CData
         //  - this is checked later by .check() in many places and by ThreadCheckObfuScationPool()
 
         CValidationState state;
-        CMutableTransaction tx = CMutableTransaction();
-        CTxOut vout = CTxOut(((Params().MasternodeCollateralLimit() - 0.01)) * COIN, obfuScationPool.collateralPubKey);
-        tx.vin.push_back(vin);
-        tx.vout.push_back(vout);
-
         bool fAcceptable = false;
         {
             TRY_LOCK(cs_main, lockMain);
             if (!lockMain) return;
-            fAcceptable = AcceptableInputs(mempool, state, CTransaction(tx), false, NULL);
+            fAcceptable = collateralWatcher.CheckUnspent(vin, state);
         }
 
         if (fAcceptable) {
@@ -1053,7 +1091,7 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand, CData
 
             int nDoS = 0;
             if (state.IsInvalid(nDoS)) {
-                LogPrint("masternode","dsee - %s from %i %s was not accepted into the memory pool\n", tx.GetHash().ToString().c_str(),
+                LogPrint("masternode","dsee - collateral %s from %i %s was not accepted\n", vin.prevout.ToString().c_str(),
                     pfrom->GetId(), pfrom->cleanSubVer.c_str());
                 if (nDoS > 0)
                     Misbehaving(pfrom->GetId(), nDoS);
@@ -1140,7 +1178,9 @@ void CMasternodeMan::Remove(CTxIn vin)
     while (it != vMasternodes.end()) {
         if ((*it).vin == vin) {
             LogPrint("masternode", "CMasternodeMan: Removing Masternode %s - %i now\n", (*it).vin.prevout.hash.ToString(), size() - 1);
+            collateralWatcher.Forget((*it).vin);
             vMasternodes.erase(it);
+            ClearRankCache();
             break;
         }
         ++it;
@@ -11,12 +11,15 @@
 #include "key.h"
 #include "main.h"
 #include "masternode.h"
+#include "masternode-cachedb.h"
 #include "net.h"
 #include "sync.h"
 #include "util.h"
+#include "validationinterface.h"
 
 #define MASTERNODES_DUMP_SECONDS (15 * 60)
 #define MASTERNODES_DSEG_SECONDS (3 * 60 * 60)
+#define MASTERNODES_RANK_CACHE_SIZE 64
 
 using namespace std;
 
@@ -27,28 +30,71 @@ void DumpMasternodes();
 
 /** Access to the MN database (mncache.dat)
  */
-class CMasternodeDB
+class CMasternodeDB : public CMasternodeCacheDB
 {
-private:
-    boost::filesystem::path pathMN;
-    std::string strMagicMessage;
-
 public:
-    enum ReadResult {
-        Ok,
-        FileError,
-        HashReadError,
-        IncorrectHash,
-        IncorrectMagicMessage,
-        IncorrectMagicNumber,
-        IncorrectFormat
-    };
-
     CMasternodeDB();
     bool Write(const CMasternodeMan& mnodemanToSave);
     ReadResult Read(CMasternodeMan& mnodemanToLoad, bool fDryRun = false);
 };
 
+/**
+ * Tracks whether masternode collateral outpoints have been spent.
+ *
+ * Only the collaterals of masternodes in the list are watched. A collateral
+ * is checked against the UTXO set and mempool until a check succeeds. From
+ * then on its state follows the transaction spending it: the collateral is
+ * spent while that transaction is in the mempool or in the active chain, and
+ * unspent again once the transaction is evicted, conflicted or disconnected.
+ */
+class CMasternodeCollateralWatcher : public CValidationInterface
+{
+public:
+    enum CollateralState {
+        COLLATERAL_UNKNOWN,
+        COLLATERAL_UNSPENT,
+        COLLATERAL_SPENT
+    };
+
+    /// State of a collateral; COLLATERAL_UNKNOWN if it is not watched or has not been checked yet
+    CollateralState GetState(const CTxIn& vin) const;
+
+    /// Check that a collateral is unspent and holds enough coins, recording the result if it is watched.
+    /// cs_main must be held, so no spend can slip in between the check and the update.
+    bool CheckUnspent(const CTxIn& vin, CValidationState& state);
+
+    /// Start watching the collateral of a masternode entering the list
+    void Watch(const CTxIn& vin);
+    /// Stop watching the collateral of a masternode leaving the list
+    void Forget(const CTxIn& vin);
+    void Clear();
+    size_t size() const;
+
+protected:
+    void SyncTransaction(const CTransaction& tx, const CBlock* pblock);
+    void TransactionRemovedFromMempool(const CTransaction& tx);
+    void BlockDisconnected(const CBlock& block);
+
+private:
+    struct WatchedCollateral {
+        // an UTXO check succeeded since the collateral started being watched
+        bool fChecked;
+        // transaction spending the collateral, null if unspent
+        uint256 hashSpender;
+        // whether hashSpender is in the active chain rather than in the mempool
+        bool fSpentInBlock;
+
+        WatchedCollateral() : fChecked(false), fSpentInBlock(false) {}
+    };
+
+    mutable RecursiveMutex cs;
+    // keyed by the prevout of the masternode's vin
+    std::map<COutPoint, WatchedCollateral> mapWatched;
+
+    /// Mark the collaterals spent by tx as unspent again, if tx was their recorded spender
+    void RevertSpends(const CTransaction& tx, bool fInBlock);
+};
+
 class CMasternodeMan
 {
 private:
@@ -67,6 +113,33 @@ private:
     // which Masternodes we've asked for
     std::map<COutPoint, int64_t> mWeAskedForMasternodeListEntry;
 
+    // masternode scores for the block hash they are derived from, best first; entries index vMasternodes
+    typedef std::vector<std::pair<int64_t, size_t> > ScoreTable;
+    std::map<uint256, ScoreTable> mapScoreCache;
+
+    // masternodes passing a rank query's filters, in rank order
+    struct RankTable {
+        int64_t nTime;
+        std::vector<size_t> vRanked;
+        std::map<COutPoint, int> mapRanks;
+    };
+    enum RankFlags {
+        RANK_ONLY_ACTIVE = (1 << 0),
+        RANK_MINIMUM_AGE = (1 << 1)
+    };
+    // rank tables keyed by block hash, minimum protocol and RankFlags
+    typedef std::pair<uint256, std::pair<int, int> > RankKey;
+    std::map<RankKey, RankTable> mapRankCache;
+    // bumped whenever vMasternodes gains or loses entries
+    int64_t nListVersion;
+
+    /// Scores of all Masternodes for a block height, computed once per block
+    const ScoreTable* GetScores(int64_t nBlockHeight, uint256& hashBlock);
+    /// Ranks of the Masternodes matching a query; refreshed after MASTERNODE_CHECK_SECONDS
+    const RankTable* GetRankTable(int64_t nBlockHeight, int minProtocol, int nFlags);
+    /// Drop cached scores and ranks, must be called whenever vMasternodes changes
+    void ClearRankCache();
+
 public:
     // Keep track of all broadcasts I've seen
     map<uint256, CMasternodeBroadcast> mapSeenMasternodeBroadcast;
@@ -76,6 +149,9 @@ public:
     // keep track of dsq count to prevent masternodes from gaming obfuscation queue
     int64_t nDsqCount;
 
+    // spend state of the collaterals of the masternodes in vMasternodes
+    CMasternodeCollateralWatcher collateralWatcher;
+
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
@@ -83,6 +159,12 @@ public:
     {
         LOCK(cs);
         READWRITE(vMasternodes);
+        if (ser_action.ForRead()) {
+            ClearRankCache();
+            collateralWatcher.Clear();
+            BOOST_FOREACH (const CMasternode& mn, vMasternodes)
+                collateralWatcher.Watch(mn.vin);
+        }
         READWRITE(mAskedUsForMasternodeList);
         READWRITE(mWeAskedForMasternodeList);
         READWRITE(mWeAskedForMasternodeListEntry);
@@ -112,6 +194,13 @@ public:
 
     int CountEnabled(int protocolVersion = -1);
 
+    /// Changes whenever a Masternode is added or removed, so callers can skip re-checking unchanged lists
+    int64_t GetListVersion()
+    {
+        LOCK(cs);
+        return nListVersion;
+    }
+
     void CountNetworks(int protocolVersion, int& ipv4, int& ipv6, int& onion);
 
     void DsegUpdate(CNode* pnode);
@@ -12,7 +12,24 @@
 
 using namespace std;
 
+CBloomBlockData::CBloomBlockData(const CBlock& blockIn) : block(blockIn)
+{
+    vTxData.reserve(block.vtx.size());
+    for (const CTransaction& tx : block.vtx)
+        vTxData.emplace_back(tx);
+}
+
 CMerkleBlock::CMerkleBlock(const CBlock& block, CBloomFilter& filter)
+{
+    Init(block, NULL, filter);
+}
+
+CMerkleBlock::CMerkleBlock(const CBloomBlockData& blockData, CBloomFilter& filter)
+{
+    Init(blockData.block, &blockData.vTxData, filter);
+}
+
+void CMerkleBlock::Init(const CBlock& block, const std::vector<CBloomTxData>* pvTxData, CBloomFilter& filter)
 {
     header = block.GetBlockHeader();
 
@@ -24,7 +41,8 @@ CMerkleBlock::CMerkleBlock(const CBlock& block, CBloomFilter& filter)
 
     for (unsigned int i = 0; i < block.vtx.size(); i++) {
         const uint256& hash = block.vtx[i].GetHash();
-        if (filter.IsRelevantAndUpdate(block.vtx[i])) {
+        bool fRelevant = pvTxData ? filter.IsRelevantAndUpdate((*pvTxData)[i]) : filter.IsRelevantAndUpdate(block.vtx[i]);
+        if (fRelevant) {
             vMatch.push_back(true);
             vMatchedTxn.push_back(make_pair(i, hash));
         } else
@@ -119,6 +119,19 @@ public:
 };
 
 
+/**
+ * A block being served to filtering peers, along with the bloom filter
+ * elements of its transactions, so they are extracted once for all peers.
+ */
+class CBloomBlockData
+{
+public:
+    CBlock block;
+    std::vector<CBloomTxData> vTxData;
+
+    explicit CBloomBlockData(const CBlock& blockIn);
+};
+
 /**
  * Used to relay blocks as header + vector<merkle branch>
  * to filtered nodes.
@@ -140,6 +153,7 @@ public:
      * thus the filter will likely be modified.
      */
     CMerkleBlock(const CBlock& block, CBloomFilter& filter);
+    CMerkleBlock(const CBloomBlockData& blockData, CBloomFilter& filter);
 
     ADD_SERIALIZE_METHODS;
 
@@ -149,6 +163,9 @@ public:
         READWRITE(header);
         READWRITE(txn);
     }
+
+private:
+    void Init(const CBlock& block, const std::vector<CBloomTxData>* pvTxData, CBloomFilter& filter);
 };
 
 #endif // BITCOIN_MERKLEBLOCK_H
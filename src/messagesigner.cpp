@@ -4,13 +4,99 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "base58.h"
+#include "checkqueue.h"
 #include "hash.h"
 #include "main.h" // For strMessageMagic
 #include "messagesigner.h"
 #include "masternodeman.h"  // For GetPublicKey (of MN from its vin)
+#include "random.h"
 #include "tinyformat.h"
 #include "utilstrencodings.h"
 #include "util.h"
+
+#include <boost/thread.hpp>
+
+namespace {
+
+/**
+ * Cache of public key ids recovered from compact signatures, keyed by the
+ * hash of the signed hash and the signature. Masternode, payment and budget
+ * messages are relayed by many peers and re-sent after every sync reset, so
+ * the same signatures get verified over and over.
+ */
+class CRecoveredKeyCache
+{
+private:
+    std::map<uint256, CKeyID> mapKeys;
+    boost::shared_mutex cs_keycache;
+
+public:
+    static uint256 GetEntry(const uint256& hash, const std::vector<unsigned char>& vchSig)
+    {
+        return Hash(hash.begin(), hash.end(), vchSig.begin(), vchSig.end());
+    }
+
+    bool Get(const uint256& entry, CKeyID& keyIDRet)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_keycache);
+        std::map<uint256, CKeyID>::const_iterator it = mapKeys.find(entry);
+        if (it == mapKeys.end())
+            return false;
+        keyIDRet = it->second;
+        return true;
+    }
+
+    void Set(const uint256& entry, const CKeyID& keyID)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_keycache);
+        while (mapKeys.size() >= MAX_RECOVERED_KEY_CACHE_SIZE) {
+            // Evict a random entry, like the script signature cache
+            std::map<uint256, CKeyID>::iterator it = mapKeys.lower_bound(GetRandHash());
+            if (it == mapKeys.end())
+                it = mapKeys.begin();
+            mapKeys.erase(it);
+        }
+        mapKeys[entry] = keyID;
+    }
+};
+
+CRecoveredKeyCache recoveredKeyCache;
+
+/** Closure representing one signature whose key is to be recovered */
+class CSignatureRecoveryCheck
+{
+private:
+    uint256 hash;
+    std::vector<unsigned char> vchSig;
+
+public:
+    CSignatureRecoveryCheck() {}
+    CSignatureRecoveryCheck(const uint256& hashIn, const std::vector<unsigned char>& vchSigIn) : hash(hashIn), vchSig(vchSigIn) {}
+
+    bool operator()()
+    {
+        // invalid signatures are reported when the message itself is checked
+        CKeyID keyID;
+        CHashSigner::RecoverKeyID(hash, vchSig, keyID);
+        return true;
+    }
+
+    void swap(CSignatureRecoveryCheck& check)
+    {
+        std::swap(hash, check.hash);
+        vchSig.swap(check.vchSig);
+    }
+};
+
+CCheckQueue<CSignatureRecoveryCheck> sigrecoveryqueue(128);
+
+}
+
+void ThreadSignatureRecovery()
+{
+    util::ThreadRename("dogecash-sigrec");
+    sigrecoveryqueue.Thread();
+}
 bool CMessageSigner::GetKeysFromSecret(const std::string& strSecret, CKey& keyRet, CPubKey& pubkeyRet)
 {
     CBitcoinSecret vchSecret;
@@ -58,15 +144,15 @@ bool CHashSigner::VerifyHash(const uint256& hash, const CPubKey& pubkey, const s
 
 bool CHashSigner::VerifyHash(const uint256& hash, const CKeyID& keyID, const std::vector<unsigned char>& vchSig, std::string& strErrorRet)
 {
-    CPubKey pubkeyFromSig;
-    if(!pubkeyFromSig.RecoverCompact(hash, vchSig)) {
+    CKeyID keyIDFromSig;
+    if(!RecoverKeyID(hash, vchSig, keyIDFromSig)) {
         strErrorRet = "Error recovering public key.";
         return false;
     }
 
-    if(pubkeyFromSig.GetID() != keyID) {
+    if(keyIDFromSig != keyID) {
         strErrorRet = strprintf("Keys don't match: pubkey=%s, pubkeyFromSig=%s, hash=%s, vchSig=%s",
-                CBitcoinAddress(keyID).ToString(), CBitcoinAddress(pubkeyFromSig.GetID()).ToString(),
+                CBitcoinAddress(keyID).ToString(), CBitcoinAddress(keyIDFromSig).ToString(),
                 hash.ToString(), EncodeBase64(&vchSig[0], vchSig.size()));
         return false;
     }
@@ -74,6 +160,41 @@ bool CHashSigner::VerifyHash(const uint256& hash, const CKeyID& keyID, const std
     return true;
 }
 
+bool CHashSigner::RecoverKeyID(const uint256& hash, const std::vector<unsigned char>& vchSig, CKeyID& keyIDRet)
+{
+    const uint256 entry = CRecoveredKeyCache::GetEntry(hash, vchSig);
+    if (recoveredKeyCache.Get(entry, keyIDRet))
+        return true;
+
+    CPubKey pubkeyFromSig;
+    if(!pubkeyFromSig.RecoverCompact(hash, vchSig))
+        return false;
+
+    keyIDRet = pubkeyFromSig.GetID();
+    recoveredKeyCache.Set(entry, keyIDRet);
+    return true;
+}
+
+void CHashSigner::RecoverBatch(const std::vector<std::pair<uint256, std::vector<unsigned char> > >& vSignatures)
+{
+    if (!nScriptCheckThreads || vSignatures.size() < MIN_SIGNATURE_BATCH_SIZE)
+        return;
+
+    std::vector<CSignatureRecoveryCheck> vChecks;
+    vChecks.reserve(vSignatures.size());
+    for (unsigned int i = 0; i < vSignatures.size(); i++) {
+        CKeyID keyID;
+        if (!recoveredKeyCache.Get(CRecoveredKeyCache::GetEntry(vSignatures[i].first, vSignatures[i].second), keyID))
+            vChecks.push_back(CSignatureRecoveryCheck(vSignatures[i].first, vSignatures[i].second));
+    }
+    if (vChecks.size() < MIN_SIGNATURE_BATCH_SIZE)
+        return;
+
+    CCheckQueueControl<CSignatureRecoveryCheck> control(&sigrecoveryqueue);
+    control.Add(vChecks);
+    control.Wait();
+}
+
 /** CSignedMessage Class
  *  Functions inherited by network signed-messages
  */
@@ -126,16 +247,9 @@ bool CSignedMessage::CheckSignature(const CPubKey& pubKey) const
 {
     std::string strError = "";
 
-    if (nMessVersion == MessageVersion::MESS_VER_HASH) {
-        uint256 hash = GetSignatureHash();
-        if(!CHashSigner::VerifyHash(hash, pubKey, vchSig, strError))
-            return error("%s : VerifyHash failed: %s", __func__, strError);
-
-    } else {
-        std::string strMessage = GetStrMessage();
-        if(!CMessageSigner::VerifyMessage(pubKey, vchSig, strMessage, strError))
-            return error("%s : VerifyMessage failed: %s", __func__, strError);
-    }
+    if(!CHashSigner::VerifyHash(GetSignedHash(), pubKey, vchSig, strError))
+        return error("%s : %s failed: %s", __func__,
+                nMessVersion == MessageVersion::MESS_VER_HASH ? "VerifyHash" : "VerifyMessage", strError);
 
     return true;
 }
@@ -151,6 +265,14 @@ bool CSignedMessage::CheckSignature() const
     return CheckSignature(pubkey);
 }
 
+uint256 CSignedMessage::GetSignedHash() const
+{
+    if (nMessVersion == MessageVersion::MESS_VER_HASH)
+        return GetSignatureHash();
+
+    return CMessageSigner::GetMessageHash(GetStrMessage());
+}
+
 const CPubKey CSignedMessage::GetPublicKey(std::string& strErrorRet) const
 {
     const CTxIn vin = GetVin();
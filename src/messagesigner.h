@@ -9,6 +9,13 @@
 #include "key.h"
 #include "primitives/transaction.h" // for CTxIn
 
+/** Fewer queued signatures than this are verified inline rather than in parallel */
+static const unsigned int MIN_SIGNATURE_BATCH_SIZE = 8;
+/** Maximum number of signatures recovered in one parallel batch */
+static const unsigned int MAX_SIGNATURE_BATCH_SIZE = 512;
+/** Maximum number of entries in the recovered key cache */
+static const unsigned int MAX_RECOVERED_KEY_CACHE_SIZE = 100000;
+
 enum MessageVersion {
         MESS_VER_STRMESS    = 0,
         MESS_VER_HASH       = 1,
@@ -42,8 +49,17 @@ public:
     static bool VerifyHash(const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
     /// Verify the hash signature, returns true if successful
     static bool VerifyHash(const uint256& hash, const CKeyID& keyID, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
+    /// Recover the key id a hash was signed with, returns true if successful.
+    /// Results are cached, so verifying the same signature again is a lookup.
+    static bool RecoverKeyID(const uint256& hash, const std::vector<unsigned char>& vchSig, CKeyID& keyIDRet);
+    /// Recover the keys of a batch of (hash, signature) pairs on the signature
+    /// recovery threads, so that verifying them afterwards hits the cache
+    static void RecoverBatch(const std::vector<std::pair<uint256, std::vector<unsigned char> > >& vSignatures);
 };
 
+/** Run a worker thread of the signature recovery queue */
+void ThreadSignatureRecovery();
+
 /** Base Class for all signed messages on the network
  */
 class CSignedMessage
@@ -78,6 +94,9 @@ public:
     virtual std::string GetStrMessage() const = 0;
     virtual const CTxIn GetVin() const = 0;
 
+    // Hash that vchSig signs, depending on nMessVersion
+    virtual uint256 GetSignedHash() const;
+
     // GetPublicKey defaults to public key of masternode with vin from GetVin.
     // Child classes can override if public key is directly accessible.
     virtual const CPubKey GetPublicKey(std::string& strErrorRet) const;
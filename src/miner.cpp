@@ -530,7 +530,10 @@ CBlockTemplate* CreateNewBlock(const CScript& scriptPubKeyIn, CWallet* pwallet,
         CValidationState state;
         if (!TestBlockValidity(state, *pblock, pindexPrev, false, false)) {
             LogPrintf("CreateNewBlock() : TestBlockValidity failed\n");
-            mempool.clear();
+            std::list<CTransaction> removed;
+            mempool.clear(removed);
+            BOOST_FOREACH (const CTransaction& tx, removed)
+                GetMainSignals().TransactionRemovedFromMempool(tx);
             return NULL;
         }
 
@@ -36,6 +36,8 @@
 #include <miniupnpc/upnperrors.h>
 #endif
 
+#include <atomic>
+
 #include <boost/filesystem.hpp>
 #include <boost/thread.hpp>
 
@@ -345,6 +347,8 @@ uint64_t CNode::nTotalBytesRecv = 0;
 uint64_t CNode::nTotalBytesSent = 0;
 RecursiveMutex CNode::cs_totalBytesRecv;
 RecursiveMutex CNode::cs_totalBytesSent;
+mapNetMsgStats CNode::mapTotalMsgStats;
+Mutex CNode::cs_totalMsgStats;
 
 CNode* FindNode(const CNetAddr& ip)
 {
@@ -705,6 +709,9 @@ void CNode::copyStats(CNodeStats& stats)
 
     // Leave string empty if addrLocal invalid (not filled in yet)
     stats.addrLocal = addrLocal.IsValid() ? addrLocal.ToString() : "";
+
+    LOCK(cs_msgStats);
+    stats.mapMsgStats = mapMsgStats;
 }
 #undef X
 
@@ -739,6 +746,7 @@ bool CNode::ReceiveMsgBytes(const char* pch, unsigned int nBytes)
 
         if (msg.complete()) {
             msg.nTime = GetTimeMicros();
+            RecordMsgRecv(msg.hdr.GetCommand(), msg.hdr.nMessageSize + CMessageHeader::HEADER_SIZE);
             messageHandlerCondition.notify_one();
         }
     }
@@ -810,6 +818,7 @@ void SocketSendData(CNode* pnode)
             if (pnode->nSendOffset == data.size()) {
                 pnode->nSendOffset = 0;
                 pnode->nSendSize -= data.size();
+                pnode->RecycleSendBuffer(*it);
                 it++;
             } else {
                 // could not send full message; stop sending more
@@ -1272,10 +1281,19 @@ void ThreadDNSAddressSeed()
 
 void DumpAddresses()
 {
+    // peers.dat is only rewritten when the address tables changed since the last flush
+    static std::atomic<uint64_t> nFlushedChanges(0);
+    uint64_t nChanges = addrman.GetChangeCount();
+    if (nChanges == nFlushedChanges) {
+        LogPrint("net", "Address tables unchanged, skipped flushing peers.dat\n");
+        return;
+    }
+
     int64_t nStart = GetTimeMillis();
 
     CAddrDB adb;
-    adb.Write(addrman);
+    if (adb.Write(addrman))
+        nFlushedChanges = nChanges;
 
     LogPrint("net", "Flushed %d addresses to peers.dat  %dms\n",
         addrman.size(), GetTimeMillis() - nStart);
@@ -1841,13 +1859,17 @@ void RelayTransaction(const CTransaction& tx, const CDataStream& ss)
         mapRelay.insert(std::make_pair(inv, ss));
         vRelayExpiration.push_back(std::make_pair(GetTime() + 15 * 60, inv));
     }
+    // the parts of tx bloom filters match against are extracted once, for the first filtering peer
+    std::unique_ptr<CBloomTxData> pTxData;
     LOCK(cs_vNodes);
     BOOST_FOREACH (CNode* pnode, vNodes) {
         if (!pnode->fRelayTxes)
             continue;
         LOCK(pnode->cs_filter);
         if (pnode->pfilter) {
-            if (pnode->pfilter->IsRelevantAndUpdate(tx))
+            if (!pTxData)
+                pTxData.reset(new CBloomTxData(tx));
+            if (pnode->pfilter->IsRelevantAndUpdate(*pTxData))
                 pnode->PushInventory(inv);
         } else
             pnode->PushInventory(inv);
@@ -1902,6 +1924,61 @@ uint64_t CNode::GetTotalBytesSent()
     return nTotalBytesSent;
 }
 
+/** Received commands are chosen by the peer, so only known ones get their own entry */
+static const std::string& MsgStatsKey(const std::string& strCommand)
+{
+    static const std::set<std::string> setKnown(GetAllNetMessageTypes().begin(), GetAllNetMessageTypes().end());
+    static const std::string strOther(NET_MESSAGE_COMMAND_OTHER);
+    std::set<std::string>::const_iterator it = setKnown.find(strCommand);
+    return it != setKnown.end() ? *it : strOther;
+}
+
+void CNode::RecordMsgSent(const std::string& strCommand, uint64_t nBytes)
+{
+    {
+        LOCK(cs_msgStats);
+        CNetMsgStats& stats = mapMsgStats[strCommand];
+        stats.nMsgsSent++;
+        stats.nBytesSent += nBytes;
+    }
+    LOCK(cs_totalMsgStats);
+    CNetMsgStats& stats = mapTotalMsgStats[strCommand];
+    stats.nMsgsSent++;
+    stats.nBytesSent += nBytes;
+}
+
+void CNode::RecordMsgRecv(const std::string& strCommand, uint64_t nBytes)
+{
+    const std::string& strKey = MsgStatsKey(strCommand);
+    {
+        LOCK(cs_msgStats);
+        CNetMsgStats& stats = mapMsgStats[strKey];
+        stats.nMsgsRecv++;
+        stats.nBytesRecv += nBytes;
+    }
+    LOCK(cs_totalMsgStats);
+    CNetMsgStats& stats = mapTotalMsgStats[strKey];
+    stats.nMsgsRecv++;
+    stats.nBytesRecv += nBytes;
+}
+
+void CNode::RecordMsgProcessTime(const std::string& strCommand, int64_t nMicros)
+{
+    const std::string& strKey = MsgStatsKey(strCommand);
+    {
+        LOCK(cs_msgStats);
+        mapMsgStats[strKey].nProcessMicros += nMicros;
+    }
+    LOCK(cs_totalMsgStats);
+    mapTotalMsgStats[strKey].nProcessMicros += nMicros;
+}
+
+mapNetMsgStats CNode::GetTotalMsgStats()
+{
+    LOCK(cs_totalMsgStats);
+    return mapTotalMsgStats;
+}
+
 void CNode::Fuzz(int nChance)
 {
     if (!fSuccessfullyConnected) return; // Don't fuzz initial handshake
@@ -1952,19 +2029,20 @@ bool CAddrDB::Write(const CAddrMan& addr)
     GetRandBytes((unsigned char*)&randv, sizeof(randv));
     std::string tmpfn = strprintf("peers.dat.%04x", randv);
 
-    // serialize addresses, checksum data up to that point, then append csum
+    // serialize addresses, checksum data up to that point, then append csum;
+    // addrman is only locked (shared) while it is serialized into memory
     CDataStream ssPeers(SER_DISK, CLIENT_VERSION);
     ssPeers << FLATDATA(Params().MessageStart());
     ssPeers << addr;
     uint256 hash = Hash(ssPeers.begin(), ssPeers.end());
     ssPeers << hash;
 
-    // open output file, and associate with CAutoFile
-    boost::filesystem::path pathAddr = GetDataDir() / "peers.dat";
-    FILE* file = fopen(pathAddr.string().c_str(), "wb");
+    // open temp output file, and associate with CAutoFile
+    boost::filesystem::path pathTmp = GetDataDir() / tmpfn;
+    FILE* file = fopen(pathTmp.string().c_str(), "wb");
     CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
     if (fileout.IsNull())
-        return error("%s : Failed to open file %s", __func__, pathAddr.string());
+        return error("%s : Failed to open file %s", __func__, pathTmp.string());
 
     // Write and commit header, data
     try {
@@ -1975,6 +2053,10 @@ bool CAddrDB::Write(const CAddrMan& addr)
     FileCommit(fileout.Get());
     fileout.fclose();
 
+    // replace existing peers.dat, if any, with new peers.dat.XXXX
+    if (!RenameOver(pathTmp, pathAddr))
+        return error("%s : Rename-into-place failed", __func__);
+
     return true;
 }
 
@@ -2144,6 +2226,15 @@ void CNode::AbortMessage() UNLOCK_FUNCTION(cs_vSend)
     LogPrint("net", "(aborted)\n");
 }
 
+void CNode::RecycleSendBuffer(CSerializeData& data)
+{
+    if (vSendPool.size() >= MAX_SEND_POOL_BUFFERS || data.capacity() > MAX_SEND_POOL_BUFFER_SIZE)
+        return;
+    vSendPool.push_back(CSerializeData());
+    vSendPool.back().swap(data);
+    vSendPool.back().clear();
+}
+
 void CNode::EndMessage() UNLOCK_FUNCTION(cs_vSend)
 {
     // The -*messagestest options are intentionally not documented in the help message,
@@ -2174,8 +2265,15 @@ void CNode::EndMessage() UNLOCK_FUNCTION(cs_vSend)
     memcpy((char*)&ssSend[CMessageHeader::CHECKSUM_OFFSET], &nChecksum, sizeof(nChecksum));
 
     LogPrint("net", "(%d bytes) peer=%d\n", nSize, id);
+    const char* pszCommand = &ssSend[MESSAGE_START_SIZE];
+    RecordMsgSent(std::string(pszCommand, strnlen(pszCommand, CMessageHeader::COMMAND_SIZE)), ssSend.size());
 
     std::deque<CSerializeData>::iterator it = vSendMsg.insert(vSendMsg.end(), CSerializeData());
+    if (!vSendPool.empty()) {
+        // Reuse the allocation of an already sent message
+        it->swap(vSendPool.back());
+        vSendPool.pop_back();
+    }
     ssSend.GetAndClear(*it);
     nSendSize += (*it).size();
 
@@ -63,6 +63,10 @@ static const bool DEFAULT_UPNP = false;
 #endif
 /** The maximum number of entries in mapAskFor */
 static const size_t MAPASKFOR_MAX_SZ = MAX_INV_SZ;
+/** The maximum number of sent message buffers kept per peer for reuse */
+static const size_t MAX_SEND_POOL_BUFFERS = 8;
+/** Sent message buffers with a larger capacity than this are freed instead of reused */
+static const size_t MAX_SEND_POOL_BUFFER_SIZE = 64 * 1024;
 
 unsigned int ReceiveFloodSize();
 unsigned int SendBufferSize();
@@ -155,6 +159,24 @@ struct LocalServiceInfo {
 extern RecursiveMutex cs_mapLocalHost;
 extern std::map<CNetAddr, LocalServiceInfo> mapLocalHost;
 
+/** Key under which messages with a command this node does not know are accounted */
+static const char* const NET_MESSAGE_COMMAND_OTHER = "*other*";
+
+/** Traffic and handler time of one message type */
+class CNetMsgStats
+{
+public:
+    uint64_t nMsgsSent;
+    uint64_t nBytesSent;
+    uint64_t nMsgsRecv;
+    uint64_t nBytesRecv;
+    int64_t nProcessMicros; // time spent handling the received messages
+
+    CNetMsgStats() : nMsgsSent(0), nBytesSent(0), nMsgsRecv(0), nBytesRecv(0), nProcessMicros(0) {}
+};
+
+typedef std::map<std::string, CNetMsgStats> mapNetMsgStats;
+
 class CNodeStats
 {
 public:
@@ -175,6 +197,7 @@ public:
     double dPingTime;
     double dPingWait;
     std::string addrLocal;
+    mapNetMsgStats mapMsgStats;
 };
 
 
@@ -192,6 +215,8 @@ public:
 
     int64_t nTime; // time (in microseconds) of message receipt.
 
+    bool fSigsPrefetched; // signatures already handed to the signature recovery queue
+
     CNetMessage(int nTypeIn, int nVersionIn) : hdrbuf(nTypeIn, nVersionIn), vRecv(nTypeIn, nVersionIn)
     {
         hdrbuf.resize(24);
@@ -199,6 +224,7 @@ public:
         nHdrPos = 0;
         nDataPos = 0;
         nTime = 0;
+        fSigsPrefetched = false;
     }
 
     bool complete() const
@@ -293,6 +319,7 @@ public:
     size_t nSendOffset; // offset inside the first vSendMsg already sent
     uint64_t nSendBytes;
     std::deque<CSerializeData> vSendMsg;
+    std::vector<CSerializeData> vSendPool; // sent buffers kept for reuse, protected by cs_vSend
     RecursiveMutex cs_vSend;
 
     std::deque<CInv> vRecvGetData;
@@ -301,6 +328,10 @@ public:
     uint64_t nRecvBytes;
     int nRecvVersion;
 
+    // Traffic and handler time per message command, protected by cs_msgStats
+    mapNetMsgStats mapMsgStats;
+    Mutex cs_msgStats;
+
     int64_t nLastSend;
     int64_t nLastRecv;
     int64_t nTimeConnected;
@@ -391,6 +422,8 @@ private:
     static RecursiveMutex cs_totalBytesSent;
     static uint64_t nTotalBytesRecv;
     static uint64_t nTotalBytesSent;
+    static mapNetMsgStats mapTotalMsgStats;
+    static Mutex cs_totalMsgStats;
 
     CNode(const CNode&);
     void operator=(const CNode&);
@@ -487,6 +520,9 @@ public:
     // TODO: Document the precondition of this function.  Is cs_vSend locked?
     void EndMessage() UNLOCK_FUNCTION(cs_vSend);
 
+    /** Keep the allocation of a fully sent message for a later EndMessage (requires cs_vSend) */
+    void RecycleSendBuffer(CSerializeData& data);
+
     void PushVersion();
 
 
@@ -731,6 +767,12 @@ public:
 
     static uint64_t GetTotalBytesRecv();
     static uint64_t GetTotalBytesSent();
+
+    // Per message command stats, for this node and for all nodes together
+    void RecordMsgSent(const std::string& strCommand, uint64_t nBytes);
+    void RecordMsgRecv(const std::string& strCommand, uint64_t nBytes);
+    void RecordMsgProcessTime(const std::string& strCommand, int64_t nMicros);
+    static mapNetMsgStats GetTotalMsgStats();
 };
 
 class CExplicitNetCleanup
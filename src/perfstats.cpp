@@ -0,0 +1,85 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "perfstats.h"
+
+#include "sync.h"
+#include "util.h"
+
+#include <algorithm>
+#include <mutex>
+
+struct PerfStageRegistry {
+    std::mutex mutex;
+    std::vector<CPerfStage*> vStages;
+};
+
+static PerfStageRegistry& GetPerfStageRegistry()
+{
+    static PerfStageRegistry registry;
+    return registry;
+}
+
+CPerfStage::CPerfStage(const char* pszNameIn) : pszName(pszNameIn), nCount(0), nTotalMicros(0), nMaxMicros(0), nLastMicros(0)
+{
+    PerfStageRegistry& registry = GetPerfStageRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.vStages.push_back(this);
+}
+
+void CPerfStage::Add(int64_t nMicros)
+{
+    nCount.fetch_add(1, std::memory_order_relaxed);
+    nTotalMicros.fetch_add(nMicros, std::memory_order_relaxed);
+    nLastMicros.store(nMicros, std::memory_order_relaxed);
+    int64_t nMax = nMaxMicros.load(std::memory_order_relaxed);
+    while (nMicros > nMax && !nMaxMicros.compare_exchange_weak(nMax, nMicros, std::memory_order_relaxed)) {
+    }
+}
+
+void CPerfStage::Reset()
+{
+    nCount = 0;
+    nTotalMicros = 0;
+    nMaxMicros = 0;
+    nLastMicros = 0;
+}
+
+std::vector<const CPerfStage*> GetPerfStages()
+{
+    PerfStageRegistry& registry = GetPerfStageRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return std::vector<const CPerfStage*>(registry.vStages.begin(), registry.vStages.end());
+}
+
+void ResetPerfStages()
+{
+    PerfStageRegistry& registry = GetPerfStageRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (CPerfStage* stage : registry.vStages)
+        stage->Reset();
+}
+
+void LogPerfStats()
+{
+    if (g_lock_stats_enabled) {
+        std::vector<CLockSiteStats> vSites = GetLockStats();
+        std::sort(vSites.begin(), vSites.end(), [](const CLockSiteStats& a, const CLockSiteStats& b) {
+            return a.nWaitMicros > b.nWaitMicros;
+        });
+        if (vSites.size() > PERF_STATS_LOG_LOCK_SITES)
+            vSites.resize(PERF_STATS_LOG_LOCK_SITES);
+        for (const CLockSiteStats& site : vSites) {
+            LogPrintf("perfstats: lock %s %s:%d samples=%u contended=%u tryfailed=%u wait=%.2fms (max %.2fms) hold=%.2fms (max %.2fms)\n",
+                site.strName, site.strFile, site.nLine, site.nSamples, site.nContended, site.nTryFailed,
+                site.nWaitMicros * 0.001, site.nWaitMaxMicros * 0.001, site.nHoldMicros * 0.001, site.nHoldMaxMicros * 0.001);
+        }
+    }
+    for (const CPerfStage* stage : GetPerfStages()) {
+        if (stage->Count() == 0)
+            continue;
+        LogPrintf("perfstats: stage %s count=%u total=%.2fms avg=%.3fms max=%.2fms\n",
+            stage->GetName(), stage->Count(), stage->Total() * 0.001, stage->Total() * 0.001 / stage->Count(), stage->Max() * 0.001);
+    }
+}
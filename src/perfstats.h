@@ -0,0 +1,56 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_PERFSTATS_H
+#define BITCOIN_PERFSTATS_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//! -perfstatsinterval default (seconds, 0 disables the periodic log)
+static const int64_t DEFAULT_PERF_STATS_INTERVAL = 0;
+//! Number of lock call sites included in the periodic log
+static const unsigned int PERF_STATS_LOG_LOCK_SITES = 10;
+
+/**
+ * Running totals for one stage of a hot path, e.g. the script checks of
+ * ConnectBlock. Stages are declared as static objects next to the code they
+ * time and register themselves, so getperfstats can list them all.
+ */
+class CPerfStage
+{
+private:
+    const char* pszName;
+    std::atomic<uint64_t> nCount;
+    std::atomic<int64_t> nTotalMicros;
+    std::atomic<int64_t> nMaxMicros;
+    std::atomic<int64_t> nLastMicros;
+
+    CPerfStage(const CPerfStage&) = delete;
+    CPerfStage& operator=(const CPerfStage&) = delete;
+
+public:
+    explicit CPerfStage(const char* pszNameIn);
+
+    /** Account for one pass through the stage which took nMicros */
+    void Add(int64_t nMicros);
+    void Reset();
+
+    const char* GetName() const { return pszName; }
+    uint64_t Count() const { return nCount; }
+    int64_t Total() const { return nTotalMicros; }
+    int64_t Max() const { return nMaxMicros; }
+    int64_t Last() const { return nLastMicros; }
+};
+
+/** Every registered stage, in registration order */
+std::vector<const CPerfStage*> GetPerfStages();
+void ResetPerfStages();
+
+/** Write the busiest lock call sites and all stage timers to debug.log */
+void LogPerfStats();
+
+#endif // BITCOIN_PERFSTATS_H
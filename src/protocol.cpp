@@ -36,6 +36,17 @@ static const char* ppszTypeName[] =
         "dstx"
     };
 
+/** Commands of every message this node sends or handles, see GetAllNetMessageTypes() */
+static const char* ppszNetMessageTypes[] =
+    {
+        "addr", "alert", "block", "dsc", "dsee", "dseep", "dseg", "dsf", "dsi", "dsq", "dsr", "dssu", "dstx",
+        "fbs", "fbvote", "filteradd", "filterclear", "filterload", "getaddr", "getblocks", "getdata",
+        "getheaders", "getsporks", "headers", "inv", "ix", "mempool", "merkleblock", "mnb", "mnget", "mnp",
+        "mnvs", "mnw", "mprop", "mvote", "notfound", "ping", "pong", "pubcoins", "reject", "spork", "ssc",
+        "tx", "txlvote", "verack", "version"
+    };
+static const std::vector<std::string> vNetMessageTypes(ppszNetMessageTypes, ppszNetMessageTypes + ARRAYLEN(ppszNetMessageTypes));
+
 CMessageHeader::CMessageHeader()
 {
     memcpy(pchMessageStart, Params().MessageStart(), MESSAGE_START_SIZE);
@@ -156,3 +167,8 @@ std::string CInv::ToString() const
 {
     return strprintf("%s %s", GetCommand(), hash.ToString());
 }
+
+const std::vector<std::string>& GetAllNetMessageTypes()
+{
+    return vNetMessageTypes;
+}
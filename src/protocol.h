@@ -19,6 +19,7 @@
 
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 #define MESSAGE_START_SIZE 4
 
@@ -172,4 +173,7 @@ enum {
     MSG_DSTX
 };
 
+/** Commands of every message this node sends or handles */
+const std::vector<std::string>& GetAllNetMessageTypes();
+
 #endif // BITCOIN_PROTOCOL_H
@@ -14,7 +14,7 @@ CSVModelWriter::CSVModelWriter(const QString& filename, QObject* parent) : QObje
 {
 }
 
-void CSVModelWriter::setModel(const QAbstractItemModel* model)
+void CSVModelWriter::setModel(QAbstractItemModel* model)
 {
     this->model = model;
 }
@@ -55,6 +55,9 @@ bool CSVModelWriter::write()
 
     int numRows = 0;
     if (model) {
+        // export the rows a model loads on demand too
+        while (model->canFetchMore(QModelIndex()))
+            model->fetchMore(QModelIndex());
         numRows = model->rowCount();
     }
 
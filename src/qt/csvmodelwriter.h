@@ -23,7 +23,7 @@ class CSVModelWriter : public QObject
 public:
     explicit CSVModelWriter(const QString& filename, QObject* parent = 0);
 
-    void setModel(const QAbstractItemModel* model);
+    void setModel(QAbstractItemModel* model);
     void addColumn(const QString& title, int column, int role = Qt::EditRole);
 
     /** Perform export of the model to CSV.
@@ -33,7 +33,7 @@ public:
 
 private:
     QString filename;
-    const QAbstractItemModel* model;
+    QAbstractItemModel* model;
 
     struct Column {
         QString title;
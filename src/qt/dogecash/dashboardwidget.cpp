@@ -208,12 +208,8 @@ void DashboardWidget::loadWalletModel(){
         connect(txModel, SIGNAL(rowsInserted(QModelIndex, int, int)),
                 this, SLOT(processNewTransaction(QModelIndex, int, int)));
 #ifdef USE_QTCHARTS
-        // chart filter
-        stakesFilter = new TransactionFilterProxy();
-        stakesFilter->setDynamicSortFilter(true);
-        stakesFilter->setOnlyStakesandMNTxes(true);
-        stakesFilter->setSourceModel(txModel);
-        hasStakes = stakesFilter->rowCount() > 0;
+        // the chart reads the stakes from the wallet, the table only loads the pages shown
+        hasStakes = !txModel->getStakeRecords(true).isEmpty();
         loadChart();
 #endif
     }
@@ -226,8 +222,7 @@ void DashboardWidget::onTxArrived(const QString& hash, const bool& isCoinStake,
 #ifdef USE_QTCHARTS
     if (isCoinStake) {
         // Update value if this is our first stake
-        if (!hasStakes)
-            hasStakes = stakesFilter->rowCount() > 0;
+        hasStakes = true;
         tryChartRefresh();
     }
 #endif
@@ -368,7 +363,7 @@ void DashboardWidget::loadChart(){
 }
 
 void DashboardWidget::showHideEmptyChart(bool showEmpty, bool loading, bool forceView) {
-    if (stakesFilter->rowCount() > SHOW_EMPTY_CHART_VIEW_THRESHOLD || forceView) {
+    if (nStakesInRange > SHOW_EMPTY_CHART_VIEW_THRESHOLD || forceView) {
         if (ui->emptyContainerChart->isVisible() != showEmpty) {
             ui->layoutChart->setVisible(!showEmpty);
             ui->emptyContainerChart->setVisible(showEmpty);
@@ -447,44 +442,43 @@ void DashboardWidget::updateStakeFilter() {
         if (yearFilter != 0) {
             if (filterByMonth) {
                 QDate monthFirst = QDate(yearFilter, monthFilter, 1);
-                stakesFilter->setDateRange(
-                        QDateTime(monthFirst),
-                        QDateTime(QDate(yearFilter, monthFilter, monthFirst.daysInMonth()))
-                );
+                stakesFrom = QDateTime(monthFirst);
+                stakesTo = QDateTime(QDate(yearFilter, monthFilter, monthFirst.daysInMonth()));
             } else {
-                stakesFilter->setDateRange(
-                        QDateTime(QDate(yearFilter, 1, 1)),
-                        QDateTime(QDate(yearFilter, 12, 31))
-                );
+                stakesFrom = QDateTime(QDate(yearFilter, 1, 1));
+                stakesTo = QDateTime(QDate(yearFilter, 12, 31));
             }
         } else if (filterByMonth) {
             QDate currentDate = QDate::currentDate();
             QDate monthFirst = QDate(currentDate.year(), monthFilter, 1);
-            stakesFilter->setDateRange(
-                    QDateTime(monthFirst),
-                    QDateTime(QDate(currentDate.year(), monthFilter, monthFirst.daysInMonth()))
-            );
+            stakesFrom = QDateTime(monthFirst);
+            stakesTo = QDateTime(QDate(currentDate.year(), monthFilter, monthFirst.daysInMonth()));
             ui->comboBoxYears->setCurrentText(QString::number(currentDate.year()));
         } else {
-            stakesFilter->clearDateRange();
+            stakesFrom = TransactionFilterProxy::MIN_DATE;
+            stakesTo = TransactionFilterProxy::MAX_DATE;
         }
     } else {
-        stakesFilter->clearDateRange();
+        stakesFrom = TransactionFilterProxy::MIN_DATE;
+        stakesTo = TransactionFilterProxy::MAX_DATE;
     }
 }
 
 // pair DOGEC,MN rewards
 const QMap<int, std::pair<qint64, qint64>> DashboardWidget::getAmountBy() {
     updateStakeFilter();
-    const int size = stakesFilter->rowCount();
     QMap<int, std::pair<qint64, qint64>> amountBy;
+    int nInRange = 0;
     // Get all of the stakes
-    for (int i = 0; i < size; ++i) {
-        QModelIndex modelIndex = stakesFilter->index(i, TransactionTableModel::ToAddress);
-        qint64 amount = llabs(modelIndex.data(TransactionTableModel::AmountRole).toLongLong());
-        QDate date = modelIndex.data(TransactionTableModel::DateRole).toDateTime().date();
-        bool isDogeC = modelIndex.data(TransactionTableModel::TypeRole).toInt() != TransactionRecord::Stakezdogec && modelIndex.data(TransactionTableModel::TypeRole).toInt() != TransactionRecord::MNReward;
-        bool isMN = modelIndex.data(TransactionTableModel::TypeRole).toInt() == TransactionRecord::MNReward;
+    for (const TransactionRecord& rec : txModel->getStakeRecords()) {
+        QDateTime datetime = QDateTime::fromTime_t(static_cast<uint>(rec.time));
+        if (datetime < stakesFrom || datetime > stakesTo)
+            continue;
+        nInRange++;
+        qint64 amount = llabs(rec.credit + rec.debit);
+        QDate date = datetime.date();
+        bool isDogeC = rec.type != TransactionRecord::Stakezdogec && rec.type != TransactionRecord::MNReward;
+        bool isMN = rec.type == TransactionRecord::MNReward;
         int time = 0;
         switch (chartShow) {
             case YEAR: {
@@ -521,6 +515,7 @@ const QMap<int, std::pair<qint64, qint64>> DashboardWidget::getAmountBy() {
             }
         }
     }
+    nStakesInRange = nInRange;
     return amountBy;
 }
 
@@ -816,7 +811,7 @@ void DashboardWidget::processNewTransaction(const QModelIndex& parent, int start
     if (!walletModel || !clientModel || clientModel->inInitialBlockDownload())
         return;
 
-    if (!txModel || txModel->processingQueuedTransactions())
+    if (!txModel || txModel->processingQueuedTransactions() || txModel->fetchingMore())
         return;
 
     QString date = txModel->index(start, TransactionTableModel::Date, parent).data().toString();
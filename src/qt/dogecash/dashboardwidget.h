@@ -147,7 +147,11 @@ private:
     std::atomic<bool> isLoading;
 
     // Chart
-    TransactionFilterProxy* stakesFilter = nullptr;
+    // Date range of the stakes summed by the chart
+    QDateTime stakesFrom = TransactionFilterProxy::MIN_DATE;
+    QDateTime stakesTo = TransactionFilterProxy::MAX_DATE;
+    // Stakes inside that range on the last load
+    std::atomic<int> nStakesInRange{0};
     bool isChartInitialized = false;
     QChartView *chartView = nullptr;
     QBarSeries *series = nullptr;
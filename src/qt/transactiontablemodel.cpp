@@ -11,6 +11,7 @@
 #include "guiutil.h"
 #include "optionsmodel.h"
 #include "transactiondesc.h"
+#include "transactionfilterproxy.h"
 #include "transactionrecord.h"
 #include "walletmodel.h"
 
@@ -28,12 +29,16 @@
 #include <QtConcurrent/QtConcurrent>
 #include <QFuture>
 
+#include <deque>
+#include <set>
+#include <tuple>
+#include <vector>
+
 #define SINGLE_THREAD_MAX_TXES_SIZE 4000
 
-// Maximum amount of loaded records in ram in the first load.
-// If the user has more and want to load them:
-// TODO, add load on demand in pages (not every tx loaded all the time into the records list).
-#define MAX_AMOUNT_LOADED_RECORDS 20000
+// Number of wallet transactions decomposed into records at once. The first
+// page is loaded with the model, older pages when the views scroll down to them.
+#define TX_RECORDS_PAGE_SIZE 5000
 
 // Amount column is right-aligned it contains numbers
 static int column_alignments[] = {
@@ -45,22 +50,6 @@ static int column_alignments[] = {
     Qt::AlignRight | Qt::AlignVCenter /* amount */
 };
 
-// Comparison operator for sort/binary search of model tx list
-struct TxLessThan {
-    bool operator()(const TransactionRecord& a, const TransactionRecord& b) const
-    {
-        return a.hash < b.hash;
-    }
-    bool operator()(const TransactionRecord& a, const uint256& b) const
-    {
-        return a.hash < b;
-    }
-    bool operator()(const uint256& a, const TransactionRecord& b) const
-    {
-        return a < b.hash;
-    }
-};
-
 // Private implementation
 class TransactionTablePriv
 {
@@ -73,78 +62,130 @@ public:
     CWallet* wallet;
     TransactionTableModel* parent;
 
-    /* Local cache of wallet.
-     * As it is in the same order as the CWallet, by definition
-     * this is sorted by sha256.
+    /* Local cache of wallet records, newest transactions first.
+     * The records of a transaction are always adjacent.
      */
     QList<TransactionRecord> cachedWallet;
+    /* Transactions that have records in cachedWallet */
+    std::set<uint256> setCachedTxes;
+    /* Wallet transactions not decomposed into records yet, newest first */
+    std::deque<uint256> pendingTxes;
+    /* The same transactions, for lookups from wallet notifications */
+    std::set<uint256> setPendingTxes;
     bool hasZcTxes = false;
 
 
     /* Query entire wallet anew from core.
+     * Only the transaction list is read here, records are built a page at a time.
      */
     void refreshWallet()
     {
         qDebug() << "TransactionTablePriv::refreshWallet";
         cachedWallet.clear();
+        setCachedTxes.clear();
+        pendingTxes.clear();
+        setPendingTxes.clear();
 
-        std::vector<CWalletTx> walletTxes = wallet->getWalletTxs();
+        {
+            LOCK2(cs_main, wallet->cs_wallet);
+            std::vector<std::pair<int64_t, uint256> > vTxTimes;
+            vTxTimes.reserve(wallet->mapWallet.size());
+            for (const auto& item : wallet->mapWallet)
+                vTxTimes.emplace_back(item.second.GetComputedTxTime(), item.first);
+            std::sort(vTxTimes.begin(), vTxTimes.end(), std::greater<std::pair<int64_t, uint256> >());
+            for (const auto& txTime : vTxTimes)
+                pendingTxes.push_back(txTime.second);
+            setPendingTxes.insert(pendingTxes.begin(), pendingTxes.end());
+        }
 
-        // Divide the work between multiple threads to speedup the process if the vector is larger than 4k txes
-        std::size_t txesSize = walletTxes.size();
-        if (txesSize > SINGLE_THREAD_MAX_TXES_SIZE) {
-
-            // First check if the amount of txs exceeds the UI limit
-            if (txesSize > MAX_AMOUNT_LOADED_RECORDS) {
-                // Sort the txs by date just to be really really sure that them are ordered.
-                // (this extra calculation should be removed in the future if can ensure that
-                // txs are stored in order in the db, which is what should be happening)
-                sort(walletTxes.begin(), walletTxes.end(),
-                        [](const CWalletTx & a, const CWalletTx & b) -> bool {
-                         return a.GetComputedTxTime() > b.GetComputedTxTime();
-                     });
-
-                // Only latest ones.
-                walletTxes = std::vector<CWalletTx>(walletTxes.begin(), walletTxes.begin() + MAX_AMOUNT_LOADED_RECORDS);
-                txesSize = walletTxes.size();
-            };
-
-            // Simple way to get the processors count
-            std::size_t threadsCount = (QThreadPool::globalInstance()->maxThreadCount() / 2 ) + 1;
-
-            // Size of the tx subsets
-            std::size_t const subsetSize = txesSize / (threadsCount + 1);
-            std::size_t totalSumSize = 0;
-            QList<QFuture<QList<TransactionRecord>>> tasks;
-
-            // Subsets + run task
-            for (std::size_t i = 0; i < threadsCount; ++i) {
-                tasks.append(
-                        QtConcurrent::run(
-                                convertTxToRecords,
-                                this,
-                                wallet,
-                                std::vector<CWalletTx>(walletTxes.begin() + totalSumSize, walletTxes.begin() + totalSumSize + subsetSize)
-                        )
-                 );
-                totalSumSize += subsetSize;
-            }
+        appendRecords(loadNextPage());
+    }
 
-            // Now take the remaining ones and do the work here
-            std::size_t const remainingSize = txesSize - totalSumSize;
-            auto res = convertTxToRecords(this, wallet,
-                                            std::vector<CWalletTx>(walletTxes.end() - remainingSize, walletTxes.end())
-            );
-            cachedWallet.append(res);
+    bool canFetchMore() const
+    {
+        return !pendingTxes.empty();
+    }
 
-            for (auto &future : tasks) {
-                future.waitForFinished();
-                cachedWallet.append(future.result());
+    /* Decompose the next page of pending transactions */
+    QList<TransactionRecord> loadNextPage()
+    {
+        std::vector<CWalletTx> walletTxes;
+        {
+            LOCK2(cs_main, wallet->cs_wallet);
+            while (!pendingTxes.empty() && walletTxes.size() < TX_RECORDS_PAGE_SIZE) {
+                const uint256 hash = pendingTxes.front();
+                pendingTxes.pop_front();
+                setPendingTxes.erase(hash);
+                // already added through a wallet notification
+                if (setCachedTxes.count(hash))
+                    continue;
+                auto mi = wallet->mapWallet.find(hash);
+                if (mi != wallet->mapWallet.end())
+                    walletTxes.push_back(mi->second);
             }
-        } else {
+        }
+
+        // Divide the work between multiple threads to speedup the process if the page is larger than 4k txes
+        std::size_t txesSize = walletTxes.size();
+        if (txesSize <= SINGLE_THREAD_MAX_TXES_SIZE) {
             // Single thread flow
-            cachedWallet.append(convertTxToRecords(this, wallet, walletTxes));
+            return convertTxToRecords(this, wallet, walletTxes);
         }
+
+        // Simple way to get the processors count
+        std::size_t threadsCount = (QThreadPool::globalInstance()->maxThreadCount() / 2 ) + 1;
+
+        // Size of the tx subsets
+        std::size_t const subsetSize = txesSize / (threadsCount + 1);
+        std::size_t totalSumSize = 0;
+        QList<QFuture<QList<TransactionRecord>>> tasks;
+
+        // Subsets + run task
+        for (std::size_t i = 0; i < threadsCount; ++i) {
+            tasks.append(
+                    QtConcurrent::run(
+                            convertTxToRecords,
+                            this,
+                            wallet,
+                            std::vector<CWalletTx>(walletTxes.begin() + totalSumSize, walletTxes.begin() + totalSumSize + subsetSize)
+                    )
+             );
+            totalSumSize += subsetSize;
+        }
+
+        // Now take the remaining ones and do the work here
+        std::size_t const remainingSize = txesSize - totalSumSize;
+        auto res = convertTxToRecords(this, wallet,
+                                        std::vector<CWalletTx>(walletTxes.end() - remainingSize, walletTxes.end())
+        );
+
+        // keep the page in time order
+        QList<TransactionRecord> records;
+        for (auto &future : tasks) {
+            future.waitForFinished();
+            records.append(future.result());
+        }
+        records.append(res);
+        return records;
+    }
+
+    void appendRecords(const QList<TransactionRecord>& records)
+    {
+        for (const TransactionRecord& rec : records)
+            setCachedTxes.insert(rec.hash);
+        cachedWallet.append(records);
+    }
+
+    /* Load the next page into the model, called as the views scroll down */
+    void fetchMore()
+    {
+        QList<TransactionRecord> records = loadNextPage();
+        if (records.isEmpty())
+            return;
+
+        parent->beginInsertRows(QModelIndex(), cachedWallet.size(), cachedWallet.size() + records.size() - 1);
+        appendRecords(records);
+        parent->endInsertRows();
     }
 
     static QList<TransactionRecord> convertTxToRecords(TransactionTablePriv* tablePriv, const CWallet* wallet, const std::vector<CWalletTx>& walletTxes) {
@@ -185,13 +226,22 @@ public:
         qDebug() << "TransactionTablePriv::updateWallet : " + QString::fromStdString(hash.ToString()) + " " + QString::number(status);
 
         // Find bounds of this transaction in model
-        QList<TransactionRecord>::iterator lower = qLowerBound(
-            cachedWallet.begin(), cachedWallet.end(), hash, TxLessThan());
-        QList<TransactionRecord>::iterator upper = qUpperBound(
-            cachedWallet.begin(), cachedWallet.end(), hash, TxLessThan());
-        int lowerIndex = (lower - cachedWallet.begin());
-        int upperIndex = (upper - cachedWallet.begin());
-        bool inModel = (lower != upper);
+        bool inModel = setCachedTxes.count(hash) > 0;
+        int lowerIndex = 0;
+        int upperIndex = 0;
+        if (inModel) {
+            while (lowerIndex < cachedWallet.size() && cachedWallet[lowerIndex].hash != hash)
+                lowerIndex++;
+            upperIndex = lowerIndex;
+            while (upperIndex < cachedWallet.size() && cachedWallet[upperIndex].hash == hash)
+                upperIndex++;
+        }
+
+        // Not loaded yet, it is decomposed in its time position when its page is fetched
+        if (!inModel && setPendingTxes.count(hash)) {
+            qDebug() << "    pending, left for its page";
+            return;
+        }
 
         if (status == CT_UPDATED) {
             if (showTransaction && !inModel)
@@ -218,18 +268,19 @@ public:
                         qWarning() << "TransactionTablePriv::updateWallet : Warning: Got CT_NEW, but transaction is not in wallet";
                         break;
                     }
-                    // Added -- insert at the right position
+                    // Added -- insert on top, with the newest transactions
                     QList<TransactionRecord> toInsert =
                         TransactionRecord::decomposeTransaction(wallet, mi->second);
                     if (!toInsert.isEmpty()) { /* only if something to insert */
-                        parent->beginInsertRows(QModelIndex(), lowerIndex, lowerIndex + toInsert.size() - 1);
-                        int insert_idx = lowerIndex;
+                        parent->beginInsertRows(QModelIndex(), 0, toInsert.size() - 1);
+                        int insert_idx = 0;
                         for (const TransactionRecord& rec : toInsert) {
                             cachedWallet.insert(insert_idx, rec);
                             if (!hasZcTxes) hasZcTxes = HasZcTxesIfNeeded(rec);
                             insert_idx += 1;
                             ret = rec; // Return record
                         }
+                        setCachedTxes.insert(hash);
                         parent->endInsertRows();
                     }
                 }
@@ -241,7 +292,8 @@ public:
                 }
                 // Removed -- remove entire transaction from table
                 parent->beginRemoveRows(QModelIndex(), lowerIndex, upperIndex - 1);
-                cachedWallet.erase(lower, upper);
+                cachedWallet.erase(cachedWallet.begin() + lowerIndex, cachedWallet.begin() + upperIndex);
+                setCachedTxes.erase(hash);
                 parent->endRemoveRows();
                 break;
             case CT_UPDATED:
@@ -251,6 +303,66 @@ public:
         }
     }
 
+    /* The part of a status the table shows without hovering: the status kind, and
+     * the depth or blocks left while it is still confirming, maturing or open.
+     */
+    static std::tuple<int, int, int64_t> confirmationBucket(const TransactionStatus& status)
+    {
+        switch (status.status) {
+            case TransactionStatus::Confirming:
+                return std::make_tuple(status.status, status.depth, 0);
+            case TransactionStatus::Immature:
+                return std::make_tuple(status.status, status.depth, status.matures_in);
+            case TransactionStatus::OpenUntilBlock:
+                return std::make_tuple(status.status, 0, status.open_for);
+            default:
+                return std::make_tuple(status.status, 0, 0);
+        }
+    }
+
+    /* Notify the views of the rows whose confirmation bucket changed with the new
+     * blocks. Rows never displayed have no status yet and are computed when they
+     * are first shown. If the core holds the locks, every computed row is
+     * notified and the views recompute it on their next paint.
+     */
+    void updateConfirmations()
+    {
+        std::vector<bool> vChanged(cachedWallet.size(), false);
+        {
+            TRY_LOCK(cs_main, lockMain);
+            TRY_LOCK(wallet->cs_wallet, lockWallet);
+            const bool fLocked = lockMain && lockWallet;
+            for (int i = 0; i < cachedWallet.size(); i++) {
+                TransactionRecord& rec = cachedWallet[i];
+                if (rec.status.cur_num_blocks == -1)
+                    continue;
+                if (!fLocked) {
+                    vChanged[i] = true;
+                    continue;
+                }
+                if (!rec.statusUpdateNeeded())
+                    continue;
+                auto mi = wallet->mapWallet.find(rec.hash);
+                if (mi == wallet->mapWallet.end())
+                    continue;
+                const std::tuple<int, int, int64_t> before = confirmationBucket(rec.status);
+                rec.updateStatus(mi->second);
+                vChanged[i] = confirmationBucket(rec.status) != before;
+            }
+        }
+
+        int first = -1;
+        for (int i = 0; i <= (int)vChanged.size(); i++) {
+            bool fChanging = i < (int)vChanged.size() && vChanged[i];
+            if (fChanging && first == -1) {
+                first = i;
+            } else if (!fChanging && first != -1) {
+                parent->emitStatusChanged(first, i - 1);
+                first = -1;
+            }
+        }
+    }
+
     int size()
     {
         return cachedWallet.size();
@@ -306,7 +418,8 @@ TransactionTableModel::TransactionTableModel(CWallet* wallet, WalletModel* paren
                                                                                      wallet(wallet),
                                                                                      walletModel(parent),
                                                                                      priv(new TransactionTablePriv(wallet, this)),
-                                                                                     fProcessingQueuedTransactions(false)
+                                                                                     fProcessingQueuedTransactions(false),
+                                                                                     fFetchingMore(false)
 {
     columns << QString() << QString() << tr("Date") << tr("Type") << tr("Address") << BitcoinUnits::getAmountColumnTitle(walletModel->getOptionsModel()->getDisplayUnit());
     priv->refreshWallet();
@@ -345,10 +458,71 @@ void TransactionTableModel::updateConfirmations()
 {
     // Blocks came in since last poll.
     // Invalidate status (number of confirmations) and (possibly) description
-    //  for all rows. Qt is smart enough to only actually request the data for the
-    //  visible rows.
-    emit dataChanged(index(0, Status), index(priv->size() - 1, Status));
-    emit dataChanged(index(0, ToAddress), index(priv->size() - 1, ToAddress));
+    //  for the rows that are not final yet. Qt is smart enough to only actually
+    //  request the data for the visible rows.
+    priv->updateConfirmations();
+}
+
+void TransactionTableModel::emitStatusChanged(int first, int last)
+{
+    emit dataChanged(index(first, Status), index(last, Status));
+    emit dataChanged(index(first, ToAddress), index(last, ToAddress));
+}
+
+bool TransactionTableModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && priv->canFetchMore();
+}
+
+void TransactionTableModel::fetchMore(const QModelIndex& parent)
+{
+    if (parent.isValid())
+        return;
+    fFetchingMore = true;
+    priv->fetchMore();
+    fFetchingMore = false;
+}
+
+static bool IsStakeRecordType(int type)
+{
+    switch (type) {
+        case TransactionRecord::StakeMint:
+        case TransactionRecord::Generated:
+        case TransactionRecord::Stakezdogec:
+        case TransactionRecord::MNReward:
+        case TransactionRecord::P2CSDelegation:
+        case TransactionRecord::P2CSDelegationSent:
+        case TransactionRecord::P2CSDelegationSentOwner:
+        case TransactionRecord::StakeDelegated:
+        case TransactionRecord::StakeHot:
+            return true;
+        default:
+            return false;
+    }
+}
+
+QList<TransactionRecord> TransactionTableModel::getStakeRecords(bool fFirstOnly) const
+{
+    QList<TransactionRecord> stakes;
+    LOCK2(cs_main, wallet->cs_wallet);
+    for (const auto& item : wallet->mapWallet) {
+        const CWalletTx& wtx = item.second;
+        // only these can decompose into stake records, skip the rest undecoded
+        if (!wtx.IsCoinStake() && !wtx.IsCoinBase() && !wtx.HasP2CSOutputs())
+            continue;
+        for (TransactionRecord& rec : TransactionRecord::decomposeTransaction(wallet, wtx)) {
+            if (!IsStakeRecordType(rec.type))
+                continue;
+            rec.updateStatus(wtx);
+            // orphans are left out, as the filter proxies do
+            if (TransactionFilterProxy::isOrphan(rec.status.status, rec.type))
+                continue;
+            stakes.append(rec);
+            if (fFirstOnly)
+                return stakes;
+        }
+    }
+    return stakes;
 }
 
 int TransactionTableModel::rowCount(const QModelIndex& parent) const
@@ -76,7 +76,17 @@ public:
     QVariant data(const QModelIndex& index, int role) const;
     QVariant headerData(int section, Qt::Orientation orientation, int role) const;
     QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const;
+    /** Older transactions are decomposed into rows a page at a time, when the views need them */
+    bool canFetchMore(const QModelIndex& parent) const;
+    void fetchMore(const QModelIndex& parent);
+    /** Stake, masternode reward and cold staking records of the whole wallet, decomposed
+     * straight from the wallet without loading them into the table. With fFirstOnly
+     * the search stops at the first record found.
+     */
+    QList<TransactionRecord> getStakeRecords(bool fFirstOnly = false) const;
     bool processingQueuedTransactions() { return fProcessingQueuedTransactions; }
+    /** Rows being inserted are older transactions loaded by fetchMore, not new ones */
+    bool fetchingMore() { return fFetchingMore; }
 
 signals:
     void txArrived(const QString& hash, const bool& isCoinStake, const bool& isCSAnyType);
@@ -87,9 +97,11 @@ private:
     QStringList columns;
     TransactionTablePriv* priv;
     bool fProcessingQueuedTransactions;
+    bool fFetchingMore;
 
     void subscribeToCoreSignals();
     void unsubscribeFromCoreSignals();
+    void emitStatusChanged(int first, int last);
 
     QString lookupAddress(const std::string& address, bool tooltip) const;
     QVariant addressColor(const TransactionRecord* wtx) const;
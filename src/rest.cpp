@@ -8,7 +8,11 @@
 #include "primitives/block.h"
 #include "primitives/transaction.h"
 #include "main.h"
+#include "guiinterface.h"
+#include "hash.h"
+#include "httprpc.h"
 #include "httpserver.h"
+#include "rpc/jsonstream.h"
 #include "rpc/server.h"
 #include "streams.h"
 #include "sync.h"
@@ -19,11 +23,17 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/dynamic_bitset.hpp>
 
+#include <list>
+
 #include <univalue.h>
 
 using namespace std;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const size_t MAX_GETUTXOS_BATCH_OUTPOINTS = 1000; //outpoints sent as binary or hex post data
+static const long MAX_REST_HEADERS_RESULTS = 2000;
+static const long MAX_REST_BLOCKRANGE_RESULTS = 100;
+static const size_t MAX_REST_CACHE_ENTRY_SIZE = 4 * 1024 * 1024; //larger responses are never cached
 
 enum RetFormat {
     RF_UNDEF,
@@ -59,9 +69,9 @@ struct CCoin {
 };
 
 extern void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry);
-extern UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
+extern void blockToJSONStream(CJSONStreamWriter& writer, const CBlock& block, const CBlockIndex* blockindex, bool txDetails);
 extern UniValue mempoolInfoToJSON();
-extern UniValue mempoolToJSON(bool fVerbose = false);
+extern void mempoolToJSONStream(CJSONStreamWriter& writer);
 extern void ScriptPubKeyToJSON(const CScript& scriptPubKey, UniValue& out, bool fIncludeHex);
 extern UniValue blockheaderToJSON(const CBlockIndex* blockindex);
 
@@ -117,6 +127,229 @@ static bool CheckWarmup(HTTPRequest* req)
     return true;
 }
 
+/**
+ * In-memory LRU of serialized REST responses, keyed by request URI.
+ *
+ * Every cached response is derived from the active chain, so the cache only
+ * holds responses for one tip. Every lookup and store passes the current tip,
+ * and a tip other than the cached one empties the cache and starts a new
+ * generation. This also covers tip changes that are not announced through
+ * NotifyBlockTip, such as invalidateblock. The ETag of a response is derived
+ * from its URI and the tip it was produced for.
+ */
+class CRESTCache
+{
+public:
+    struct Entry {
+        std::string strContentType;
+        std::string strBody;
+    };
+
+    CRESTCache() : nUsage(0), nMaxUsage(0), nGeneration(0) {}
+
+    void SetMaxUsage(size_t nMaxUsageIn)
+    {
+        LOCK(cs);
+        nMaxUsage = nMaxUsageIn;
+        Evict();
+    }
+
+    /** Drop every entry and start a new generation for the given tip */
+    void Reset(const uint256& hashTipIn)
+    {
+        LOCK(cs);
+        lru.clear();
+        mapEntries.clear();
+        nUsage = 0;
+        nGeneration++;
+        hashTip = hashTipIn;
+    }
+
+    /** Return the generation for the given tip and the ETag of a URI in it */
+    uint64_t GetTag(const std::string& strURI, const uint256& hashTipIn, std::string& strETag)
+    {
+        LOCK(cs);
+        if (hashTipIn != hashTip)
+            Reset(hashTipIn);
+        strETag = "\"" + Hash(strURI.begin(), strURI.end(), hashTip.begin(), hashTip.end()).GetHex() + "\"";
+        return nGeneration;
+    }
+
+    bool Get(const std::string& strURI, Entry& entry)
+    {
+        LOCK(cs);
+        std::map<std::string, EntryList::iterator>::iterator it = mapEntries.find(strURI);
+        if (it == mapEntries.end())
+            return false;
+        lru.splice(lru.begin(), lru, it->second);
+        entry = it->second->second;
+        return true;
+    }
+
+    /**
+     * Store a response produced in the given generation, while hashTipIn is the tip.
+     * Responses from an earlier generation and oversized responses are ignored.
+     */
+    void Put(const std::string& strURI, const uint256& hashTipIn, uint64_t nGenerationIn, const Entry& entry)
+    {
+        const size_t nEntryUsage = strURI.size() + entry.strContentType.size() + entry.strBody.size();
+        LOCK(cs);
+        if (hashTipIn != hashTip)
+            Reset(hashTipIn);
+        if (nGenerationIn != nGeneration || nEntryUsage > std::min(nMaxUsage, MAX_REST_CACHE_ENTRY_SIZE) || mapEntries.count(strURI))
+            return;
+        lru.push_front(std::make_pair(strURI, entry));
+        mapEntries[strURI] = lru.begin();
+        nUsage += nEntryUsage;
+        Evict();
+    }
+
+private:
+    typedef std::list<std::pair<std::string, Entry> > EntryList;
+
+    RecursiveMutex cs;
+    EntryList lru;
+    std::map<std::string, EntryList::iterator> mapEntries;
+    size_t nUsage;
+    size_t nMaxUsage;
+    uint64_t nGeneration;
+    uint256 hashTip;
+
+    void Evict()
+    {
+        while (nUsage > nMaxUsage && !lru.empty()) {
+            const std::pair<std::string, Entry>& back = lru.back();
+            nUsage -= back.first.size() + back.second.strContentType.size() + back.second.strBody.size();
+            mapEntries.erase(back.first);
+            lru.pop_back();
+        }
+    }
+};
+
+static CRESTCache restCache;
+
+static uint256 ActiveTipHash()
+{
+    AssertLockHeld(cs_main);
+    return chainActive.Tip() ? chainActive.Tip()->GetBlockHash() : uint256();
+}
+
+/**
+ * A cacheable response to one REST request. Lookup() answers the request from
+ * the cache when it can; otherwise the handler produces the response with
+ * Write() or, for large responses, BeginStream() and Stream().
+ */
+class CRESTReply
+{
+public:
+    explicit CRESTReply(HTTPRequest* reqIn) : req(reqIn), strURI(reqIn->GetURI()), fOverflow(false)
+    {
+        LOCK(cs_main);
+        nGeneration = restCache.GetTag(strURI, ActiveTipHash(), strETag);
+    }
+
+    /** Answer with 304 or a cached response if possible; returns true if the request was answered */
+    bool Lookup()
+    {
+        std::pair<bool, std::string> ifNoneMatch = req->GetHeader("if-none-match");
+        if (ifNoneMatch.first && ifNoneMatch.second == strETag) {
+            req->WriteHeader("ETag", strETag);
+            req->WriteReply(HTTP_NOT_MODIFIED);
+            return true;
+        }
+        CRESTCache::Entry entry;
+        if (!restCache.Get(strURI, entry))
+            return false;
+        req->WriteHeader("Content-Type", entry.strContentType);
+        req->WriteHeader("ETag", strETag);
+        req->WriteReply(HTTP_OK, entry.strBody);
+        return true;
+    }
+
+    void Write(const std::string& strContentType, const std::string& strBody)
+    {
+        BeginStream(strContentType);
+        Stream(strBody, true);
+    }
+
+    void BeginStream(const std::string& strContentType)
+    {
+        entry.strContentType = strContentType;
+        req->WriteHeader("Content-Type", strContentType);
+        req->WriteHeader("ETag", strETag);
+    }
+
+    bool Stream(const std::string& strData, bool fFinal)
+    {
+        if (!fOverflow) {
+            if (entry.strBody.size() + strData.size() > MAX_REST_CACHE_ENTRY_SIZE) {
+                fOverflow = true;
+                std::string().swap(entry.strBody);
+            } else {
+                entry.strBody += strData;
+            }
+        }
+        if (!req->WriteReplyStream(HTTP_OK, strData, fFinal))
+            return false;
+        if (fFinal && !fOverflow) {
+            // Dropped if the tip moved while the response was produced
+            LOCK(cs_main);
+            restCache.Put(strURI, ActiveTipHash(), nGeneration, entry);
+        }
+        return true;
+    }
+
+private:
+    HTTPRequest* req;
+    std::string strURI;
+    std::string strETag;
+    uint64_t nGeneration;
+    CRESTCache::Entry entry;
+    bool fOverflow;
+};
+
+static void RESTNotifyBlockTip(bool fInitialDownload, const CBlockIndex* pindexNew)
+{
+    restCache.Reset(pindexNew->GetBlockHash());
+}
+
+static bool RESTWriteHeaders(HTTPRequest* req, CRESTReply& reply, const RetFormat rf, const std::vector<const CBlockIndex*>& headers)
+{
+    CDataStream ssHeader(SER_NETWORK, PROTOCOL_VERSION);
+    BOOST_FOREACH(const CBlockIndex *pindex, headers) {
+        ssHeader << pindex->GetBlockHeader();
+    }
+
+    switch (rf) {
+    case RF_BINARY: {
+        string binaryHeader = ssHeader.str();
+        reply.Write("application/octet-stream", binaryHeader);
+        return true;
+    }
+
+    case RF_HEX: {
+        string strHex = HexStr(ssHeader.begin(), ssHeader.end()) + "\n";
+        reply.Write("text/plain", strHex);
+        return true;
+    }
+    case RF_JSON: {
+        UniValue jsonHeaders(UniValue::VARR);
+        BOOST_FOREACH(const CBlockIndex *pindex, headers) {
+            jsonHeaders.push_back(blockheaderToJSON(pindex));
+        }
+        string strJSON = jsonHeaders.write() + "\n";
+        reply.Write("application/json", strJSON);
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
 static bool rest_headers(HTTPRequest* req,
                          const std::string& strURIPart)
 {
@@ -131,7 +364,7 @@ static bool rest_headers(HTTPRequest* req,
         return RESTERR(req, HTTP_BAD_REQUEST, "No header count specified. Use /rest/headers/<count>/<hash>.<ext>.");
 
     long count = strtol(path[0].c_str(), NULL, 10);
-    if (count < 1 || count > 2000)
+    if (count < 1 || count > MAX_REST_HEADERS_RESULTS)
         return RESTERR(req, HTTP_BAD_REQUEST, "Header count out of range: " + path[0]);
 
     string hashStr = path[1];
@@ -139,6 +372,10 @@ static bool rest_headers(HTTPRequest* req,
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
+    CRESTReply reply(req);
+    if (reply.Lookup())
+        return true;
+
     std::vector<const CBlockIndex *> headers;
     headers.reserve(count);
     {
@@ -153,42 +390,63 @@ static bool rest_headers(HTTPRequest* req,
         }
     }
 
-    CDataStream ssHeader(SER_NETWORK, PROTOCOL_VERSION);
-    BOOST_FOREACH(const CBlockIndex *pindex, headers) {
-        ssHeader << pindex->GetBlockHeader();
+    return RESTWriteHeaders(req, reply, rf, headers);
+}
+
+/** Parse the <height>/<count> part of a range request */
+static bool ParseHeightRange(const std::string& strRange, long nMaxCount, int& nHeight, long& nCount, std::string& strError)
+{
+    vector<string> path;
+    boost::split(path, strRange, boost::is_any_of("/"));
+    if (path.size() != 2) {
+        strError = "No height and count specified. Use <height>/<count>.<ext>.";
+        return false;
     }
 
-    switch (rf) {
-    case RF_BINARY: {
-        string binaryHeader = ssHeader.str();
-        req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryHeader);
-        return true;
+    int32_t nHeightParsed;
+    if (!ParseInt32(path[0], &nHeightParsed) || nHeightParsed < 0) {
+        strError = "Invalid height: " + path[0];
+        return false;
     }
+    nHeight = nHeightParsed;
 
-    case RF_HEX: {
-        string strHex = HexStr(ssHeader.begin(), ssHeader.end()) + "\n";
-        req->WriteHeader("Content-Type", "text/plain");
-        req->WriteReply(HTTP_OK, strHex);
-        return true;
+    nCount = strtol(path[1].c_str(), NULL, 10);
+    if (nCount < 1 || nCount > nMaxCount) {
+        strError = "Count out of range: " + path[1];
+        return false;
     }
-    case RF_JSON: {
-        UniValue jsonHeaders(UniValue::VARR);
-        BOOST_FOREACH(const CBlockIndex *pindex, headers) {
-            jsonHeaders.push_back(blockheaderToJSON(pindex));
-        }
-        string strJSON = jsonHeaders.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+    return true;
+}
+
+static bool rest_headersrange(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    vector<string> params;
+    const RetFormat rf = ParseDataFormat(params, strURIPart);
+
+    int nHeight;
+    long count;
+    std::string strError;
+    if (!ParseHeightRange(params[0], MAX_REST_HEADERS_RESULTS, nHeight, count, strError))
+        return RESTERR(req, HTTP_BAD_REQUEST, strError);
+
+    CRESTReply reply(req);
+    if (reply.Lookup())
         return true;
-    }
-    default: {
-        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: .bin, .hex)");
-    }
+
+    std::vector<const CBlockIndex *> headers;
+    {
+        LOCK(cs_main);
+        if (nHeight > chainActive.Height())
+            return RESTERR(req, HTTP_NOT_FOUND, strprintf("Height %d not found", nHeight));
+        int nEnd = std::min((long)chainActive.Height(), nHeight + count - 1);
+        headers.reserve(nEnd - nHeight + 1);
+        for (int i = nHeight; i <= nEnd; i++)
+            headers.push_back(chainActive[i]);
     }
 
-    // not reached
-    return true; // continue to process further HTTP reqs on this cxn
+    return RESTWriteHeaders(req, reply, rf, headers);
 }
 
 static bool rest_block(HTTPRequest* req,
@@ -205,8 +463,15 @@ static bool rest_block(HTTPRequest* req,
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
-    CBlock block;
+    if (rf != RF_BINARY && rf != RF_HEX && rf != RF_JSON)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+
+    CRESTReply reply(req);
+    if (reply.Lookup())
+        return true;
+
     CBlockIndex* pblockindex = nullptr;
+    CDiskBlockPos pos;
     {
         LOCK(cs_main);
         if (mapBlockIndex.count(hash) == 0)
@@ -215,34 +480,37 @@ static bool rest_block(HTTPRequest* req,
         pblockindex = mapBlockIndex[hash];
         if (!(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
-
-        if (!ReadBlockFromDisk(block, pblockindex))
-            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        pos = pblockindex->GetBlockPos();
     }
 
-    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-    ssBlock << block;
-
     switch (rf) {
     case RF_BINARY: {
-        string binaryBlock = ssBlock.str();
-        req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
+        // The on-disk serialization is the network serialization; send it as stored
+        std::vector<char> vchBlock;
+        if (!ReadRawBlockFromDisk(vchBlock, pblockindex))
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        reply.Write("application/octet-stream", string(vchBlock.begin(), vchBlock.end()));
         return true;
     }
 
     case RF_HEX: {
-        string strHex = HexStr(ssBlock.begin(), ssBlock.end()) + "\n";
-        req->WriteHeader("Content-Type", "text/plain");
-        req->WriteReply(HTTP_OK, strHex);
+        std::vector<char> vchBlock;
+        if (!ReadRawBlockFromDisk(vchBlock, pblockindex))
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        string strHex = HexStr(vchBlock.begin(), vchBlock.end()) + "\n";
+        reply.Write("text/plain", strHex);
         return true;
     }
 
     case RF_JSON: {
-        UniValue objBlock = blockToJSON(block, pblockindex, showTxDetails);
-        string strJSON = objBlock.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pos) || block.GetHash() != hash)
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        reply.BeginStream("application/json");
+        CJSONStreamWriter writer(std::bind(&CRESTReply::Stream, &reply, std::placeholders::_1, std::placeholders::_2));
+        blockToJSONStream(writer, block, pblockindex, showTxDetails);
+        writer.Raw("\n");
+        writer.Finish();
         return true;
     }
 
@@ -265,6 +533,69 @@ static bool rest_block_notxdetails(HTTPRequest* req, const std::string& strURIPa
     return rest_block(req, strURIPart, false);
 }
 
+static bool rest_blockrange(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    vector<string> params;
+    const RetFormat rf = ParseDataFormat(params, strURIPart);
+    if (rf != RF_BINARY && rf != RF_HEX)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: .bin, .hex)");
+
+    int nHeight;
+    long count;
+    std::string strError;
+    if (!ParseHeightRange(params[0], MAX_REST_BLOCKRANGE_RESULTS, nHeight, count, strError))
+        return RESTERR(req, HTTP_BAD_REQUEST, strError);
+
+    CRESTReply reply(req);
+    if (reply.Lookup())
+        return true;
+
+    std::vector<const CBlockIndex*> vBlocks;
+    {
+        LOCK(cs_main);
+        if (nHeight > chainActive.Height())
+            return RESTERR(req, HTTP_NOT_FOUND, strprintf("Height %d not found", nHeight));
+        int nEnd = std::min((long)chainActive.Height(), nHeight + count - 1);
+        for (int i = nHeight; i <= nEnd; i++) {
+            const CBlockIndex* pindex = chainActive[i];
+            if (!(pindex->nStatus & BLOCK_HAVE_DATA))
+                return RESTERR(req, HTTP_NOT_FOUND, pindex->GetBlockHash().GetHex() + " not available (pruned data)");
+            vBlocks.push_back(pindex);
+        }
+    }
+
+    // Blocks are read one at a time and handed to the HTTP stream as they are
+    // read. The stream holds this thread back while too much output waits for
+    // the client, but the reply is also collected for the cache until it
+    // exceeds MAX_REST_CACHE_ENTRY_SIZE. Binary output is the concatenation
+    // of the serialized blocks; hex output has one block per line.
+    std::vector<char> vchBlock;
+    for (size_t i = 0; i < vBlocks.size(); i++) {
+        if (!ReadRawBlockFromDisk(vchBlock, vBlocks[i])) {
+            if (i == 0)
+                return RESTERR(req, HTTP_NOT_FOUND, vBlocks[i]->GetBlockHash().GetHex() + " not found");
+            // Part of the reply has been sent already; close the connection
+            // so the client cannot take it for a complete reply
+            LogPrintf("%s: failed to read block %s\n", __func__, vBlocks[i]->GetBlockHash().GetHex());
+            req->AbortReplyStream();
+            return false;
+        }
+        if (i == 0)
+            reply.BeginStream(rf == RF_BINARY ? "application/octet-stream" : "text/plain");
+        const bool fFinal = (i + 1 == vBlocks.size());
+        bool fSent;
+        if (rf == RF_BINARY)
+            fSent = reply.Stream(string(vchBlock.begin(), vchBlock.end()), fFinal);
+        else
+            fSent = reply.Stream(HexStr(vchBlock.begin(), vchBlock.end()) + "\n", fFinal);
+        if (!fSent)
+            return false;
+    }
+    return true;
+}
+
 static bool rest_chaininfo(HTTPRequest* req, const std::string& strURIPart)
 {
     if (!CheckWarmup(req))
@@ -324,11 +655,11 @@ static bool rest_mempool_contents(HTTPRequest* req, const std::string& strURIPar
 
     switch (rf) {
     case RF_JSON: {
-        UniValue mempoolObject = mempoolToJSON(true);
-
-        string strJSON = mempoolObject.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        CJSONStreamWriter writer(std::bind(&HTTPRequest::WriteReplyStream, req, HTTP_OK, std::placeholders::_1, std::placeholders::_2));
+        mempoolToJSONStream(writer);
+        writer.Raw("\n");
+        writer.Finish();
         return true;
     }
     default: {
@@ -483,9 +814,10 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
     }
     }
 
-    // limit max outpoints
-    if (vOutPoints.size() > MAX_GETUTXOS_OUTPOINTS)
-        return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, strprintf("Error: max outpoints exceeded (max: %d, tried: %d)", MAX_GETUTXOS_OUTPOINTS, vOutPoints.size()));
+    // limit max outpoints; batches sent as post data may be larger than URI requests
+    const size_t nMaxOutPoints = fInputParsed ? MAX_GETUTXOS_OUTPOINTS : MAX_GETUTXOS_BATCH_OUTPOINTS;
+    if (vOutPoints.size() > nMaxOutPoints)
+        return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, strprintf("Error: max outpoints exceeded (max: %d, tried: %d)", nMaxOutPoints, vOutPoints.size()));
 
     // check spentness and form a bitmap (as well as a JSON capable human-readble string representation)
     vector<unsigned char> bitmap;
@@ -504,11 +836,20 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
         if (fCheckMemPool)
             view.SetBackend(viewMempool); // switch cache backend to db+mempool in case user likes to query mempool
 
+        // Batches usually list several outputs of the same transaction in a row;
+        // look each transaction up only once for such a run
+        CCoins coins;
+        uint256 hashCoins;
+        bool fHaveCoins = false;
         for (size_t i = 0; i < vOutPoints.size(); i++) {
-            CCoins coins;
             uint256 hash = vOutPoints[i].hash;
-            if (view.GetCoins(hash, coins)) {
-                mempool.pruneSpent(hash, coins);
+            if (i == 0 || hash != hashCoins) {
+                hashCoins = hash;
+                fHaveCoins = view.GetCoins(hash, coins);
+                if (fHaveCoins)
+                    mempool.pruneSpent(hash, coins);
+            }
+            if (fHaveCoins) {
                 if (coins.IsAvailable(vOutPoints[i].n)) {
                     hits[i] = true;
                     // Safe to index into vout here because IsAvailable checked if it's off the end of the array, or if
@@ -600,11 +941,20 @@ static const struct {
       {"/rest/mempool/info", rest_mempool_info},
       {"/rest/mempool/contents", rest_mempool_contents},
       {"/rest/headers/", rest_headers},
+      {"/rest/headersrange/", rest_headersrange},
+      {"/rest/blockrange/", rest_blockrange},
       {"/rest/getutxos", rest_getutxos},
 };
 
 bool StartREST()
 {
+    restCache.SetMaxUsage(std::max(GetArg("-restcachesize", DEFAULT_REST_CACHE_SIZE), (int64_t)0) * 1024 * 1024);
+    {
+        LOCK(cs_main);
+        restCache.Reset(ActiveTipHash());
+    }
+    uiInterface.NotifyBlockTip.connect(RESTNotifyBlockTip);
+
     for (unsigned int i = 0; i < ARRAYLEN(uri_prefixes); i++)
         RegisterHTTPHandler(uri_prefixes[i].prefix, false, uri_prefixes[i].handler);
     return true;
@@ -616,6 +966,8 @@ void InterruptREST()
 
 void StopREST()
 {
+    uiInterface.NotifyBlockTip.disconnect(RESTNotifyBlockTip);
     for (unsigned int i = 0; i < ARRAYLEN(uri_prefixes); i++)
         UnregisterHTTPHandler(uri_prefixes[i].prefix, false);
+    restCache.Reset(uint256());
 }
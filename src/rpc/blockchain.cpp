@@ -10,6 +10,7 @@
 #include "checkpoints.h"
 #include "clientversion.h"
 #include "main.h"
+#include "rpc/jsonstream.h"
 #include "rpc/server.h"
 #include "sync.h"
 #include "txdb.h"
@@ -140,7 +141,7 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
 
     UniValue zdogecObj(UniValue::VOBJ);
     for (auto denom : libzerocoin::zerocoinDenomList) {
-        zdogecObj.push_back(Pair(to_string(denom), ValueFromAmount(blockindex->mapZerocoinSupply.at(denom) * (denom*COIN))));
+        zdogecObj.push_back(Pair(to_string(denom), ValueFromAmount(blockindex->zerocoinSupply.at(denom) * (denom*COIN))));
     }
     zdogecObj.push_back(Pair("total", ValueFromAmount(blockindex->GetZerocoinSupply())));
     result.push_back(Pair("zdogecsupply", zdogecObj));
@@ -148,6 +149,40 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     return result;
 }
 
+/**
+ * Write a block as blockToJSON would describe it. With txDetails the transactions
+ * are rendered one at a time instead of as part of a single document.
+ */
+void blockToJSONStream(CJSONStreamWriter& writer, const CBlock& block, const CBlockIndex* blockindex, bool txDetails)
+{
+    UniValue objBlock;
+    {
+        LOCK(cs_main);
+        objBlock = blockToJSON(block, blockindex, false);
+    }
+    const std::vector<std::string>& keys = objBlock.getKeys();
+    const std::vector<UniValue>& values = objBlock.getValues();
+
+    writer.BeginObject();
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (!txDetails || keys[i] != "tx") {
+            writer.Pair(keys[i], values[i]);
+            continue;
+        }
+        writer.Key(keys[i]);
+        writer.BeginArray();
+        for (const CTransaction& tx : block.vtx) {
+            if (!writer.Good())
+                break;
+            UniValue objTx(UniValue::VOBJ);
+            TxToJSON(tx, uint256(0), objTx);
+            writer.Value(objTx);
+        }
+        writer.EndArray();
+    }
+    writer.EndObject();
+}
+
 UniValue getchecksumblock(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() < 2 || params.size() > 3)
@@ -426,36 +461,66 @@ UniValue getdifficulty(const UniValue& params, bool fHelp)
 }
 
 
+/** Verbose description of a single mempool entry (requires mempool.cs) */
+static UniValue mempoolEntryToJSON(const CTxMemPoolEntry& e)
+{
+    AssertLockHeld(mempool.cs);
+    UniValue info(UniValue::VOBJ);
+    info.push_back(Pair("size", (int)e.GetTxSize()));
+    info.push_back(Pair("fee", ValueFromAmount(e.GetFee())));
+    info.push_back(Pair("time", e.GetTime()));
+    info.push_back(Pair("height", (int)e.GetHeight()));
+    info.push_back(Pair("startingpriority", e.GetPriority(e.GetHeight())));
+    info.push_back(Pair("currentpriority", e.GetPriority(chainActive.Height())));
+    const CTransaction& tx = e.GetTx();
+    set<string> setDepends;
+    BOOST_FOREACH (const CTxIn& txin, tx.vin) {
+        if (mempool.exists(txin.prevout.hash))
+            setDepends.insert(txin.prevout.hash.ToString());
+    }
+
+    UniValue depends(UniValue::VARR);
+    BOOST_FOREACH(const string& dep, setDepends) {
+        depends.push_back(dep);
+    }
+
+    info.push_back(Pair("depends", depends));
+    return info;
+}
+
+/**
+ * Write the verbose mempool contents entry by entry, as mempoolToJSON(true) would return them.
+ * The writer may block on a slow client, so mempool.cs is only held to render each entry.
+ */
+void mempoolToJSONStream(CJSONStreamWriter& writer)
+{
+    vector<uint256> vtxid;
+    mempool.queryHashes(vtxid);
+
+    writer.BeginObject();
+    for (const uint256& hash : vtxid) {
+        if (!writer.Good())
+            break;
+        UniValue info;
+        {
+            LOCK(mempool.cs);
+            std::map<uint256, CTxMemPoolEntry>::const_iterator it = mempool.mapTx.find(hash);
+            if (it == mempool.mapTx.end())
+                continue;
+            info = mempoolEntryToJSON(it->second);
+        }
+        writer.Pair(hash.ToString(), info);
+    }
+    writer.EndObject();
+}
+
 UniValue mempoolToJSON(bool fVerbose = false)
 {
     if (fVerbose) {
         LOCK(mempool.cs);
         UniValue o(UniValue::VOBJ);
-        BOOST_FOREACH (const PAIRTYPE(uint256, CTxMemPoolEntry) & entry, mempool.mapTx) {
-            const uint256& hash = entry.first;
-            const CTxMemPoolEntry& e = entry.second;
-            UniValue info(UniValue::VOBJ);
-            info.push_back(Pair("size", (int)e.GetTxSize()));
-            info.push_back(Pair("fee", ValueFromAmount(e.GetFee())));
-            info.push_back(Pair("time", e.GetTime()));
-            info.push_back(Pair("height", (int)e.GetHeight()));
-            info.push_back(Pair("startingpriority", e.GetPriority(e.GetHeight())));
-            info.push_back(Pair("currentpriority", e.GetPriority(chainActive.Height())));
-            const CTransaction& tx = e.GetTx();
-            set<string> setDepends;
-            BOOST_FOREACH (const CTxIn& txin, tx.vin) {
-                if (mempool.exists(txin.prevout.hash))
-                    setDepends.insert(txin.prevout.hash.ToString());
-            }
-
-            UniValue depends(UniValue::VARR);
-            BOOST_FOREACH(const string& dep, setDepends) {
-                depends.push_back(dep);
-            }
-
-            info.push_back(Pair("depends", depends));
-            o.push_back(Pair(hash.ToString(), info));
-        }
+        BOOST_FOREACH (const PAIRTYPE(uint256, CTxMemPoolEntry) & entry, mempool.mapTx)
+            o.push_back(Pair(entry.first.ToString(), mempoolEntryToJSON(entry.second)));
         return o;
     } else {
         vector<uint256> vtxid;
@@ -591,8 +656,6 @@ UniValue getblock(const UniValue& params, bool fHelp)
             HelpExampleCli("getblock", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\"") +
             HelpExampleRpc("getblock", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\""));
 
-    LOCK(cs_main);
-
     std::string strHash = params[0].get_str();
     uint256 hash(strHash);
 
@@ -600,13 +663,23 @@ UniValue getblock(const UniValue& params, bool fHelp)
     if (params.size() > 1)
         fVerbose = params[1].get_bool();
 
-    if (mapBlockIndex.count(hash) == 0)
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+    CBlockIndex* pblockindex;
+    CDiskBlockPos blockPos;
+    {
+        LOCK(cs_main);
+        BlockMap::iterator mi = mapBlockIndex.find(hash);
+        if (mi == mapBlockIndex.end())
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        pblockindex = mi->second;
+        if (!(pblockindex->nStatus & BLOCK_HAVE_DATA))
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
+        blockPos = pblockindex->GetBlockPos();
+    }
 
+    // Block index entries are never freed and stored blocks never move, so the
+    // disk read and deserialization do not need cs_main.
     CBlock block;
-    CBlockIndex* pblockindex = mapBlockIndex[hash];
-
-    if (!ReadBlockFromDisk(block, pblockindex))
+    if (!ReadBlockFromDisk(block, blockPos) || block.GetHash() != pblockindex->GetBlockHash())
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
 
     if (!fVerbose) {
@@ -616,6 +689,7 @@ UniValue getblock(const UniValue& params, bool fHelp)
         return strHex;
     }
 
+    LOCK(cs_main);
     return blockToJSON(block, pblockindex);
 }
 
@@ -1372,7 +1446,7 @@ UniValue getmintsinblocks(const UniValue& params, bool fHelp) {
         CBlockIndex* pindex = chainActive[heightStart];
 
         while (true) {
-            num_of_mints += count(pindex->vMintDenominationsInBlock.begin(), pindex->vMintDenominationsInBlock.end(), denom);
+            num_of_mints += pindex->mintsInBlock.Count(denom);
             if (pindex->nHeight < heightEnd) {
                 pindex = chainActive.Next(pindex);
             } else {
@@ -31,6 +31,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     {
         {"stop", 0},
         {"setmocktime", 0},
+        {"getperfstats", 0},
+        {"getperfstats", 1},
         {"getaddednodeinfo", 0},
         {"setgenerate", 0},
         {"setgenerate", 1},
@@ -0,0 +1,109 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rpc/jsonstream.h"
+
+#include <assert.h>
+
+CJSONStreamWriter::CJSONStreamWriter(const SinkFunc& sinkIn, size_t nChunkSizeIn) : sink(sinkIn),
+                                                                                     nChunkSize(nChunkSizeIn),
+                                                                                     fAfterKey(false),
+                                                                                     fGood(true)
+{
+    buffer.reserve(nChunkSize + 1024);
+}
+
+void CJSONStreamWriter::BeginElement()
+{
+    if (fAfterKey) {
+        fAfterKey = false;
+        return;
+    }
+    if (!vEmpty.empty()) {
+        if (!vEmpty.back())
+            Write(",");
+        vEmpty.back() = false;
+    }
+}
+
+void CJSONStreamWriter::Write(const std::string& str)
+{
+    if (!fGood)
+        return;
+    buffer += str;
+    if (buffer.size() >= nChunkSize) {
+        fGood = sink(buffer, false);
+        buffer.clear();
+    }
+}
+
+void CJSONStreamWriter::BeginObject()
+{
+    BeginElement();
+    vEmpty.push_back(true);
+    Write("{");
+}
+
+void CJSONStreamWriter::EndObject()
+{
+    assert(!vEmpty.empty() && !fAfterKey);
+    vEmpty.pop_back();
+    Write("}");
+}
+
+void CJSONStreamWriter::BeginArray()
+{
+    BeginElement();
+    vEmpty.push_back(true);
+    Write("[");
+}
+
+void CJSONStreamWriter::EndArray()
+{
+    assert(!vEmpty.empty() && !fAfterKey);
+    vEmpty.pop_back();
+    Write("]");
+}
+
+void CJSONStreamWriter::Key(const std::string& key)
+{
+    assert(!vEmpty.empty() && !fAfterKey);
+    BeginElement();
+    Write(UniValue(key).write() + ":");
+    fAfterKey = true;
+}
+
+void CJSONStreamWriter::Value(const UniValue& value)
+{
+    if (value.isObject()) {
+        BeginObject();
+        const std::vector<std::string>& keys = value.getKeys();
+        const std::vector<UniValue>& values = value.getValues();
+        for (size_t i = 0; i < keys.size(); i++)
+            Pair(keys[i], values[i]);
+        EndObject();
+    } else if (value.isArray()) {
+        BeginArray();
+        const std::vector<UniValue>& values = value.getValues();
+        for (size_t i = 0; i < values.size(); i++)
+            Value(values[i]);
+        EndArray();
+    } else {
+        BeginElement();
+        Write(value.write());
+    }
+}
+
+void CJSONStreamWriter::Raw(const std::string& str)
+{
+    Write(str);
+}
+
+void CJSONStreamWriter::Finish()
+{
+    assert(vEmpty.empty());
+    if (fGood)
+        fGood = sink(buffer, true);
+    buffer.clear();
+}
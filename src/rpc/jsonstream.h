@@ -0,0 +1,72 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONSTREAM_H
+#define BITCOIN_RPC_JSONSTREAM_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <univalue.h>
+
+/** Size of the pieces a CJSONStreamWriter hands to its sink */
+static const size_t DEFAULT_JSON_STREAM_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Incremental compact JSON writer.
+ *
+ * Output is accumulated in a small buffer and handed to the sink whenever it
+ * exceeds the chunk size, so large replies can be produced element by element
+ * without materializing the whole document. The output is byte-identical to
+ * UniValue::write() of the equivalent value.
+ */
+class CJSONStreamWriter
+{
+public:
+    /**
+     * Receives each piece of output; fFinal is set on the last call only.
+     * Returning false stops the output, e.g. when the client has gone away.
+     */
+    typedef std::function<bool(const std::string& strData, bool fFinal)> SinkFunc;
+
+    CJSONStreamWriter(const SinkFunc& sinkIn, size_t nChunkSizeIn = DEFAULT_JSON_STREAM_CHUNK_SIZE);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    /** Write the key of the next member of the current object */
+    void Key(const std::string& key);
+    /** Write a value; containers are walked recursively instead of being written to one string */
+    void Value(const UniValue& value);
+    void Pair(const std::string& key, const UniValue& value)
+    {
+        Key(key);
+        Value(value);
+    }
+    /** Append raw text after the document, e.g. a trailing newline */
+    void Raw(const std::string& str);
+
+    /** Hand the remaining output to the sink as the final piece */
+    void Finish();
+
+    /** False once the sink has refused output; anything written after that is dropped */
+    bool Good() const { return fGood; }
+
+private:
+    SinkFunc sink;
+    size_t nChunkSize;
+    std::string buffer;
+    //! One entry per open container: whether it has no members yet
+    std::vector<bool> vEmpty;
+    bool fAfterKey;
+    bool fGood;
+
+    void BeginElement();
+    void Write(const std::string& str);
+};
+
+#endif // BITCOIN_RPC_JSONSTREAM_H
@@ -12,6 +12,7 @@
 #include "masternode-sync.h"
 #include "net.h"
 #include "netbase.h"
+#include "perfstats.h"
 #include "rpc/server.h"
 #include "spork.h"
 #include "timedata.h"
@@ -145,7 +146,7 @@ UniValue getinfo(const UniValue& params, bool fHelp)
     obj.push_back(Pair("moneysupply",ValueFromAmount(chainActive.Tip()->nMoneySupply)));
     UniValue zdogecObj(UniValue::VOBJ);
     for (auto denom : libzerocoin::zerocoinDenomList) {
-        zdogecObj.push_back(Pair(to_string(denom), ValueFromAmount(chainActive.Tip()->mapZerocoinSupply.at(denom) * (denom*COIN))));
+        zdogecObj.push_back(Pair(to_string(denom), ValueFromAmount(chainActive.Tip()->zerocoinSupply.at(denom) * (denom*COIN))));
     }
     zdogecObj.push_back(Pair("total", ValueFromAmount(chainActive.Tip()->GetZerocoinSupply())));
     obj.push_back(Pair("zdogecsupply", zdogecObj));
@@ -658,6 +659,129 @@ UniValue setmocktime(const UniValue& params, bool fHelp)
     return NullUniValue;
 }
 
+static UniValue LockSiteToJSON(const CLockSiteStats& site)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("lock", site.strName));
+    if (site.nLine > 0)
+        obj.push_back(Pair("site", strprintf("%s:%d", site.strFile, site.nLine)));
+    obj.push_back(Pair("samples", site.nSamples));
+    obj.push_back(Pair("contended", site.nContended));
+    obj.push_back(Pair("tryfailed", site.nTryFailed));
+    obj.push_back(Pair("wait_total_us", site.nWaitMicros));
+    obj.push_back(Pair("wait_max_us", site.nWaitMaxMicros));
+    obj.push_back(Pair("hold_total_us", site.nHoldMicros));
+    obj.push_back(Pair("hold_max_us", site.nHoldMaxMicros));
+    return obj;
+}
+
+UniValue getperfstats(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() > 2)
+        throw runtime_error(
+            "getperfstats ( count reset )\n"
+            "\nReturns sampled lock contention statistics (see -lockstats) and the timers of the block validation stages.\n"
+
+            "\nArguments:\n"
+            "1. count    (numeric, optional, default=20) Number of lock call sites to return, busiest first\n"
+            "2. reset    (boolean, optional, default=false) Clear all statistics after reading them\n"
+
+            "\nResult:\n"
+            "{\n"
+            "  \"lockstats\": true|false,      (boolean) whether lock acquisitions are being sampled\n"
+            "  \"samplerate\": n,              (numeric) one in this many acquisitions of each thread is timed\n"
+            "  \"locks\": [                    (array) totals per lock, ordered by total wait time\n"
+            "    {\n"
+            "      \"lock\": \"name\",             (string) the lock as named at its LOCK call sites\n"
+            "      \"samples\": n,               (numeric) number of sampled acquisitions\n"
+            "      \"contended\": n,             (numeric) sampled acquisitions which had to wait for another thread\n"
+            "      \"tryfailed\": n,             (numeric) sampled TRY_LOCK attempts which failed\n"
+            "      \"wait_total_us\": n,         (numeric) microseconds spent waiting for the lock\n"
+            "      \"wait_max_us\": n,           (numeric) longest wait\n"
+            "      \"hold_total_us\": n,         (numeric) microseconds the lock was held\n"
+            "      \"hold_max_us\": n            (numeric) longest hold\n"
+            "    }, ...\n"
+            "  ],\n"
+            "  \"sites\": [                    (array) the same totals per call site, ordered by total wait time\n"
+            "    {\n"
+            "      \"lock\": \"name\",             (string) the lock\n"
+            "      \"site\": \"file:line\",        (string) where it is taken\n"
+            "      ...                       as for \"locks\"\n"
+            "    }, ...\n"
+            "  ],\n"
+            "  \"stages\": [                   (array) block validation stage timers\n"
+            "    {\n"
+            "      \"name\": \"stage\",            (string) stage name\n"
+            "      \"count\": n,                 (numeric) times the stage ran\n"
+            "      \"total_us\": n,              (numeric) total microseconds spent in the stage\n"
+            "      \"max_us\": n,                (numeric) longest run\n"
+            "      \"last_us\": n                (numeric) most recent run\n"
+            "    }, ...\n"
+            "  ]\n"
+            "}\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getperfstats", "") + HelpExampleCli("getperfstats", "10 true") + HelpExampleRpc("getperfstats", "10, true"));
+
+    int nCount = 20;
+    if (params.size() > 0)
+        nCount = params[0].get_int();
+    if (nCount < 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative count");
+    bool fReset = params.size() > 1 && params[1].get_bool();
+
+    std::vector<CLockSiteStats> vSites = GetLockStats();
+    auto byWait = [](const CLockSiteStats& a, const CLockSiteStats& b) { return a.nWaitMicros > b.nWaitMicros; };
+
+    std::map<std::string, CLockSiteStats> mapLocks;
+    for (const CLockSiteStats& site : vSites) {
+        CLockSiteStats& lock = mapLocks[site.strName];
+        lock.strName = site.strName;
+        lock.nSamples += site.nSamples;
+        lock.nContended += site.nContended;
+        lock.nTryFailed += site.nTryFailed;
+        lock.nWaitMicros += site.nWaitMicros;
+        lock.nWaitMaxMicros = std::max(lock.nWaitMaxMicros, site.nWaitMaxMicros);
+        lock.nHoldMicros += site.nHoldMicros;
+        lock.nHoldMaxMicros = std::max(lock.nHoldMaxMicros, site.nHoldMaxMicros);
+    }
+    std::vector<CLockSiteStats> vLocks;
+    for (const auto& item : mapLocks)
+        vLocks.push_back(item.second);
+    std::sort(vLocks.begin(), vLocks.end(), byWait);
+    std::sort(vSites.begin(), vSites.end(), byWait);
+
+    UniValue locks(UniValue::VARR);
+    for (const CLockSiteStats& lock : vLocks)
+        locks.push_back(LockSiteToJSON(lock));
+    UniValue sites(UniValue::VARR);
+    for (size_t i = 0; i < vSites.size() && i < (size_t)nCount; i++)
+        sites.push_back(LockSiteToJSON(vSites[i]));
+    UniValue stages(UniValue::VARR);
+    for (const CPerfStage* stage : GetPerfStages()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("name", stage->GetName()));
+        obj.push_back(Pair("count", stage->Count()));
+        obj.push_back(Pair("total_us", stage->Total()));
+        obj.push_back(Pair("max_us", stage->Max()));
+        obj.push_back(Pair("last_us", stage->Last()));
+        stages.push_back(obj);
+    }
+
+    if (fReset) {
+        ResetLockStats();
+        ResetPerfStages();
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("lockstats", g_lock_stats_enabled.load()));
+    ret.push_back(Pair("samplerate", (int64_t)GetLockStatsSampleRate()));
+    ret.push_back(Pair("locks", locks));
+    ret.push_back(Pair("sites", sites));
+    ret.push_back(Pair("stages", stages));
+    return ret;
+}
+
 #ifdef ENABLE_WALLET
 UniValue getstakingstatus(const UniValue& params, bool fHelp)
 {
@@ -77,6 +77,22 @@ static void CopyNodeStats(std::vector<CNodeStats>& vstats)
     }
 }
 
+static UniValue MsgStatsToJSON(const mapNetMsgStats& mapMsgStats)
+{
+    UniValue ret(UniValue::VOBJ);
+    for (const auto& item : mapMsgStats) {
+        const CNetMsgStats& stats = item.second;
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("msgssent", stats.nMsgsSent));
+        obj.push_back(Pair("bytessent", stats.nBytesSent));
+        obj.push_back(Pair("msgsrecv", stats.nMsgsRecv));
+        obj.push_back(Pair("bytesrecv", stats.nBytesRecv));
+        obj.push_back(Pair("processtime_us", stats.nProcessMicros));
+        ret.push_back(Pair(item.first, obj));
+    }
+    return ret;
+}
+
 UniValue getpeerinfo(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 0)
@@ -109,7 +125,12 @@ UniValue getpeerinfo(const UniValue& params, bool fHelp)
             "    \"inflight\": [\n"
             "       n,                        (numeric) The heights of blocks we're currently asking from this peer\n"
             "       ...\n"
-            "    ]\n"
+            "    ],\n"
+            "    \"whitelisted\": true|false, (boolean) Whether the peer is whitelisted\n"
+            "    \"msgstats\": {             (json object) Traffic with this peer by message command, see getnetmsgstats\n"
+            "       \"command\": { ... },\n"
+            "       ...\n"
+            "    }\n"
             "  }\n"
             "  ,...\n"
             "]\n"
@@ -160,6 +181,7 @@ UniValue getpeerinfo(const UniValue& params, bool fHelp)
             obj.push_back(Pair("inflight", heights));
         }
         obj.push_back(Pair("whitelisted", stats.fWhitelisted));
+        obj.push_back(Pair("msgstats", MsgStatsToJSON(stats.mapMsgStats)));
 
         ret.push_back(obj);
     }
@@ -368,6 +390,32 @@ UniValue getnettotals(const UniValue& params, bool fHelp)
     return obj;
 }
 
+UniValue getnetmsgstats(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() > 0)
+        throw runtime_error(
+            "getnetmsgstats\n"
+            "\nReturns the network traffic and message handling time of all peers since startup, by message command.\n"
+            "Received messages with an unknown command are counted under \"" + std::string(NET_MESSAGE_COMMAND_OTHER) + "\".\n"
+
+            "\nResult:\n"
+            "{\n"
+            "  \"command\": {            (json object) The message command, such as \"inv\" or \"mnb\"\n"
+            "    \"msgssent\": n,        (numeric) Messages queued for sending\n"
+            "    \"bytessent\": n,       (numeric) Bytes queued for sending, including message headers\n"
+            "    \"msgsrecv\": n,        (numeric) Messages received\n"
+            "    \"bytesrecv\": n,       (numeric) Bytes received, including message headers\n"
+            "    \"processtime_us\": n   (numeric) Microseconds spent handling the received messages\n"
+            "  },\n"
+            "  ...\n"
+            "}\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getnetmsgstats", "") + HelpExampleRpc("getnetmsgstats", ""));
+
+    return MsgStatsToJSON(CNode::GetTotalMsgStats());
+}
+
 static UniValue GetNetworksInfo()
 {
     UniValue networks(UniValue::VARR);
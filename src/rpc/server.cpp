@@ -9,6 +9,7 @@
 #include "rpc/server.h"
 
 #include "base58.h"
+#include "httpserver.h"
 #include "init.h"
 #include "main.h"
 #include "random.h"
@@ -17,6 +18,11 @@
 #include "util.h"
 #include "utilstrencodings.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
 #include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
@@ -286,6 +292,7 @@ static const CRPCCommand vRPCCommands[] =
         //  --------------------- ------------------------  -----------------------  ---------- ---------- ---------
         /* Overall control/query calls */
         {"control", "getinfo", &getinfo, true, false, false}, /* uses wallet if enabled */
+        {"control", "getperfstats", &getperfstats, true, true, false},
         {"control", "help", &help, true, true, false},
         {"control", "stop", &stop, true, true, false},
 
@@ -296,6 +303,7 @@ static const CRPCCommand vRPCCommands[] =
         {"network", "getaddednodeinfo", &getaddednodeinfo, true, true, false},
         {"network", "getconnectioncount", &getconnectioncount, true, false, false},
         {"network", "getnettotals", &getnettotals, true, true, false},
+        {"network", "getnetmsgstats", &getnetmsgstats, true, true, false},
         {"network", "getpeerinfo", &getpeerinfo, true, false, false},
         {"network", "ping", &ping, true, false, false},
         {"network", "setban", &setban, true, false, false},
@@ -606,11 +614,94 @@ static UniValue JSONRPCExecOne(const UniValue& req)
     return rpc_result;
 }
 
+/**
+ * Read-only calls that do not depend on the effects of other entries in the
+ * same batch, and may therefore be executed concurrently. Wallet calls are
+ * left out, they serialize on cs_wallet anyway.
+ */
+static const char* const pszConcurrentBatchCommands[] = {
+    "getbestblockhash", "getblock", "getblockcount", "getblockhash", "getblockheader",
+    "getrawmempool", "getrawtransaction", "gettxout", "decoderawtransaction", "decodescript"};
+
+static bool IsConcurrentBatchRequest(const UniValue& req)
+{
+    if (!req.isObject())
+        return false;
+    const UniValue& valMethod = find_value(req, "method");
+    if (!valMethod.isStr())
+        return false;
+    for (const char* pszCommand : pszConcurrentBatchCommands) {
+        if (valMethod.get_str() == pszCommand)
+            return true;
+    }
+    return false;
+}
+
+/** A batch being executed, shared with the helpers working on it */
+struct CRPCBatch {
+    CRPCBatch(const UniValue& vReqIn) : vReq(vReqIn), vResults(vReqIn.size()), nNext(0), nRunning(0) {}
+
+    const UniValue vReq;
+    std::vector<UniValue> vResults;
+    std::atomic<unsigned int> nNext;
+    //! Number of entries being executed by helpers
+    int nRunning;
+    std::mutex cs;
+    std::condition_variable cond;
+};
+
+static void JSONRPCExecBatchWorker(std::shared_ptr<CRPCBatch> batch, bool fHelper)
+{
+    while (true) {
+        // A helper registers before claiming an entry, so the batch owner
+        // cannot miss a result that is still being produced
+        if (fHelper) {
+            std::lock_guard<std::mutex> lock(batch->cs);
+            batch->nRunning++;
+        }
+        unsigned int reqIdx = batch->nNext++;
+        bool fDone = reqIdx >= batch->vReq.size();
+        if (!fDone)
+            batch->vResults[reqIdx] = JSONRPCExecOne(batch->vReq[reqIdx]);
+        if (fHelper) {
+            std::lock_guard<std::mutex> lock(batch->cs);
+            batch->nRunning--;
+            batch->cond.notify_all();
+        }
+        if (fDone)
+            break;
+    }
+}
+
 std::string JSONRPCExecBatch(const UniValue& vReq)
 {
+    std::shared_ptr<CRPCBatch> batch = std::make_shared<CRPCBatch>(vReq);
+
+    // Fan the batch out only if every entry is a read-only call
+    int nThreads = std::min((int)vReq.size(), (int)GetArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS));
+    for (unsigned int reqIdx = 0; reqIdx < vReq.size() && nThreads > 1; reqIdx++) {
+        if (!IsConcurrentBatchRequest(vReq[reqIdx]))
+            nThreads = 1;
+    }
+
+    // Helpers run on the HTTP worker threads, so the number of threads working
+    // on batches stays bounded by -rpcthreads. This thread works through the
+    // batch as well and only waits for entries a helper has already started,
+    // so a batch completes even if no helper ever gets to run.
+    for (int i = 1; i < nThreads; i++) {
+        if (!HTTPEnqueueWork(std::bind(&JSONRPCExecBatchWorker, batch, true)))
+            break;
+    }
+    JSONRPCExecBatchWorker(batch, false);
+    {
+        std::unique_lock<std::mutex> lock(batch->cs);
+        while (batch->nRunning > 0)
+            batch->cond.wait(lock);
+    }
+
     UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(vReq[reqIdx]));
+    for (const UniValue& result : batch->vResults)
+        ret.push_back(result);
 
     return ret.write() + "\n";
 }
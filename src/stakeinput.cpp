@@ -176,32 +176,41 @@ bool CzdogecStake::MarkSpent(CWallet *pwallet, const uint256& txid)
 bool CDOGECStake::SetInput(CTransaction txPrev, unsigned int n)
 {
     this->txFrom = txPrev;
+    this->pTxFrom = &txFrom;
     this->nPosition = n;
     return true;
 }
 
+bool CDOGECStake::SetInput(const CTransaction* ptxPrev, unsigned int n, CBlockIndex* pindexFromIn)
+{
+    this->pTxFrom = ptxPrev;
+    this->nPosition = n;
+    this->pindexFrom = pindexFromIn;
+    return true;
+}
+
 bool CDOGECStake::GetTxFrom(CTransaction& tx)
 {
-    tx = txFrom;
+    tx = *pTxFrom;
     return true;
 }
 
 bool CDOGECStake::CreateTxIn(CWallet* pwallet, CTxIn& txIn, uint256 hashTxOut)
 {
-    txIn = CTxIn(txFrom.GetHash(), nPosition);
+    txIn = CTxIn(pTxFrom->GetHash(), nPosition);
     return true;
 }
 
 CAmount CDOGECStake::GetValue()
 {
-    return txFrom.vout[nPosition].nValue;
+    return pTxFrom->vout[nPosition].nValue;
 }
 
 bool CDOGECStake::CreateTxOuts(CWallet* pwallet, vector<CTxOut>& vout, CAmount nTotal)
 {
     vector<valtype> vSolutions;
     txnouttype whichType;
-    CScript scriptPubKeyKernel = txFrom.vout[nPosition].scriptPubKey;
+    const CScript& scriptPubKeyKernel = pTxFrom->vout[nPosition].scriptPubKey;
     if (!Solver(scriptPubKeyKernel, whichType, vSolutions))
         return error("%s: failed to parse kernel", __func__);
 
@@ -265,16 +274,20 @@ CDataStream CDOGECStake::GetUniqueness()
 {
     //The unique identifier for a DOGEC stake is the outpoint
     CDataStream ss(SER_NETWORK, 0);
-    ss << nPosition << txFrom.GetHash();
+    ss << nPosition << pTxFrom->GetHash();
     return ss;
 }
 
 //The block that the UTXO was added to the chain
 CBlockIndex* CDOGECStake::GetIndexFrom()
 {
+    // the wallet already knows which block holds its transactions
+    if (pindexFrom && chainActive.Contains(pindexFrom))
+        return pindexFrom;
+
     uint256 hashBlock = 0;
     CTransaction tx;
-    if (GetTransaction(txFrom.GetHash(), tx, hashBlock, true)) {
+    if (GetTransaction(pTxFrom->GetHash(), tx, hashBlock, true)) {
         // If the index is in the chain, then set it as the "index from"
         if (mapBlockIndex.count(hashBlock)) {
             CBlockIndex* pindex = mapBlockIndex.at(hashBlock);
@@ -282,7 +295,7 @@ CBlockIndex* CDOGECStake::GetIndexFrom()
                 pindexFrom = pindex;
         }
     } else {
-        LogPrintf("%s : failed to find tx %s\n", __func__, txFrom.GetHash().GetHex());
+        LogPrintf("%s : failed to find tx %s\n", __func__, pTxFrom->GetHash().GetHex());
     }
 
     return pindexFrom;
@@ -73,14 +73,21 @@ class CDOGECStake : public CStakeInput
 {
 private:
     CTransaction txFrom;
+    // the transaction being staked: txFrom, or a wallet transaction that is not copied
+    const CTransaction* pTxFrom;
     unsigned int nPosition;
 public:
     CDOGECStake()
     {
         this->pindexFrom = nullptr;
+        this->pTxFrom = nullptr;
     }
+    CDOGECStake(const CDOGECStake&) = delete;
+    CDOGECStake& operator=(const CDOGECStake&) = delete;
 
     bool SetInput(CTransaction txPrev, unsigned int n);
+    // Stake an output of a wallet transaction, which must outlive this object
+    bool SetInput(const CTransaction* ptxPrev, unsigned int n, CBlockIndex* pindexFromIn);
 
     CBlockIndex* GetIndexFrom() override;
     bool GetTxFrom(CTransaction& tx) override;
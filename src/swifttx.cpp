@@ -21,11 +21,7 @@
 using namespace std;
 using namespace boost;
 
-std::map<uint256, CTransaction> mapTxLockReq;
-std::map<uint256, CTransaction> mapTxLockReqRejected;
-std::map<uint256, CConsensusVote> mapTxLockVote;
-std::map<uint256, CTransactionLock> mapTxLocks;
-std::map<COutPoint, uint256> mapLockedInputs;
+CSwiftTXManager swifttxManager;
 std::map<uint256, int64_t> mapUnknownVotes; //track votes with no tx for DOS
 int nCompleteTXLocks;
 
@@ -52,7 +48,7 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
         pfrom->AddInventoryKnown(inv);
         GetMainSignals().Inventory(inv.hash);
 
-        if (mapTxLockReq.count(tx.GetHash()) || mapTxLockReqRejected.count(tx.GetHash())) {
+        if (swifttxManager.HaveLockRequest(tx.GetHash()) || swifttxManager.IsLockRequestRejected(tx.GetHash())) {
             return;
         }
 
@@ -84,7 +80,7 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
 
             DoConsensusVote(tx, nBlockHeight);
 
-            mapTxLockReq.insert(make_pair(tx.GetHash(), tx));
+            swifttxManager.AddLockRequest(tx);
 
             LogPrintf("%s : Transaction Lock Request: %s %s : accepted %s\n", __func__,
                     pfrom->addr.ToString().c_str(), pfrom->cleanSubVer.c_str(),
@@ -97,7 +93,7 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
             return;
 
         } else {
-            mapTxLockReqRejected.insert(make_pair(tx.GetHash(), tx));
+            swifttxManager.AddRejectedLockRequest(tx);
 
             // can we get the conflicting transaction as proof?
 
@@ -105,24 +101,17 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
                 pfrom->addr.ToString().c_str(), pfrom->cleanSubVer.c_str(),
                 tx.GetHash().ToString().c_str());
 
-            BOOST_FOREACH (const CTxIn& in, tx.vin) {
-                if (!mapLockedInputs.count(in.prevout)) {
-                    mapLockedInputs.insert(make_pair(in.prevout, tx.GetHash()));
-                }
-            }
+            swifttxManager.LockInputs(tx);
 
             // resolve conflicts
-            std::map<uint256, CTransactionLock>::iterator i = mapTxLocks.find(tx.GetHash());
-            if (i != mapTxLocks.end()) {
-                //we only care if we have a complete tx lock
-                if ((*i).second.CountSignatures() >= SWIFTTX_SIGNATURES_REQUIRED) {
-                    if (!CheckForConflictingLocks(tx)) {
-                        LogPrintf("%s : Found Existing Complete IX Lock\n", __func__);
-
-                        //reprocess the last 15 blocks
-                        ReprocessBlocks(15);
-                        mapTxLockReq.insert(make_pair(tx.GetHash(), tx));
-                    }
+            //we only care if we have a complete tx lock
+            if (swifttxManager.CountSignatures(tx.GetHash()) >= SWIFTTX_SIGNATURES_REQUIRED) {
+                if (!swifttxManager.CancelConflictingLocks(tx)) {
+                    LogPrintf("%s : Found Existing Complete IX Lock\n", __func__);
+
+                    //reprocess the last 15 blocks
+                    ReprocessBlocks(15);
+                    swifttxManager.AddLockRequest(tx);
                 }
             }
 
@@ -136,12 +125,10 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
         CInv inv(MSG_TXLOCK_VOTE, ctx.GetHash());
         pfrom->AddInventoryKnown(inv);
 
-        if (mapTxLockVote.count(ctx.GetHash())) {
+        if (!swifttxManager.AddVote(ctx)) {
             return;
         }
 
-        mapTxLockVote.insert(make_pair(ctx.GetHash(), ctx));
-
         if (ProcessConsensusVote(pfrom, ctx)) {
             //Spam/Dos protection
             /*
@@ -149,7 +136,7 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
                 This tracks those messages and allows it at the same rate of the rest of the network, if
                 a peer violates it, it will simply be ignored
             */
-            if (!mapTxLockReq.count(ctx.txHash) && !mapTxLockReqRejected.count(ctx.txHash)) {
+            if (!swifttxManager.HaveLockRequest(ctx.txHash) && !swifttxManager.IsLockRequestRejected(ctx.txHash)) {
                 if (!mapUnknownVotes.count(ctx.vinMasternode.prevout.hash)) {
                     mapUnknownVotes[ctx.vinMasternode.prevout.hash] = GetTime() + (60 * 10);
                 }
@@ -167,8 +154,9 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
             RelayInv(inv);
         }
 
-        if (mapTxLockReq.count(ctx.txHash) && GetTransactionLockSignatures(ctx.txHash) == SWIFTTX_SIGNATURES_REQUIRED) {
-            GetMainSignals().NotifyTransactionLock(mapTxLockReq[ctx.txHash]);
+        CTransaction tx;
+        if (swifttxManager.GetLockRequest(ctx.txHash, tx) && GetTransactionLockSignatures(ctx.txHash) == SWIFTTX_SIGNATURES_REQUIRED) {
+            GetMainSignals().NotifyTransactionLock(tx);
         }
 
         return;
@@ -242,17 +230,9 @@ int64_t CreateNewLock(CTransaction tx)
     */
     int nBlockHeight = (chainActive.Tip()->nHeight - nTxAge) + 4;
 
-    if (!mapTxLocks.count(tx.GetHash())) {
+    if (swifttxManager.CreateLock(tx.GetHash(), nBlockHeight)) {
         LogPrintf("%s : New Transaction Lock %s !\n", __func__, tx.GetHash().ToString().c_str());
-
-        CTransactionLock newLock;
-        newLock.nBlockHeight = nBlockHeight;
-        newLock.nExpiration = GetTime() + (60 * 60); //locks expire after 60 minutes (24 confirmations)
-        newLock.nTimeout = GetTime() + (60 * 5);
-        newLock.txHash = tx.GetHash();
-        mapTxLocks.insert(make_pair(tx.GetHash(), newLock));
     } else {
-        mapTxLocks[tx.GetHash()].nBlockHeight = nBlockHeight;
         LogPrint("swiftx", "%s : Transaction Lock Exists %s !\n", __func__, tx.GetHash().ToString().c_str());
     }
 
@@ -300,7 +280,7 @@ void DoConsensusVote(CTransaction& tx, int64_t nBlockHeight)
         return;
     }
 
-    mapTxLockVote[ctx.GetHash()] = ctx;
+    swifttxManager.AddVote(ctx);
 
     CInv inv(MSG_TXLOCK_VOTE, ctx.GetHash());
     RelayInv(inv);
@@ -334,91 +314,51 @@ bool ProcessConsensusVote(CNode* pnode, CConsensusVote& ctx)
         return error("%s : Signature invalid\n", __func__);
     }
 
-    if (!mapTxLocks.count(ctx.txHash)) {
+    if (swifttxManager.CreateLock(ctx.txHash, 0))
         LogPrintf("%s : New Transaction Lock %s !\n", __func__, ctx.txHash.ToString().c_str());
-
-        CTransactionLock newLock;
-        newLock.nBlockHeight = 0;
-        newLock.nExpiration = GetTime() + (60 * 60);
-        newLock.nTimeout = GetTime() + (60 * 5);
-        newLock.txHash = ctx.txHash;
-        mapTxLocks.insert(make_pair(ctx.txHash, newLock));
-    } else
+    else
         LogPrint("swiftx", "%s : Transaction Lock Exists %s !\n", __func__, ctx.txHash.ToString().c_str());
 
     //compile consessus vote
-    std::map<uint256, CTransactionLock>::iterator i = mapTxLocks.find(ctx.txHash);
-    if (i != mapTxLocks.end()) {
-        (*i).second.AddSignature(ctx);
+    int nSignatures = swifttxManager.AddLockVote(ctx);
 
 #ifdef ENABLE_WALLET
-        if (pwalletMain) {
-            //when we get back signatures, we'll count them as requests. Otherwise the client will think it didn't propagate.
-            if (pwalletMain->mapRequestCount.count(ctx.txHash))
-                pwalletMain->mapRequestCount[ctx.txHash]++;
-        }
+    if (pwalletMain) {
+        //when we get back signatures, we'll count them as requests. Otherwise the client will think it didn't propagate.
+        if (pwalletMain->mapRequestCount.count(ctx.txHash))
+            pwalletMain->mapRequestCount[ctx.txHash]++;
+    }
 #endif
 
-        LogPrint("swiftx", "%s : Transaction Lock Votes %d - %s !\n", __func__, (*i).second.CountSignatures(), ctx.GetHash().ToString().c_str());
+    LogPrint("swiftx", "%s : Transaction Lock Votes %d - %s !\n", __func__, nSignatures, ctx.GetHash().ToString().c_str());
 
-        if ((*i).second.CountSignatures() >= SWIFTTX_SIGNATURES_REQUIRED) {
-            LogPrint("swiftx", "%s : Transaction Lock Is Complete %s !\n", __func__, (*i).second.GetHash().ToString().c_str());
+    if (nSignatures >= SWIFTTX_SIGNATURES_REQUIRED) {
+        LogPrint("swiftx", "%s : Transaction Lock Is Complete %s !\n", __func__, ctx.txHash.ToString().c_str());
 
-            CTransaction& tx = mapTxLockReq[ctx.txHash];
-            if (!CheckForConflictingLocks(tx)) {
+        CTransaction tx;
+        bool fHaveRequest = swifttxManager.GetLockRequest(ctx.txHash, tx);
+        if (!swifttxManager.CancelConflictingLocks(tx)) {
 #ifdef ENABLE_WALLET
-                if (pwalletMain) {
-                    if (pwalletMain->UpdatedTransaction((*i).second.txHash)) {
-                        nCompleteTXLocks++;
-                    }
+            if (pwalletMain) {
+                if (pwalletMain->UpdatedTransaction(ctx.txHash)) {
+                    nCompleteTXLocks++;
                 }
+            }
 #endif
 
-                if (mapTxLockReq.count(ctx.txHash)) {
-                    BOOST_FOREACH (const CTxIn& in, tx.vin) {
-                        if (!mapLockedInputs.count(in.prevout)) {
-                            mapLockedInputs.insert(make_pair(in.prevout, ctx.txHash));
-                        }
-                    }
-                }
+            if (fHaveRequest)
+                swifttxManager.LockInputs(tx);
 
-                // resolve conflicts
+            // resolve conflicts
 
-                //if this tx lock was rejected, we need to remove the conflicting blocks
-                if (mapTxLockReqRejected.count((*i).second.txHash)) {
-                    //reprocess the last 15 blocks
-                    ReprocessBlocks(15);
-                }
+            //if this tx lock was rejected, we need to remove the conflicting blocks
+            if (swifttxManager.IsLockRequestRejected(ctx.txHash)) {
+                //reprocess the last 15 blocks
+                ReprocessBlocks(15);
             }
         }
-        return true;
     }
-
-    return false;
-}
-
-bool CheckForConflictingLocks(CTransaction& tx)
-{
-    /*
-        It's possible (very unlikely though) to get 2 conflicting transaction locks approved by the network.
-        In that case, they will cancel each other out.
-
-        Blocks could have been rejected during this time, which is OK. After they cancel out, the client will
-        rescan the blocks and find they're acceptable and then take the chain with the most work.
-    */
-    BOOST_FOREACH (const CTxIn& in, tx.vin) {
-        if (mapLockedInputs.count(in.prevout)) {
-            if (mapLockedInputs[in.prevout] != tx.GetHash()) {
-                LogPrintf("%s : found two complete conflicting locks - removing both. %s %s", __func__,
-                        tx.GetHash().ToString().c_str(), mapLockedInputs[in.prevout].ToString().c_str());
-                if (mapTxLocks.count(tx.GetHash())) mapTxLocks[tx.GetHash()].nExpiration = GetTime();
-                if (mapTxLocks.count(mapLockedInputs[in.prevout])) mapTxLocks[mapLockedInputs[in.prevout]].nExpiration = GetTime();
-                return true;
-            }
-        }
-    }
-
-    return false;
+    return true;
 }
 
 int64_t GetAverageVoteTime()
@@ -440,31 +380,7 @@ void CleanTransactionLocksList()
 {
     if (chainActive.Tip() == NULL) return;
 
-    std::map<uint256, CTransactionLock>::iterator it = mapTxLocks.begin();
-
-    while (it != mapTxLocks.end()) {
-        if (GetTime() > it->second.nExpiration) { //keep them for an hour
-            LogPrintf("%s : Removing old transaction lock %s\n", __func__,
-                    it->second.txHash.ToString().c_str());
-
-            if (mapTxLockReq.count(it->second.txHash)) {
-                CTransaction& tx = mapTxLockReq[it->second.txHash];
-
-                BOOST_FOREACH (const CTxIn& in, tx.vin)
-                    mapLockedInputs.erase(in.prevout);
-
-                mapTxLockReq.erase(it->second.txHash);
-                mapTxLockReqRejected.erase(it->second.txHash);
-
-                BOOST_FOREACH (CConsensusVote& v, it->second.vecConsensusVotes)
-                    mapTxLockVote.erase(v.GetHash());
-            }
-
-            mapTxLocks.erase(it++);
-        } else {
-            it++;
-        }
-    }
+    swifttxManager.RemoveExpiredLocks(GetTime());
 }
 
 int GetTransactionLockSignatures(uint256 txHash)
@@ -472,10 +388,7 @@ int GetTransactionLockSignatures(uint256 txHash)
     if(fLargeWorkForkFound || fLargeWorkInvalidChainFound) return -2;
     if (!sporkManager.IsSporkActive(SPORK_2_SWIFTTX)) return -1;
 
-    std::map<uint256, CTransactionLock>::iterator it = mapTxLocks.find(txHash);
-    if(it != mapTxLocks.end()) return it->second.CountSignatures();
-
-    return -1;
+    return swifttxManager.CountSignatures(txHash);
 }
 
 uint256 CConsensusVote::GetHash() const
@@ -519,12 +432,13 @@ bool CTransactionLock::SignaturesValid()
     return true;
 }
 
-void CTransactionLock::AddSignature(CConsensusVote& cv)
+void CTransactionLock::AddSignature(const CConsensusVote& cv)
 {
     vecConsensusVotes.push_back(cv);
+    mapVotesByHeight[cv.nBlockHeight]++;
 }
 
-int CTransactionLock::CountSignatures()
+int CTransactionLock::CountSignatures() const
 {
     /*
         Only count signatures where the BlockHeight matches the transaction's blockheight.
@@ -533,11 +447,187 @@ int CTransactionLock::CountSignatures()
 
     if (nBlockHeight == 0) return -1;
 
-    int n = 0;
-    BOOST_FOREACH (CConsensusVote v, vecConsensusVotes) {
-        if (v.nBlockHeight == nBlockHeight) {
-            n++;
+    std::map<int, int>::const_iterator it = mapVotesByHeight.find(nBlockHeight);
+    return it != mapVotesByHeight.end() ? it->second : 0;
+}
+
+bool CSwiftTXManager::HaveLockRequest(const uint256& txHash) const
+{
+    LOCK(cs);
+    return mapTxLockReq.count(txHash);
+}
+
+bool CSwiftTXManager::IsLockRequestRejected(const uint256& txHash) const
+{
+    LOCK(cs);
+    return mapTxLockReqRejected.count(txHash);
+}
+
+bool CSwiftTXManager::GetLockRequest(const uint256& txHash, CTransaction& txRet) const
+{
+    LOCK(cs);
+    std::map<uint256, CTransaction>::const_iterator it = mapTxLockReq.find(txHash);
+    if (it == mapTxLockReq.end())
+        return false;
+    txRet = it->second;
+    return true;
+}
+
+void CSwiftTXManager::AddLockRequest(const CTransaction& tx)
+{
+    LOCK(cs);
+    mapTxLockReq.insert(std::make_pair(tx.GetHash(), tx));
+}
+
+void CSwiftTXManager::AddRejectedLockRequest(const CTransaction& tx)
+{
+    LOCK(cs);
+    mapTxLockReqRejected.insert(std::make_pair(tx.GetHash(), tx));
+}
+
+bool CSwiftTXManager::HaveVote(const uint256& hash) const
+{
+    LOCK(cs);
+    return mapTxLockVote.count(hash);
+}
+
+bool CSwiftTXManager::GetVote(const uint256& hash, CConsensusVote& voteRet) const
+{
+    LOCK(cs);
+    std::map<uint256, CConsensusVote>::const_iterator it = mapTxLockVote.find(hash);
+    if (it == mapTxLockVote.end())
+        return false;
+    voteRet = it->second;
+    return true;
+}
+
+bool CSwiftTXManager::AddVote(const CConsensusVote& vote)
+{
+    LOCK(cs);
+    return mapTxLockVote.insert(std::make_pair(vote.GetHash(), vote)).second;
+}
+
+void CSwiftTXManager::SetExpiration(CTransactionLock& lock, int64_t nExpiration)
+{
+    setLockExpiry.erase(std::make_pair((int64_t)lock.nExpiration, lock.txHash));
+    lock.nExpiration = nExpiration;
+    setLockExpiry.insert(std::make_pair(nExpiration, lock.txHash));
+}
+
+bool CSwiftTXManager::CreateLock(const uint256& txHash, int nBlockHeight)
+{
+    LOCK(cs);
+    std::map<uint256, CTransactionLock>::iterator it = mapTxLocks.find(txHash);
+    if (it != mapTxLocks.end()) {
+        if (nBlockHeight != 0)
+            it->second.nBlockHeight = nBlockHeight;
+        return false;
+    }
+
+    CTransactionLock& lock = mapTxLocks[txHash];
+    lock.nBlockHeight = nBlockHeight;
+    lock.nTimeout = GetTime() + (60 * 5);
+    lock.txHash = txHash;
+    SetExpiration(lock, GetTime() + (60 * 60)); //locks expire after 60 minutes (24 confirmations)
+    return true;
+}
+
+int CSwiftTXManager::AddLockVote(const CConsensusVote& vote)
+{
+    LOCK(cs);
+    std::map<uint256, CTransactionLock>::iterator it = mapTxLocks.find(vote.txHash);
+    if (it == mapTxLocks.end())
+        return -1;
+    it->second.AddSignature(vote);
+    return it->second.CountSignatures();
+}
+
+int CSwiftTXManager::CountSignatures(const uint256& txHash) const
+{
+    LOCK(cs);
+    std::map<uint256, CTransactionLock>::const_iterator it = mapTxLocks.find(txHash);
+    return it != mapTxLocks.end() ? it->second.CountSignatures() : -1;
+}
+
+bool CSwiftTXManager::IsLockTimedOut(const uint256& txHash) const
+{
+    LOCK(cs);
+    std::map<uint256, CTransactionLock>::const_iterator it = mapTxLocks.find(txHash);
+    return it != mapTxLocks.end() && GetTime() > it->second.nTimeout;
+}
+
+void CSwiftTXManager::LockInputs(const CTransaction& tx)
+{
+    LOCK(cs);
+    for (const CTxIn& in : tx.vin)
+        mapLockedInputs.insert(std::make_pair(in.prevout, tx.GetHash()));
+    nLockedInputs = mapLockedInputs.size();
+}
+
+bool CSwiftTXManager::GetConflictingLock(const CTransaction& tx, uint256& hashConflictRet) const
+{
+    if (nLockedInputs == 0)
+        return false;
+
+    LOCK(cs);
+    for (const CTxIn& in : tx.vin) {
+        boost::unordered_map<COutPoint, uint256, OutPointHasher>::const_iterator it = mapLockedInputs.find(in.prevout);
+        if (it != mapLockedInputs.end() && it->second != tx.GetHash()) {
+            hashConflictRet = it->second;
+            return true;
         }
     }
-    return n;
+    return false;
+}
+
+bool CSwiftTXManager::CancelConflictingLocks(const CTransaction& tx)
+{
+    /*
+        It's possible (very unlikely though) to get 2 conflicting transaction locks approved by the network.
+        In that case, they will cancel each other out.
+
+        Blocks could have been rejected during this time, which is OK. After they cancel out, the client will
+        rescan the blocks and find they're acceptable and then take the chain with the most work.
+    */
+    LOCK(cs);
+    uint256 hashConflict;
+    if (!GetConflictingLock(tx, hashConflict))
+        return false;
+
+    LogPrintf("%s : found two complete conflicting locks - removing both. %s %s", __func__,
+            tx.GetHash().ToString().c_str(), hashConflict.ToString().c_str());
+    std::map<uint256, CTransactionLock>::iterator it = mapTxLocks.find(tx.GetHash());
+    if (it != mapTxLocks.end()) SetExpiration(it->second, GetTime());
+    it = mapTxLocks.find(hashConflict);
+    if (it != mapTxLocks.end()) SetExpiration(it->second, GetTime());
+    return true;
+}
+
+void CSwiftTXManager::RemoveExpiredLocks(int64_t nNow)
+{
+    LOCK(cs);
+    while (!setLockExpiry.empty() && setLockExpiry.begin()->first < nNow) { //keep them for an hour
+        const uint256 txHash = setLockExpiry.begin()->second;
+        setLockExpiry.erase(setLockExpiry.begin());
+
+        std::map<uint256, CTransactionLock>::iterator it = mapTxLocks.find(txHash);
+        if (it == mapTxLocks.end())
+            continue;
+        LogPrintf("%s : Removing old transaction lock %s\n", __func__, txHash.ToString().c_str());
+
+        std::map<uint256, CTransaction>::iterator itReq = mapTxLockReq.find(txHash);
+        if (itReq != mapTxLockReq.end()) {
+            for (const CTxIn& in : itReq->second.vin)
+                mapLockedInputs.erase(in.prevout);
+
+            mapTxLockReq.erase(itReq);
+            mapTxLockReqRejected.erase(txHash);
+
+            for (const CConsensusVote& v : it->second.vecConsensusVotes)
+                mapTxLockVote.erase(v.GetHash());
+        }
+
+        mapTxLocks.erase(it);
+    }
+    nLockedInputs = mapLockedInputs.size();
 }
@@ -14,6 +14,11 @@
 #include "sync.h"
 #include "util.h"
 
+#include <atomic>
+#include <set>
+
+#include <boost/unordered_map.hpp>
+
 /*
     At 15 signatures, 1/2 of the masternode network can be owned by
     one party without comprimising the security of SwiftX
@@ -35,11 +40,9 @@ class CTransactionLock;
 
 static const int MIN_SWIFTTX_PROTO_VERSION = 70103;
 
-extern map<uint256, CTransaction> mapTxLockReq;
-extern map<uint256, CTransaction> mapTxLockReqRejected;
-extern map<uint256, CConsensusVote> mapTxLockVote;
-extern map<uint256, CTransactionLock> mapTxLocks;
-extern std::map<COutPoint, uint256> mapLockedInputs;
+class CSwiftTXManager;
+
+extern CSwiftTXManager swifttxManager;
 extern int nCompleteTXLocks;
 
 
@@ -47,9 +50,6 @@ int64_t CreateNewLock(CTransaction tx);
 
 bool IsIXTXValid(const CTransaction& txCollateral);
 
-// if two conflicting locks are approved by the network, they will cancel out
-bool CheckForConflictingLocks(CTransaction& tx);
-
 void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
 
 //check if we need to vote on this transaction
@@ -111,18 +111,81 @@ public:
     int nBlockHeight;
     uint256 txHash;
     std::vector<CConsensusVote> vecConsensusVotes;
+    std::map<int, int> mapVotesByHeight; // number of votes for each block height
     int nExpiration;
     int nTimeout;
 
+    CTransactionLock() : nBlockHeight(0), nExpiration(0), nTimeout(0) {}
+
     bool SignaturesValid();
-    int CountSignatures();
-    void AddSignature(CConsensusVote& cv);
+    int CountSignatures() const;
+    void AddSignature(const CConsensusVote& cv);
 
-    uint256 GetHash()
+    uint256 GetHash() const
     {
         return txHash;
     }
 };
 
+struct OutPointHasher {
+    size_t operator()(const COutPoint& outpoint) const { return outpoint.hash.GetLow64() ^ outpoint.n; }
+};
+
+/**
+ * Transaction lock state: the lock requests and votes seen, the locks they
+ * add up to and the inputs claimed by locks. Inputs are indexed by outpoint,
+ * so checking a block or mempool transaction against the locks costs one
+ * lookup per input (none at all while nothing is locked), and locks are kept
+ * ordered by expiry so cleaning up does not walk all of them.
+ */
+class CSwiftTXManager
+{
+private:
+    mutable RecursiveMutex cs;
+    std::map<uint256, CTransaction> mapTxLockReq;
+    std::map<uint256, CTransaction> mapTxLockReqRejected;
+    std::map<uint256, CConsensusVote> mapTxLockVote;
+    std::map<uint256, CTransactionLock> mapTxLocks;
+    boost::unordered_map<COutPoint, uint256, OutPointHasher> mapLockedInputs;
+    std::set<std::pair<int64_t, uint256> > setLockExpiry; // (expiration, tx hash) of every lock
+    std::atomic<size_t> nLockedInputs;
+
+    void SetExpiration(CTransactionLock& lock, int64_t nExpiration);
+
+public:
+    CSwiftTXManager() : nLockedInputs(0) {}
+
+    bool HaveLockRequest(const uint256& txHash) const;
+    bool IsLockRequestRejected(const uint256& txHash) const;
+    bool GetLockRequest(const uint256& txHash, CTransaction& txRet) const;
+    void AddLockRequest(const CTransaction& tx);
+    void AddRejectedLockRequest(const CTransaction& tx);
+
+    bool HaveVote(const uint256& hash) const;
+    bool GetVote(const uint256& hash, CConsensusVote& voteRet) const;
+    /** Remember a vote, returns false if it was known already */
+    bool AddVote(const CConsensusVote& vote);
+
+    /** Start tracking the lock of txHash, returns false if it exists already.
+     *  An existing lock is moved to nBlockHeight unless that is 0. */
+    bool CreateLock(const uint256& txHash, int nBlockHeight);
+    /** Count a vote towards its lock, returns the number of valid signatures or -1 without a lock */
+    int AddLockVote(const CConsensusVote& vote);
+    /** Number of votes for the block height of the lock of txHash, -1 without a lock */
+    int CountSignatures(const uint256& txHash) const;
+    bool IsLockTimedOut(const uint256& txHash) const;
+
+    /** Claim the inputs of tx which are not claimed by another lock yet */
+    void LockInputs(const CTransaction& tx);
+    /** Find an input of tx claimed by a lock of another transaction */
+    bool GetConflictingLock(const CTransaction& tx, uint256& hashConflictRet) const;
+    /** If two conflicting locks are approved by the network, they will cancel out:
+     *  both expire right away. Returns whether tx had such a conflict. */
+    bool CancelConflictingLocks(const CTransaction& tx);
+
+    /** Forget the locks which expired before nNow, with their requests, votes and inputs */
+    void RemoveExpiredLocks(int64_t nNow);
+};
+
 
 #endif
@@ -5,6 +5,9 @@
 
 #include "sync.h"
 
+#include <algorithm>
+#include <chrono>
+#include <map>
 #include <memory>
 #include <set>
 
@@ -210,3 +213,90 @@ void DeleteLock(void* cs)
 bool g_debug_lockorder_abort = true;
 
 #endif /* DEBUG_LOCKORDER */
+
+std::atomic<bool> g_lock_stats_enabled(false);
+static std::atomic<unsigned int> g_lock_stats_sample_rate(DEFAULT_LOCK_STATS_SAMPLE_RATE);
+
+struct LockStatsData {
+    std::mutex mutex;
+    std::map<std::pair<const char*, int>, CLockSiteStats> mapSites;
+};
+
+static LockStatsData& GetLockStatsData()
+{
+    // Never freed, so that locks taken by global destructors can still be sampled
+    static LockStatsData* lockstatsdata = new LockStatsData();
+    return *lockstatsdata;
+}
+
+void SetLockStatsSampleRate(unsigned int nRate)
+{
+    g_lock_stats_sample_rate = std::max(1u, nRate);
+}
+
+unsigned int GetLockStatsSampleRate()
+{
+    return g_lock_stats_sample_rate;
+}
+
+bool LockStatsSample()
+{
+    static thread_local unsigned int nAcquisitions = 0;
+    return ++nAcquisitions % g_lock_stats_sample_rate.load(std::memory_order_relaxed) == 0;
+}
+
+int64_t LockStatsTime()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static CLockSiteStats& GetLockSite(LockStatsData& data, const char* pszName, const char* pszFile, int nLine, const void* cs)
+{
+    CLockSiteStats& site = data.mapSites[std::make_pair(pszFile, nLine)];
+    if (site.nSamples == 0 && site.nTryFailed == 0) {
+        site.strName = pszName;
+        site.strFile = pszFile;
+        site.nLine = nLine;
+    }
+    site.cs = cs;
+    return site;
+}
+
+void LockStatsRecord(const char* pszName, const char* pszFile, int nLine, const void* cs, bool fContended, int64_t nWaitMicros, int64_t nHoldMicros)
+{
+    LockStatsData& data = GetLockStatsData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    CLockSiteStats& site = GetLockSite(data, pszName, pszFile, nLine, cs);
+    site.nSamples++;
+    if (fContended)
+        site.nContended++;
+    site.nWaitMicros += nWaitMicros;
+    site.nWaitMaxMicros = std::max(site.nWaitMaxMicros, nWaitMicros);
+    site.nHoldMicros += nHoldMicros;
+    site.nHoldMaxMicros = std::max(site.nHoldMaxMicros, nHoldMicros);
+}
+
+void LockStatsRecordTryFailed(const char* pszName, const char* pszFile, int nLine, const void* cs)
+{
+    LockStatsData& data = GetLockStatsData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    GetLockSite(data, pszName, pszFile, nLine, cs).nTryFailed++;
+}
+
+std::vector<CLockSiteStats> GetLockStats()
+{
+    LockStatsData& data = GetLockStatsData();
+    std::vector<CLockSiteStats> vStats;
+    std::lock_guard<std::mutex> lock(data.mutex);
+    vStats.reserve(data.mapSites.size());
+    for (const auto& item : data.mapSites)
+        vStats.push_back(item.second);
+    return vStats;
+}
+
+void ResetLockStats()
+{
+    LockStatsData& data = GetLockStatsData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    data.mapSites.clear();
+}
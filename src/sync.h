@@ -10,10 +10,15 @@
 #include "threadsafety.h"
 #include "util/macros.h"
 
+#include <atomic>
 #include <condition_variable>
+#include <stdint.h>
+#include <string>
 #include <thread>
 #include <mutex>
+#include <vector>
 
+#include <boost/thread/shared_mutex.hpp>
 
 /////////////////////////////////////////////////
 //                                             //
@@ -35,6 +40,12 @@ LOCK2(mutex1, mutex2);
 TRY_LOCK(mutex, name);
     std::unique_lock<std::recursive_mutex> name(mutex, std::try_to_lock_t);
 
+SharedMutex mutex;
+    boost::shared_mutex mutex;
+
+LOCK_SHARED(mutex);
+    boost::shared_lock<boost::shared_mutex> criticalblock(mutex);
+
 ENTER_CRITICAL_SECTION(mutex); // no RAII
     mutex.lock();
 
@@ -111,18 +122,157 @@ using RecursiveMutex = AnnotatedMixin<std::recursive_mutex>;
 /** Wrapped mutex: supports waiting but not recursive locking */
 typedef AnnotatedMixin<std::mutex> Mutex;
 
+/**
+ * std::unique_lock counterpart that holds a mutex in shared mode, so that
+ * UniqueLock can add lock order checking and -lockstats to shared locks too.
+ */
+template <typename PARENT>
+class SharedLockBase
+{
+private:
+    PARENT* pmutex;
+    bool fOwns;
+
+    SharedLockBase(const SharedLockBase&);
+    SharedLockBase& operator=(const SharedLockBase&);
+
+public:
+    SharedLockBase() : pmutex(nullptr), fOwns(false) {}
+    SharedLockBase(PARENT& mutexIn, std::defer_lock_t) : pmutex(&mutexIn), fOwns(false) {}
+    SharedLockBase(SharedLockBase&& other) : pmutex(other.pmutex), fOwns(other.fOwns)
+    {
+        other.pmutex = nullptr;
+        other.fOwns = false;
+    }
+    ~SharedLockBase()
+    {
+        if (fOwns)
+            pmutex->unlock_shared();
+    }
+
+    SharedLockBase& operator=(SharedLockBase&& other)
+    {
+        if (fOwns)
+            pmutex->unlock_shared();
+        pmutex = other.pmutex;
+        fOwns = other.fOwns;
+        other.pmutex = nullptr;
+        other.fOwns = false;
+        return *this;
+    }
+
+    void lock()
+    {
+        pmutex->lock_shared();
+        fOwns = true;
+    }
+
+    bool try_lock()
+    {
+        fOwns = pmutex->try_lock_shared();
+        return fOwns;
+    }
+
+    void unlock()
+    {
+        pmutex->unlock_shared();
+        fOwns = false;
+    }
+
+    bool owns_lock() const { return fOwns; }
+    PARENT* mutex() const { return pmutex; }
+};
+
+/**
+ * Wrapped mutex: readers share it, writers hold it exclusively. LOCK takes it
+ * exclusively, LOCK_SHARED in shared mode. Not recursive in either mode.
+ */
+class LOCKABLE SharedMutex : public AnnotatedMixin<boost::shared_mutex>
+{
+public:
+    void lock_shared() SHARED_LOCK_FUNCTION()
+    {
+        boost::shared_mutex::lock_shared();
+    }
+
+    void unlock_shared() UNLOCK_FUNCTION()
+    {
+        boost::shared_mutex::unlock_shared();
+    }
+
+    bool try_lock_shared() SHARED_TRYLOCK_FUNCTION(true)
+    {
+        return boost::shared_mutex::try_lock_shared();
+    }
+
+    using SharedLock = SharedLockBase<boost::shared_mutex>;
+};
+
 #ifdef DEBUG_LOCKCONTENTION
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+/**
+ * Lock contention statistics (-lockstats). While enabled, one in every
+ * -lockstatssamplerate acquisitions made by LOCK/TRY_LOCK on each thread is
+ * timed: how long the caller waited, whether the mutex was already taken and
+ * how long it was then held. Samples are aggregated per call site.
+ */
+extern std::atomic<bool> g_lock_stats_enabled;
+//! -lockstatssamplerate default
+static const unsigned int DEFAULT_LOCK_STATS_SAMPLE_RATE = 16;
+
+/** Totals for the sampled acquisitions made at one LOCK/TRY_LOCK call site */
+struct CLockSiteStats {
+    std::string strName;
+    std::string strFile;
+    int nLine;
+    const void* cs;
+    uint64_t nSamples;
+    uint64_t nContended;
+    uint64_t nTryFailed;
+    int64_t nWaitMicros;
+    int64_t nWaitMaxMicros;
+    int64_t nHoldMicros;
+    int64_t nHoldMaxMicros;
+
+    CLockSiteStats() : nLine(0), cs(nullptr), nSamples(0), nContended(0), nTryFailed(0), nWaitMicros(0), nWaitMaxMicros(0), nHoldMicros(0), nHoldMaxMicros(0) {}
+};
+
+void SetLockStatsSampleRate(unsigned int nRate);
+unsigned int GetLockStatsSampleRate();
+bool LockStatsSample();
+int64_t LockStatsTime();
+void LockStatsRecord(const char* pszName, const char* pszFile, int nLine, const void* cs, bool fContended, int64_t nWaitMicros, int64_t nHoldMicros);
+void LockStatsRecordTryFailed(const char* pszName, const char* pszFile, int nLine, const void* cs);
+std::vector<CLockSiteStats> GetLockStats();
+void ResetLockStats();
+
 /** Wrapper around std::unique_lock style lock for Mutex. */
 template <typename Mutex, typename Base = typename Mutex::UniqueLock>
 class SCOPED_LOCKABLE UniqueLock  : public Base
 {
 private:
+    //! Call site of an acquisition sampled for -lockstats, NULL when not sampled
+    const char* pszStatsName = nullptr;
+    const char* pszStatsFile = nullptr;
+    int nStatsLine = 0;
+    bool fStatsContended = false;
+    int64_t nStatsWaitMicros = 0;
+    int64_t nStatsLockedMicros = 0;
+
+    static bool SampleLockStats()
+    {
+        return g_lock_stats_enabled.load(std::memory_order_relaxed) && LockStatsSample();
+    }
+
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(Base::mutex()));
+        if (SampleLockStats()) {
+            EnterSampled(pszName, pszFile, nLine);
+            return;
+        }
 #ifdef DEBUG_LOCKCONTENTION
         if (!Base::try_lock()) {
             PrintLockContention(pszName, pszFile, nLine);
@@ -133,12 +283,39 @@ private:
 #endif
     }
 
+    void EnterSampled(const char* pszName, const char* pszFile, int nLine)
+    {
+        int64_t nStart = LockStatsTime();
+        fStatsContended = !Base::try_lock();
+        if (fStatsContended) {
+#ifdef DEBUG_LOCKCONTENTION
+            PrintLockContention(pszName, pszFile, nLine);
+#endif
+            Base::lock();
+        }
+        pszStatsName = pszName;
+        pszStatsFile = pszFile;
+        nStatsLine = nLine;
+        nStatsLockedMicros = LockStatsTime();
+        nStatsWaitMicros = nStatsLockedMicros - nStart;
+    }
+
     bool TryEnter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(Base::mutex()), true);
         Base::try_lock();
         if (!Base::owns_lock())
             LeaveCritical();
+        if (SampleLockStats()) {
+            if (!Base::owns_lock()) {
+                LockStatsRecordTryFailed(pszName, pszFile, nLine, Base::mutex());
+            } else {
+                pszStatsName = pszName;
+                pszStatsFile = pszFile;
+                nStatsLine = nLine;
+                nStatsLockedMicros = LockStatsTime();
+            }
+        }
         return Base::owns_lock();
     }
 
@@ -164,8 +341,11 @@ public:
 
     ~UniqueLock() UNLOCK_FUNCTION()
     {
-        if (Base::owns_lock())
+        if (Base::owns_lock()) {
+            if (pszStatsName)
+                LockStatsRecord(pszStatsName, pszStatsFile, nStatsLine, Base::mutex(), fStatsContended, nStatsWaitMicros, LockStatsTime() - nStatsLockedMicros);
             LeaveCritical();
+        }
     }
 
     operator bool()
@@ -177,7 +357,12 @@ public:
 template<typename MutexArg>
 using DebugLock = UniqueLock<typename std::remove_reference<typename std::remove_pointer<MutexArg>::type>::type>;
 
+template<typename MutexArg>
+using DebugSharedLock = UniqueLock<typename std::remove_reference<typename std::remove_pointer<MutexArg>::type>::type,
+                                   typename std::remove_reference<typename std::remove_pointer<MutexArg>::type>::type::SharedLock>;
+
 #define LOCK(cs) DebugLock<decltype(cs)> PASTE2(criticalblock, __COUNTER__)(cs, #cs, __FILE__, __LINE__)
+#define LOCK_SHARED(cs) DebugSharedLock<decltype(cs)> PASTE2(criticalblock, __COUNTER__)(cs, #cs, __FILE__, __LINE__)
 #define LOCK2(cs1, cs2)                                               \
     DebugLock<decltype(cs1)> criticalblock1(cs1, #cs1, __FILE__, __LINE__); \
     DebugLock<decltype(cs2)> criticalblock2(cs2, #cs2, __FILE__, __LINE__);
@@ -5,32 +5,22 @@
 #include "test/test_dogecash.h"
 #include <string>
 #include <boost/test/unit_test.hpp>
-#include <crypto/common.h> // for ReadLE64
 
 #include "hash.h"
 #include "random.h"
 
 class CAddrManTest : public CAddrMan
 {
-    uint64_t state;
-
 public:
-    CAddrManTest()
-    {
-        state = 1;
-    }
-
     //! Ensure that bucket placement is always the same for testing purposes.
     void MakeDeterministic()
     {
         nKey.SetNull();
-        seed_insecure_rand(true);
     }
 
-    int RandomInt(int nMax)
+    int Check()
     {
-        state = ReadLE64((CHashWriter(SER_GETHASH, 0) << state).GetHash().begin());
-        return (unsigned int)(state % nMax);
+        return CAddrMan::Check_();
     }
 
     CAddrInfo* Find(const CNetAddr& addr, int* pnId = NULL)
@@ -118,8 +108,7 @@ BOOST_AUTO_TEST_CASE(addrman_ports)
     //  Perhaps this is not ideal behavior but it is the current behavior.
     addrman.Good(CAddress(addr1_port));
     BOOST_CHECK(addrman.size() == 1);
-    bool newOnly = true;
-    CAddrInfo addr_ret3 = addrman.Select(newOnly);
+    CAddrInfo addr_ret3 = addrman.Select();
     BOOST_CHECK(addr_ret3.ToString() == "250.1.1.1:8333");
 }
 
@@ -138,16 +127,12 @@ BOOST_AUTO_TEST_CASE(addrman_select)
     addrman.Add(CAddress(addr1), source);
     BOOST_CHECK(addrman.size() == 1);
 
-    bool newOnly = true;
-    CAddrInfo addr_ret1 = addrman.Select(newOnly);
+    CAddrInfo addr_ret1 = addrman.Select();
     BOOST_CHECK(addr_ret1.ToString() == "250.1.1.1:8333");
 
-    // Test 10: move addr to tried, select from new expected nothing returned.
+    // Test 10: move addr to tried, it is still selected.
     addrman.Good(CAddress(addr1));
     BOOST_CHECK(addrman.size() == 1);
-    CAddrInfo addr_ret2 = addrman.Select(newOnly);
-    BOOST_CHECK(addr_ret2.ToString() == "[::]:0");
-
     CAddrInfo addr_ret3 = addrman.Select();
     BOOST_CHECK(addr_ret3.ToString() == "250.1.1.1:8333");
 
@@ -179,10 +164,21 @@ BOOST_AUTO_TEST_CASE(addrman_select)
     BOOST_CHECK(addrman.size() == 7);
 
     // Test 12: Select pulls from new and tried regardless of port number.
-    BOOST_CHECK(addrman.Select().ToString() == "250.4.6.6:8333");
-    BOOST_CHECK(addrman.Select().ToString() == "250.3.2.2:9999");
-    BOOST_CHECK(addrman.Select().ToString() == "250.3.3.3:9999");
-    BOOST_CHECK(addrman.Select().ToString() == "250.4.4.4:8333");
+    std::set<std::string> setAdded;
+    setAdded.insert(addr1.ToString());
+    setAdded.insert(addr2.ToString());
+    setAdded.insert(addr3.ToString());
+    setAdded.insert(addr4.ToString());
+    setAdded.insert(addr5.ToString());
+    setAdded.insert(addr6.ToString());
+    setAdded.insert(addr7.ToString());
+    std::set<std::string> setSelected;
+    for (int i = 0; i < 1000; i++) {
+        std::string strSelected = addrman.Select().ToString();
+        BOOST_CHECK(setAdded.count(strSelected));
+        setSelected.insert(strSelected);
+    }
+    BOOST_CHECK(setSelected == setAdded);
 }
 
 BOOST_AUTO_TEST_CASE(addrman_new_collisions)
@@ -517,4 +513,44 @@ BOOST_AUTO_TEST_CASE(caddrinfo_get_new_bucket)
     //  than 64 buckets.
     BOOST_CHECK(buckets.size() > 64);
 }
+BOOST_AUTO_TEST_CASE(addrman_consistency_and_changes)
+{
+    CAddrManTest addrman;
+    CNetAddr source = CNetAddr("252.2.2.2");
+    BOOST_CHECK_EQUAL(addrman.Check(), 0);
+
+    for (int i = 1; i < 200; i++) {
+        CAddress addr = CAddress(CService("250." + boost::to_string(i % 16) + ".1." + boost::to_string(i), 8333));
+        addr.nTime = GetAdjustedTime();
+        addrman.Add(addr, source);
+        if (i % 3 == 0)
+            addrman.Good(addr);
+        if (i % 5 == 0)
+            addrman.Attempt(addr);
+    }
+    BOOST_CHECK_EQUAL(addrman.Check(), 0);
+
+    // only calls that touch a serialized entry count as changes
+    CAddress addrKnown = CAddress(CService("251.1.1.1", 8333));
+    CService addrUnknown = CService("250.99.99.99", 8333);
+    BOOST_CHECK(addrman.Add(addrKnown, CNetAddr("253.3.3.3")));
+    uint64_t nChanges = addrman.GetChangeCount();
+    addrman.Attempt(addrUnknown);
+    addrman.Good(addrUnknown);
+    BOOST_CHECK_EQUAL(addrman.GetChangeCount(), nChanges);
+    addrman.Attempt(addrKnown);
+    BOOST_CHECK_EQUAL(addrman.GetChangeCount(), nChanges + 1);
+    addrman.Good(addrKnown);
+    BOOST_CHECK_EQUAL(addrman.GetChangeCount(), nChanges + 2);
+    BOOST_CHECK_EQUAL(addrman.Check(), 0);
+
+    // the tables survive a round trip
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << addrman;
+    CAddrManTest addrmanLoaded;
+    ss >> addrmanLoaded;
+    BOOST_CHECK_EQUAL(addrmanLoaded.size(), addrman.size());
+    BOOST_CHECK_EQUAL(addrmanLoaded.Check(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -279,6 +279,23 @@ BOOST_AUTO_TEST_CASE(merkle_block_2)
     BOOST_CHECK(vMatched.size() == merkleBlock.vMatchedTxn.size());
     for (unsigned int i = 0; i < vMatched.size(); i++)
         BOOST_CHECK(vMatched[i] == merkleBlock.vMatchedTxn[i].second);
+
+    // Matching against the block data extracted once for all peers gives the same merkle block and filter updates
+    CBloomFilter filterBlock(10, 0.000001, 0, BLOOM_UPDATE_ALL);
+    filterBlock.insert(uint256("0xe980fe9f792d014e73b95203dc1335c5f9ce19ac537a419e6df5b47aecb93b70"));
+    filterBlock.insert(ParseHex("044a656f065871a353f216ca26cef8dde2f03e8c16202d2e8ad769f02032cb86a5eb5e56842e92e19141d60a01928f8dd2c875a390f67c1f6c94cfc617c0ea45af"));
+    CBloomFilter filterShared = filterBlock;
+
+    CBloomBlockData blockData(block);
+    CMerkleBlock merkleBlockFromBlock(block, filterBlock);
+    CMerkleBlock merkleBlockShared(blockData, filterShared);
+    BOOST_CHECK(merkleBlockShared.vMatchedTxn == merkleBlock.vMatchedTxn);
+    BOOST_CHECK(merkleBlockShared.vMatchedTxn == merkleBlockFromBlock.vMatchedTxn);
+
+    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION), ssShared(SER_NETWORK, PROTOCOL_VERSION);
+    ssBlock << merkleBlockFromBlock << filterBlock;
+    ssShared << merkleBlockShared << filterShared;
+    BOOST_CHECK(ssBlock.str() == ssShared.str());
 }
 
 BOOST_AUTO_TEST_CASE(merkle_block_2_with_update_none)
@@ -3,6 +3,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "masternode-budget.h"
+#include "masternodeman.h"
+#include "streams.h"
 #include "tinyformat.h"
 #include "utilmoneystr.h"
 
@@ -29,4 +31,55 @@ BOOST_AUTO_TEST_CASE(budget_value)
     CheckBudgetValue(nHeightTest, "mainnet", 43200*COIN);
 }
 
+static CTxIn VoterIn(unsigned char n)
+{
+    uint256 hash;
+    *hash.begin() = n;
+    return CTxIn(COutPoint(hash, 0));
+}
+
+BOOST_AUTO_TEST_CASE(budget_vote_tallies)
+{
+    CBudgetProposal proposal;
+    std::string strError;
+    int nVotes[] = {VOTE_YES, VOTE_YES, VOTE_YES, VOTE_NO, VOTE_ABSTAIN};
+    for (unsigned char i = 0; i < 5; i++) {
+        CBudgetVote vote(VoterIn(i), proposal.GetHash(), nVotes[i]);
+        vote.nTime = GetTime() - BUDGET_VOTE_UPDATE_MIN - 60;
+        BOOST_CHECK(proposal.AddOrUpdateVote(vote, strError));
+    }
+    BOOST_CHECK_EQUAL(proposal.GetYeas(), 3);
+    BOOST_CHECK_EQUAL(proposal.GetNays(), 1);
+    BOOST_CHECK_EQUAL(proposal.GetAbstains(), 1);
+
+    // a replaced vote moves between the tallies
+    CBudgetVote voteChanged(VoterIn(0), proposal.GetHash(), VOTE_NO);
+    BOOST_CHECK(proposal.AddOrUpdateVote(voteChanged, strError));
+    BOOST_CHECK_EQUAL(proposal.GetYeas(), 2);
+    BOOST_CHECK_EQUAL(proposal.GetNays(), 2);
+
+    // tallies are rebuilt on load
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << proposal;
+    CBudgetProposal proposalLoaded;
+    ss >> proposalLoaded;
+    BOOST_CHECK_EQUAL(proposalLoaded.GetYeas(), 2);
+    BOOST_CHECK_EQUAL(proposalLoaded.GetNays(), 2);
+    BOOST_CHECK_EQUAL(proposalLoaded.GetAbstains(), 1);
+
+    // only votes of listed masternodes count, and they are only revalidated when the list changes
+    CMasternode mn;
+    mn.vin = VoterIn(1);
+    BOOST_CHECK(mnodeman.Add(mn));
+    BOOST_CHECK(proposal.CleanAndRemove());
+    BOOST_CHECK_EQUAL(proposal.GetYeas(), 1);
+    BOOST_CHECK_EQUAL(proposal.GetNays(), 0);
+    BOOST_CHECK_EQUAL(proposal.GetAbstains(), 0);
+    BOOST_CHECK(!proposal.CleanAndRemove());
+
+    mnodeman.Remove(mn.vin);
+    BOOST_CHECK(proposal.CleanAndRemove());
+    BOOST_CHECK_EQUAL(proposal.GetYeas(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
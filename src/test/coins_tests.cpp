@@ -3,7 +3,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "coins.h"
+#include "main.h"
 #include "script/standard.h"
+#include "txdb.h"
 #include "uint256.h"
 #include "test/test_dogecash.h"
 #include "utilstrencodings.h"
@@ -71,7 +73,8 @@ static const unsigned int NUM_SIMULATION_ITERATIONS = 40000;
 //
 // It will randomly create/update/delete CCoins entries to a tip of caches, with
 // txids picked from a limited list of random 256-bit hashes. Occasionally, a
-// new tip is added to the stack of caches, or the tip is flushed and removed.
+// new tip is added to the stack of caches, or the tip is flushed and removed,
+// or the tip is flushed while keeping part of its entries cached.
 //
 // During the process, booleans are kept to make sure that the randomized
 // operation hits all branches.
@@ -85,6 +88,7 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
     bool updated_an_entry = false;
     bool found_an_entry = false;
     bool missed_an_entry = false;
+    bool flushed_partially = false;
 
     // A simple map to track what we expect the cache stack to represent.
     std::map<uint256, CCoins> result;
@@ -145,6 +149,9 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
                 stack.back()->Flush();
                 delete stack.back();
                 stack.pop_back();
+            } else if (stack.size() > 0 && InsecureRandRange(4) == 0) {
+                stack.back()->Flush(InsecureRandRange(stack.back()->GetCacheSize() + 1));
+                flushed_partially = true;
             }
             if (stack.size() == 0 || (stack.size() < 4 && InsecureRandBool())) {
                 CCoinsView* tip = &base;
@@ -175,6 +182,120 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
     BOOST_CHECK(updated_an_entry);
     BOOST_CHECK(found_an_entry);
     BOOST_CHECK(missed_an_entry);
+    BOOST_CHECK(flushed_partially);
+}
+
+BOOST_FIXTURE_TEST_CASE(coins_write_behind, TestingSetup)
+{
+    CCoinsViewDB db(1 << 20, true);
+    CCoinsViewWriteBehind writer(&db);
+    CCoinsViewCache cache(&writer);
+
+    std::vector<uint256> txids;
+    for (int i = 0; i < 100; i++) {
+        uint256 txid = InsecureRand256();
+        CCoinsModifier coins = cache.ModifyCoins(txid);
+        coins->nVersion = 1;
+        coins->vout.resize(1);
+        coins->vout[0].nValue = i + 1;
+        txids.push_back(txid);
+    }
+    uint256 hashBlock = InsecureRand256();
+    cache.SetBestBlock(hashBlock);
+
+    // Hand all modified coins to the writer, keeping half of them cached.
+    CCoinsMap mapDirty;
+    cache.DetachDirty(mapDirty, 50);
+    BOOST_CHECK_EQUAL(mapDirty.size(), 100U);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 50U);
+    BOOST_CHECK(writer.WriteAsync(mapDirty, hashBlock));
+    BOOST_CHECK(mapDirty.empty());
+
+    // Whether or not the write has finished, all coins are visible through the writer.
+    BOOST_CHECK(writer.GetBestBlock() == hashBlock);
+    for (int i = 0; i < 100; i++) {
+        CCoins coins;
+        BOOST_CHECK(writer.GetCoins(txids[i], coins));
+        BOOST_CHECK_EQUAL(coins.vout[0].nValue, i + 1);
+    }
+
+    BOOST_CHECK(writer.WaitForWrite());
+    BOOST_CHECK(!writer.IsWriting());
+    BOOST_CHECK(db.GetBestBlock() == hashBlock);
+    for (int i = 0; i < 100; i++)
+        BOOST_CHECK(db.HaveCoins(txids[i]));
+
+    // Spending a coin and flushing synchronously erases it from the database.
+    cache.ModifyCoins(txids[0])->Clear();
+    BOOST_CHECK(cache.Flush(10));
+    BOOST_CHECK(cache.GetCacheSize() <= 10);
+    BOOST_CHECK(!db.HaveCoins(txids[0]));
+    BOOST_CHECK(!writer.HaveCoins(txids[0]));
+    BOOST_CHECK(writer.HaveCoins(txids[1]));
+
+    // Retained entries and the detached batch together stay within the given total.
+    for (int i = 1; i < 41; i++)
+        cache.ModifyCoins(txids[i])->vout[0].nValue = 1000 + i;
+    BOOST_CHECK(cache.GetCacheSize() >= 40U);
+    cache.DetachDirty(mapDirty, 50, 60);
+    BOOST_CHECK_EQUAL(mapDirty.size(), 40U);
+    BOOST_CHECK(cache.GetCacheSize() <= 20U);
+    BOOST_CHECK(writer.WriteAsync(mapDirty, hashBlock));
+    BOOST_CHECK(writer.GetWritingSize() == 0 || writer.GetWritingSize() == 40);
+    BOOST_CHECK(writer.WaitForWrite());
+    BOOST_CHECK_EQUAL(writer.GetWritingSize(), 0U);
+    CCoins coins;
+    BOOST_CHECK(db.GetCoins(txids[40], coins));
+    BOOST_CHECK_EQUAL(coins.vout[0].nValue, 1040);
+}
+
+BOOST_FIXTURE_TEST_CASE(coins_write_behind_headroom, TestingSetup)
+{
+    CCoinsViewDB db(1 << 20, true);
+    CCoinsViewWriteBehind writer(&db);
+    CCoinsViewCache cache(&writer);
+    const size_t nLimit = 100;
+    auto addCoins = [&cache](int nCount) {
+        for (int i = 0; i < nCount; i++) {
+            CCoinsModifier coins = cache.ModifyCoins(InsecureRand256());
+            coins->nVersion = 1;
+            coins->vout.resize(1);
+            coins->vout[0].nValue = 1;
+        }
+    };
+
+    // a block fills the cache past the limit with modified coins, as during initial sync
+    addCoins(101);
+    BOOST_CHECK(CoinsCacheFlushNeeded(cache.GetCacheSize(), 0, nLimit));
+
+    // the flush detaches more than half of the limit, so nothing stays cached
+    CCoinsMap mapDirty;
+    cache.DetachDirty(mapDirty, 80, nLimit / 2);
+    const size_t nWriting = mapDirty.size();
+    BOOST_CHECK_EQUAL(nWriting, 101U);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+
+    // blocks connected while the batch is written do not flush, and wait for it,
+    // until they have filled the other half of the cache
+    int nBlocks = 0;
+    while (!CoinsCacheFlushNeeded(cache.GetCacheSize(), nWriting, nLimit)) {
+        addCoins(10);
+        nBlocks++;
+    }
+    BOOST_CHECK_EQUAL(nBlocks, 6);
+    BOOST_CHECK(cache.GetCacheSize() > nLimit / 2);
+    BOOST_CHECK(writer.WriteAsync(mapDirty, InsecureRand256()));
+
+    // with few modified coins, part of the cache is retained and the headroom is the same
+    BOOST_CHECK(cache.Flush(nLimit));
+    addCoins(20);
+    cache.DetachDirty(mapDirty, 80, nLimit / 2);
+    BOOST_CHECK_EQUAL(mapDirty.size(), 20U);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 30U);
+    BOOST_CHECK(!CoinsCacheFlushNeeded(cache.GetCacheSize() + 50, mapDirty.size(), nLimit));
+    BOOST_CHECK(CoinsCacheFlushNeeded(cache.GetCacheSize() + 51, mapDirty.size(), nLimit));
+    BOOST_CHECK(writer.WriteAsync(mapDirty, InsecureRand256()));
+    BOOST_CHECK(writer.WaitForWrite());
 }
 
 BOOST_AUTO_TEST_CASE(ccoins_serialization)
@@ -0,0 +1,137 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "kernel.h"
+#include "main.h"
+#include "test/test_dogecash.h"
+
+#include <list>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(kernel_tests, BasicTestingSetup)
+
+//! Append nBlocks synthetic blocks, one to two minutes apart, on top of pindexFork
+static void BuildChain(std::list<uint256>& lHashes, std::list<CBlockIndex>& lIndex, CBlockIndex* pindexFork, int nBlocks)
+{
+    CBlockIndex* pindexPrev = pindexFork;
+    for (int i = 0; i < nBlocks; i++) {
+        lHashes.push_back(InsecureRand256());
+        lIndex.push_back(CBlockIndex());
+        CBlockIndex* pindex = &lIndex.back();
+        pindex->phashBlock = &lHashes.back();
+        pindex->pprev = pindexPrev;
+        pindex->nHeight = pindexPrev ? pindexPrev->nHeight + 1 : 0;
+        pindex->nTime = pindexPrev ? pindexPrev->nTime + 60 + InsecureRandRange(60) : 1500000000;
+        if (pindex->nHeight > 0 && InsecureRandBool())
+            pindex->SetProofOfStake();
+        uint64_t nStakeModifier = 0;
+        bool fGeneratedStakeModifier = false;
+        BOOST_CHECK(ComputeNextStakeModifier(pindexPrev, nStakeModifier, fGeneratedStakeModifier));
+        pindex->SetStakeModifier(nStakeModifier, fGeneratedStakeModifier);
+        mapBlockIndex[pindex->GetBlockHash()] = pindex;
+        pindexPrev = pindex;
+    }
+}
+
+//! The v1 modifier computed the straightforward way, hashing every candidate in every round
+static uint64_t ReferenceStakeModifier(const CBlockIndex* pindexPrev, uint64_t nStakeModifierPrev)
+{
+    std::vector<std::pair<int64_t, const CBlockIndex*> > vCandidates;
+    int64_t nSelectionIntervalStart = (pindexPrev->GetBlockTime() / MODIFIER_INTERVAL) * MODIFIER_INTERVAL - 2087;
+    for (const CBlockIndex* pindex = pindexPrev; pindex && pindex->GetBlockTime() >= nSelectionIntervalStart; pindex = pindex->pprev)
+        vCandidates.push_back(std::make_pair(pindex->GetBlockTime(), pindex));
+    std::sort(vCandidates.begin(), vCandidates.end(), [](const std::pair<int64_t, const CBlockIndex*>& a, const std::pair<int64_t, const CBlockIndex*>& b) {
+        return a.first < b.first || (a.first == b.first && a.second->GetBlockHash() < b.second->GetBlockHash());
+    });
+
+    bool fModifierV2 = vCandidates[0].second->nHeight >= Params().ModifierUpgradeBlock();
+    std::set<const CBlockIndex*> setSelected;
+    uint64_t nStakeModifierNew = 0;
+    int64_t nSelectionIntervalStop = nSelectionIntervalStart;
+    for (int nRound = 0; nRound < std::min(64, (int)vCandidates.size()); nRound++) {
+        nSelectionIntervalStop += MODIFIER_INTERVAL * 63 / (63 + ((63 - nRound) * (MODIFIER_INTERVAL_RATIO - 1)));
+        const CBlockIndex* pindexBest = NULL;
+        uint256 hashBest = 0;
+        for (const std::pair<int64_t, const CBlockIndex*>& item : vCandidates) {
+            if (pindexBest && item.first > nSelectionIntervalStop)
+                break;
+            if (setSelected.count(item.second))
+                continue;
+            uint256 hashProof = (fModifierV2 || !item.second->IsProofOfStake()) ? item.second->GetBlockHash() : 0;
+            CDataStream ss(SER_GETHASH, 0);
+            ss << hashProof << nStakeModifierPrev;
+            uint256 hashSelection = Hash(ss.begin(), ss.end());
+            if (item.second->IsProofOfStake())
+                hashSelection >>= 32;
+            if (!pindexBest || hashSelection < hashBest) {
+                pindexBest = item.second;
+                hashBest = hashSelection;
+            }
+        }
+        setSelected.insert(pindexBest);
+        nStakeModifierNew |= (((uint64_t)pindexBest->GetStakeEntropyBit()) << nRound);
+    }
+    return nStakeModifierNew;
+}
+
+BOOST_AUTO_TEST_CASE(stake_modifier_selection)
+{
+    std::list<uint256> lHashes;
+    std::list<CBlockIndex> lIndex;
+    BuildChain(lHashes, lIndex, NULL, 300);
+
+    // Every generated modifier matches the reference computation from the previous one.
+    int nGenerated = 0;
+    uint64_t nStakeModifierPrev = 0;
+    for (const CBlockIndex& index : lIndex) {
+        if (index.nHeight > 1 && index.GeneratedStakeModifier()) {
+            BOOST_CHECK_EQUAL(index.nStakeModifier, ReferenceStakeModifier(index.pprev, nStakeModifierPrev));
+            nGenerated++;
+        }
+        if (index.GeneratedStakeModifier())
+            nStakeModifierPrev = index.nStakeModifier;
+    }
+    BOOST_CHECK(nGenerated > 100);
+
+    for (const uint256& hash : lHashes)
+        mapBlockIndex.erase(hash);
+}
+
+BOOST_AUTO_TEST_CASE(kernel_stake_modifier_cache)
+{
+    std::list<uint256> lHashes;
+    std::list<CBlockIndex> lIndex;
+    BuildChain(lHashes, lIndex, NULL, 200);
+    chainActive.SetTip(&lIndex.back());
+
+    // A cached lookup returns the same modifier as the first one.
+    const CBlockIndex* pindexFrom = chainActive[120];
+    uint64_t nStakeModifier1 = 0, nStakeModifier2 = 0;
+    int nHeight1 = 0, nHeight2 = 0;
+    int64_t nTime1 = 0, nTime2 = 0;
+    BOOST_CHECK(GetKernelStakeModifier(pindexFrom->GetBlockHash(), nStakeModifier1, nHeight1, nTime1, false));
+    BOOST_CHECK(GetKernelStakeModifier(pindexFrom->GetBlockHash(), nStakeModifier2, nHeight2, nTime2, false));
+    BOOST_CHECK_EQUAL(nStakeModifier1, nStakeModifier2);
+    BOOST_CHECK_EQUAL(nHeight1, nHeight2);
+    BOOST_CHECK_EQUAL(nTime1, nTime2);
+    BOOST_CHECK(nHeight1 > pindexFrom->nHeight && nHeight1 <= 200);
+    BOOST_CHECK(nTime1 >= pindexFrom->GetBlockTime() + 2087);
+
+    // After a reorg below the modifier block, the lookup follows the new chain.
+    BuildChain(lHashes, lIndex, chainActive[pindexFrom->nHeight + 1], 150);
+    chainActive.SetTip(&lIndex.back());
+    BOOST_CHECK(GetKernelStakeModifier(pindexFrom->GetBlockHash(), nStakeModifier2, nHeight2, nTime2, false));
+    BOOST_CHECK(chainActive[nHeight2]->GeneratedStakeModifier());
+    BOOST_CHECK_EQUAL(nTime2, chainActive[nHeight2]->GetBlockTime());
+    BOOST_CHECK(nTime2 >= pindexFrom->GetBlockTime() + 2087);
+    BOOST_CHECK(nHeight1 != nHeight2 || nTime1 != nTime2 || nStakeModifier1 != nStakeModifier2);
+
+    chainActive.SetTip(NULL);
+    for (const uint256& hash : lHashes)
+        mapBlockIndex.erase(hash);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,7 @@
 #include "key.h"
 
 #include "base58.h"
+#include "messagesigner.h"
 #include "script/script.h"
 #include "uint256.h"
 #include "util.h"
@@ -188,4 +189,30 @@ BOOST_AUTO_TEST_CASE(key_test1)
     BOOST_CHECK(detsigc == ParseHex("1f4f304f1b05599f88bc517819f6d43c69503baea5f253c55ea2d791394f7ce0de4f23c0d4c1f4d7a89bf130fed755201d22581911a8a44cf594014794231d325a"));
 }
 
+BOOST_AUTO_TEST_CASE(hashsigner_recovered_key_cache)
+{
+    CKey key, keyOther;
+    key.MakeNewKey(true);
+    keyOther.MakeNewKey(true);
+    uint256 hash = GetRandHash();
+
+    std::vector<unsigned char> vchSig;
+    BOOST_CHECK(CHashSigner::SignHash(hash, key, vchSig));
+
+    // the second verification is served from the cache and must agree with the first
+    std::string strError;
+    for (int i = 0; i < 2; i++) {
+        BOOST_CHECK(CHashSigner::VerifyHash(hash, key.GetPubKey(), vchSig, strError));
+        BOOST_CHECK(!CHashSigner::VerifyHash(hash, keyOther.GetPubKey(), vchSig, strError));
+    }
+
+    CKeyID keyID;
+    BOOST_CHECK(CHashSigner::RecoverKeyID(hash, vchSig, keyID));
+    BOOST_CHECK(keyID == key.GetPubKey().GetID());
+
+    // a different hash must not reuse the cached key
+    uint256 hashOther = GetRandHash();
+    BOOST_CHECK(!CHashSigner::VerifyHash(hashOther, key.GetPubKey(), vchSig, strError));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
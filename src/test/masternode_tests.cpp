@@ -0,0 +1,238 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "masternodeman.h"
+#include "txmempool.h"
+#include "util.h"
+#include "validationinterface.h"
+
+#include "test/test_dogecash.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(masternode_tests, BasicTestingSetup)
+
+static CTxIn CollateralIn(unsigned char n)
+{
+    uint256 hash;
+    *hash.begin() = n;
+    return CTxIn(COutPoint(hash, 0));
+}
+
+static CTransaction SpendOf(const CTxIn& vin)
+{
+    CMutableTransaction tx;
+    tx.vin.push_back(CTxIn(vin.prevout));
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 1 * COIN;
+    tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    return tx;
+}
+
+BOOST_AUTO_TEST_CASE(collateral_watcher_block)
+{
+    CMasternodeCollateralWatcher watcher;
+    RegisterValidationInterface(&watcher);
+
+    CTxIn vin = CollateralIn(1);
+    CTransaction tx = SpendOf(vin);
+    CBlock block;
+    block.vtx.push_back(tx);
+
+    // spends of collaterals nobody watches are not recorded
+    GetMainSignals().SyncTransaction(tx, &block);
+    BOOST_CHECK_EQUAL(watcher.size(), 0U);
+    BOOST_CHECK(watcher.GetState(vin) == CMasternodeCollateralWatcher::COLLATERAL_UNKNOWN);
+
+    watcher.Watch(vin);
+    BOOST_CHECK(watcher.GetState(vin) == CMasternodeCollateralWatcher::COLLATERAL_UNKNOWN);
+    GetMainSignals().SyncTransaction(tx, &block);
+    BOOST_CHECK(watcher.GetState(vin) == CMasternodeCollateralWatcher::COLLATERAL_SPENT);
+
+    // a block spend is not undone by a mempool removal, only by disconnecting the block
+    GetMainSignals().TransactionRemovedFromMempool(tx);
+    BOOST_CHECK(watcher.GetState(vin) == CMasternodeCollateralWatcher::COLLATERAL_SPENT);
+    GetMainSignals().BlockDisconnected(block);
+    BOOST_CHECK(watcher.GetState(vin) == CMasternodeCollateralWatcher::COLLATERAL_UNKNOWN);
+
+    // the disconnected spend being announced without a block while not in the mempool changes nothing
+    GetMainSignals().SyncTransaction(tx, NULL);
+    BOOST_CHECK(watcher.GetState(vin) == CMasternodeCollateralWatcher::COLLATERAL_UNKNOWN);
+
+    watcher.Forget(vin);
+    BOOST_CHECK_EQUAL(watcher.size(), 0U);
+    UnregisterValidationInterface(&watcher);
+}
+
+BOOST_AUTO_TEST_CASE(collateral_watcher_mempool)
+{
+    CMasternodeCollateralWatcher watcher;
+    RegisterValidationInterface(&watcher);
+
+    CTxIn vin = CollateralIn(2);
+    CTransaction tx = SpendOf(vin);
+    watcher.Watch(vin);
+
+    mempool.addUnchecked(tx.GetHash(), CTxMemPoolEntry(tx, 0, 0, 0.0, 1));
+    GetMainSignals().SyncTransaction(tx, NULL);
+    BOOST_CHECK(watcher.GetState(vin) == CMasternodeCollateralWatcher::COLLATERAL_SPENT);
+
+    // the spend being mined keeps the collateral spent
+    CBlock block;
+    block.vtx.push_back(tx);
+    GetMainSignals().SyncTransaction(tx, &block);
+    GetMainSignals().TransactionRemovedFromMempool(tx);
+    BOOST_CHECK(watcher.GetState(vin) == CMasternodeCollateralWatcher::COLLATERAL_SPENT);
+
+    // a spend going back to the mempool on disconnect stays spent until it is evicted
+    GetMainSignals().SyncTransaction(tx, NULL);
+    GetMainSignals().BlockDisconnected(block);
+    BOOST_CHECK(watcher.GetState(vin) == CMasternodeCollateralWatcher::COLLATERAL_SPENT);
+
+    std::list<CTransaction> removed;
+    mempool.remove(tx, removed, true);
+    BOOST_CHECK_EQUAL(removed.size(), 1U);
+    BOOST_FOREACH (const CTransaction& txRemoved, removed)
+        GetMainSignals().TransactionRemovedFromMempool(txRemoved);
+    BOOST_CHECK(watcher.GetState(vin) == CMasternodeCollateralWatcher::COLLATERAL_UNKNOWN);
+
+    // removal of an unrelated transaction spending the same collateral leaves the recorded spender alone
+    mempool.addUnchecked(tx.GetHash(), CTxMemPoolEntry(tx, 0, 0, 0.0, 1));
+    GetMainSignals().SyncTransaction(tx, NULL);
+    CMutableTransaction txOther = SpendOf(vin);
+    txOther.vout[0].nValue = 2 * COIN;
+    GetMainSignals().TransactionRemovedFromMempool(txOther);
+    BOOST_CHECK(watcher.GetState(vin) == CMasternodeCollateralWatcher::COLLATERAL_SPENT);
+
+    // clearing the mempool, as the miner does after a failed block, reports what it dropped
+    removed.clear();
+    mempool.clear(removed);
+    BOOST_CHECK_EQUAL(removed.size(), 1U);
+    BOOST_FOREACH (const CTransaction& txRemoved, removed)
+        GetMainSignals().TransactionRemovedFromMempool(txRemoved);
+    BOOST_CHECK(watcher.GetState(vin) == CMasternodeCollateralWatcher::COLLATERAL_UNKNOWN);
+    UnregisterValidationInterface(&watcher);
+}
+
+BOOST_AUTO_TEST_CASE(collateral_watcher_follows_list)
+{
+    CMasternodeMan mnodemanTest;
+
+    CMasternode mn;
+    mn.vin = CollateralIn(3);
+    BOOST_CHECK(mnodemanTest.Add(mn));
+    BOOST_CHECK_EQUAL(mnodemanTest.collateralWatcher.size(), 1U);
+
+    // loading a list watches exactly its entries
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << mnodemanTest;
+    CMasternodeMan mnodemanLoaded;
+    ss >> mnodemanLoaded;
+    BOOST_CHECK_EQUAL(mnodemanLoaded.size(), 1);
+    BOOST_CHECK_EQUAL(mnodemanLoaded.collateralWatcher.size(), 1U);
+
+    mnodemanTest.Remove(mn.vin);
+    BOOST_CHECK_EQUAL(mnodemanTest.collateralWatcher.size(), 0U);
+    mnodemanLoaded.Clear();
+    BOOST_CHECK_EQUAL(mnodemanLoaded.collateralWatcher.size(), 0U);
+}
+
+// collaterals in rank order for a height, computed without the manager's caches
+static std::vector<CTxIn> RankedByScore(std::vector<CMasternode>& vmn, int nHeight)
+{
+    std::vector<std::pair<int64_t, size_t> > vScores;
+    for (size_t i = 0; i < vmn.size(); i++)
+        vScores.push_back(std::make_pair(-(int64_t)vmn[i].CalculateScore(1, nHeight).GetCompact(false), i));
+    std::sort(vScores.begin(), vScores.end());
+    std::vector<CTxIn> vRanked;
+    for (size_t i = 0; i < vScores.size(); i++)
+        vRanked.push_back(vmn[vScores[i].second].vin);
+    return vRanked;
+}
+
+static void CheckRanks(CMasternodeMan& mnodemanTest, std::vector<CMasternode>& vmn, int nHeight)
+{
+    std::vector<CTxIn> vRanked = RankedByScore(vmn, nHeight);
+    for (size_t i = 0; i < vRanked.size(); i++) {
+        BOOST_CHECK_EQUAL(mnodemanTest.GetMasternodeRank(vRanked[i], nHeight, 0, false), (int)i + 1);
+        CMasternode* pmn = mnodemanTest.GetMasternodeByRank(i + 1, nHeight, 0, false);
+        BOOST_CHECK(pmn != NULL && pmn->vin == vRanked[i]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(rank_cache_follows_chain_and_list)
+{
+    LOCK(cs_main);
+    CBlockIndex indexGenesis, indexOne, indexOneFork;
+    uint256 hashGenesis = GetRandHash(), hashOne = GetRandHash(), hashOneFork = GetRandHash();
+    indexGenesis.phashBlock = &hashGenesis;
+    indexOne.phashBlock = &hashOne;
+    indexOne.pprev = &indexGenesis;
+    indexOne.nHeight = 1;
+    indexOneFork = indexOne;
+    indexOneFork.phashBlock = &hashOneFork;
+    chainActive.SetTip(&indexOne);
+
+    CMasternodeMan mnodemanTest;
+    std::vector<CMasternode> vmn(8);
+    for (size_t i = 0; i < vmn.size(); i++) {
+        vmn[i].vin = CollateralIn(10 + i);
+        // old enough to be ranked
+        vmn[i].sigTime = GetAdjustedTime() - 24 * 60 * 60;
+        if (i < 6)
+            BOOST_CHECK(mnodemanTest.Add(vmn[i]));
+    }
+    std::vector<CMasternode> vListed(vmn.begin(), vmn.begin() + 6);
+    CheckRanks(mnodemanTest, vListed, 2);
+    // repeated queries are answered from the cache
+    CheckRanks(mnodemanTest, vListed, 2);
+
+    // a reorg replacing the block the scores derive from changes them
+    chainActive.SetTip(&indexOneFork);
+    CheckRanks(mnodemanTest, vListed, 2);
+
+    // changes to the list drop the cached tables
+    BOOST_CHECK(mnodemanTest.Add(vmn[6]));
+    BOOST_CHECK(mnodemanTest.Add(vmn[7]));
+    CheckRanks(mnodemanTest, vmn, 2);
+    mnodemanTest.Remove(vmn[0].vin);
+    BOOST_CHECK_EQUAL(mnodemanTest.GetMasternodeRank(vmn[0].vin, 2, 0, false), -1);
+    vmn.erase(vmn.begin());
+    CheckRanks(mnodemanTest, vmn, 2);
+
+    chainActive.SetTip(NULL);
+}
+
+BOOST_FIXTURE_TEST_CASE(cache_file_round_trip, TestingSetup)
+{
+    CMasternodeDB mndb;
+    BOOST_CHECK(mndb.VerifyHeader() == CMasternodeDB::FileError);
+
+    CMasternodeMan mnodemanSaved;
+    CMasternode mn;
+    mn.vin = CollateralIn(5);
+    BOOST_CHECK(mnodemanSaved.Add(mn));
+    BOOST_CHECK(mndb.Write(mnodemanSaved));
+    BOOST_CHECK(mndb.VerifyHeader() == CMasternodeDB::Ok);
+
+    CMasternodeMan mnodemanLoaded;
+    BOOST_CHECK(mndb.Read(mnodemanLoaded, true) == CMasternodeDB::Ok);
+    BOOST_CHECK_EQUAL(mnodemanLoaded.size(), 1);
+    BOOST_CHECK(mnodemanLoaded.Find(mn.vin) != NULL);
+
+    // an unchanged snapshot is not rewritten
+    boost::filesystem::path pathDB = GetDataDir() / "mncache.dat";
+    boost::filesystem::last_write_time(pathDB, 0);
+    BOOST_CHECK(mndb.Write(mnodemanLoaded));
+    BOOST_CHECK_EQUAL(boost::filesystem::last_write_time(pathDB), 0);
+
+    // a corrupted file is rejected
+    boost::filesystem::resize_file(pathDB, boost::filesystem::file_size(pathDB) - 1);
+    CMasternodeMan mnodemanCorrupt;
+    BOOST_CHECK(mndb.Read(mnodemanCorrupt, true) == CMasternodeDB::IncorrectHash);
+    BOOST_CHECK_EQUAL(mnodemanCorrupt.size(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,16 +5,26 @@
 
 #include "rpc/server.h"
 #include "rpc/client.h"
+#include "rpc/jsonstream.h"
 
 #include "base58.h"
+#include "httpserver.h"
+#include "net.h"
 #include "netbase.h"
 #include "util.h"
 
+#include "test/test_dogecash.h"
+
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 #include <boost/test/unit_test.hpp>
 
 #include <univalue.h>
 
+#include <mutex>
+#include <set>
+#include <thread>
+
 using namespace std;
 
 UniValue
@@ -48,7 +58,7 @@ UniValue CallRPC(string args)
 }
 
 
-BOOST_AUTO_TEST_SUITE(rpc_tests)
+BOOST_FIXTURE_TEST_SUITE(rpc_tests, TestingSetup)
 
 BOOST_AUTO_TEST_CASE(rpc_rawparams)
 {
@@ -182,6 +192,181 @@ BOOST_AUTO_TEST_CASE(json_parse_errors)
     BOOST_CHECK_THROW(ParseNonRFCJSONValue("3J98t1WpEZ73CNmQviecrnyiWrnqRhWNL"), std::runtime_error);
 }
 
+static bool AppendStreamPiece(std::string& strOut, unsigned int& nPieces, const std::string& strData, bool fFinal)
+{
+    strOut += strData;
+    nPieces++;
+    return true;
+}
+
+static bool RefuseStreamPiece(unsigned int& nPieces, const std::string& strData, bool fFinal)
+{
+    nPieces++;
+    return false;
+}
+
+BOOST_AUTO_TEST_CASE(rpc_json_stream)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("str", "a\"b\n"));
+    obj.push_back(Pair("num", 42));
+    obj.push_back(Pair("null", NullUniValue));
+    obj.push_back(Pair("empty", UniValue(UniValue::VARR)));
+    UniValue arr(UniValue::VARR);
+    for (int i = 0; i < 100; i++) {
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("n", i));
+        entry.push_back(Pair("flag", i % 2 == 0));
+        arr.push_back(entry);
+    }
+    obj.push_back(Pair("arr", arr));
+
+    // Output matches UniValue::write regardless of how it is split into pieces
+    std::string strOut;
+    unsigned int nPieces = 0;
+    CJSONStreamWriter writer(boost::bind(&AppendStreamPiece, boost::ref(strOut), boost::ref(nPieces), _1, _2), 16);
+    writer.Value(obj);
+    writer.Raw("\n");
+    writer.Finish();
+    BOOST_CHECK_EQUAL(strOut, obj.write() + "\n");
+    BOOST_CHECK(nPieces > 1);
+
+    // Containers built member by member
+    strOut.clear();
+    nPieces = 0;
+    CJSONStreamWriter writer2(boost::bind(&AppendStreamPiece, boost::ref(strOut), boost::ref(nPieces), _1, _2));
+    writer2.BeginObject();
+    writer2.Pair("result", arr);
+    writer2.Key("error");
+    writer2.BeginArray();
+    writer2.Value(1);
+    writer2.Value("x");
+    writer2.EndArray();
+    writer2.EndObject();
+    writer2.Finish();
+    BOOST_CHECK_EQUAL(strOut, "{\"result\":" + arr.write() + ",\"error\":[1,\"x\"]}");
+    BOOST_CHECK_EQUAL(nPieces, 1U);
+
+    // Once the sink refuses a piece, e.g. because the client went away, nothing more is handed to it
+    nPieces = 0;
+    CJSONStreamWriter writer3(boost::bind(&RefuseStreamPiece, boost::ref(nPieces), _1, _2), 16);
+    BOOST_CHECK(writer3.Good());
+    writer3.Value(obj);
+    writer3.Finish();
+    BOOST_CHECK(!writer3.Good());
+    BOOST_CHECK_EQUAL(nPieces, 1U);
+}
+
+static UniValue BatchEntry(const std::string& strMethod, const UniValue& params, int nId)
+{
+    UniValue req(UniValue::VOBJ);
+    req.push_back(Pair("method", strMethod));
+    req.push_back(Pair("params", params));
+    req.push_back(Pair("id", nId));
+    return req;
+}
+
+BOOST_AUTO_TEST_CASE(rpc_batch)
+{
+    const char* pszScripts[] = {"", "51", "76a914000000000000000000000000000000000000000088ac", "0000", "6a", "zz"};
+    UniValue vReq(UniValue::VARR);
+    std::vector<UniValue> vExpected;
+    for (int i = 0; i < 60; i++) {
+        UniValue params(UniValue::VARR);
+        params.push_back(pszScripts[i % 6]);
+        vReq.push_back(BatchEntry("decodescript", params, i));
+        try {
+            vExpected.push_back(JSONRPCReplyObj(tableRPC.execute("decodescript", params), NullUniValue, i));
+        } catch (const UniValue& objError) {
+            vExpected.push_back(JSONRPCReplyObj(NullUniValue, objError, i));
+        }
+    }
+
+    // Replies come back in request order and match executing each call on its own
+    UniValue ret;
+    BOOST_CHECK(ret.read(JSONRPCExecBatch(vReq)));
+    BOOST_CHECK_EQUAL(ret.size(), vExpected.size());
+    for (unsigned int i = 0; i < ret.size(); i++)
+        BOOST_CHECK_EQUAL(ret[i].write(), vExpected[i].write());
+
+    // Unknown methods and malformed entries fail in place
+    vReq.push_back(BatchEntry("nosuchmethod", UniValue(UniValue::VARR), 60));
+    vReq.push_back(UniValue("notanobject"));
+    BOOST_CHECK(ret.read(JSONRPCExecBatch(vReq)));
+    BOOST_CHECK_EQUAL(ret.size(), vExpected.size() + 2);
+    BOOST_CHECK_EQUAL(ret[59].write(), vExpected[59].write());
+    BOOST_CHECK_EQUAL(find_value(ret[60], "id").get_int(), 60);
+    BOOST_CHECK_EQUAL(find_value(find_value(ret[60], "error"), "code").get_int(), RPC_METHOD_NOT_FOUND);
+    BOOST_CHECK(find_value(ret[61], "error").isObject());
+}
+
+static bool fRecordBatchThreads = false;
+static std::mutex csBatchThreads;
+static std::set<std::thread::id> setBatchThreads;
+
+static void RecordBatchThread(const CRPCCommand&)
+{
+    if (!fRecordBatchThreads)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(csBatchThreads);
+        setBatchThreads.insert(std::this_thread::get_id());
+    }
+    // give the helpers time to pick up entries before this thread finishes the batch
+    MilliSleep(2);
+}
+
+BOOST_AUTO_TEST_CASE(rpc_batch_workers)
+{
+    // run the HTTP worker threads, on a port picked by the system
+    mapArgs["-rpcport"] = "0";
+    mapArgs["-rpcthreads"] = "4";
+    BOOST_REQUIRE(InitHTTPServer());
+    BOOST_REQUIRE(StartHTTPServer());
+    RPCServer::OnPreCommand(&RecordBatchThread);
+
+    const char* pszScripts[] = {"", "51", "76a914000000000000000000000000000000000000000088ac", "0000", "6a", "zz"};
+    UniValue vReq(UniValue::VARR);
+    std::vector<UniValue> vExpected;
+    for (int i = 0; i < 60; i++) {
+        UniValue params(UniValue::VARR);
+        params.push_back(pszScripts[i % 6]);
+        vReq.push_back(BatchEntry("decodescript", params, i));
+        try {
+            vExpected.push_back(JSONRPCReplyObj(tableRPC.execute("decodescript", params), NullUniValue, i));
+        } catch (const UniValue& objError) {
+            vExpected.push_back(JSONRPCReplyObj(NullUniValue, objError, i));
+        }
+    }
+
+    // entries run on the workers as well, and replies still come back in request order
+    fRecordBatchThreads = true;
+    UniValue ret;
+    BOOST_CHECK(ret.read(JSONRPCExecBatch(vReq)));
+    fRecordBatchThreads = false;
+    BOOST_CHECK_GT(setBatchThreads.size(), 1U);
+    BOOST_CHECK_EQUAL(ret.size(), vExpected.size());
+    for (unsigned int i = 0; i < ret.size(); i++)
+        BOOST_CHECK_EQUAL(ret[i].write(), vExpected[i].write());
+
+    // a batch with a call not known to be read-only stays on this thread
+    setBatchThreads.clear();
+    vReq.push_back(BatchEntry("nosuchmethod", UniValue(UniValue::VARR), 60));
+    fRecordBatchThreads = true;
+    BOOST_CHECK(ret.read(JSONRPCExecBatch(vReq)));
+    fRecordBatchThreads = false;
+    BOOST_CHECK_EQUAL(setBatchThreads.size(), 1U);
+    BOOST_CHECK(setBatchThreads.count(std::this_thread::get_id()));
+    BOOST_CHECK_EQUAL(ret.size(), vExpected.size() + 1);
+    for (unsigned int i = 0; i < vExpected.size(); i++)
+        BOOST_CHECK_EQUAL(ret[i].write(), vExpected[i].write());
+
+    InterruptHTTPServer();
+    StopHTTPServer();
+    mapArgs.erase("-rpcport");
+    mapArgs.erase("-rpcthreads");
+}
+
 BOOST_AUTO_TEST_CASE(rpc_ban)
 {
     BOOST_CHECK_NO_THROW(CallRPC(string("clearbanned")));
@@ -264,4 +449,35 @@ BOOST_AUTO_TEST_CASE(rpc_ban)
     BOOST_CHECK_EQUAL(adr.get_str(), "2001:4d48:ac57:400:cacf:e9ff:fe1d:9c63/128");
 }
 
+BOOST_AUTO_TEST_CASE(rpc_netmsgstats)
+{
+    CAddress addr(CService("10.0.0.1", 9999));
+    CNode dummyNode(INVALID_SOCKET, addr, "", true);
+
+    // a known command gets its own entry, anything else is lumped together
+    CDataStream ssRecv(SER_NETWORK, PROTOCOL_VERSION);
+    ssRecv << CMessageHeader("ping", sizeof(uint64_t)) << (uint64_t)1;
+    ssRecv << CMessageHeader("nosuchcmd", 0);
+    {
+        LOCK(dummyNode.cs_vRecvMsg);
+        BOOST_CHECK(dummyNode.ReceiveMsgBytes(&ssRecv[0], ssRecv.size()));
+    }
+    dummyNode.PushMessage("pong", (uint64_t)1);
+
+    CNodeStats stats;
+    dummyNode.copyStats(stats);
+    BOOST_CHECK_EQUAL(stats.mapMsgStats.size(), 3U);
+    BOOST_CHECK_EQUAL(stats.mapMsgStats["ping"].nMsgsRecv, 1U);
+    BOOST_CHECK_EQUAL(stats.mapMsgStats["ping"].nBytesRecv, CMessageHeader::HEADER_SIZE + sizeof(uint64_t));
+    BOOST_CHECK_EQUAL(stats.mapMsgStats[NET_MESSAGE_COMMAND_OTHER].nMsgsRecv, 1U);
+    BOOST_CHECK_EQUAL(stats.mapMsgStats["pong"].nMsgsSent, 1U);
+    BOOST_CHECK_EQUAL(stats.mapMsgStats["pong"].nBytesSent, CMessageHeader::HEADER_SIZE + sizeof(uint64_t));
+
+    // the totals include this peer
+    UniValue r = CallRPC("getnetmsgstats");
+    BOOST_CHECK(find_value(find_value(r.get_obj(), "ping").get_obj(), "msgsrecv").get_int64() >= 1);
+    BOOST_CHECK(find_value(find_value(r.get_obj(), "pong").get_obj(), "msgssent").get_int64() >= 1);
+    BOOST_CHECK_THROW(CallRPC("getnetmsgstats 1"), runtime_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -161,4 +161,27 @@ BOOST_AUTO_TEST_CASE(insert_delete)
     BOOST_CHECK_EQUAL(ss.size(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(secure_datastream)
+{
+    CSecureDataStream ssSecure(SER_DISK, 0);
+    ssSecure << uint32_t(0xdeadbeef) << std::string("secret");
+
+    // Public and secure streams interoperate through their byte contents
+    CSecureSerializeData vchSecure(ssSecure.begin(), ssSecure.end());
+    CDataStream ss(vchSecure, SER_DISK, 0);
+    BOOST_CHECK_EQUAL(ss.size(), ssSecure.size());
+
+    uint32_t n;
+    std::string str;
+    ss >> n >> str;
+    BOOST_CHECK_EQUAL(n, 0xdeadbeef);
+    BOOST_CHECK_EQUAL(str, "secret");
+    BOOST_CHECK(ss.empty());
+
+    CSecureSerializeData d;
+    ssSecure.GetAndClear(d);
+    BOOST_CHECK_EQUAL(d.size(), vchSecure.size());
+    BOOST_CHECK(ssSecure.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
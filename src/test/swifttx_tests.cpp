@@ -0,0 +1,86 @@
+// Copyright (c) 2019 The DogeCash developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "swifttx.h"
+#include "utiltime.h"
+#include "test/test_dogecash.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(swifttx_tests, BasicTestingSetup)
+
+static CTransaction SpendOutPoint(const COutPoint& outpoint, CAmount nValue)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = outpoint;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = nValue;
+    return tx;
+}
+
+static CConsensusVote MakeVote(const uint256& txHash, int nBlockHeight, uint32_t nMasternode)
+{
+    CConsensusVote vote;
+    vote.vinMasternode = CTxIn(COutPoint(GetRandHash(), nMasternode));
+    vote.txHash = txHash;
+    vote.nBlockHeight = nBlockHeight;
+    return vote;
+}
+
+BOOST_AUTO_TEST_CASE(swifttx_lock_votes)
+{
+    CSwiftTXManager manager;
+    const uint256 txHash = GetRandHash();
+
+    BOOST_CHECK_EQUAL(manager.CountSignatures(txHash), -1);
+    BOOST_CHECK(manager.CreateLock(txHash, 100));
+    BOOST_CHECK(!manager.CreateLock(txHash, 0));
+
+    CConsensusVote vote = MakeVote(txHash, 100, 0);
+    BOOST_CHECK(manager.AddVote(vote));
+    BOOST_CHECK(!manager.AddVote(vote));
+    BOOST_CHECK(manager.HaveVote(vote.GetHash()));
+
+    BOOST_CHECK_EQUAL(manager.AddLockVote(vote), 1);
+    BOOST_CHECK_EQUAL(manager.AddLockVote(MakeVote(txHash, 100, 1)), 2);
+    // votes for another height do not count until the lock moves there
+    BOOST_CHECK_EQUAL(manager.AddLockVote(MakeVote(txHash, 101, 2)), 2);
+    BOOST_CHECK(!manager.CreateLock(txHash, 101));
+    BOOST_CHECK_EQUAL(manager.CountSignatures(txHash), 1);
+}
+
+BOOST_AUTO_TEST_CASE(swifttx_locked_inputs_and_expiry)
+{
+    SetMockTime(1500000000);
+    CSwiftTXManager manager;
+    const COutPoint outpoint(GetRandHash(), 0);
+    const CTransaction tx = SpendOutPoint(outpoint, 1 * COIN);
+    const CTransaction txConflict = SpendOutPoint(outpoint, 2 * COIN);
+    uint256 hashLocked;
+
+    BOOST_CHECK(!manager.GetConflictingLock(txConflict, hashLocked));
+
+    manager.CreateLock(tx.GetHash(), 100);
+    manager.AddLockRequest(tx);
+    manager.LockInputs(tx);
+    BOOST_CHECK(!manager.GetConflictingLock(tx, hashLocked));
+    BOOST_CHECK(manager.GetConflictingLock(txConflict, hashLocked));
+    BOOST_CHECK(hashLocked == tx.GetHash());
+
+    // a conflicting lock cancels both out at the next clean up
+    manager.CreateLock(txConflict.GetHash(), 100);
+    BOOST_CHECK(manager.CancelConflictingLocks(txConflict));
+    manager.RemoveExpiredLocks(GetTime());
+    BOOST_CHECK_EQUAL(manager.CountSignatures(tx.GetHash()), 0);
+    manager.RemoveExpiredLocks(GetTime() + 1);
+    BOOST_CHECK_EQUAL(manager.CountSignatures(tx.GetHash()), -1);
+    BOOST_CHECK_EQUAL(manager.CountSignatures(txConflict.GetHash()), -1);
+    BOOST_CHECK(!manager.HaveLockRequest(tx.GetHash()));
+    BOOST_CHECK(!manager.GetConflictingLock(txConflict, hashLocked));
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
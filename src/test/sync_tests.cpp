@@ -5,6 +5,8 @@
 #include "sync.h"
 #include "test/test_dogecash.h"
 
+#include <thread>
+
 #include <boost/test/unit_test.hpp>
 
 namespace {
@@ -49,4 +51,43 @@ BOOST_AUTO_TEST_CASE(potential_deadlock_detected)
     #endif
 }
 
+BOOST_AUTO_TEST_CASE(lock_stats_sampled)
+{
+    unsigned int nPrevRate = GetLockStatsSampleRate();
+    ResetLockStats();
+    SetLockStatsSampleRate(1);
+    g_lock_stats_enabled = true;
+
+    RecursiveMutex mutex;
+    for (int i = 0; i < 10; i++) {
+        LOCK(mutex);
+    }
+    {
+        LOCK(mutex);
+        std::thread t([&mutex] {
+            TRY_LOCK(mutex, lockMutex);
+            BOOST_CHECK(!lockMutex);
+        });
+        t.join();
+    }
+
+    g_lock_stats_enabled = false;
+    SetLockStatsSampleRate(nPrevRate);
+
+    uint64_t nSamples = 0, nTryFailed = 0;
+    for (const CLockSiteStats& site : GetLockStats()) {
+        if (site.cs != &mutex)
+            continue;
+        BOOST_CHECK_EQUAL(site.strName, "mutex");
+        BOOST_CHECK_EQUAL(site.nContended, 0U);
+        nSamples += site.nSamples;
+        nTryFailed += site.nTryFailed;
+    }
+    BOOST_CHECK_EQUAL(nSamples, 11U);
+    BOOST_CHECK_EQUAL(nTryFailed, 1U);
+
+    ResetLockStats();
+    BOOST_CHECK(GetLockStats().empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -7,6 +7,7 @@
 #include "coincontrol.h"
 #include "denomination_functions.h"
 #include "main.h"
+#include "streams.h"
 #include "txdb.h"
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
@@ -69,6 +70,52 @@ BOOST_AUTO_TEST_CASE(denomination_to_value_test)
     BOOST_CHECK_MESSAGE(ZerocoinDenominationToAmount(denomination) == Value, "Wrong Value - should be 0");
 }
 
+//the inline per-denomination counts of CBlockIndex keep the on-disk format of the containers they replaced
+BOOST_AUTO_TEST_CASE(block_index_denomination_counts_test)
+{
+    cout << "Running block_index_denomination_counts_test...\n";
+
+    std::map<CoinDenomination, int64_t> mapSupply;
+    CZerocoinSupply supply;
+    int64_t nValue = 3;
+    for (auto denom : zerocoinDenomList) {
+        mapSupply.insert(std::make_pair(denom, nValue));
+        supply.at(denom) = nValue;
+        nValue *= 7;
+    }
+    CDataStream ssMap(SER_DISK, CLIENT_VERSION);
+    ssMap << mapSupply;
+    CDataStream ssSupply(SER_DISK, CLIENT_VERSION);
+    ssSupply << supply;
+    BOOST_CHECK_MESSAGE(ssMap.str() == ssSupply.str(), "Supply serializes differently from a map");
+    BOOST_CHECK_EQUAL(ssSupply.size(), supply.GetSerializeSize(SER_DISK, CLIENT_VERSION));
+
+    CZerocoinSupply supplyRead;
+    ssMap >> supplyRead;
+    for (auto denom : zerocoinDenomList)
+        BOOST_CHECK_EQUAL(supplyRead.at(denom), mapSupply.at(denom));
+    BOOST_CHECK_THROW(supplyRead.at(ZQ_ERROR), std::out_of_range);
+
+    //mints are written sorted by denomination, in whatever order they were read
+    std::vector<CoinDenomination> vMints = {ZQ_FIFTY, ZQ_ONE, ZQ_FIFTY, ZQ_FIVE_THOUSAND, ZQ_ONE};
+    CDataStream ssVector(SER_DISK, CLIENT_VERSION);
+    ssVector << vMints;
+    CZerocoinMintCounts mints;
+    ssVector >> mints;
+    BOOST_CHECK_EQUAL(mints.Count(ZQ_ONE), 2U);
+    BOOST_CHECK_EQUAL(mints.Count(ZQ_FIVE), 0U);
+    BOOST_CHECK_EQUAL(mints.Count(ZQ_FIFTY), 2U);
+    BOOST_CHECK_EQUAL(mints.Count(ZQ_FIVE_THOUSAND), 1U);
+    BOOST_CHECK_EQUAL(mints.Total(), vMints.size());
+
+    std::sort(vMints.begin(), vMints.end());
+    ssVector << vMints;
+    CDataStream ssMints(SER_DISK, CLIENT_VERSION);
+    ssMints << mints;
+    BOOST_CHECK_MESSAGE(ssVector.str() == ssMints.str(), "Mint counts serialize differently from a sorted vector");
+    BOOST_CHECK_EQUAL(ssMints.size(), mints.GetSerializeSize(SER_DISK, CLIENT_VERSION));
+}
+
 BOOST_AUTO_TEST_CASE(zerocoin_spend_test241)
 {
     const int nMaxNumberOfSpends = 4;
@@ -546,4 +546,41 @@ BOOST_AUTO_TEST_CASE(deterministic_tests)
 }
 
 
+BOOST_AUTO_TEST_CASE(accumulator_values_load_erase)
+{
+    // the background load must never put back a value that was erased while it ran
+    SelectParams(CBaseChainParams::UNITTEST);
+    bool fOwnDB = !zerocoinDB;
+    if (fOwnDB)
+        zerocoinDB = new CZerocoinDB(0, true);
+
+    std::vector<uint256> vCheckpoints;
+    for (uint32_t i = 0; i < 200; i++) {
+        uint256 nCheckpoint = 0;
+        for (uint32_t j = 0; j < libzerocoin::zerocoinDenomList.size(); j++) {
+            uint32_t nChecksum = 0x5a000000 + i * 8 + j;
+            BOOST_CHECK(zerocoinDB->WriteAccumulatorValue(nChecksum, CBigNum(nChecksum)));
+            nCheckpoint = nCheckpoint << 32 | nChecksum;
+        }
+        vCheckpoints.push_back(nCheckpoint);
+    }
+
+    LoadAccumulatorValuesAsync(vCheckpoints);
+    for (const uint256& nCheckpoint : vCheckpoints)
+        BOOST_CHECK(EraseAccumulatorValues(nCheckpoint, 0));
+    StopAccumulatorValuesLoad(false);
+
+    for (const uint256& nCheckpoint : vCheckpoints) {
+        for (auto denom : libzerocoin::zerocoinDenomList) {
+            CBigNum bnValue;
+            BOOST_CHECK(!GetAccumulatorValueFromChecksum(ParseChecksum(nCheckpoint, denom), true, bnValue));
+        }
+    }
+
+    if (fOwnDB) {
+        delete zerocoinDB;
+        zerocoinDB = nullptr;
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -74,6 +74,162 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock)
     return db.WriteBatch(batch);
 }
 
+bool CCoinsViewDB::WriteCoins(const CCoinsMap& mapCoins, const uint256& hashBlock)
+{
+    CLevelDBBatch batch;
+    size_t changed = 0;
+    for (CCoinsMap::const_iterator it = mapCoins.begin(); it != mapCoins.end(); it++) {
+        if (it->second.flags & CCoinsCacheEntry::DIRTY) {
+            BatchWriteCoins(batch, it->first, it->second.coins);
+            changed++;
+        }
+    }
+    if (hashBlock != uint256(0))
+        BatchWriteHashBestChain(batch, hashBlock);
+
+    LogPrint("coindb", "Committing %u changed transactions (out of %u) to coin database in the background...\n", (unsigned int)changed, (unsigned int)mapCoins.size());
+    return db.WriteBatch(batch);
+}
+
+CCoinsViewWriteBehind::CCoinsViewWriteBehind(CCoinsViewDB* dbIn) : db(dbIn), hashBlockWriting(0), fWriting(false), fFailed(false), fStop(false)
+{
+    threadWrite = boost::thread(&CCoinsViewWriteBehind::ThreadWrite, this);
+}
+
+CCoinsViewWriteBehind::~CCoinsViewWriteBehind()
+{
+    {
+        WAIT_LOCK(cs, lock);
+        fStop = true;
+    }
+    cvWrite.notify_all();
+    threadWrite.join();
+}
+
+void CCoinsViewWriteBehind::ThreadWrite()
+{
+    util::ThreadRename("dogecash-coinswrite");
+    while (true) {
+        {
+            WAIT_LOCK(cs, lock);
+            while (!fWriting && !fStop)
+                cvWrite.wait(lock);
+            if (!fWriting)
+                return;
+        }
+
+        bool fOk = false;
+        try {
+            fOk = db->WriteCoins(mapWriting, hashBlockWriting);
+        } catch (const std::exception& e) {
+            LogPrintf("%s: %s\n", __func__, e.what());
+        }
+        if (!fOk)
+            LogPrintf("%s: failed to write to coin database\n", __func__);
+
+        // Free the batch outside the lock; nobody reads it once fWriting is cleared.
+        CCoinsMap mapDone;
+        {
+            WAIT_LOCK(cs, lock);
+            mapDone.swap(mapWriting);
+            fWriting = false;
+            fFailed |= !fOk;
+        }
+        cvWrite.notify_all();
+    }
+}
+
+bool CCoinsViewWriteBehind::GetCoins(const uint256& txid, CCoins& coins) const
+{
+    {
+        WAIT_LOCK(cs, lock);
+        if (fWriting) {
+            CCoinsMap::const_iterator it = mapWriting.find(txid);
+            if (it != mapWriting.end()) {
+                // the database erases pruned entries
+                if (it->second.coins.IsPruned())
+                    return false;
+                coins = it->second.coins;
+                return true;
+            }
+        }
+    }
+    return db->GetCoins(txid, coins);
+}
+
+bool CCoinsViewWriteBehind::HaveCoins(const uint256& txid) const
+{
+    {
+        WAIT_LOCK(cs, lock);
+        if (fWriting) {
+            CCoinsMap::const_iterator it = mapWriting.find(txid);
+            if (it != mapWriting.end())
+                return !it->second.coins.IsPruned();
+        }
+    }
+    return db->HaveCoins(txid);
+}
+
+uint256 CCoinsViewWriteBehind::GetBestBlock() const
+{
+    {
+        WAIT_LOCK(cs, lock);
+        if (fWriting && hashBlockWriting != uint256(0))
+            return hashBlockWriting;
+    }
+    return db->GetBestBlock();
+}
+
+bool CCoinsViewWriteBehind::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock)
+{
+    if (!WaitForWrite())
+        return false;
+    return db->BatchWrite(mapCoins, hashBlock);
+}
+
+bool CCoinsViewWriteBehind::GetStats(CCoinsStats& stats) const
+{
+    if (!WaitForWrite())
+        return false;
+    return db->GetStats(stats);
+}
+
+bool CCoinsViewWriteBehind::WriteAsync(CCoinsMap& mapCoins, const uint256& hashBlock)
+{
+    {
+        WAIT_LOCK(cs, lock);
+        while (fWriting)
+            cvWrite.wait(lock);
+        if (fFailed)
+            return false;
+        mapWriting.swap(mapCoins);
+        hashBlockWriting = hashBlock;
+        fWriting = true;
+    }
+    cvWrite.notify_all();
+    return true;
+}
+
+bool CCoinsViewWriteBehind::WaitForWrite() const
+{
+    WAIT_LOCK(cs, lock);
+    while (fWriting)
+        cvWrite.wait(lock);
+    return !fFailed;
+}
+
+bool CCoinsViewWriteBehind::IsWriting() const
+{
+    WAIT_LOCK(cs, lock);
+    return fWriting;
+}
+
+size_t CCoinsViewWriteBehind::GetWritingSize() const
+{
+    WAIT_LOCK(cs, lock);
+    return fWriting ? mapWriting.size() : 0;
+}
+
 CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CLevelDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe)
 {
 }
@@ -210,6 +366,32 @@ bool CBlockTreeDB::ReadInt(const std::string& name, int& nValue)
     return Read(std::make_pair('I', name), nValue);
 }
 
+/** A block index entry read off the database, deserialized on a worker thread */
+struct CBlockIndexLoadEntry {
+    uint256 hash;
+    std::string strValue;
+    CDiskBlockIndex diskindex;
+    bool fCheckHash;
+    std::string strError;
+};
+
+static void DeserializeBlockIndexEntries(std::vector<CBlockIndexLoadEntry>& vEntries, size_t nThread, size_t nThreads)
+{
+    for (size_t i = nThread; i < vEntries.size(); i += nThreads) {
+        CBlockIndexLoadEntry& entry = vEntries[i];
+        try {
+            CDataStream ssValue(entry.strValue.data(), entry.strValue.data() + entry.strValue.size(), SER_DISK, CLIENT_VERSION);
+            ssValue >> entry.diskindex;
+            // the entry is stored under its block hash; re-hashing the header (Quark for old blocks) is only needed to verify that
+            if (entry.fCheckHash && entry.diskindex.GetBlockHash() != entry.hash)
+                entry.strError = strprintf("header hash %s does not match key", entry.diskindex.GetBlockHash().GetHex());
+        } catch (const std::exception& e) {
+            entry.strError = strprintf("Deserialize or I/O error - %s", e.what());
+        }
+        std::string().swap(entry.strValue);
+    }
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts()
 {
     boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
@@ -218,78 +400,113 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
     ssKeySet << make_pair('b', uint256(0));
     pcursor->Seek(ssKeySet.str());
 
+    const bool fCheckAllHashes = GetBoolArg("-checkblockindexhashes", false);
+    const size_t nThreads = std::max(1U, boost::thread::hardware_concurrency());
+    size_t nEntries = 0;
+
     // Load mapBlockIndex
     uint256 nPreviousCheckpoint;
-    while (pcursor->Valid()) {
+    std::vector<uint256> vAccumulatorCheckpoints;
+    std::vector<CBlockIndexLoadEntry> vEntries;
+    bool fDone = false;
+    while (!fDone) {
         boost::this_thread::interruption_point();
-        try {
-            leveldb::Slice slKey = pcursor->key();
-            CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
-            char chType;
-            ssKey >> chType;
-            if (chType == 'b') {
-                leveldb::Slice slValue = pcursor->value();
-                CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
-                CDiskBlockIndex diskindex;
-                ssValue >> diskindex;
-
-                // Construct block index object
-                CBlockIndex* pindexNew = InsertBlockIndex(diskindex.GetBlockHash());
-                pindexNew->pprev = InsertBlockIndex(diskindex.hashPrev);
-                pindexNew->pnext = InsertBlockIndex(diskindex.hashNext);
-                pindexNew->nHeight = diskindex.nHeight;
-                pindexNew->nFile = diskindex.nFile;
-                pindexNew->nDataPos = diskindex.nDataPos;
-                pindexNew->nUndoPos = diskindex.nUndoPos;
-                pindexNew->nVersion = diskindex.nVersion;
-                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->nTime = diskindex.nTime;
-                pindexNew->nBits = diskindex.nBits;
-                pindexNew->nNonce = diskindex.nNonce;
-                pindexNew->nStatus = diskindex.nStatus;
-                pindexNew->nTx = diskindex.nTx;
-
-                //zerocoin
-                pindexNew->nAccumulatorCheckpoint = diskindex.nAccumulatorCheckpoint;
-                pindexNew->mapZerocoinSupply = diskindex.mapZerocoinSupply;
-                pindexNew->vMintDenominationsInBlock = diskindex.vMintDenominationsInBlock;
-
-                //Proof Of Stake
-                pindexNew->nMint = diskindex.nMint;
-                pindexNew->nMoneySupply = diskindex.nMoneySupply;
-                pindexNew->nFlags = diskindex.nFlags;
-                if (!Params().IsStakeModifierV2(pindexNew->nHeight)) {
-                    pindexNew->nStakeModifier = diskindex.nStakeModifier;
-                } else {
-                    pindexNew->nStakeModifierV2 = diskindex.nStakeModifierV2;
-                }
-                pindexNew->prevoutStake = diskindex.prevoutStake;
-                pindexNew->nStakeTime = diskindex.nStakeTime;
-                pindexNew->hashProofOfStake = diskindex.hashProofOfStake;
 
-                if (pindexNew->nHeight <= Params().LAST_POW_BLOCK()) {
-                    if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits))
-                        return error("LoadBlockIndex() : CheckProofOfWork failed: %s", pindexNew->ToString());
-                }
-                
-                //populate accumulator checksum map in memory
-                if(pindexNew->nAccumulatorCheckpoint != 0 && pindexNew->nAccumulatorCheckpoint != nPreviousCheckpoint) {
-                    //Don't load any checkpoints that exist before v2 zdogec. The accumulator is invalid for v1 and not used.
-                    if (pindexNew->nHeight >= Params().Zerocoin_Block_V2_Start())
-                        LoadAccumulatorValuesFromDB(pindexNew->nAccumulatorCheckpoint);
-
-                    nPreviousCheckpoint = pindexNew->nAccumulatorCheckpoint;
+        // Read a batch of entries off the cursor
+        vEntries.clear();
+        while (vEntries.size() < BLOCK_INDEX_LOAD_BATCH_SIZE) {
+            if (!pcursor->Valid()) {
+                fDone = true;
+                break;
+            }
+            try {
+                leveldb::Slice slKey = pcursor->key();
+                CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+                char chType;
+                ssKey >> chType;
+                if (chType != 'b') {
+                    fDone = true; // finished loading block index
+                    break;
                 }
-
+                vEntries.emplace_back();
+                CBlockIndexLoadEntry& entry = vEntries.back();
+                ssKey >> entry.hash;
+                leveldb::Slice slValue = pcursor->value();
+                entry.strValue.assign(slValue.data(), slValue.size());
+                entry.fCheckHash = fCheckAllHashes || (nEntries++ % BLOCK_INDEX_HASH_CHECK_INTERVAL) == 0;
                 pcursor->Next();
+            } catch (const std::exception& e) {
+                return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+            }
+        }
+
+        // Deserialize it on all cores
+        size_t nBatchThreads = std::min(nThreads, vEntries.size() / 64 + 1);
+        boost::thread_group threads;
+        for (size_t nThread = 1; nThread < nBatchThreads; nThread++)
+            threads.create_thread(boost::bind(&DeserializeBlockIndexEntries, boost::ref(vEntries), nThread, nBatchThreads));
+        DeserializeBlockIndexEntries(vEntries, 0, nBatchThreads);
+        threads.join_all();
+
+        // Link the entries up in database order
+        for (const CBlockIndexLoadEntry& entry : vEntries) {
+            if (!entry.strError.empty())
+                return error("%s : block index entry %s: %s", __func__, entry.hash.GetHex(), entry.strError);
+            const CDiskBlockIndex& diskindex = entry.diskindex;
+
+            // Construct block index object
+            CBlockIndex* pindexNew = InsertBlockIndex(entry.hash);
+            pindexNew->pprev = InsertBlockIndex(diskindex.hashPrev);
+            pindexNew->pnext = InsertBlockIndex(diskindex.hashNext);
+            pindexNew->nHeight = diskindex.nHeight;
+            pindexNew->nFile = diskindex.nFile;
+            pindexNew->nDataPos = diskindex.nDataPos;
+            pindexNew->nUndoPos = diskindex.nUndoPos;
+            pindexNew->nVersion = diskindex.nVersion;
+            pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+            pindexNew->nTime = diskindex.nTime;
+            pindexNew->nBits = diskindex.nBits;
+            pindexNew->nNonce = diskindex.nNonce;
+            pindexNew->nStatus = diskindex.nStatus;
+            pindexNew->nTx = diskindex.nTx;
+
+            //zerocoin
+            pindexNew->nAccumulatorCheckpoint = diskindex.nAccumulatorCheckpoint;
+            pindexNew->zerocoinSupply = diskindex.zerocoinSupply;
+            pindexNew->mintsInBlock = diskindex.mintsInBlock;
+
+            //Proof Of Stake
+            pindexNew->nMint = diskindex.nMint;
+            pindexNew->nMoneySupply = diskindex.nMoneySupply;
+            pindexNew->nFlags = diskindex.nFlags;
+            if (!Params().IsStakeModifierV2(pindexNew->nHeight)) {
+                pindexNew->nStakeModifier = diskindex.nStakeModifier;
             } else {
-                break; // if shutdown requested or finished loading block index
+                pindexNew->nStakeModifierV2 = diskindex.nStakeModifierV2;
+            }
+            pindexNew->prevoutStake = diskindex.prevoutStake;
+            pindexNew->nStakeTime = diskindex.nStakeTime;
+            pindexNew->hashProofOfStake = diskindex.hashProofOfStake;
+
+            if (pindexNew->nHeight <= Params().LAST_POW_BLOCK()) {
+                if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits))
+                    return error("LoadBlockIndex() : CheckProofOfWork failed: %s", pindexNew->ToString());
+            }
+
+            //collect the accumulator checksums to load into memory
+            if(pindexNew->nAccumulatorCheckpoint != 0 && pindexNew->nAccumulatorCheckpoint != nPreviousCheckpoint) {
+                //Don't load any checkpoints that exist before v2 zdogec. The accumulator is invalid for v1 and not used.
+                if (pindexNew->nHeight >= Params().Zerocoin_Block_V2_Start())
+                    vAccumulatorCheckpoints.push_back(pindexNew->nAccumulatorCheckpoint);
+
+                nPreviousCheckpoint = pindexNew->nAccumulatorCheckpoint;
             }
-        } catch (const std::exception& e) {
-            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
         }
     }
 
+    // Values missing from memory are read from the database on demand, so there is no need to wait for them
+    LoadAccumulatorValuesAsync(vAccumulatorCheckpoints);
+
     return true;
 }
 
@@ -322,6 +539,31 @@ bool CZerocoinDB::ReadCoinMint(const uint256& hashPubcoin, uint256& hashTx)
     return Read(make_pair('m', hashPubcoin), hashTx);
 }
 
+bool CZerocoinDB::ReadCoinMints(std::vector<uint256> vPubcoinHashes, std::map<uint256, uint256>& mapTxHashes)
+{
+    // seek a single iterator through the keys in order instead of doing a lookup per mint
+    std::sort(vPubcoinHashes.begin(), vPubcoinHashes.end());
+    boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
+    for (const uint256& hashPubcoin : vPubcoinHashes) {
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey << make_pair('m', hashPubcoin);
+        pcursor->Seek(ssKey.str());
+        if (!pcursor->Valid() || pcursor->key() != leveldb::Slice(&ssKey[0], ssKey.size()))
+            continue;
+
+        try {
+            leveldb::Slice slValue = pcursor->value();
+            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+            uint256 hashTx;
+            ssValue >> hashTx;
+            mapTxHashes[hashPubcoin] = hashTx;
+        } catch (const std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
+    return pcursor->status().ok();
+}
+
 bool CZerocoinDB::EraseCoinMint(const CBigNum& bnPubcoin)
 {
     uint256 hash = GetPubCoinHash(bnPubcoin);
@@ -9,13 +9,17 @@
 
 #include "leveldbwrapper.h"
 #include "main.h"
+#include "sync.h"
 #include "zdogec/zerocoin.h"
 
+#include <condition_variable>
 #include <map>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <boost/thread/thread.hpp>
+
 class CCoins;
 class uint256;
 
@@ -25,6 +29,14 @@ static const int64_t nDefaultDbCache = 100;
 static const int64_t nMaxDbCache = sizeof(void*) > 4 ? 4096 : 1024;
 //! min. -dbcache in (MiB)
 static const int64_t nMinDbCache = 4;
+//! -dbcacheretain default (percentage of the coins cache kept warm after a flush)
+static const int64_t nDefaultDbCacheRetain = 50;
+//! -dbwritebehind default
+static const bool DEFAULT_DB_WRITE_BEHIND = true;
+//! Block index entries read off the database at a time and deserialized in parallel
+static const unsigned int BLOCK_INDEX_LOAD_BATCH_SIZE = 16384;
+//! Without -checkblockindexhashes, one in this many block index entries has its header hash checked at startup
+static const unsigned int BLOCK_INDEX_HASH_CHECK_INTERVAL = 1000;
 
 /** CCoinsView backed by the LevelDB coin database (chainstate/) */
 class CCoinsViewDB : public CCoinsView
@@ -40,6 +52,62 @@ public:
     uint256 GetBestBlock() const;
     bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock);
     bool GetStats(CCoinsStats& stats) const;
+
+    //! Write the modified entries of mapCoins without touching the map, so other threads may keep reading it
+    bool WriteCoins(const CCoinsMap& mapCoins, const uint256& hashBlock);
+};
+
+/**
+ * CCoinsView between the coins cache and the coin database that writes flushed
+ * coins on a background thread. While a batch is being written its coins keep
+ * being served from memory, so block connection does not wait on LevelDB.
+ * Only one batch is in flight at a time.
+ */
+class CCoinsViewWriteBehind : public CCoinsView
+{
+private:
+    CCoinsViewDB* db;
+
+    mutable Mutex cs;
+    mutable std::condition_variable cvWrite;
+
+    //! Batch being written. Only replaced or cleared under cs while no write is in flight;
+    //! the writer thread reads it without the lock.
+    CCoinsMap mapWriting;
+    uint256 hashBlockWriting;
+    bool fWriting;
+    bool fFailed;
+    bool fStop;
+
+    boost::thread threadWrite;
+
+    void ThreadWrite();
+
+public:
+    CCoinsViewWriteBehind(CCoinsViewDB* dbIn);
+    ~CCoinsViewWriteBehind();
+
+    bool GetCoins(const uint256& txid, CCoins& coins) const;
+    bool HaveCoins(const uint256& txid) const;
+    uint256 GetBestBlock() const;
+    //! Synchronous write; waits for the batch in flight first
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock);
+    bool GetStats(CCoinsStats& stats) const;
+
+    /**
+     * Hand mapCoins (which is left empty) to the background writer, waiting for the
+     * previous batch to finish first. Returns false if a previous write failed.
+     */
+    bool WriteAsync(CCoinsMap& mapCoins, const uint256& hashBlock);
+
+    //! Wait until no batch is in flight. Returns false if a write failed.
+    bool WaitForWrite() const;
+
+    //! Whether a batch is still being written
+    bool IsWriting() const;
+
+    //! Number of entries in the batch being written, 0 if none
+    size_t GetWritingSize() const;
 };
 
 /** Access to the block database (blocks/index/) */
@@ -83,6 +151,8 @@ public:
     bool WriteCoinMintBatch(const std::vector<std::pair<libzerocoin::PublicCoin, uint256> >& mintInfo);
     bool ReadCoinMint(const CBigNum& bnPubcoin, uint256& txHash);
     bool ReadCoinMint(const uint256& hashPubcoin, uint256& hashTx);
+    /** Look up many mints at once, adding those found on chain to mapTxHashes (pubcoin hash -> tx hash) */
+    bool ReadCoinMints(std::vector<uint256> vPubcoinHashes, std::map<uint256, uint256>& mapTxHashes);
     /** Write zdogec spends to the zerocoinDB in a batch */
     bool WriteCoinSpendBatch(const std::vector<std::pair<libzerocoin::CoinSpend, uint256> >& spendInfo);
     bool ReadCoinSpend(const CBigNum& bnSerial, uint256& txHash);
@@ -466,7 +466,7 @@ void CTxMemPool::remove(const CTransaction& origTx, std::list<CTransaction>& rem
     }
 }
 
-void CTxMemPool::removeCoinbaseSpends(const CCoinsViewCache* pcoins, unsigned int nMemPoolHeight)
+void CTxMemPool::removeCoinbaseSpends(const CCoinsViewCache* pcoins, unsigned int nMemPoolHeight, std::list<CTransaction>& removed)
 {
     // Remove transactions spending a coinbase which are now immature
     LOCK(cs);
@@ -486,7 +486,6 @@ void CTxMemPool::removeCoinbaseSpends(const CCoinsViewCache* pcoins, unsigned in
         }
     }
     BOOST_FOREACH (const CTransaction& tx, transactionsToRemove) {
-        list<CTransaction> removed;
         remove(tx, removed, true);
     }
 }
@@ -538,6 +537,14 @@ void CTxMemPool::clear()
     ++nTransactionsUpdated;
 }
 
+void CTxMemPool::clear(std::list<CTransaction>& removed)
+{
+    LOCK(cs);
+    for (std::map<uint256, CTxMemPoolEntry>::const_iterator it = mapTx.begin(); it != mapTx.end(); it++)
+        removed.push_back(it->second.GetTx());
+    clear();
+}
+
 void CTxMemPool::check(const CCoinsViewCache* pcoins) const
 {
     if (!fSanityCheck)
@@ -25,6 +25,34 @@
 
 unsigned int nWalletDBUpdated;
 
+static boost::mutex csWalletDBUpdated;
+static boost::condition_variable condWalletDBUpdated;
+
+void NotifyWalletDBUpdated()
+{
+    // writers bump nWalletDBUpdated before releasing their handle; taking the
+    // mutex orders that with a waiter that just found it unchanged
+    {
+        boost::lock_guard<boost::mutex> lock(csWalletDBUpdated);
+    }
+    condWalletDBUpdated.notify_all();
+}
+
+void WaitForWalletDBUpdate(unsigned int nLastSeen, int64_t nTimeoutMillis)
+{
+    boost::unique_lock<boost::mutex> lock(csWalletDBUpdated);
+    if (nTimeoutMillis < 0) {
+        while (nWalletDBUpdated == nLastSeen)
+            condWalletDBUpdated.wait(lock);
+        return;
+    }
+    boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(nTimeoutMillis);
+    while (nWalletDBUpdated == nLastSeen) {
+        if (!condWalletDBUpdated.timed_wait(lock, deadline))
+            break;
+    }
+}
+
 
 //
 // CDB
@@ -53,7 +81,7 @@ void CDBEnv::Reset()
     fMockDb = false;
 }
 
-CDBEnv::CDBEnv() : dbenv(NULL)
+CDBEnv::CDBEnv() : nBatchesClosed(0), dbenv(NULL)
 {
     Reset();
 }
@@ -223,7 +251,7 @@ void CDBEnv::CheckpointLSN(const std::string& strFile)
 }
 
 
-CDB::CDB(const std::string& strFilename, const char* pszMode, bool fFlushOnCloseIn) : pdb(NULL), activeTxn(NULL)
+CDB::CDB(const std::string& strFilename, const char* pszMode, bool fFlushOnCloseIn) : pdb(NULL), activeTxn(NULL), fBatchTxn(false)
 {
     int ret;
     fReadOnly = (!strchr(pszMode, '+') && !strchr(pszMode, 'w'));
@@ -231,6 +259,20 @@ CDB::CDB(const std::string& strFilename, const char* pszMode, bool fFlushOnClose
     if (strFilename.empty())
         return;
 
+    // wait for a batch another thread has open on the file to close
+    while (true) {
+        RecursiveMutex* pcsWriters = NULL;
+        {
+            LOCK(bitdb.cs_db);
+            std::map<std::string, CDBEnv::BatchTxn>::const_iterator it = bitdb.mapBatchTxn.find(strFilename);
+            if (it == bitdb.mapBatchTxn.end() || it->second.thread == std::this_thread::get_id())
+                break;
+            pcsWriters = it->second.pcsWriters;
+        }
+        plockWriters.reset();
+        plockWriters.reset(new DebugLock<RecursiveMutex>(*pcsWriters, "csWriters", __FILE__, __LINE__));
+    }
+
     bool fCreate = strchr(pszMode, 'c') != NULL;
     unsigned int nFlags = DB_THREAD;
     if (fCreate)
@@ -279,6 +321,13 @@ CDB::CDB(const std::string& strFilename, const char* pszMode, bool fFlushOnClose
 
             bitdb.mapDb[strFile] = pdb;
         }
+
+        // join the batch this thread has open on the file, if any
+        std::map<std::string, CDBEnv::BatchTxn>::const_iterator it = bitdb.mapBatchTxn.find(strFile);
+        if (it != bitdb.mapBatchTxn.end() && it->second.thread == std::this_thread::get_id()) {
+            activeTxn = it->second.ptxn;
+            fBatchTxn = activeTxn != NULL;
+        }
     }
 }
 
@@ -299,18 +348,92 @@ void CDB::Close()
 {
     if (!pdb)
         return;
-    if (activeTxn)
+    if (activeTxn && !fBatchTxn)
         activeTxn->abort();
     activeTxn = NULL;
     pdb = NULL;
 
-    if (fFlushOnClose)
+    // the batch flushes once, when it commits
+    if (fFlushOnClose && !fBatchTxn)
         Flush();
 
     {
         LOCK(bitdb.cs_db);
         --bitdb.mapFileUseCount[strFile];
     }
+
+    if (!fReadOnly)
+        NotifyWalletDBUpdated();
+}
+
+CDBBatch::CDBBatch(const std::string& strFilename, RecursiveMutex& csWritersIn, bool fFlushOnCommitIn) : strFile(strFilename),
+                                                                                                      csWriters(csWritersIn),
+                                                                                                      fOwner(false),
+                                                                                                      ptxn(NULL),
+                                                                                                      fFlushOnCommit(fFlushOnCommitIn)
+{
+    AssertLockHeld(csWriters);
+    if (strFile.empty())
+        return;
+
+    LOCK(bitdb.cs_db);
+    if (!bitdb.Open(GetDataDir()))
+        throw std::runtime_error("CDBBatch : Failed to open database environment.");
+
+    // nested: the outer batch commits
+    std::map<std::string, CDBEnv::BatchTxn>::const_iterator it = bitdb.mapBatchTxn.find(strFile);
+    if (it != bitdb.mapBatchTxn.end()) {
+        assert(it->second.thread == std::this_thread::get_id());
+        return;
+    }
+
+    ptxn = bitdb.TxnBegin();
+    if (!ptxn)
+        LogPrintf("CDBBatch : Failed to begin a transaction on %s, writing records one by one\n", strFile);
+    CDBEnv::BatchTxn& batch = bitdb.mapBatchTxn[strFile];
+    batch.ptxn = ptxn;
+    batch.thread = std::this_thread::get_id();
+    batch.pcsWriters = &csWriters;
+    fOwner = true;
+    // keep the file open until the transaction is committed
+    ++bitdb.mapFileUseCount[strFile];
+}
+
+CDBBatch::~CDBBatch()
+{
+    Commit();
+}
+
+bool CDBBatch::Commit()
+{
+    if (!fOwner)
+        return true;
+    AssertLockHeld(csWriters);
+    fOwner = false;
+
+    {
+        LOCK(bitdb.cs_db);
+        bitdb.mapBatchTxn.erase(strFile);
+    }
+
+    bool fSuccess = true;
+    if (ptxn) {
+        int ret = ptxn->commit(0);
+        ptxn = NULL;
+        if (ret != 0)
+            fSuccess = error("CDBBatch : Error %d committing writes to %s", ret, strFile);
+        if (fFlushOnCommit)
+            bitdb.dbenv->txn_checkpoint(0, 0, 0);
+    }
+
+    {
+        LOCK(bitdb.cs_db);
+        --bitdb.mapFileUseCount[strFile];
+        ++bitdb.nBatchesClosed;
+    }
+
+    NotifyWalletDBUpdated();
+    return fSuccess;
 }
 
 void CDBEnv::CloseDb(const std::string& strFile)
@@ -368,8 +491,8 @@ bool CDB::Rewrite(const std::string& strFile, const char* pszSkip)
                     Dbc* pcursor = db.GetCursor();
                     if (pcursor)
                         while (fSuccess) {
-                            CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-                            CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+                            CSecureDataStream ssKey(SER_DISK, CLIENT_VERSION);
+                            CSecureDataStream ssValue(SER_DISK, CLIENT_VERSION);
                             int ret = db.ReadAtCursor(pcursor, ssKey, ssValue, DB_NEXT);
                             if (ret == DB_NOTFOUND) {
                                 pcursor->close();
@@ -14,6 +14,7 @@
 
 #include <map>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <boost/filesystem/path.hpp>
@@ -27,6 +28,11 @@ struct CBlockLocator;
 
 extern unsigned int nWalletDBUpdated;
 
+/** Wake up the wallet flushing thread, called whenever a database handle that could write is released */
+void NotifyWalletDBUpdated();
+/** Wait up to nTimeoutMillis (forever if negative) for nWalletDBUpdated to move away from nLastSeen */
+void WaitForWalletDBUpdate(unsigned int nLastSeen, int64_t nTimeoutMillis);
+
 void ThreadFlushWalletDB(const std::string& strWalletFile);
 
 
@@ -46,6 +52,18 @@ public:
     DbEnv *dbenv;
     std::map<std::string, int> mapFileUseCount;
     std::map<std::string, Db*> mapDb;
+    struct BatchTxn {
+        // NULL if no transaction could be started, records are then written one by one
+        DbTxn* ptxn;
+        // the thread writing through the batch
+        std::thread::id thread;
+        // held by that thread while the batch is open, other writers to the file wait on it
+        RecursiveMutex* pcsWriters;
+    };
+    // open CDBBatch transactions by file
+    std::map<std::string, BatchTxn> mapBatchTxn;
+    // outermost batches closed so far, on any file
+    unsigned int nBatchesClosed;
 
     CDBEnv();
     ~CDBEnv();
@@ -102,8 +120,12 @@ protected:
     Db* pdb;
     std::string strFile;
     DbTxn* activeTxn;
+    // activeTxn belongs to a CDBBatch, which commits it
+    bool fBatchTxn;
     bool fReadOnly;
     bool fFlushOnClose;
+    // held while another thread's batch was open on the file when the handle was opened
+    std::unique_ptr<DebugLock<RecursiveMutex> > plockWriters;
 
     explicit CDB(const std::string& strFilename, const char* pszMode = "r+", bool fFlushOnCloseIn=true);
     ~CDB() { Close(); }
@@ -124,7 +146,7 @@ protected:
             return false;
 
         // Key
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CSecureDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(1000);
         ssKey << key;
         Dbt datKey(&ssKey[0], ssKey.size());
@@ -139,7 +161,7 @@ protected:
 
         // Unserialize value
         try {
-            CDataStream ssValue((char*)datValue.get_data(), (char*)datValue.get_data() + datValue.get_size(), SER_DISK, CLIENT_VERSION);
+            CSecureDataStream ssValue((char*)datValue.get_data(), (char*)datValue.get_data() + datValue.get_size(), SER_DISK, CLIENT_VERSION);
             ssValue >> value;
         } catch (const std::exception&) {
             return false;
@@ -160,13 +182,13 @@ protected:
             assert(!"Write called on database in read-only mode");
 
         // Key
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CSecureDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(1000);
         ssKey << key;
         Dbt datKey(&ssKey[0], ssKey.size());
 
         // Value
-        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+        CSecureDataStream ssValue(SER_DISK, CLIENT_VERSION);
         ssValue.reserve(10000);
         ssValue << value;
         Dbt datValue(&ssValue[0], ssValue.size());
@@ -189,7 +211,7 @@ protected:
             assert(!"Erase called on database in read-only mode");
 
         // Key
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CSecureDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(1000);
         ssKey << key;
         Dbt datKey(&ssKey[0], ssKey.size());
@@ -209,7 +231,7 @@ protected:
             return false;
 
         // Key
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CSecureDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(1000);
         ssKey << key;
         Dbt datKey(&ssKey[0], ssKey.size());
@@ -227,13 +249,13 @@ protected:
         if (!pdb)
             return NULL;
         Dbc* pcursor = NULL;
-        int ret = pdb->cursor(NULL, &pcursor, 0);
+        int ret = pdb->cursor(activeTxn, &pcursor, 0);
         if (ret != 0)
             return NULL;
         return pcursor;
     }
 
-    int ReadAtCursor(Dbc* pcursor, CDataStream& ssKey, CDataStream& ssValue, unsigned int fFlags = DB_NEXT)
+    int ReadAtCursor(Dbc* pcursor, CSecureDataStream& ssKey, CSecureDataStream& ssValue, unsigned int fFlags = DB_NEXT)
     {
         // Read at cursor
         Dbt datKey;
@@ -284,7 +306,7 @@ public:
 
     bool TxnCommit()
     {
-        if (!pdb || !activeTxn)
+        if (!pdb || !activeTxn || fBatchTxn)
             return false;
         int ret = activeTxn->commit(0);
         activeTxn = nullptr;
@@ -293,7 +315,7 @@ public:
 
     bool TxnAbort()
     {
-        if (!pdb || !activeTxn)
+        if (!pdb || !activeTxn || fBatchTxn)
             return false;
         int ret = activeTxn->abort();
         activeTxn = nullptr;
@@ -314,4 +336,49 @@ public:
     bool static Rewrite(const std::string& strFile, const char* pszSkip = nullptr);
 };
 
+/**
+ * Groups the writes to a database file into a single transaction.
+ *
+ * While a batch is in scope, every CDB handle the same thread opens on the file
+ * joins its transaction, so bulk updates pay for one commit and one checkpoint
+ * instead of one per record. The transaction is committed by Commit(), or when
+ * the batch goes out of scope if Commit() was not called; records already
+ * written are kept if the bulk update fails half way, as they would have been
+ * without the batch. Callers that can report an error call Commit(), as the
+ * destructor can only log a failed commit. Batches nest: an inner batch on the
+ * same file just joins the outer one.
+ *
+ * The batch is opened under csWriters, the lock that guards the data being
+ * written, and must stay under it until it closes. Handles other threads open
+ * on the file meanwhile take csWriters before touching the database, so they
+ * wait where lock order checking sees them instead of on page locks inside
+ * Berkeley DB. Handles opened on the file before the batch must not be used
+ * while it is in scope, as they would wait for the batch transaction to
+ * complete.
+ */
+class CDBBatch
+{
+private:
+    std::string strFile;
+    RecursiveMutex& csWriters;
+    // false if nested in an outer batch on the file
+    bool fOwner;
+    // NULL if an outer batch owns the transaction, or none could be started
+    DbTxn* ptxn;
+    bool fFlushOnCommit;
+
+    CDBBatch(const CDBBatch&);
+    void operator=(const CDBBatch&);
+
+public:
+    CDBBatch(const std::string& strFilename, RecursiveMutex& csWritersIn, bool fFlushOnCommitIn = true);
+    ~CDBBatch();
+
+    /** Commit the writes now. Returns false if the transaction could not be
+     * committed. An inner batch has nothing to commit and returns true. Handles
+     * opened on the file afterwards write outside the batch.
+     */
+    bool Commit();
+};
+
 #endif // BITCOIN_DB_H
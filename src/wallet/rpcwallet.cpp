@@ -4305,7 +4305,7 @@ void static SearchThread(CzdogecWallet* zwallet, int nCountStart, int nCountEnd)
         uint256 hashSeed = Hash(seedMaster.begin(), seedMaster.end());
         for(int i = nCountStart; i < nCountEnd; i++) {
             boost::this_thread::interruption_point();
-            CDataStream ss(SER_GETHASH, 0);
+            CSecureDataStream ss(SER_GETHASH, 0);
             ss << seedMaster << i;
             uint512 zerocoinSeed = Hash512(ss.begin(), ss.end());
 
@@ -4,6 +4,11 @@
 
 #include "wallet/wallet.h"
 
+#include "init.h"
+#include "test/test_dogecash.h"
+#include "zdogec/deterministicmint.h"
+#include "zdogec/zdogecwallet.h"
+
 #include <set>
 #include <stdint.h>
 #include <utility>
@@ -305,4 +310,138 @@ BOOST_AUTO_TEST_CASE(coin_selection_tests)
     empty_wallet();
 }
 
+BOOST_FIXTURE_TEST_CASE(stake_set_follows_wallet, BasicTestingSetup)
+{
+    SelectParams(CBaseChainParams::REGTEST);
+    CWallet walletStake;
+    std::list<std::unique_ptr<CStakeInput> > listInputs;
+
+    LOCK2(cs_main, walletStake.cs_wallet);
+    CKey key;
+    key.MakeNewKey(true);
+    BOOST_CHECK(walletStake.AddKeyPubKey(key, key.GetPubKey()));
+
+    // a transaction with two stakeable outputs, confirmed in the tip
+    CMutableTransaction txStake;
+    txStake.vin.resize(1);
+    txStake.vin[0].prevout = COutPoint(GetRandHash(), 0);
+    txStake.vout.resize(2);
+    txStake.vout[0] = CTxOut(100 * COIN, GetScriptForDestination(key.GetPubKey().GetID()));
+    txStake.vout[1] = CTxOut(200 * COIN, GetScriptForDestination(key.GetPubKey().GetID()));
+
+    CBlockIndex indexGenesis, indexTip;
+    uint256 hashGenesis = GetRandHash(), hashTip = GetRandHash();
+    indexGenesis.phashBlock = &mapBlockIndex.insert(std::make_pair(hashGenesis, &indexGenesis)).first->first;
+    indexTip.phashBlock = &mapBlockIndex.insert(std::make_pair(hashTip, &indexTip)).first->first;
+    indexTip.pprev = &indexGenesis;
+    indexTip.nHeight = 1;
+    chainActive.SetTip(&indexTip);
+
+    CWalletTx wtxStake(&walletStake, txStake);
+    wtxStake.hashBlock = hashTip;
+    wtxStake.nIndex = 0;
+    BOOST_CHECK(walletStake.AddToWallet(wtxStake, true, NULL));
+    BOOST_CHECK(walletStake.SelectStakeCoins(listInputs, Params().MaxMoneyOut(), 2));
+    BOOST_CHECK_EQUAL(listInputs.size(), 2U);
+
+    // spending an output removes it from the stake set
+    CMutableTransaction txSpend;
+    txSpend.vin.push_back(CTxIn(COutPoint(txStake.GetHash(), 0)));
+    txSpend.vout.push_back(CTxOut(99 * COIN, CScript() << OP_TRUE));
+    BOOST_CHECK(walletStake.AddToWallet(CWalletTx(&walletStake, txSpend), true, NULL));
+    listInputs.clear();
+    BOOST_CHECK(walletStake.SelectStakeCoins(listInputs, Params().MaxMoneyOut(), 2));
+    BOOST_CHECK_EQUAL(listInputs.size(), 1U);
+
+    // inputs selected for the kernel search refer to copies, which outlive the wallet transaction
+    std::map<uint256, CTransaction> mapTxFrom;
+    std::list<std::unique_ptr<CStakeInput> > listCopied;
+    BOOST_CHECK(walletStake.SelectStakeCoins(listCopied, Params().MaxMoneyOut(), 2, false, &mapTxFrom));
+    BOOST_CHECK_EQUAL(listCopied.size(), 1U);
+    BOOST_CHECK_EQUAL(mapTxFrom.size(), 1U);
+
+    // the stake set refers to wallet transactions by outpoint, so erasing one behind
+    // its back only drops the outputs instead of leaving dangling entries
+    walletStake.mapWallet.erase(txStake.GetHash());
+    listInputs.clear();
+    BOOST_CHECK(walletStake.SelectStakeCoins(listInputs, Params().MaxMoneyOut(), 2));
+    BOOST_CHECK(listInputs.empty());
+    BOOST_CHECK_EQUAL(listCopied.front()->GetValue(), 200 * COIN);
+
+    chainActive.SetTip(NULL);
+    mapBlockIndex.erase(hashGenesis);
+    mapBlockIndex.erase(hashTip);
+    SelectParams(CBaseChainParams::UNITTEST);
+}
+
+BOOST_FIXTURE_TEST_CASE(rescan_commits_once, TestingSetup)
+{
+    // the genesis coinbase becomes the wallet's once its script is watched
+    const CTransaction& txGenesis = Params().GenesisBlock().vtx[0];
+    BOOST_CHECK(pwalletMain->AddWatchOnly(txGenesis.vout[0].scriptPubKey));
+
+    unsigned int nBatchesClosed;
+    {
+        LOCK(bitdb.cs_db);
+        nBatchesClosed = bitdb.nBatchesClosed;
+    }
+    BOOST_CHECK_EQUAL(pwalletMain->ScanForWalletTransactions(chainActive.Genesis(), true), 1);
+    BOOST_CHECK(pwalletMain->mapWallet.count(txGenesis.GetHash()));
+    {
+        LOCK(bitdb.cs_db);
+        BOOST_CHECK_EQUAL(bitdb.nBatchesClosed, nBatchesClosed + 1);
+        BOOST_CHECK(bitdb.mapBatchTxn.empty());
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(batch_commit_reports, TestingSetup)
+{
+    LOCK(pwalletMain->cs_wallet);
+    unsigned int nBatchesClosed;
+    {
+        LOCK(bitdb.cs_db);
+        nBatchesClosed = bitdb.nBatchesClosed;
+    }
+    {
+        CDBBatch batch(pwalletMain->strWalletFile, pwalletMain->cs_wallet);
+        {
+            // an inner batch leaves the commit to the outer one
+            CDBBatch inner(pwalletMain->strWalletFile, pwalletMain->cs_wallet);
+            BOOST_CHECK(CWalletDB(pwalletMain->strWalletFile).WriteName("batch", "commit"));
+            BOOST_CHECK(inner.Commit());
+        }
+        {
+            LOCK(bitdb.cs_db);
+            BOOST_CHECK_EQUAL(bitdb.mapBatchTxn.size(), 1U);
+        }
+        BOOST_CHECK(batch.Commit());
+        // committing again, or going out of scope, does not commit twice
+        BOOST_CHECK(batch.Commit());
+    }
+    LOCK(bitdb.cs_db);
+    BOOST_CHECK_EQUAL(bitdb.nBatchesClosed, nBatchesClosed + 1);
+    BOOST_CHECK(bitdb.mapBatchTxn.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(mint_pool_matches_sequential, TestingSetup)
+{
+    CzdogecWallet zWallet(pwalletMain->strWalletFile);
+    BOOST_CHECK(zWallet.SetMasterSeed(uint256("3a1947364362e2e7c073b386869c89c905c0cf462448ffd6c2021bd03ce689f6")));
+
+    // enough counts to spread the pool over several threads, where the machine has them
+    const uint32_t nMints = 4 * MINTPOOL_MIN_PER_THREAD;
+    zWallet.GenerateMintPool(1, nMints);
+    int nCount, nLastGenerated;
+    zWallet.GetState(nCount, nLastGenerated);
+    BOOST_CHECK_EQUAL(nLastGenerated, (int)nMints);
+
+    // the pool holds the values a sequential derivation gives for those counts, and no other
+    for (uint32_t i = 1; i <= nMints + 1; i++) {
+        libzerocoin::PrivateCoin coin(Params().Zerocoin_Params(false), libzerocoin::CoinDenomination::ZQ_ONE, false);
+        CDeterministicMint dMint;
+        zWallet.GenerateMint(i, libzerocoin::CoinDenomination::ZQ_ONE, coin, dMint);
+        BOOST_CHECK_EQUAL(zWallet.IsInMintPool(coin.getPublicCoin().getValue()), i <= nMints);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -33,6 +33,7 @@
 #include "zdogec/zdogectracker.h"
 #include "zdogec/deterministicmint.h"
 #include <assert.h>
+#include <memory>
 
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/thread.hpp>
@@ -986,6 +987,7 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFromLoadWallet, CWalletD
         wtx.BindWallet(this);
         wtxOrdered.insert(make_pair(wtx.nOrderPos, TxPair(&wtx, (CAccountingEntry*)0)));
         AddToSpends(hash);
+        fStakeableCoinsDirty = true;
     } else {
         LOCK(cs_wallet);
         // Inserts only if not already there, returns tx inserted or tx found
@@ -1043,6 +1045,8 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFromLoadWallet, CWalletD
         // Break debit/credit balance caches:
         wtx.MarkDirty();
 
+        AddStakeableCoins(wtx);
+
         // Notify UI of new or updated transaction
         NotifyTransactionChanged(this, hash, fInsertedNew ? CT_NEW : CT_UPDATED);
 
@@ -1075,6 +1079,7 @@ bool CWallet::AddToWalletIfInvolvingMe(const CTransaction& tx, const CBlock* pbl
                 wtx.SetMerkleBranch(*pblock);
             // Do not flush the wallet here for performance reasons
             // this is safe, as in case of a crash, we rescan the necessary blocks on startup through our SetBestChain-mechanism
+            // Callers adding a whole block hold a batch on the wallet file, so the block is committed once
             CWalletDB walletdb(strWalletFile, "r+", false);
 
             return AddToWallet(wtx, false, &walletdb);
@@ -1215,8 +1220,10 @@ void CWallet::EraseFromWallet(const uint256& hash)
         return;
     {
         LOCK(cs_wallet);
-        if (mapWallet.erase(hash))
+        if (mapWallet.erase(hash)) {
             CWalletDB(strWalletFile).EraseTx(hash);
+            fStakeableCoinsDirty = true;
+        }
         LogPrintf("%s: Erased wtx %s from wallet\n", __func__, hash.GetHex());
     }
     return;
@@ -2006,6 +2013,10 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate, b
         double dProgressStart = Checkpoints::GuessVerificationProgress(pindex, false);
         double dProgressTip = Checkpoints::GuessVerificationProgress(chainActive.Tip(), false);
         std::set<uint256> setAddedToWallet;
+        // commit what the rescan finds every few blocks, not once per transaction; a single
+        // transaction for the whole chain would run out of Berkeley DB locks
+        std::unique_ptr<CDBBatch> pbatch(new CDBBatch(strWalletFile, cs_wallet));
+        int nBatchBlocks = 0;
         while (pindex) {
             if (pindex->nHeight % 100 == 0 && dProgressTip - dProgressStart > 0.0)
                 ShowProgress(_("Rescanning..."), std::max(1, std::min(99, (int)((Checkpoints::GuessVerificationProgress(pindex, false) - dProgressStart) / (dProgressTip - dProgressStart) * 100))));
@@ -2068,12 +2079,21 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate, b
                 }
             }
 
+            if (++nBatchBlocks == RESCAN_BATCH_BLOCKS) {
+                if (!pbatch->Commit())
+                    return -1;
+                pbatch.reset(new CDBBatch(strWalletFile, cs_wallet));
+                nBatchBlocks = 0;
+            }
+
             pindex = chainActive.Next(pindex);
             if (GetTime() >= nNow + 60) {
                 nNow = GetTime();
                 LogPrintf("Still rescanning. At block %d. Progress=%f\n", pindex->nHeight, Checkpoints::GuessVerificationProgress(pindex));
             }
         }
+        if (!pbatch->Commit())
+            return -1;
         ShowProgress(_("Rescanning..."), 100); // hide progress dialog in GUI
     }
     return ret;
@@ -2129,7 +2149,7 @@ void CWalletTx::RelayWalletTransaction(std::string strCommand)
             LogPrintf("Relaying wtx %s\n", hash.ToString());
 
             if (strCommand == "ix") {
-                mapTxLockReq.insert(make_pair(hash, (CTransaction) * this));
+                swifttxManager.AddLockRequest(*this);
                 CreateNewLock(((CTransaction) * this));
                 RelayTransactionLockReq((CTransaction) * this, true);
             } else {
@@ -2724,38 +2744,105 @@ bool less_then_denom(const COutput& out1, const COutput& out2)
     return (!found1 && found2);
 }
 
+void CWallet::AddStakeableCoins(const CWalletTx& wtx)
+{
+    AssertLockHeld(cs_wallet);
+
+    const uint256& wtxid = wtx.GetHash();
+    for (unsigned int i = 0; i < wtx.vout.size(); i++) {
+        const CTxOut& out = wtx.vout[i];
+        if (out.IsZerocoinMint() || out.nValue <= 0)
+            continue;
+
+        isminetype mine = IsMine(out);
+        // never stake watch-only or delegated coins
+        if (mine == ISMINE_NO || mine == ISMINE_WATCH_ONLY || mine == ISMINE_SPENDABLE_DELEGATED)
+            continue;
+        if (IsSpent(wtxid, i))
+            continue;
+
+        mapStakeableCoins[COutPoint(wtxid, i)] = mine;
+    }
+}
+
+void CWallet::UpdateStakeableCoins()
+{
+    AssertLockHeld(cs_wallet);
+
+    if (!fStakeableCoinsDirty && GetAdjustedTime() - nStakeableCoinsTime <= nStakeSetUpdateTime)
+        return;
+
+    mapStakeableCoins.clear();
+    for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
+        AddStakeableCoins(it->second);
+    fStakeableCoinsDirty = false;
+    nStakeableCoinsTime = GetAdjustedTime();
+}
+
 bool CWallet::SelectStakeCoins(std::list<std::unique_ptr<CStakeInput> >& listInputs, CAmount nTargetAmount,
-        int blockHeight, bool fPrecompute){
+        int blockHeight, bool fPrecompute, std::map<uint256, CTransaction>* pmapTxFrom){
     LOCK(cs_main);
     //Add DOGEC
-    std::vector<COutput> vCoins;
     // include cold, exclude delegated
     const bool fIncludeCold = sporkManager.IsSporkActive(SPORK_17_COLDSTAKING_ENFORCEMENT) && GetBoolArg("-coldstaking", true);
-    AvailableCoins(&vCoins,
-            nullptr,            // coin control
-            false,              // fIncludeDelegated
-            fIncludeCold,       // fIncludeColdStaking
-            STAKEABLE_COINS);  // coin type
     CAmount nAmountSelected = 0;
     if (GetBoolArg("-DOGECstake", true) && !fPrecompute) {
-        for (const COutput &out : vCoins) {
+        LOCK(cs_wallet);
+        UpdateStakeableCoins();
+
+        std::map<COutPoint, isminetype>::iterator it = mapStakeableCoins.begin();
+        while (it != mapStakeableCoins.end()) {
+            const COutPoint& outpoint = it->first;
+            const isminetype mine = it->second;
+
+            // outputs of erased transactions and spent outputs never become stakeable again
+            std::map<uint256, CWalletTx>::const_iterator mi = mapWallet.find(outpoint.hash);
+            if (mi == mapWallet.end() || IsSpent(outpoint.hash, outpoint.n)) {
+                mapStakeableCoins.erase(it++);
+                continue;
+            }
+            const CWalletTx* pcoin = &mi->second;
+            ++it;
+
+            if (IsLockedCoin(outpoint.hash, outpoint.n))
+                continue;
+            // skip cold coins we do not stake for, and auto-delegated coins when cold staking is off
+            if (mine == ISMINE_COLD && (!fIncludeCold || !HasDelegator(pcoin->vout[outpoint.n])))
+                continue;
+            if (mine == ISMINE_SPENDABLE_STAKEABLE && !fIncludeCold)
+                continue;
+
             //make sure not to outrun target amount
-            if (nAmountSelected + out.tx->vout[out.i].nValue > nTargetAmount)
+            const CAmount nValue = pcoin->vout[outpoint.n].nValue;
+            if (nAmountSelected + nValue > nTargetAmount)
                 continue;
 
-            if (!out.tx->IsInMainChain())
+            // depth and maturity are derived from the containing block, so they follow the tip
+            const int nDepth = pcoin->GetDepthInMainChain(false);
+            if (nDepth < Params().COINSTAKE_MIN_DEPTH())
+                continue;
+            if ((pcoin->IsCoinBase() || pcoin->IsCoinStake()) && pcoin->GetBlocksToMaturity() > 0)
                 continue;
 
-            CBlockIndex* utxoBlock = mapBlockIndex.at(out.tx->hashBlock);
+            CBlockIndex* utxoBlock = mapBlockIndex.at(pcoin->hashBlock);
             //check that it is matured
             if (!Params().HasStakeMinAgeOrDepth(blockHeight, GetAdjustedTime(), utxoBlock->nHeight, utxoBlock->GetBlockTime()))
                 continue;
 
             //add to our stake set
-            nAmountSelected += out.tx->vout[out.i].nValue;
+            nAmountSelected += nValue;
+
+            // one copy per transaction, shared by its outputs
+            const CTransaction* ptxFrom = pcoin;
+            if (pmapTxFrom) {
+                std::map<uint256, CTransaction>::iterator itTx = pmapTxFrom->find(outpoint.hash);
+                if (itTx == pmapTxFrom->end())
+                    itTx = pmapTxFrom->insert(std::make_pair(outpoint.hash, CTransaction(*pcoin))).first;
+                ptxFrom = &itTx->second;
+            }
 
             std::unique_ptr<CDOGECStake> input(new CDOGECStake());
-            input->SetInput((CTransaction) *out.tx, out.i);
+            input->SetInput(ptxFrom, outpoint.n, utxoBlock);
             listInputs.emplace_back(std::move(input));
         }
     }
@@ -3566,11 +3653,16 @@ bool CWallet::CreateCoinStake(
     if (nBalance > 0 && nBalance <= nReserveBalance)
         return false;
 
-    // Get the list of stakable inputs
+    // Get the list of stakable inputs. They are looked up under the locks and refer to
+    // copies of their transactions, so the kernel search runs without blocking validation.
+    std::map<uint256, CTransaction> mapTxFrom;
     std::list<std::unique_ptr<CStakeInput> > listInputs;
-    if (!SelectStakeCoins(listInputs, nBalance - nReserveBalance, pindexPrev->nHeight + 1)) {
-        LogPrintf("CreateCoinStake(): selectStakeCoins failed\n");
-        return false;
+    {
+        LOCK2(cs_main, cs_wallet);
+        if (!SelectStakeCoins(listInputs, nBalance - nReserveBalance, pindexPrev->nHeight + 1, false, &mapTxFrom)) {
+            LogPrintf("CreateCoinStake(): selectStakeCoins failed\n");
+            return false;
+        }
     }
 
     if (listInputs.empty()) {
@@ -3579,6 +3671,18 @@ bool CWallet::CreateCoinStake(
         return false;
     }
 
+    return CreateCoinStakeFromInputs(listInputs, mapTxFrom, pindexPrev, nBits, txNew, nTxNewTime);
+}
+
+bool CWallet::CreateCoinStakeFromInputs(
+        std::list<std::unique_ptr<CStakeInput> >& listInputs,
+        const std::map<uint256, CTransaction>& mapTxFrom,
+        const CBlockIndex* pindexPrev,
+        unsigned int nBits,
+        CMutableTransaction& txNew,
+        int64_t& nTxNewTime
+        )
+{
     // update staker status (hash)
     pStakerStatus->SetLastTip(pindexPrev);
     pStakerStatus->SetLastCoins(listInputs.size());
@@ -3673,8 +3777,8 @@ bool CWallet::CreateCoinStake(
     int nIn = 0;
     if (!txNew.vin[0].scriptSig.IsZerocoinSpend()) {
         for (CTxIn txIn : txNew.vin) {
-            const CWalletTx *wtx = GetWalletTx(txIn.prevout.hash);
-            if (!SignSignature(*this, *wtx, txNew, nIn++, SIGHASH_ALL, true))
+            std::map<uint256, CTransaction>::const_iterator itTx = mapTxFrom.find(txIn.prevout.hash);
+            if (itTx == mapTxFrom.end() || !SignSignature(*this, itTx->second, txNew, nIn++, SIGHASH_ALL, true))
                 return error("CreateCoinStake : failed to sign coinstake");
         }
     } else {
@@ -3946,6 +4050,7 @@ bool CWallet::NewKeyPool()
 {
     {
         LOCK(cs_wallet);
+        CDBBatch batch(strWalletFile, cs_wallet);
         CWalletDB walletdb(strWalletFile);
         for (int64_t nIndex : setInternalKeyPool){
             walletdb.ErasePool(nIndex);
@@ -3957,6 +4062,8 @@ bool CWallet::NewKeyPool()
         setExternalKeyPool.clear();
         if (!TopUpKeyPool())
             return false;
+        if (!batch.Commit())
+            return false;
 
         LogPrintf("CWallet::NewKeyPool rewrote keypool\n");
     }
@@ -4004,6 +4111,8 @@ bool CWallet::TopUpKeyPool(unsigned int kpSize)
             nTargetSize *= 2;
         }
         bool fInternal = false;
+        // the keys, their metadata, HD chain state and pool entries are all written in one transaction
+        CDBBatch batch(strWalletFile, cs_wallet);
         CWalletDB walletdb(strWalletFile);
         for (int64_t i = missingInternal + missingExternal; i--;) {
             int64_t nEnd = 1;
@@ -4029,6 +4138,8 @@ bool CWallet::TopUpKeyPool(unsigned int kpSize)
             std::string strMsg = strprintf(_("Loading wallet... (%3.2f %%)"), dProgress);
             uiInterface.InitMessage(strMsg);
         }
+        if (!batch.Commit())
+            throw std::runtime_error("TopUpKeyPool() : committing generated keys failed");
     }
     return true;
 }
@@ -5029,25 +5140,14 @@ int CMerkleTx::GetTransactionLockSignatures() const
     if (!fEnableSwiftTX) return -1;
 
     //compile consessus vote
-    std::map<uint256, CTransactionLock>::iterator i = mapTxLocks.find(GetHash());
-    if (i != mapTxLocks.end()) {
-        return (*i).second.CountSignatures();
-    }
-
-    return -1;
+    return swifttxManager.CountSignatures(GetHash());
 }
 
 bool CMerkleTx::IsTransactionLockTimedOut() const
 {
     if (!fEnableSwiftTX) return 0;
 
-    //compile consessus vote
-    std::map<uint256, CTransactionLock>::iterator i = mapTxLocks.find(GetHash());
-    if (i != mapTxLocks.end()) {
-        return GetTime() > (*i).second.nTimeout;
-    }
-
-    return false;
+    return swifttxManager.IsLockTimedOut(GetHash());
 }
 
 // Given a set of inputs, find the public key that contributes the most coins to the input set
@@ -6354,6 +6454,8 @@ void CWallet::SetNull()
     }
     nStakeSplitThreshold = STAKE_SPLIT_THRESHOLD;
     nStakeSetUpdateTime = 300; // 5 minutes
+    fStakeableCoinsDirty = true;
+    nStakeableCoinsTime = 0;
 
     //MultiSend
     vMultiSend.clear();
@@ -66,6 +66,8 @@ static const int DEFAULT_CUSTOMBACKUPTHRESHOLD = 1;
 static const bool DEFAULT_AUTOCONVERTADDRESS = true;
 //! if set, all keys will be derived by using BIP32
 static const bool DEFAULT_USE_HD_WALLET = true;
+//! Blocks a wallet rescan commits to the database at once
+static const int RESCAN_BATCH_BLOCKS = 1000;
 
 // Zerocoin denomination which creates exactly one of each denominations:
 // 6666 = 1*5000 + 1*1000 + 1*500 + 1*100 + 1*50 + 1*10 + 1*5 + 1
@@ -236,6 +238,24 @@ private:
     void MarkConflicted(const uint256& hashBlock, const uint256& hashTx);
 
     void SyncMetaData(std::pair<TxSpends::iterator, TxSpends::iterator>);
+
+    /**
+     * Wallet outputs that can be staked once they are deep enough, kept in
+     * step with mapWallet so staking does not rescan the whole wallet on
+     * every attempt. Entries are looked up in mapWallet again whenever the
+     * stake set is selected, which also filters out spent, locked and
+     * immature outputs.
+     */
+    std::map<COutPoint, isminetype> mapStakeableCoins;
+    bool fStakeableCoinsDirty;
+    int64_t nStakeableCoinsTime;
+
+    /// Add the outputs of a wallet transaction that could be staked
+    void AddStakeableCoins(const CWalletTx& wtx);
+    /// Rebuild mapStakeableCoins when invalidated, or once every nStakeSetUpdateTime
+    void UpdateStakeableCoins();
+    /// Search the selected inputs for a kernel and sign the coinstake; runs without cs_main and cs_wallet
+    bool CreateCoinStakeFromInputs(std::list<std::unique_ptr<CStakeInput> >& listInputs, const std::map<uint256, CTransaction>& mapTxFrom, const CBlockIndex* pindexPrev, unsigned int nBits, CMutableTransaction& txNew, int64_t& nTxNewTime);
    /* HD derive new child key (on internal or external chain) */
     void DeriveNewChildKey(const CKeyMetadata& metadata, CKey& secretRet, uint32_t nAccountIndex, bool fInternal = false);
 
@@ -243,7 +263,11 @@ public:
     static const int STAKE_SPLIT_THRESHOLD = 2000;
 
     bool MintableCoins();
-    bool SelectStakeCoins(std::list<std::unique_ptr<CStakeInput> >& listInputs, CAmount nTargetAmount, int blockHeight, bool fPrecompute = false);
+    /**
+     * Select the outputs to stake. They refer to wallet transactions, or, if pmapTxFrom is set,
+     * to copies of them kept there, which stay valid after cs_wallet is released.
+     */
+    bool SelectStakeCoins(std::list<std::unique_ptr<CStakeInput> >& listInputs, CAmount nTargetAmount, int blockHeight, bool fPrecompute = false, std::map<uint256, CTransaction>* pmapTxFrom = NULL);
     bool SelectCoinsDark(CAmount nValueMin, CAmount nValueMax, std::vector<CTxIn>& setCoinsRet, CAmount& nValueRet, int nObfuscationRoundsMin, int nObfuscationRoundsMax) const;
     bool SelectCoinsByDenominations(int nDenom, CAmount nValueMin, CAmount nValueMax, std::vector<CTxIn>& vCoinsRet, std::vector<COutput>& vCoinsRet2, CAmount& nValueRet, int nObfuscationRoundsMin, int nObfuscationRoundsMax);
     bool SelectCoinsDarkDenominated(CAmount nTargetValue, std::vector<CTxIn>& setCoinsRet, CAmount& nValueRet) const;
@@ -13,10 +13,16 @@
 #include "zdogecchain.h"
 #include "tinyformat.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
 using namespace libzerocoin;
 
+// guards mapAccumulatorValues and listAccCheckpointsNoDB, which the startup load fills in the background
+static RecursiveMutex cs_accumulatorValues;
 std::map<uint32_t, CBigNum> mapAccumulatorValues;
 std::list<uint256> listAccCheckpointsNoDB;
+static boost::thread* pthreadLoadAccumulatorValues = nullptr;
 
 
 uint32_t ParseChecksum(uint256 nChecksum, CoinDenomination denomination)
@@ -67,9 +73,12 @@ int GetChecksumHeight(uint32_t nChecksum, CoinDenomination denomination)
 
 bool GetAccumulatorValueFromChecksum(uint32_t nChecksum, bool fMemoryOnly, CBigNum& bnAccValue)
 {
-    if (mapAccumulatorValues.count(nChecksum)) {
-        bnAccValue = mapAccumulatorValues.at(nChecksum);
-        return true;
+    {
+        LOCK(cs_accumulatorValues);
+        if (mapAccumulatorValues.count(nChecksum)) {
+            bnAccValue = mapAccumulatorValues.at(nChecksum);
+            return true;
+        }
     }
 
     if (fMemoryOnly)
@@ -94,6 +103,7 @@ void AddAccumulatorChecksum(const uint32_t nChecksum, const CBigNum &bnValue)
 {
     //Since accumulators are switching at v2, stop databasing v1 because its useless. Only focus on v2.
     if (chainActive.Height() >= Params().Zerocoin_Block_V2_Start()) {
+        LOCK(cs_accumulatorValues);
         zerocoinDB->WriteAccumulatorValue(nChecksum, bnValue);
         mapAccumulatorValues.insert(make_pair(nChecksum, bnValue));
     }
@@ -114,7 +124,9 @@ void DatabaseChecksums(AccumulatorMap& mapAccumulators)
 
 bool EraseChecksum(uint32_t nChecksum)
 {
-    //erase from both memory and database
+    //erase from both memory and database, under the lock the background load reads the database with,
+    //so the load cannot put back a value erased after it was read
+    LOCK(cs_accumulatorValues);
     mapAccumulatorValues.erase(nChecksum);
     return zerocoinDB->EraseAccumulatorValue(nChecksum);
 }
@@ -142,6 +154,9 @@ bool LoadAccumulatorValuesFromDB(const uint256 nCheckpoint)
     for (auto& denomination : zerocoinDenomList) {
         uint32_t nChecksum = ParseChecksum(nCheckpoint, denomination);
 
+        //read and insert under one lock, so a checksum erased meanwhile is not put back
+        LOCK(cs_accumulatorValues);
+
         //if read is not successful then we are not in a state to verify zerocoin transactions
         CBigNum bnValue;
         if (!zerocoinDB->ReadAccumulatorValue(nChecksum, bnValue)) {
@@ -155,6 +170,39 @@ bool LoadAccumulatorValuesFromDB(const uint256 nCheckpoint)
     return true;
 }
 
+static void ThreadLoadAccumulatorValues(const std::vector<uint256> vCheckpoints)
+{
+    util::ThreadRename("dogecash-accload");
+    int64_t nStart = GetTimeMillis();
+    try {
+        for (const uint256& nCheckpoint : vCheckpoints) {
+            boost::this_thread::interruption_point();
+            LoadAccumulatorValuesFromDB(nCheckpoint);
+        }
+    } catch (const boost::thread_interrupted&) {
+        LogPrintf("%s : interrupted\n", __func__);
+        return;
+    }
+    LogPrintf("%s : loaded %u accumulator checkpoints in %dms\n", __func__, vCheckpoints.size(), GetTimeMillis() - nStart);
+}
+
+void LoadAccumulatorValuesAsync(const std::vector<uint256>& vCheckpoints)
+{
+    StopAccumulatorValuesLoad(true);
+    pthreadLoadAccumulatorValues = new boost::thread(boost::bind(&ThreadLoadAccumulatorValues, vCheckpoints));
+}
+
+void StopAccumulatorValuesLoad(bool fInterrupt)
+{
+    if (!pthreadLoadAccumulatorValues)
+        return;
+    if (fInterrupt)
+        pthreadLoadAccumulatorValues->interrupt();
+    pthreadLoadAccumulatorValues->join();
+    delete pthreadLoadAccumulatorValues;
+    pthreadLoadAccumulatorValues = nullptr;
+}
+
 
 //Erase accumulator checkpoints for a certain block range
 bool EraseCheckpoints(int nStartHeight, int nEndHeight)
@@ -351,7 +399,7 @@ int ComputeAccumulatedCoins(int nHeightEnd, libzerocoin::CoinDenomination denom)
     CBlockIndex* pindex = chainActive[GetZerocoinStartHeight()];
     int n = 0;
     while (pindex->nHeight < nHeightEnd) {
-        n += count(pindex->vMintDenominationsInBlock.begin(), pindex->vMintDenominationsInBlock.end(), denom);
+        n += pindex->mintsInBlock.Count(denom);
         pindex = chainActive.Next(pindex);
     }
 
@@ -905,8 +953,7 @@ map<CoinDenomination, int> GetMintMaturityHeight()
         for (auto denom : libzerocoin::zerocoinDenomList) {
             //If the denom has not already had a mint added to it, then see if it has a mint added on this block
             if (mapDenomMaturity.at(denom).first < Params().Zerocoin_RequiredAccumulation()) {
-                mapDenomMaturity.at(denom).first += count(pindex->vMintDenominationsInBlock.begin(),
-                                                          pindex->vMintDenominationsInBlock.end(), denom);
+                mapDenomMaturity.at(denom).first += pindex->mintsInBlock.Count(denom);
 
                 //if mint was found then record this block as the first block that maturity occurs.
                 if (mapDenomMaturity.at(denom).first >= Params().Zerocoin_RequiredAccumulation())
@@ -56,6 +56,10 @@ void AddAccumulatorChecksum(const uint32_t nChecksum, const CBigNum &bnValue, bo
 bool CalculateAccumulatorCheckpoint(int nHeight, uint256& nCheckpoint, AccumulatorMap& mapAccumulators);
 void DatabaseChecksums(AccumulatorMap& mapAccumulators);
 bool LoadAccumulatorValuesFromDB(const uint256 nCheckpoint);
+/** Load the values of the given accumulator checkpoints into memory on a background thread */
+void LoadAccumulatorValuesAsync(const std::vector<uint256>& vCheckpoints);
+/** Wait for the background load to finish, or stop it early if fInterrupt is set */
+void StopAccumulatorValuesLoad(bool fInterrupt);
 bool EraseAccumulatorValues(const uint256& nCheckpointErase, const uint256& nCheckpointPrevious);
 uint32_t ParseChecksum(uint256 nChecksum, libzerocoin::CoinDenomination denomination);
 uint32_t GetChecksum(const CBigNum &bnValue);
@@ -11,6 +11,9 @@
 #include "deterministicmint.h"
 #include "zdogecchain.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
 using namespace libzerocoin;
 
 CzdogecWallet::CzdogecWallet(std::string strWalletFile)
@@ -125,37 +128,60 @@ void CzdogecWallet::GenerateMintPool(uint32_t nCountStart, uint32_t nCountEnd)
     if (nCountEnd > 0)
         nStop = std::max(n, n + nCountEnd);
 
-    bool fFound;
+    // Prevent unnecessary repeated minted
+    std::set<uint32_t> setPoolCounts;
+    for (auto& pair : mintPool)
+        setPoolCounts.insert(pair.second);
+
+    std::vector<uint32_t> vCounts;
+    for (uint32_t i = n; i < nStop; ++i) {
+        if (!setPoolCounts.count(i))
+            vCounts.push_back(i);
+    }
 
     uint256 hashSeed = Hash(seedMaster.begin(), seedMaster.end());
     LogPrintf("%s : n=%d nStop=%d\n", __func__, n, nStop - 1);
-    for (uint32_t i = n; i < nStop; ++i) {
-        if (ShutdownRequested())
-            return;
 
-        fFound = false;
+    // Each mint is derived independently from its count, so the costly
+    // prime searches are spread over worker threads, every thread taking
+    // every nThreads-th count. Results are added to the pool in count order.
+    std::vector<CBigNum> vValues(vCounts.size());
+    int nThreads = std::max(1, std::min((int)boost::thread::hardware_concurrency(), (int)vCounts.size() / MINTPOOL_MIN_PER_THREAD));
+    boost::thread_group threads;
+    for (int nThread = 1; nThread < nThreads; ++nThread)
+        threads.create_thread(boost::bind(&CzdogecWallet::GenerateMintPoolValues, this, boost::cref(vCounts), boost::ref(vValues), nThread, nThreads));
+    GenerateMintPoolValues(vCounts, vValues, 0, nThreads);
+    threads.join_all();
+
+    LOCK(pwalletMain->cs_wallet);
+    CDBBatch batch(strWalletFile, pwalletMain->cs_wallet);
+    for (size_t j = 0; j < vCounts.size(); ++j) {
+        // left unset when shutting down
+        if (vValues[j] == 0)
+            return;
 
-        // Prevent unnecessary repeated minted
-        for (auto& pair : mintPool) {
-            if(pair.second == i) {
-                fFound = true;
-                break;
-            }
-        }
+        uint32_t i = vCounts[j];
+        const CBigNum& bnValue = vValues[j];
+        mintPool.Add(bnValue, i);
+        CWalletDB(strWalletFile).WriteMintPoolPair(hashSeed, GetPubCoinHash(bnValue), i);
+        LogPrintf("%s : %s count=%d\n", __func__, bnValue.GetHex().substr(0, 6), i);
+    }
+    // the pool in memory stays usable for this session
+    if (!batch.Commit())
+        error("%s : failed to store the mint pool", __func__);
+}
 
-        if(fFound)
-            continue;
+void CzdogecWallet::GenerateMintPoolValues(const std::vector<uint32_t>& vCounts, std::vector<CBigNum>& vValues, int nThread, int nThreads)
+{
+    for (size_t j = nThread; j < vCounts.size(); j += nThreads) {
+        if (ShutdownRequested())
+            return;
 
-        uint512 seedZerocoin = GetZerocoinSeed(i);
-        CBigNum bnValue;
+        uint512 seedZerocoin = GetZerocoinSeed(vCounts[j]);
         CBigNum bnSerial;
         CBigNum bnRandomness;
         CKey key;
-        SeedTozdogec(seedZerocoin, bnValue, bnSerial, bnRandomness, key);
-
-        mintPool.Add(bnValue, i);
-        CWalletDB(strWalletFile).WriteMintPoolPair(hashSeed, GetPubCoinHash(bnValue), i);
-        LogPrintf("%s : %s count=%d\n", __func__, bnValue.GetHex().substr(0, 6), i);
+        SeedTozdogec(seedZerocoin, vValues[j], bnSerial, bnRandomness, key);
     }
 }
 
@@ -198,24 +224,41 @@ void CzdogecWallet::SyncWithChain(bool fGenerateMintPool)
         LogPrintf("%s: Mintpool size=%d\n", __func__, mintPool.size());
 
         std::set<uint256> setChecked;
-        list<pair<uint256,uint32_t> > listMints = mintPool.List();
-        for (pair<uint256, uint32_t> pMint : listMints) {
+        bool fRepeated = false;
+        list<pair<uint256,uint32_t> > listMints;
+        {
             LOCK(cs_main);
-            if (setChecked.count(pMint.first))
-                return;
-            setChecked.insert(pMint.first);
+            for (pair<uint256, uint32_t> pMint : mintPool.List()) {
+                if (setChecked.count(pMint.first)) {
+                    fRepeated = true;
+                    break;
+                }
+                setChecked.insert(pMint.first);
+
+                if (pwalletMain->zdogecTracker->HasPubcoinHash(pMint.first)) {
+                    mintPool.Remove(pMint.first);
+                    continue;
+                }
+                listMints.push_back(pMint);
+            }
+        }
 
+        // Find which of the pool's mints made it on chain in one pass over the zerocoin db
+        std::vector<uint256> vPubcoinHashes;
+        for (const pair<uint256, uint32_t>& pMint : listMints)
+            vPubcoinHashes.push_back(pMint.first);
+        std::map<uint256, uint256> mapMintTxHashes;
+        if (!zerocoinDB->ReadCoinMints(vPubcoinHashes, mapMintTxHashes))
+            LogPrintf("%s : failed to look up mint pool in the zerocoin db\n", __func__);
+
+        for (pair<uint256, uint32_t> pMint : listMints) {
             if (ShutdownRequested())
                 return;
 
-            if (pwalletMain->zdogecTracker->HasPubcoinHash(pMint.first)) {
-                mintPool.Remove(pMint.first);
-                continue;
-            }
-
-            uint256 txHash;
-            CZerocoinMint mint;
-            if (zerocoinDB->ReadCoinMint(pMint.first, txHash)) {
+            auto it = mapMintTxHashes.find(pMint.first);
+            if (it != mapMintTxHashes.end()) {
+                LOCK(cs_main);
+                uint256 txHash = it->second;
                 //this mint has already occurred on the chain, increment counter's state to reflect this
                 LogPrintf("%s : Found wallet coin mint=%s count=%d tx=%s\n", __func__, pMint.first.GetHex(), pMint.second, txHash.GetHex());
                 found = true;
@@ -282,6 +325,9 @@ void CzdogecWallet::SyncWithChain(bool fGenerateMintPool)
                 LogPrint("zero", "%s: updated count to %d\n", __func__, nCountLastUsed);
             }
         }
+
+        if (fRepeated)
+            return;
     }
 }
 
@@ -407,7 +453,7 @@ void CzdogecWallet::SeedTozdogec(const uint512& seedZerocoin, CBigNum& bnValue,
 
 uint512 CzdogecWallet::GetZerocoinSeed(uint32_t n)
 {
-    CDataStream ss(SER_GETHASH, 0);
+    CSecureDataStream ss(SER_GETHASH, 0);
     ss << seedMaster << n;
     uint512 zerocoinSeed = Hash512(ss.begin(), ss.end());
     return zerocoinSeed;
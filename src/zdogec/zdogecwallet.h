@@ -13,6 +13,9 @@
 
 class CDeterministicMint;
 
+/** Minimum number of mints for each thread generating the mint pool */
+static const int MINTPOOL_MIN_PER_THREAD = 4;
+
 class CzdogecWallet
 {
 private:
@@ -44,6 +47,8 @@ public:
 
 private:
     uint512 GetZerocoinSeed(uint32_t n);
+    /** Derive the pubcoin values of vCounts[nThread], vCounts[nThread + nThreads]... into vValues */
+    void GenerateMintPoolValues(const std::vector<uint32_t>& vCounts, std::vector<CBigNum>& vValues, int nThread, int nThreads);
 };
 
 #endif //dogecash_zdogecWALLET_H
@@ -322,5 +322,74 @@ class RESTTest (BitcoinTestFramework):
         json_obj = json.loads(json_string)
         assert_equal(json_obj['bestblockhash'], bb_hash)
 
+        ##########################################
+        # /rest/headersrange/ /rest/blockrange/  #
+        ##########################################
+
+        tip_height = self.nodes[0].getblockcount()
+        start = tip_height - 4
+
+        # headers by height match the headers by hash
+        response = http_get_call(url.hostname, url.port, '/rest/headersrange/%d/5%sbin' % (start, self.FORMAT_SEPARATOR), True)
+        assert_equal(response.status, 200)
+        headers_bin = response.read()
+        assert_equal(len(headers_bin), 5 * 80)
+        response = http_get_call(url.hostname, url.port, '/rest/headers/5/%s%sbin' % (self.nodes[0].getblockhash(start), self.FORMAT_SEPARATOR), True)
+        assert_equal(response.read(), headers_bin)
+
+        # a range is the concatenation of the individual blocks
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/%d/5%sbin' % (start, self.FORMAT_SEPARATOR), True)
+        assert_equal(response.status, 200)
+        range_bin = response.read()
+        blocks_bin = b''
+        for height in range(start, tip_height + 1):
+            blocks_bin += http_get_call(url.hostname, url.port, '/rest/block/%s%sbin' % (self.nodes[0].getblockhash(height), self.FORMAT_SEPARATOR), True).read()
+        assert_equal(range_bin, blocks_bin)
+
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/%d/5%shex' % (start, self.FORMAT_SEPARATOR), True)
+        assert_equal(response.status, 200)
+        lines = response.read().decode('utf-8').split('\n')
+        assert_equal(len(lines), 6)
+        assert_equal(''.join(lines), encode(range_bin, 'hex_codec').decode('ascii'))
+
+        # ranges are cut at the tip and must start on the chain
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/%d/100%sbin' % (start, self.FORMAT_SEPARATOR), True)
+        assert_equal(response.read(), range_bin)
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/%d/1%sbin' % (tip_height + 1, self.FORMAT_SEPARATOR), True)
+        assert_equal(response.status, 404)
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/%d/101%sbin' % (start, self.FORMAT_SEPARATOR), True)
+        assert_equal(response.status, 400)
+
+        ###################################
+        # response cache and conditionals #
+        ###################################
+
+        range_uri = '/rest/headersrange/%d/10%sjson' % (start, self.FORMAT_SEPARATOR)
+        response = http_get_call(url.hostname, url.port, range_uri, True)
+        etag = response.getheader('ETag')
+        assert_equal(len(json.loads(response.read().decode('utf-8'))), 5)
+
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request('GET', range_uri, headers={'If-None-Match': etag})
+        assert_equal(conn.getresponse().status, 304)
+
+        # invalidateblock does not announce a new tip, but must not leave stale responses behind
+        tip_hash = self.nodes[0].getbestblockhash()
+        self.nodes[0].invalidateblock(tip_hash)
+        response = http_get_call(url.hostname, url.port, range_uri, True)
+        assert_equal(response.status, 200)
+        assert(response.getheader('ETag') != etag)
+        headers_json = json.loads(response.read().decode('utf-8'))
+        assert_equal(len(headers_json), 4)
+        assert(tip_hash not in [header['hash'] for header in headers_json])
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/%d/100%sbin' % (start, self.FORMAT_SEPARATOR), True)
+        assert_equal(response.read(), range_bin[:len(range_bin) - len(http_get_call(url.hostname, url.port, '/rest/block/%s%sbin' % (tip_hash, self.FORMAT_SEPARATOR), True).read())])
+
+        self.nodes[0].reconsiderblock(tip_hash)
+        assert_equal(self.nodes[0].getbestblockhash(), tip_hash)
+        response = http_get_call(url.hostname, url.port, range_uri, True)
+        assert_equal(response.getheader('ETag'), etag)
+        assert_equal(len(json.loads(response.read().decode('utf-8'))), 5)
+
 if __name__ == '__main__':
     RESTTest ().main ()